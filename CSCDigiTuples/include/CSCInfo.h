@@ -36,7 +36,7 @@ class Object {
 public:
 	const string name;
 	virtual ~Object(){};
-	Object(const char *n): name(n){}
+	Object(const char *n): name(n), tree(0), isLazy(false){}
 
 	/* @brief takes a variable name and returns a std::string in current branch convention
 	 * branchify
@@ -48,8 +48,107 @@ public:
 	{
 		return (name+'_'+string(varname));
 	}
+
+	/* @brief connects a field to its branch when reading, and enables the branch
+	 * connect
+	 * 	- requires: the tree [t], the variable name [varname] and its address
+	 * 	- returns: 0 if connected, -1 if the tree doesn't have the branch. If not [required],
+	 * 		the field is left at its default value
+	 */
+	template<class T>
+	int connect(TTree* t, char const * varname, T* address, bool required=true)
+	{
+		tree = t;
+		const string branch = branchify(varname);
+		if(!t->GetBranch(branch.c_str())) {
+			if(required) t->SetBranchAddress(branch.c_str(), address); //let root complain
+			return -1;
+		}
+		t->SetBranchAddress(branch.c_str(), address);
+		t->SetBranchStatus(branch.c_str(), 1);
+		fields.push_back(Field(varname, (void*)address));
+		return 0;
+	}
+
+	/* @brief only read the given fields, the rest of this object's branches are disabled.
+	 * 	Branches not belonging to any reader are still read, unless disableAll() was called
+	 * 	- returns: 0 if all fields are known, -1 if not
+	 */
+	int select(const std::vector<std::string>& varnames)
+	{
+		int status = 0;
+		for(auto& v : varnames){
+			bool found = false;
+			for(auto& f : fields) if(f.varname == v) found = true;
+			if(!found) status = -1;
+		}
+		for(auto& f : fields){
+			bool keep = false;
+			for(auto& v : varnames) if(f.varname == v) keep = true;
+			setActive(f, keep);
+		}
+		return status;
+	}
+
+	/* @brief disables all of this object's branches, each is enabled the first time
+	 * 	its field is accessed through get(), and read from then on with the rest of the entry
+	 */
+	void lazy()
+	{
+		isLazy = true;
+		for(auto& f : fields) setActive(f, false);
+	}
+
+	/* @brief access to a field of a lazy object, e.g. segments.get(segments.pos_x)->at(i)
+	 * 	- returns: the field, after reading its branch for the current entry if it was disabled
+	 */
+	template<class T>
+	T& get(T& field)
+	{
+		if(!isLazy) return field;
+		for(auto& f : fields){
+			if(f.address != (void*)&field) continue;
+			if(f.active) break;
+			setActive(f, true);
+			//read it for the entry we are already on, later entries read it along with the rest
+			TTree* current = tree->GetTree();
+			if(current && current->GetReadEntry() >= 0) {
+				TBranch* b = current->GetBranch(branchify(f.varname.c_str()).c_str());
+				if(b) b->GetEntry(current->GetReadEntry());
+			}
+			break;
+		}
+		return field;
+	}
+
+	TTree* tree; //tree we read from, if any
+
+private:
+	struct Field {
+		Field(const std::string& v, void* a) : varname(v), address(a), active(true) {}
+		std::string varname;
+		void* address;
+		bool active;
+	};
+
+	void setActive(Field& f, bool active)
+	{
+		f.active = active;
+		tree->SetBranchStatus(branchify(f.varname.c_str()).c_str(), active);
+	}
+
+	std::vector<Field> fields;
+	bool isLazy;
 };
 
+/* @brief disables every branch of the tree, so only the branches of readers
+ * 	constructed afterwards are read by GetEntry. Call before making the readers
+ */
+inline void disableAll(TTree* t)
+{
+	t->SetBranchStatus("*", 0);
+}
+
 class Event : public Object{
 public:
 
@@ -70,14 +169,12 @@ public:
 	 * used independently of FillCSCInfo.h. Analogous for following classes
 	 */
 	Event(TTree* t): Event(){
-		t->SetBranchAddress(branchify(GET_VARIABLE_NAME(EventNumber)).c_str(), &EventNumber);
-		t->SetBranchAddress(branchify(GET_VARIABLE_NAME(RunNumber)).c_str(), &RunNumber);
-		t->SetBranchAddress(branchify(GET_VARIABLE_NAME(LumiSection)).c_str(),&LumiSection);
-		t->SetBranchAddress(branchify(GET_VARIABLE_NAME(BXCrossing)).c_str(), &BXCrossing);
-		if(t->GetBranch(branchify(GET_VARIABLE_NAME(NSegmentsInEvent)).c_str())) { //in the event you are using legacy trees, defaults the value to 0
-			t->SetBranchAddress(branchify(GET_VARIABLE_NAME(NSegmentsInEvent)).c_str(),
-						&NSegmentsInEvent);
-		}
+		connect(t, GET_VARIABLE_NAME(EventNumber), &EventNumber);
+		connect(t, GET_VARIABLE_NAME(RunNumber), &RunNumber);
+		connect(t, GET_VARIABLE_NAME(LumiSection), &LumiSection);
+		connect(t, GET_VARIABLE_NAME(BXCrossing), &BXCrossing);
+		//in the event you are using legacy trees, defaults the value to 0
+		connect(t, GET_VARIABLE_NAME(NSegmentsInEvent), &NSegmentsInEvent, false);
 	}
 
 	unsigned long long EventNumber;
@@ -106,16 +203,11 @@ public:
 	}
 
 	GenParticles(TTree* t) : GenParticles() {
-		t->SetBranchAddress(branchify(GET_VARIABLE_NAME(pdg_id)).c_str(),
-				&pdg_id);
-		t->SetBranchAddress(branchify(GET_VARIABLE_NAME(pt)).c_str(),
-				&pt);
-		t->SetBranchAddress(branchify(GET_VARIABLE_NAME(eta)).c_str(),
-				&eta);
-		t->SetBranchAddress(branchify(GET_VARIABLE_NAME(phi)).c_str(),
-				&phi);
-		t->SetBranchAddress(branchify(GET_VARIABLE_NAME(q)).c_str(),
-				&q);
+		connect(t, GET_VARIABLE_NAME(pdg_id), &pdg_id);
+		connect(t, GET_VARIABLE_NAME(pt), &pt);
+		connect(t, GET_VARIABLE_NAME(eta), &eta);
+		connect(t, GET_VARIABLE_NAME(phi), &phi);
+		connect(t, GET_VARIABLE_NAME(q), &q);
 	}
 
 	unsigned int size() const {
@@ -141,20 +233,13 @@ public:
 	}
 
 	SimHits(TTree* t) : SimHits() {
-		t->SetBranchAddress(branchify(GET_VARIABLE_NAME(ch_id)).c_str(),
-				&ch_id);
-		t->SetBranchAddress(branchify(GET_VARIABLE_NAME(pdg_id)).c_str(),
-				&pdg_id);
-		t->SetBranchAddress(branchify(GET_VARIABLE_NAME(layer)).c_str(),
-				&layer);
-		t->SetBranchAddress(branchify(GET_VARIABLE_NAME(energyLoss)).c_str(),
-				&energyLoss);
-		t->SetBranchAddress(branchify(GET_VARIABLE_NAME(thetaAtEntry)).c_str(),
-				&thetaAtEntry);
-		t->SetBranchAddress(branchify(GET_VARIABLE_NAME(phiAtEntry)).c_str(),
-				&phiAtEntry);
-		t->SetBranchAddress(branchify(GET_VARIABLE_NAME(pAtEntry)).c_str(),
-				&pAtEntry);
+		connect(t, GET_VARIABLE_NAME(ch_id), &ch_id);
+		connect(t, GET_VARIABLE_NAME(pdg_id), &pdg_id);
+		connect(t, GET_VARIABLE_NAME(layer), &layer);
+		connect(t, GET_VARIABLE_NAME(energyLoss), &energyLoss);
+		connect(t, GET_VARIABLE_NAME(thetaAtEntry), &thetaAtEntry);
+		connect(t, GET_VARIABLE_NAME(phiAtEntry), &phiAtEntry);
+		connect(t, GET_VARIABLE_NAME(pAtEntry), &pAtEntry);
 
 	}
 	unsigned int size() const {
@@ -180,14 +265,10 @@ public:
 	}
 
 	CaloHit(const string& pref, TTree* t) : CaloHit(pref) {
-		t->SetBranchAddress(branchify(GET_VARIABLE_NAME(energyEM)).c_str(),
-								&energyEM);
-		t->SetBranchAddress(branchify(GET_VARIABLE_NAME(energyHad)).c_str(),
-								&energyHad);
-		t->SetBranchAddress(branchify(GET_VARIABLE_NAME(eta)).c_str(),
-								&eta);
-		t->SetBranchAddress(branchify(GET_VARIABLE_NAME(phi)).c_str(),
-								&phi);
+		connect(t, GET_VARIABLE_NAME(energyEM), &energyEM);
+		connect(t, GET_VARIABLE_NAME(energyHad), &energyHad);
+		connect(t, GET_VARIABLE_NAME(eta), &eta);
+		connect(t, GET_VARIABLE_NAME(phi), &phi);
 	}
 	unsigned int size() const {
 		return energyEM? energyEM->size() : 0;
@@ -222,20 +303,13 @@ public:
 
 
 	PFCandidate(TTree* t) : PFCandidate() {
-		t->SetBranchAddress(branchify(GET_VARIABLE_NAME(pdg_id)).c_str(),
-				&pdg_id);
-		t->SetBranchAddress(branchify(GET_VARIABLE_NAME(particleId)).c_str(),
-						&particleId);
-		t->SetBranchAddress(branchify(GET_VARIABLE_NAME(eta)).c_str(),
-						&eta);
-		t->SetBranchAddress(branchify(GET_VARIABLE_NAME(phi)).c_str(),
-						&phi);
-		t->SetBranchAddress(branchify(GET_VARIABLE_NAME(ecalEnergy)).c_str(),
-						&ecalEnergy);
-		t->SetBranchAddress(branchify(GET_VARIABLE_NAME(hcalEnergy)).c_str(),
-						&hcalEnergy);
-		t->SetBranchAddress(branchify(GET_VARIABLE_NAME(h0Energy)).c_str(),
-								&h0Energy);
+		connect(t, GET_VARIABLE_NAME(pdg_id), &pdg_id);
+		connect(t, GET_VARIABLE_NAME(particleId), &particleId);
+		connect(t, GET_VARIABLE_NAME(eta), &eta);
+		connect(t, GET_VARIABLE_NAME(phi), &phi);
+		connect(t, GET_VARIABLE_NAME(ecalEnergy), &ecalEnergy);
+		connect(t, GET_VARIABLE_NAME(hcalEnergy), &hcalEnergy);
+		connect(t, GET_VARIABLE_NAME(h0Energy), &h0Energy);
 	}
 
 	std::vector<int>* pdg_id;
@@ -259,12 +333,12 @@ public:
 		isTracker = 0;
 	}
 	Muons(TTree* t) : Muons() {
-		t->SetBranchAddress(branchify(GET_VARIABLE_NAME(pt)).c_str(), &pt);
-		t->SetBranchAddress(branchify(GET_VARIABLE_NAME(eta)).c_str(), &eta);
-		t->SetBranchAddress(branchify(GET_VARIABLE_NAME(phi)).c_str(), &phi);
-		t->SetBranchAddress(branchify(GET_VARIABLE_NAME(q)).c_str(), &q);
-		t->SetBranchAddress(branchify(GET_VARIABLE_NAME(isGlobal)).c_str(), &isGlobal);
-		t->SetBranchAddress(branchify(GET_VARIABLE_NAME(isTracker)).c_str(), &isTracker);
+		connect(t, GET_VARIABLE_NAME(pt), &pt);
+		connect(t, GET_VARIABLE_NAME(eta), &eta);
+		connect(t, GET_VARIABLE_NAME(phi), &phi);
+		connect(t, GET_VARIABLE_NAME(q), &q);
+		connect(t, GET_VARIABLE_NAME(isGlobal), &isGlobal);
+		connect(t, GET_VARIABLE_NAME(isTracker), &isTracker);
 	}
 
 	unsigned int size() const {
@@ -292,14 +366,14 @@ public:
 		nHits = 0;
 	}
 	Segments(TTree* t) : Segments() {
-		t->SetBranchAddress(branchify(GET_VARIABLE_NAME(mu_id)).c_str(), &mu_id);
-		t->SetBranchAddress(branchify(GET_VARIABLE_NAME(ch_id)).c_str(), &ch_id);
-		t->SetBranchAddress(branchify(GET_VARIABLE_NAME(pos_x)).c_str(), &pos_x);
-		t->SetBranchAddress(branchify(GET_VARIABLE_NAME(pos_y)).c_str(), &pos_y);
-		t->SetBranchAddress(branchify(GET_VARIABLE_NAME(dxdz)).c_str(), &dxdz);
-		t->SetBranchAddress(branchify(GET_VARIABLE_NAME(dydz)).c_str(), &dydz);
-		t->SetBranchAddress(branchify(GET_VARIABLE_NAME(chisq)).c_str(), &chisq);
-		t->SetBranchAddress(branchify(GET_VARIABLE_NAME(nHits)).c_str(), &nHits);
+		connect(t, GET_VARIABLE_NAME(mu_id), &mu_id);
+		connect(t, GET_VARIABLE_NAME(ch_id), &ch_id);
+		connect(t, GET_VARIABLE_NAME(pos_x), &pos_x);
+		connect(t, GET_VARIABLE_NAME(pos_y), &pos_y);
+		connect(t, GET_VARIABLE_NAME(dxdz), &dxdz);
+		connect(t, GET_VARIABLE_NAME(dydz), &dydz);
+		connect(t, GET_VARIABLE_NAME(chisq), &chisq);
+		connect(t, GET_VARIABLE_NAME(nHits), &nHits);
 	}
 
 	unsigned int size() const {
@@ -329,13 +403,13 @@ class RecHits : public Object{
 		max_adc = 0;
 	}
 	RecHits(TTree* t) : RecHits() {
-		t->SetBranchAddress(branchify(GET_VARIABLE_NAME(mu_id)).c_str(), &mu_id);
-		t->SetBranchAddress(branchify(GET_VARIABLE_NAME(ch_id)).c_str(), &ch_id);
-		t->SetBranchAddress(branchify(GET_VARIABLE_NAME(lay)).c_str(), &lay);
-		t->SetBranchAddress(branchify(GET_VARIABLE_NAME(pos_x)).c_str(), &pos_x);
-		t->SetBranchAddress(branchify(GET_VARIABLE_NAME(pos_y)).c_str(), &pos_y);
-		t->SetBranchAddress(branchify(GET_VARIABLE_NAME(e)).c_str(), &e);
-		t->SetBranchAddress(branchify(GET_VARIABLE_NAME(max_adc)).c_str(), &max_adc);
+		connect(t, GET_VARIABLE_NAME(mu_id), &mu_id);
+		connect(t, GET_VARIABLE_NAME(ch_id), &ch_id);
+		connect(t, GET_VARIABLE_NAME(lay), &lay);
+		connect(t, GET_VARIABLE_NAME(pos_x), &pos_x);
+		connect(t, GET_VARIABLE_NAME(pos_y), &pos_y);
+		connect(t, GET_VARIABLE_NAME(e), &e);
+		connect(t, GET_VARIABLE_NAME(max_adc), &max_adc);
 	}
 	unsigned int size() const {
 		return mu_id ? mu_id->size() : 0;
@@ -362,13 +436,13 @@ public:
 		bunchCross = 0;
 	}
 	LCTs(TTree* t) : LCTs() {
-		t->SetBranchAddress(branchify(GET_VARIABLE_NAME(ch_id)).c_str(), &ch_id);
-		t->SetBranchAddress(branchify(GET_VARIABLE_NAME(quality)).c_str(), &quality);
-		t->SetBranchAddress(branchify(GET_VARIABLE_NAME(pattern)).c_str(), &pattern);
-		t->SetBranchAddress(branchify(GET_VARIABLE_NAME(bend)).c_str(), &bend);
-		t->SetBranchAddress(branchify(GET_VARIABLE_NAME(keyWireGroup)).c_str(), &keyWireGroup);
-		t->SetBranchAddress(branchify(GET_VARIABLE_NAME(keyHalfStrip)).c_str(), &keyHalfStrip);
-		t->SetBranchAddress(branchify(GET_VARIABLE_NAME(bunchCross)).c_str(), &bunchCross);
+		connect(t, GET_VARIABLE_NAME(ch_id), &ch_id);
+		connect(t, GET_VARIABLE_NAME(quality), &quality);
+		connect(t, GET_VARIABLE_NAME(pattern), &pattern);
+		connect(t, GET_VARIABLE_NAME(bend), &bend);
+		connect(t, GET_VARIABLE_NAME(keyWireGroup), &keyWireGroup);
+		connect(t, GET_VARIABLE_NAME(keyHalfStrip), &keyHalfStrip);
+		connect(t, GET_VARIABLE_NAME(bunchCross), &bunchCross);
 	}
 
 	unsigned int size() const {
@@ -401,17 +475,17 @@ public:
 		keyStrip = 0;
 	}
 	CLCTs(TTree* t) : CLCTs() {
-		t->SetBranchAddress(branchify(GET_VARIABLE_NAME(ch_id)).c_str(), &ch_id);
-		t->SetBranchAddress(branchify(GET_VARIABLE_NAME(isValid)).c_str(), &isValid);
-		t->SetBranchAddress(branchify(GET_VARIABLE_NAME(quality)).c_str(), &quality);
-		t->SetBranchAddress(branchify(GET_VARIABLE_NAME(pattern)).c_str(), &pattern);
-		t->SetBranchAddress(branchify(GET_VARIABLE_NAME(stripType)).c_str(), &stripType);
-		t->SetBranchAddress(branchify(GET_VARIABLE_NAME(bend)).c_str(), &bend);
-		t->SetBranchAddress(branchify(GET_VARIABLE_NAME(halfStrip)).c_str(), &halfStrip);
-		t->SetBranchAddress(branchify(GET_VARIABLE_NAME(CFEB)).c_str(), &CFEB);
-		t->SetBranchAddress(branchify(GET_VARIABLE_NAME(BX)).c_str(), &BX);
-		t->SetBranchAddress(branchify(GET_VARIABLE_NAME(trkNumber)).c_str(), &trkNumber);
-		t->SetBranchAddress(branchify(GET_VARIABLE_NAME(keyStrip)).c_str(), &keyStrip);
+		connect(t, GET_VARIABLE_NAME(ch_id), &ch_id);
+		connect(t, GET_VARIABLE_NAME(isValid), &isValid);
+		connect(t, GET_VARIABLE_NAME(quality), &quality);
+		connect(t, GET_VARIABLE_NAME(pattern), &pattern);
+		connect(t, GET_VARIABLE_NAME(stripType), &stripType);
+		connect(t, GET_VARIABLE_NAME(bend), &bend);
+		connect(t, GET_VARIABLE_NAME(halfStrip), &halfStrip);
+		connect(t, GET_VARIABLE_NAME(CFEB), &CFEB);
+		connect(t, GET_VARIABLE_NAME(BX), &BX);
+		connect(t, GET_VARIABLE_NAME(trkNumber), &trkNumber);
+		connect(t, GET_VARIABLE_NAME(keyStrip), &keyStrip);
 	}
 
 	unsigned int size() const {
@@ -463,15 +537,15 @@ class ALCTs : public Object
 
 		ALCTs(TTree* t) : ALCTs()
 		{
-			t->SetBranchAddress(branchify(GET_VARIABLE_NAME(ch_id)).c_str(), &ch_id);
-			t->SetBranchAddress(branchify(GET_VARIABLE_NAME(isValid)).c_str(), &isValid);
-			t->SetBranchAddress(branchify(GET_VARIABLE_NAME(quality)).c_str(), &quality);
-			t->SetBranchAddress(branchify(GET_VARIABLE_NAME(accelerator)).c_str(), &accelerator);
-			t->SetBranchAddress(branchify(GET_VARIABLE_NAME(collisionB)).c_str(), &collisionB);
-			t->SetBranchAddress(branchify(GET_VARIABLE_NAME(keyWG)).c_str(), &keyWG);
-			t->SetBranchAddress(branchify(GET_VARIABLE_NAME(BX)).c_str(), &BX);
-			t->SetBranchAddress(branchify(GET_VARIABLE_NAME(trkNumber)).c_str(), &trkNumber);
-			t->SetBranchAddress(branchify(GET_VARIABLE_NAME(fullBX)).c_str(), &fullBX);
+			connect(t, GET_VARIABLE_NAME(ch_id), &ch_id);
+			connect(t, GET_VARIABLE_NAME(isValid), &isValid);
+			connect(t, GET_VARIABLE_NAME(quality), &quality);
+			connect(t, GET_VARIABLE_NAME(accelerator), &accelerator);
+			connect(t, GET_VARIABLE_NAME(collisionB), &collisionB);
+			connect(t, GET_VARIABLE_NAME(keyWG), &keyWG);
+			connect(t, GET_VARIABLE_NAME(BX), &BX);
+			connect(t, GET_VARIABLE_NAME(trkNumber), &trkNumber);
+			connect(t, GET_VARIABLE_NAME(fullBX), &fullBX);
 		}
 
 		unsigned int size() const 
@@ -505,12 +579,12 @@ class Wires : public Object
 
 		Wires(TTree* t) : Wires()
 		{
-			t->SetBranchAddress(branchify(GET_VARIABLE_NAME(ch_id)).c_str(), &ch_id);
-			t->SetBranchAddress(branchify(GET_VARIABLE_NAME(group)).c_str(), &group);
-			t->SetBranchAddress(branchify(GET_VARIABLE_NAME(lay)).c_str(), &lay);
-			t->SetBranchAddress(branchify(GET_VARIABLE_NAME(timeBin)).c_str(), &timeBin);
-			t->SetBranchAddress(branchify(GET_VARIABLE_NAME(BX)).c_str(), &BX);
-			t->SetBranchAddress(branchify(GET_VARIABLE_NAME(timeBinWord)).c_str(), &timeBinWord);
+			connect(t, GET_VARIABLE_NAME(ch_id), &ch_id);
+			connect(t, GET_VARIABLE_NAME(group), &group);
+			connect(t, GET_VARIABLE_NAME(lay), &lay);
+			connect(t, GET_VARIABLE_NAME(timeBin), &timeBin);
+			connect(t, GET_VARIABLE_NAME(BX), &BX);
+			connect(t, GET_VARIABLE_NAME(timeBinWord), &timeBinWord);
 		}
 
 		unsigned int size() const 
@@ -543,14 +617,14 @@ class Strips : public Object
 
 		Strips(TTree* t) : Strips()
 		{
-			t->SetBranchAddress(branchify(GET_VARIABLE_NAME(ch_id)).c_str(), &ch_id);
-			t->SetBranchAddress(branchify(GET_VARIABLE_NAME(lay)).c_str(), &lay);
-			t->SetBranchAddress(branchify(GET_VARIABLE_NAME(num)).c_str(), &num);
-			//t->SetBranchAddress(branchify(GET_VARIABLE_NAME(ADC)).c_str(), &ADC);
-			//t->SetBranchAddress(branchify(GET_VARIABLE_NAME(L1APhase)).c_str(), &L1APhase);
-			//t->SetBranchAddress(branchify(GET_VARIABLE_NAME(ADCOverflow)).c_str(), &ADCOverflow);
-			//t->SetBranchAddress(branchify(GET_VARIABLE_NAME(OverlappedSample)).c_str(), &OverlappedSample);
-			//t->SetBranchAddress(branchify(GET_VARIABLE_NAME(Errorstat)).c_str(), &Errorstat);
+			connect(t, GET_VARIABLE_NAME(ch_id), &ch_id);
+			connect(t, GET_VARIABLE_NAME(lay), &lay);
+			connect(t, GET_VARIABLE_NAME(num), &num);
+			//connect(t, GET_VARIABLE_NAME(ADC), &ADC);
+			//connect(t, GET_VARIABLE_NAME(L1APhase), &L1APhase);
+			//connect(t, GET_VARIABLE_NAME(ADCOverflow), &ADCOverflow);
+			//connect(t, GET_VARIABLE_NAME(OverlappedSample), &OverlappedSample);
+			//connect(t, GET_VARIABLE_NAME(Errorstat), &Errorstat);
 		}
 
 		unsigned int size() const 
@@ -580,12 +654,12 @@ public:
 		nTimeOn = 0;
 	}
 	Comparators(TTree* t) : Comparators(){
-		t->SetBranchAddress(branchify(GET_VARIABLE_NAME(ch_id)).c_str(), &ch_id);
-		t->SetBranchAddress(branchify(GET_VARIABLE_NAME(lay)).c_str(), &lay);
-		t->SetBranchAddress(branchify(GET_VARIABLE_NAME(strip)).c_str(), &strip);
-		t->SetBranchAddress(branchify(GET_VARIABLE_NAME(halfStrip)).c_str(), &halfStrip);
-		t->SetBranchAddress(branchify(GET_VARIABLE_NAME(bestTime)).c_str(), &bestTime);
-		t->SetBranchAddress(branchify(GET_VARIABLE_NAME(nTimeOn)).c_str(), &nTimeOn);
+		connect(t, GET_VARIABLE_NAME(ch_id), &ch_id);
+		connect(t, GET_VARIABLE_NAME(lay), &lay);
+		connect(t, GET_VARIABLE_NAME(strip), &strip);
+		connect(t, GET_VARIABLE_NAME(halfStrip), &halfStrip);
+		connect(t, GET_VARIABLE_NAME(bestTime), &bestTime);
+		connect(t, GET_VARIABLE_NAME(nTimeOn), &nTimeOn);
 	}
 
 	unsigned int size() const {
@@ -121,6 +121,10 @@ public:
 	int patternId() const;
 	const LUTKey key() const;
 
+	//packed integer ranks, lower is better
+	unsigned int qualityRank() const;
+	unsigned long long cfebRank() const;
+
 	//declare a function pointer used to sort the CLCT Candidates
 	typedef function<bool(CLCTCandidate*, CLCTCandidate*)> QUALITY_SORT;
 	static QUALITY_SORT quality;
@@ -195,6 +199,9 @@ CLCTCandidate::QUALITY_SORT CLCTCandidate::quality =
 	// which should be by default better than nothing
 	if(!l1) return false;
 
+	//entries of a final LUT are already ranked
+	if(l1->rank() != LUTEntry::NO_RANK && l2->rank() != LUTEntry::NO_RANK)
+		return l1->rank() < l2->rank();
 
 	//priority (layers, chi2, slope)
 	if (l1->_layers > l2->_layers) return true;
@@ -219,19 +226,7 @@ CLCTCandidate::QUALITY_SORT CLCTCandidate::cfebQuality =
 
 
 	//sort by layers, bend bit, key half strip
-	if(c1->layerCount() > c2-> layerCount()) return true;
-	else if(c1->layerCount() == c2->layerCount()){
-		if(c1->_pattern.bendBit() > c2->_pattern.bendBit()) return true;
-		else if (c1->_pattern.bendBit() == c2->_pattern.bendBit()) {
-			if(c1->keyHalfStrip() <= c2->keyHalfStrip()) return true;
-			else return false;
-		} else{
-			return false;
-		}
-	}else{
-		return false;
-	}
-
+	return c1->cfebRank() <= c2->cfebRank();
 };
 
 
@@ -259,6 +254,14 @@ public:
 	float hitStdHS();
 	int _hits[N_MAX_HALF_STRIPS][NLAYERS];
 
+	//hit counts, kept up to date by fill() and -=, as nhits()
+	unsigned int layerHits(unsigned int lay) const {return _layerHits[lay];}
+	unsigned int cfebHits(unsigned int cfeb) const {return _cfebHits[cfeb];}
+	unsigned int timeHits(unsigned int tbin) const {return _timeHits[tbin];} //comparators, time bins 0-15
+	unsigned int layersHit() const;
+	//at least the hits in half strips [lowHs, highHs] of _hits, from the cfebs they are in
+	unsigned int windowHits(int lowHs, int highHs) const;
+
 	bool shift(unsigned int lay) const;
 
 	int fill(const CSCInfo::Comparators& c);
@@ -278,6 +281,11 @@ private:
 
 	unsigned int _nCFEBs;
 
+	unsigned int _layerHits[NLAYERS];
+	unsigned int _cfebHits[MAX_CFEBS];
+	unsigned int _timeHits[16];
+	void count(unsigned int hs, unsigned int lay, int n);
+
 };
 
 class ALCT_ChamberHits
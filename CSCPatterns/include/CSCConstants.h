@@ -27,9 +27,6 @@ const unsigned int TIME_CAPTURE_WINDOW = 4; //allow for 4 consecutive time bins
 const unsigned int CFEB_HS = 32;
 const unsigned int MAX_CFEBS = 7; //in ME11
 
-const std::string LINEFIT_LUT_PATH = "/uscms/home/wnash/CSCUCLA/CSCPatterns/dat/linearFits.lut";
-//const std::string LINEFIT_LUT_PATH = "/home/wnash/workspace/CSCUCLA/CSCPatterns/dat/linearFits.lut";
-
 //labels of all envelopes
 const unsigned int NPATTERNS = 5;
 const unsigned int PATTERN_IDS[NPATTERNS] = {100,90,80,70,60};
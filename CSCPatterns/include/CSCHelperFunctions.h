@@ -17,7 +17,46 @@
 
 #include "../include/CSCInfo.h"
 
-bool validComparatorTime(const unsigned int time, const unsigned int startTimeWindow);
+/* @brief Parameters of the CLCT emulation, the TMB's by default. Passed down
+ * through searchForMatch, so several settings can run on the same hits
+ */
+struct CLCTConfig {
+	CLCTConfig() :
+		busyWindow(BUSY_WINDOW),
+		layerRequirement(N_LAYER_REQUIREMENT),
+		timeWindow(TIME_CAPTURE_WINDOW),
+		startTime(7),
+		maxCLCTs(0),
+		skipQuietRegions(false) {}
+
+	int busyWindow; //half strips blocked either side of a found clct, when it is used. Negative blocks nothing
+	unsigned int layerRequirement; //layers a clct needs
+	unsigned int timeWindow; //consecutive time bins a comparator hit can be in
+	unsigned int startTime; //first of them, time bins start at 1
+	unsigned int maxCLCTs; //stop once this many are found, the TMB sends 2. 0 finds all of them
+	//don't look where the hit counts of ChamberHits say no clct can be: fewer layers
+	// hit than required, or fewer hits in the cfebs under a pattern
+	bool skipQuietRegions;
+};
+
+/* @brief High multiplicity (shower) trigger on the comparator hits of a
+ * chamber, counted in a window of time bins, as the OTMB does
+ */
+struct ShowerConfig {
+	ShowerConfig() :
+		startTime(7),
+		timeWindow(TIME_CAPTURE_WINDOW) {
+		thresholds[0] = 20;
+		thresholds[1] = 30;
+		thresholds[2] = 40;
+	}
+
+	unsigned int startTime; //time bins start at 1, as CLCTConfig
+	unsigned int timeWindow;
+	unsigned int thresholds[3]; //comparator hits for a loose, nominal, tight shower
+};
+
+bool validComparatorTime(const unsigned int time, const unsigned int startTimeWindow, const unsigned int timeWindow=TIME_CAPTURE_WINDOW);
 
 int findClosestToSegment(vector<CLCTCandidate*> matches, float segmentX);
 
@@ -27,18 +66,26 @@ void printPattern(const CSCPattern &p);
 int printPatternCC(unsigned int pattID,int cc=-1);
 
 //calculates the overlap of a pattern on a chamber at a given position and time bin window, returns layers matched
-int getOverlap(const ChamberHits &c, const CSCPattern &p, const int horPos, const int startTimeWindow, bool overlap[NLAYERS][3]);
+int getOverlap(const ChamberHits &c, const CSCPattern &p, const int horPos, const int startTimeWindow, bool overlap[NLAYERS][3],
+		const unsigned int timeWindow=TIME_CAPTURE_WINDOW);
 
 //looks if a chamber "c" contains an envelope "p" at the location horPos returns
 //the number of matched layers
-int legacyLayersMatched(const ChamberHits &c, const CSCPattern &p, const int horPos, const int startTimeWindow);
+int legacyLayersMatched(const ChamberHits &c, const CSCPattern &p, const int horPos, const int startTimeWindow,
+		const unsigned int timeWindow=TIME_CAPTURE_WINDOW);
 
 //looks if a chamber "c" contains a pattern "p". returns -1 if error, and the number of matched layers if ,
 // run successfully, match info is stored in variable mi
-int containsPattern(const ChamberHits &c, const CSCPattern &p,  CLCTCandidate *&mi, const vector<CLCTCandidate*>& previousCandidates=vector<CLCTCandidate*>());
+int containsPattern(const ChamberHits &c, const CSCPattern &p,  CLCTCandidate *&mi, const vector<CLCTCandidate*>& previousCandidates=vector<CLCTCandidate*>(),
+		const CLCTConfig& config=CLCTConfig());
 
 //look for the best matched pattern, when we have a set of them, and return a vector possible of candidates
-int searchForMatch(const ChamberHits &c, const vector<CSCPattern>* ps, vector<CLCTCandidate*>& m, bool useBusyWindow=false);
+int searchForMatch(const ChamberHits &c, const vector<CSCPattern>* ps, vector<CLCTCandidate*>& m, bool useBusyWindow=false,
+		const CLCTConfig& config=CLCTConfig());
+
+//0 if the chamber isn't showering, 1-3 for a loose, nominal or tight shower. From the counts
+// ChamberHits::fill makes, so it costs nothing next to the emulation. -1 if config.startTime is 0
+int showerFlag(const ChamberHits& c, const ShowerConfig& config=ShowerConfig());
 
 //makes a LUT out of a properly formatted TTree
 int makeLUT(TTree* t, DetectorLUTs& newLUTs, DetectorLUTs& legacyLUTs);
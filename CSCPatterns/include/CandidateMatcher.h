@@ -0,0 +1,117 @@
+/*
+ * CandidateMatcher.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: agent
+ */
+
+#ifndef CSCPATTERNS_INCLUDE_CANDIDATEMATCHER_H_
+#define CSCPATTERNS_INCLUDE_CANDIDATEMATCHER_H_
+
+#include <vector>
+#include <functional>
+#include <math.h>
+
+using namespace std;
+
+/* @brief Where something to be matched sits: its chamber (hash) and
+ * position along it, half strips / strips / wire groups
+ */
+struct MatchKey {
+	MatchKey(float position_=0, int chamber_=0) : chamber(chamber_), position(position_) {}
+	int chamber;
+	float position;
+};
+
+struct MatchedPair {
+	unsigned int first; //index in the first collection
+	unsigned int second; //index in the second
+	float separation; //position of the first - position of the second
+};
+
+/* @brief Matches two collections, e.g. recorded and emulated CLCTs, or
+ * segments and ALCTs, by position within the same chamber. The second
+ * collection is sorted by chamber and position, so finding the closest
+ * is a binary search instead of a loop over everything. Only pairs closer
+ * than the tolerance are made, keys with a nan position never match.
+ * The collections aren't copied, each is read through a function
+ * giving the key of its i-th element
+ *
+ * 	NEAREST			- each of the first gets the closest of the second, which can be
+ * 					  shared, as findClosestToSegment. O(n log n)
+ * 	IN_ORDER		- each of the first, in order, takes the closest of the second not
+ * 					  already taken. O(n log n) for spread out positions
+ * 	CLOSEST_FIRST	- the closest of all pairs are made first, so a later one of the first
+ * 					  can't lose its match to an earlier, further one. O(m log m), m pairs
+ * 					  within the tolerance
+ *
+ * Ties go to the lowest index, as the loops this replaces did. Keep one
+ * around, the buffers are reused between calls
+ */
+class CandidateMatcher {
+public:
+	enum Mode {
+		NEAREST,
+		IN_ORDER,
+		CLOSEST_FIRST
+	};
+
+	typedef function<MatchKey(unsigned int i)> Key;
+
+	CandidateMatcher(Mode mode=CLOSEST_FIRST, float tolerance=INFINITY) :
+		_mode(mode), _tolerance(tolerance) {}
+
+	//pairs in order of the first index
+	void match(unsigned int nFirst, const Key& first, unsigned int nSecond, const Key& second, vector<MatchedPair>& pairs);
+
+	//index of the second matched to each of the first, -1 if none
+	void match(unsigned int nFirst, const Key& first, unsigned int nSecond, const Key& second, vector<int>& matchOfFirst);
+
+	Mode mode() const {return _mode;}
+	float tolerance() const {return _tolerance;}
+
+private:
+	struct Entry {
+		int chamber;
+		float position;
+		unsigned int index;
+		bool operator<(const Entry& e) const {
+			if(chamber != e.chamber) return chamber < e.chamber;
+			if(position != e.position) return position < e.position;
+			return index < e.index;
+		}
+	};
+
+	void sortSecond(unsigned int nSecond, const Key& second);
+	unsigned int lowerBound(const MatchKey& k) const;
+	int closer(const MatchKey& k, int left, int right) const;
+	int untakenRight(unsigned int i);
+	int untakenLeft(int i);
+
+	void nearest(unsigned int nFirst, const Key& first, vector<int>& matchOfFirst);
+	void inOrder(unsigned int nFirst, const Key& first, vector<int>& matchOfFirst);
+	void closestFirst(unsigned int nFirst, const Key& first, vector<int>& matchOfFirst);
+
+	Mode _mode;
+	float _tolerance;
+
+	vector<Entry> _second; //sorted
+	vector<unsigned int> _right; //next untaken at or after, union find
+	vector<int> _left; //next untaken at or before, -1 for none
+	struct Pair {
+		float distance;
+		unsigned int first;
+		unsigned int second;
+		bool operator<(const Pair& p) const {
+			if(distance != p.distance) return distance < p.distance;
+			if(first != p.first) return first < p.first;
+			return second < p.second;
+		}
+	};
+	vector<Pair> _pairs;
+	vector<char> _taken;
+	vector<int> _matches;
+};
+
+
+#endif /* CSCPATTERNS_INCLUDE_CANDIDATEMATCHER_H_ */
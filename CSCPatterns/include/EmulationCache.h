@@ -0,0 +1,120 @@
+/*
+ * EmulationCache.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: agent
+ */
+
+#ifndef CSCPATTERNS_INCLUDE_EMULATIONCACHE_H_
+#define CSCPATTERNS_INCLUDE_EMULATIONCACHE_H_
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+#include "CSCClasses.h"
+#include "CSCHelperFunctions.h"
+#include "Emulators.h"
+
+using namespace std;
+
+/* @brief What the emulation of one chamber is stored under
+ */
+struct EmulationKey {
+	EmulationKey(unsigned long long run_=0, unsigned long long event_=0, unsigned int chamberHash_=0,
+			unsigned long long version_=0) :
+		run(run_), event(event_), chamberHash(chamberHash_), version(version_) {}
+
+	unsigned long long run;
+	unsigned long long event;
+	unsigned int chamberHash;
+	unsigned long long version; //of the emulator, its patterns and settings, see EmulationCache::version
+
+	bool operator<(const EmulationKey& k) const;
+	bool operator==(const EmulationKey& k) const;
+};
+
+/* @brief Lookups made by one user of a shared cache, e.g. a worker,
+ * which can be merged and sent around with the rest of its results
+ */
+struct CacheLookups {
+	CacheLookups() : hits(0), misses(0) {}
+	unsigned long long hits;
+	unsigned long long misses;
+};
+
+/* @brief Emulator output kept on disk, so analyses run again over the
+ * same tuples don't emulate again. Each entry is what searchForMatch
+ * returned for a chamber and the candidates it found, keyed by run, event,
+ * chamber and a hash of the emulation (EmulationCache::version), so changing
+ * the patterns or settings misses instead of reading stale candidates.
+ *
+ * Lookups can run on several threads at once, so can put(). Entries put in
+ * a forked process (-p) aren't kept, only the process that opened the cache
+ * writes to it
+ *
+ * Format, native byte order
+ * 	magic "CSCEMC1", version
+ * 	then the entries: status, number of candidates (1 byte each) and the
+ * 	candidates, 5 x int32 each (key, pattern, code, layers, bx)
+ * 	then the index: run, event, version, chamber hash and offset of each entry,
+ * 	sorted, 40 bytes each
+ * 	then where the index starts, its size and the magic again
+ *
+ * The index is read on open(), new entries are written over it and the whole
+ * index after them on close(). A cache that wasn't closed is started over.
+ * Only one job can use a cache at a time, open() fails while another holds it
+ */
+class EmulationCache {
+public:
+	EmulationCache();
+	~EmulationCache();
+
+	//a file that doesn't exist is an empty cache. -1 if another job has it open
+	int open(const string& file);
+	//0 if it has the chamber, 1 if not
+	int get(const EmulationKey& key, int& status, vector<EmulatedCandidate>& found) const;
+	int put(const EmulationKey& key, int status, const vector<EmulatedCandidate>& found);
+	//writes the index, -1 if the cache couldn't be written
+	int close();
+
+	bool isOpen() const {return _state;}
+	unsigned long long hits() const;
+	unsigned long long misses() const;
+	unsigned long long size() const;
+	void printSummary() const;
+	//of the lookups of a user, e.g. those of forked workers, which this process didn't count
+	void printSummary(const CacheLookups& lookups) const;
+
+	//hash of everything the candidates of an emulation depend on
+	static unsigned long long version(const string& emulator, const vector<CSCPattern>* patterns,
+			bool useBusyWindow, const CLCTConfig& config);
+
+private:
+	string _file;
+	struct State; //the file, index and lock
+	State* _state;
+};
+
+/* @brief searchForMatch with a set of patterns and settings, through a cache
+ */
+class CachedCLCTSearch {
+public:
+	CachedCLCTSearch(const vector<CSCPattern>* patterns, bool useBusyWindow=false,
+			const CLCTConfig& config=CLCTConfig());
+
+	//as searchForMatch, the candidates come from the cache if it has the chamber,
+	// otherwise they are emulated and put in it. cache can be 0. Counts the lookup
+	// in lookups, if given
+	int find(EmulationCache* cache, unsigned long long run, unsigned long long event,
+			const ChamberHits& c, vector<CLCTCandidate*>& m, CacheLookups* lookups=0) const;
+
+private:
+	const vector<CSCPattern>* _patterns;
+	bool _useBusyWindow;
+	CLCTConfig _config;
+	unsigned long long _version;
+};
+
+
+#endif /* CSCPATTERNS_INCLUDE_EMULATIONCACHE_H_ */
@@ -0,0 +1,138 @@
+/*
+ * EmulationSweepAnalyzer.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: agent
+ */
+
+#ifndef CSCPATTERNS_INCLUDE_EMULATIONSWEEPANALYZER_H_
+#define CSCPATTERNS_INCLUDE_EMULATIONSWEEPANALYZER_H_
+
+#include "../include/Processor.h"
+#include "../include/CSCHelperFunctions.h"
+#include "../include/ALCTHelperFunctions.h"
+#include "../include/CandidateMatcher.h"
+#include "../include/Emulators.h"
+
+#include <string>
+#include <vector>
+
+class TH1;
+class TH1F;
+
+namespace CSCInfo {
+class Muons;
+class Segments;
+class Comparators;
+class Wires;
+}
+
+/* @brief One point of the sweep, e.g. "bw5 busy_window=5 drift_delay=3"
+ */
+struct SweepConfig {
+	string name;
+	CLCTConfig clct;
+	ALCTConfig alct;
+	ShowerConfig shower;
+};
+
+/* @brief What one configuration found, in one worker
+ */
+struct SweepResult {
+	SweepResult();
+
+	double clctSeconds; //in the emulation only
+	double alctSeconds;
+	unsigned long long clctChambers; //emulated
+	unsigned long long clctFailures; //couldn't be, several hits in one layer
+	unsigned long long clctCandidates;
+	unsigned long long alctChambers;
+	unsigned long long alctCandidates;
+
+	TH1F* clctMultiplicity; //per chamber with comparators
+	TH1F* alctMultiplicity; //per chamber with wires
+	TH1F* clctSegmentPt; //segments, the denominator of the efficiency
+	TH1F* clctMatchedPt; //those with a clct within the tolerance
+	TH1F* alctSegmentPt;
+	TH1F* alctMatchedPt;
+	TH1F* clctPosDiff; //segment - clct [strips]
+	TH1F* alctPosDiff; //segment - alct [wire groups]
+	TH1F* showerFlag; //per chamber with comparators, 0 none to 3 tight
+};
+
+/* @brief Runs the CLCT and ALCT emulation with several configurations
+ * (busy window, layer requirement, time window, clct cap, shower thresholds,
+ * ALCTConfig fields) over one
+ * pass of the input. The hits of each chamber are read and filled once, every
+ * configuration runs on the same ones, so each extra configuration only costs
+ * its emulation. Writes the efficiency to find a segment's CLCT / ALCT and the
+ * multiplicity of each configuration, in a directory named after it, and a
+ * summary tree. Runs through the event loop hooks, so -j N, -p N and
+ * --checkpoint work
+ *
+ * 	--sweep file		- configurations, one per line: name key=value ..., # comments
+ * 	--config "..."		- one configuration, as a line of the file, can be repeated
+ * 	--clct name			- clct emulator of Emulators.h (tmb), none to skip
+ * 	--alct name			- alct emulator (alct), none to skip
+ * 	--clct-tolerance x	- strips a segment's clct can be from it (1)
+ * 	--alct-tolerance x	- wire groups a segment's alct can be from it (2)
+ *
+ * Without configurations, the defaults are run
+ */
+class EmulationSweepAnalyzer : public Processor {
+public:
+	EmulationSweepAnalyzer();
+	~EmulationSweepAnalyzer();
+
+	//parses "name key=value key=value ...", -1 if malformed
+	static int parseConfig(const string& line, SweepConfig& config);
+
+protected:
+	int option(int argc, char* argv[], int i);
+	int setup();
+	Processor* makeWorker() const;
+	int beginWorker(TTree* t);
+	int processEntry(long long entry);
+	int mergeWorker(Processor* worker);
+	int writeOutput(const std::string& outputfile);
+	int writeCheckpoint(TDirectory* dir);
+	int readCheckpoint(TDirectory* dir);
+	bool supportsCheckpoint() const {return true;}
+
+private:
+	int readConfigs(const string& file);
+	TH1F* book(const string& name, const string& title, unsigned int bins, float low, float high);
+	void emulateCLCTs(unsigned int chamberHash);
+	void emulateALCTs(unsigned int chamberHash);
+
+	vector<SweepConfig> _configs;
+	string _clctName;
+	string _alctName;
+	const CLCTEmulator* _clct;
+	const ALCTEmulator* _alct;
+	float _clctTolerance;
+	float _alctTolerance;
+
+	//input branches
+	CSCInfo::Muons* _muons;
+	CSCInfo::Segments* _segments;
+	CSCInfo::Comparators* _comparators;
+	CSCInfo::Wires* _wires;
+
+	vector<SweepResult> _results; //by configuration
+	vector<TH1*> _hists;
+
+	//reused between chambers
+	CandidateMatcher _clctMatcher;
+	CandidateMatcher _alctMatcher;
+	vector<char> _hasComparators; //by chamber hash, in this entry
+	vector<char> _hasWires;
+	vector<float> _segmentPos;
+	vector<float> _segmentPt;
+	vector<EmulatedCandidate> _found;
+	vector<int> _matches;
+};
+
+
+
+#endif /* CSCPATTERNS_INCLUDE_EMULATIONSWEEPANALYZER_H_ */
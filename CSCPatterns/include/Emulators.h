@@ -0,0 +1,87 @@
+/*
+ * Emulators.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: agent
+ */
+
+#ifndef CSCPATTERNS_INCLUDE_EMULATORS_H_
+#define CSCPATTERNS_INCLUDE_EMULATORS_H_
+
+#include <string>
+#include <vector>
+#include <functional>
+
+#include "CSCClasses.h"
+#include "ALCTHelperFunctions.h"
+#include "CSCHelperFunctions.h"
+
+using namespace std;
+
+/* @brief What of a found CLCT / ALCT has to agree between two
+ * emulator implementations
+ */
+struct EmulatedCandidate {
+	EmulatedCandidate(int key_=0, int pattern_=0, int code_=-1, int layers_=0, int bx_=0) :
+		key(key_), pattern(pattern_), code(code_), layers(layers_), bx(bx_) {}
+
+	int key; //key half strip of a clct, key wire group of an alct
+	int pattern;
+	int code; //comparator code id, -1 for legacy patterns and alcts
+	int layers; //layers matched, the quality of an alct
+	int bx; //start time of a clct, first bx of an alct
+
+	bool operator==(const EmulatedCandidate& c) const {
+		return key == c.key && pattern == c.pattern && code == c.code && layers == c.layers && bx == c.bx;
+	}
+	bool operator!=(const EmulatedCandidate& c) const {return !(*this == c);}
+};
+
+/* @brief One way of finding the CLCTs of a chamber, with the given TMB
+ * parameters. Fills the candidates best first and returns what searchForMatch
+ * would, -1 if the chamber couldn't be emulated (i.e. several hits in one
+ * layer of an envelope)
+ */
+struct CLCTEmulator {
+	CLCTEmulator() : maxCandidates(0) {}
+	string name;
+	string description;
+	unsigned int maxCandidates; //most it reports, as the TMB sends out 2. 0 if it finds all of them
+	function<int(const ChamberHits& c, const CLCTConfig& config, vector<EmulatedCandidate>& found)> find;
+};
+
+/* @brief One way of finding the ALCTs of a chamber, from the 16 time bin
+ * images ALCT_ChamberHits::fill(wires, tbin) makes, best first
+ */
+struct ALCTEmulator {
+	string name;
+	string description;
+	function<int(vector<ALCT_ChamberHits*>& tbins, ALCTConfig& config, vector<EmulatedCandidate>& found)> find;
+};
+
+/* @brief Registry of the emulator implementations, by name, so a faster
+ * path can be checked against the reference one (see EmulatorEquivalenceChecker).
+ * The first of each is the reference, as TMBEmulationTester and
+ * ALCTEmulationTreeCreator run it
+ */
+class Emulators {
+public:
+	static const vector<CLCTEmulator>& clct();
+	static const vector<ALCTEmulator>& alct();
+
+	//0 if there is no such implementation
+	static const CLCTEmulator* findCLCT(const string& name);
+	static const ALCTEmulator* findALCT(const string& name);
+
+	//returns -1 if the name is taken. Add before looking any up, the pointers
+	// findCLCT / findALCT return don't survive it
+	static int add(const CLCTEmulator& e);
+	static int add(const ALCTEmulator& e);
+
+	//what the emulators report of the classes they run on
+	static EmulatedCandidate candidate(const CLCTCandidate& c);
+	static EmulatedCandidate candidate(const ALCTCandidate& c);
+};
+
+
+#endif /* CSCPATTERNS_INCLUDE_EMULATORS_H_ */
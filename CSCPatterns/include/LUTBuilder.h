@@ -9,9 +9,63 @@
 #define CSCPATTERNS_INCLUDE_LUTBUILDER_H_
 
 #include "../include/Processor.h"
+#include "../include/CandidateMatcher.h"
+#include "../include/EmulationCache.h"
 
+#include <vector>
+
+class LUT;
+class CSCPattern;
+
+namespace CSCInfo {
+class Event;
+class Muons;
+class Segments;
+class Comparators;
+}
+
+/* @brief Builds the LUT out of the segments matched to the emulated clcts.
+ * Runs through the Processor event loop hooks, so can be split over threads
+ * (-j N) or processes (-p N): each worker fills its own copy of the line fit
+ * LUT, and the clcts of each are added in order of their entry ranges.
+ * With --checkpoint, the clcts added to it so far are saved and resumed from
+ */
 class LUTBuilder : public  Processor {
-	int run(std::string inputfile, std::string outputfile, int start=0, int end=-1);
+public:
+	LUTBuilder();
+	~LUTBuilder();
+
+protected:
+	int setup();
+	Processor* makeWorker() const;
+	int beginWorker(TTree* t);
+	int processEntry(long long entry);
+	int mergeWorker(Processor* worker);
+	int writeOutput(const std::string& outputfile);
+	int writeCheckpoint(TDirectory* dir);
+	int readCheckpoint(TDirectory* dir);
+	bool supportsCheckpoint() const {return true;}
+
+private:
+	//shared between workers, owned by the processor that ran setup()
+	bool _ownsShared;
+	LUT* _lineFits; //what each worker's LUT starts from
+	vector<CSCPattern>* _newPatterns;
+	vector<CSCPattern>* _oldPatterns;
+	EmulationCache* _cache; //0 without --emulation-cache
+	CachedCLCTSearch* _newSearch;
+	CachedCLCTSearch* _oldSearch;
+
+	//input branches
+	CSCInfo::Event* _evt;
+	CSCInfo::Muons* _muons;
+	CSCInfo::Segments* _segments;
+	CSCInfo::Comparators* _comparators;
+
+	LUT* _lut; //being built by this worker
+	CacheLookups _cacheLookups;
+	//each segment with the closest clct, as findClosestToSegment
+	CandidateMatcher _matcher;
 };
 
 
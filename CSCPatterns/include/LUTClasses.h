@@ -10,6 +10,7 @@
 
 #include <set>
 #include <map>
+#include <vector>
 #include <string>
 #include <iterator>
 #include <utility> //pair
@@ -20,6 +21,8 @@
 
 #include "TTree.h"
 
+class TDirectory;
+
 #include "../include/CSCClasses.h"
 
 
@@ -64,6 +67,7 @@ public:
 	 */
 
 	int loadTree(TTree* tree);
+	int addTree(TTree* tree); //as loadTree, without finalizing
 	int addCLCT(unsigned int multiplicity=1, float pt=-1.,float posOffset=-999., float slopeoffset=-999.); //no associated segment
 
 	bool operator<(const LUTEntry& l) const;
@@ -76,6 +80,9 @@ public:
 	float quality() const;
 	float probability() const;
 	float multiplicity() const; //calculates average multiplicity for how many clcts it is associated with
+	unsigned int rank() const; //quality rank within its LUT, lower is better
+
+	static const unsigned int NO_RANK = 0xffffffff;
 
 	TTree* makeTree(const string& name) const;
 
@@ -87,6 +94,7 @@ public:
 	const float _chi2; //chi2 of fit
 
 private:
+	friend class LUT;
 	bool _isFinal; //if we have already calculated the offsets with all the segments
 	/*
 	 * TODO: Nov 13
@@ -110,6 +118,7 @@ private:
 
 	float _quality; //quality parameter used choose between CLCTs
 
+	unsigned int _rank; //set by LUT::makeFinal()
 };
 
 
@@ -138,81 +147,118 @@ public:
 
 	int loadROOT(const string& rootfile);
 	int loadText(const string& textfile);
+	int loadLinearFits();
 	int writeToText(const string& filename);
 	int writeToROOT(const string& filename);
 	int writeToPSLs(const string& fileprefix);
+	//the clcts added so far, not finalized, for a job building the LUT to go on from
+	int writeCLCTs(TDirectory* dir) const;
+	int loadCLCTs(TDirectory* dir);
+	//appends the clcts of another LUT being built, e.g. over the entries following this one's
+	int addCLCTs(const LUT& l);
+	int encodePSLs(vector<unsigned int>& words);
+	int loadPSLs(const string& fileprefix);
 	int makeFinal();
 	int sort(const string& sortOrder);
 	int size() const {return _orderedLUT.size();}
 
 	int nclcts();
 	int nsegments();
+	bool isFinal() const {return _isFinal;}
+
+	/* @brief Iterates through the LUT in the order given by the
+	 * sort string, dereferencing straight into the underlying map
+	 */
+	class const_iterator {
+	public:
+		typedef forward_iterator_tag iterator_category;
+		typedef const pair<const LUTKey, LUTEntry> value_type;
+		typedef ptrdiff_t difference_type;
+		typedef value_type* pointer;
+		typedef value_type& reference;
+
+		const_iterator(const LUT* lut, vector<unsigned int>::const_iterator it) :
+			_lut(lut), _it(it) {}
+
+		reference operator*() const {return *(_lut->_entries[*_it]);}
+		pointer operator->() const {return &(*(_lut->_entries[*_it]));}
+		const_iterator& operator++() {++_it; return *this;}
+		const_iterator operator++(int) {const_iterator tmp(*this); ++_it; return tmp;}
+		bool operator==(const const_iterator& o) const {return _it == o._it;}
+		bool operator!=(const const_iterator& o) const {return _it != o._it;}
+	private:
+		const LUT* _lut;
+		vector<unsigned int>::const_iterator _it;
+	};
+
+	LUT(const LUT& l);
+
 private:
 	bool _isFinal;
 	const bool _isLegacy;
 	int _nclcts;
 	int _nsegments;
 	string _sortOrder;
-	/* @brief Lambda function used to optimize LUTEntrys in the set,
-	 * mostly for printing
+
+	/* @brief Sort string compiled into a chain of fields,
+	 * which are looked up once per entry rather than
+	 * once per comparison
+	 *
+	 * p = probability, s = nsegments, c = nclcts, l = layers
+	 * m = multiplicity, x = chi2, e = pt, k = key
 	 */
-	typedef function<bool(pair<LUTKey,LUTEntry>, pair<LUTKey,LUTEntry>)> LUTLambda;
-	LUTLambda _lutFunc =
-			[this](pair<LUTKey,LUTEntry> l1, pair<LUTKey,LUTEntry> l2)
-			{
-
-			//cout << "sorting: l1.pat: "<< l1.first._pattern << " l1.code: " << l1.first._code << " l2.pat" << l2.first._pattern <<
-			//		" l2.code: " << l2.first._code << endl;
-			//return l1.first < l2.first;
-			//TODO: some bug here, doesn't work for first lut??
-			//May 14: Ignoring old warning, not sure where this would be happening, will keep an eye out
-			auto& l1e = l1.second;
-			auto& l2e = l2.second;
-			for(auto c: _sortOrder){
-				//cout << c << endl;
-				switch (c) {
-				case 'p':
-					if(l1e.probability() == l2e.probability()) continue;
-					return l1e.probability() > l2e.probability();
-				case 's':
-					if(l1e.nsegments() == l2e.nsegments()) continue;
-					return l1e.nsegments() > l2e.nsegments();
-				case 'c':
-					if(l1e.nclcts() == l2e.nclcts()) continue;
-					return l1e.nclcts() > l2e.nclcts();
-				case 'l':
-					if(l1e._layers == l2e._layers) continue;
-					return l1e._layers > l2e._layers;
-				case 'm':
-					if(l1e.multiplicity() == l2e.multiplicity()) continue;
-					return l1e.multiplicity() > l2e.multiplicity();
-				case 'x': //x^2
-					if(l1e._chi2 == l2e._chi2) continue;
-					return l1e._chi2 < l2e._chi2;
-				case 'e': //energy
-					if(l1e.pt() == l2e.pt()) continue;
-					return l1e.pt() > l2e.pt();
-				case 'k': //key
-					if(l1.first == l2.first) continue;
-					return l1.first < l2.first;
-				default:
-					return l1.second < l2.second;
-				}
-			}
-			return false;
-		};
-
-
-	set<pair<LUTKey, LUTEntry>, LUTLambda> _orderedLUT;
+	vector<char> _sortChain;
+	static int compileSortOrder(const string& sortOrder, vector<char>& chain);
+	int rankEntries();
+	static double sortValue(char field, const LUTKey& k, const LUTEntry& e);
+	int order();
+
 	map<LUTKey,LUTEntry> _lut;
+	//entries of _lut, in key order, and the permutation of them we iterate with
+	vector<map<LUTKey,LUTEntry>::const_iterator> _entries;
+	vector<unsigned int> _orderedLUT;
 
 	static int convertToPSLLine(const LUTEntry& e);
 
 public:
-	set<pair<LUTKey, LUTEntry>, LUTLambda>::iterator begin() {return _orderedLUT.begin();}
-	set<pair<LUTKey, LUTEntry>, LUTLambda>::iterator end() {return _orderedLUT.end();}
+	static LUTEntry convertFromPSLLine(unsigned int word);
+	static int writePSLWords(const string& fileprefix, const vector<unsigned int>& words);
+	static int readPSLs(const string& fileprefix, vector<unsigned int>& words);
+	static int comparePSLs(const string& prefix1, const string& prefix2, bool verbose=true);
+
+	const_iterator begin() const {return const_iterator(this, _orderedLUT.begin());}
+	const_iterator end() const {return const_iterator(this, _orderedLUT.end());}
+
+
+};
+
+/* @brief Position and slope of each entry of a LUT, quantized
+ * to a given amount of bits with the same scheme used in the PSLs
+ */
+class QuantizedLUT {
+public:
+	QuantizedLUT(unsigned int positionBits, unsigned int slopeBits);
 
+	~QuantizedLUT() {}
+
+	int fill(const LUT& lut);
+	int getEntry(const LUTKey& k, float& position, float& slope) const;
+
+	static unsigned int positionToBits(float position, unsigned int nBits);
+	static float bitsToPosition(unsigned int bits, unsigned int nBits);
+	static unsigned int slopeToBits(float slope, unsigned int nBits);
+	static float bitsToSlope(unsigned int bits, unsigned int nBits);
+
+	const unsigned int _positionBits;
+	const unsigned int _slopeBits;
+
+private:
+	static int getIndex(const LUTKey& k);
 
+	//indexed by pattern (as in PATTERN_IDS) and comparator code
+	vector<float> _position;
+	vector<float> _slope;
+	vector<bool> _hasEntry;
 };
 
 class DetectorLUTs {
@@ -222,13 +268,16 @@ public:
 
 	~DetectorLUTs(){};
 
+	//without a path, non-legacy LUTs are filled with line fits
 	int addEntry(const string& name, int station, int ring,
 			const string& lutpath = "");
 	int editLUT(int station, int ring, LUT*& lut);
 	int getLUT(int station, int ring, const LUT*& lut) const;
 	int makeFinal();
 	int writeAll(const string& path);
+	int writeAllPSLs(const string& path);
 	int loadAll(const string& path);
+	static int compareAllPSLs(const string& path1, const string& path2, bool verbose=true);
 	unsigned int size() const;
 
 private:
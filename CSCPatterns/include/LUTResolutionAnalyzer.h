@@ -9,9 +9,143 @@
 #define CSCPATTERNS_INCLUDE_LUTRESOLUTIONANALYZER_H_
 
 #include "../include/Processor.h"
+#include "../include/CandidateMatcher.h"
+#include "../include/EmulationCache.h"
 
+#include <map>
+#include <vector>
+#include <utility>
+
+class TTree;
+class TH1;
+class TH1F;
+class DetectorLUTs;
+class QuantizedLUT;
+class CSCPattern;
+
+namespace CSCInfo {
+class Event;
+class Muons;
+class Segments;
+class RecHits;
+class LCTs;
+class CLCTs;
+class Comparators;
+}
+
+/* @brief Runs through the Processor event loop hooks, so can be
+ * split over threads with -j N. LUTs and patterns are loaded once
+ * in setup() and shared, read only, by all the workers
+ *
+ * 	--bit-budgets 4:5,5:5	- position:slope bits to quantize the LUTs to,
+ * 							  each giving its residuals and resolution
+ */
 class LUTResolutionAnalyzer : public  Processor {
-	int run(std::string inputfile, std::string outputfile, int start=0, int end=-1);
+public:
+	LUTResolutionAnalyzer();
+	~LUTResolutionAnalyzer();
+
+protected:
+	int option(int argc, char* argv[], int i);
+	int setup();
+	Processor* makeWorker() const;
+	int beginWorker(TTree* t);
+	int processEntry(long long entry);
+	int mergeWorker(Processor* worker);
+	int writeOutput(const std::string& outputfile);
+	int writeCheckpoint(TDirectory* dir);
+	int readCheckpoint(TDirectory* dir);
+	bool supportsCheckpoint() const {return true;}
+
+private:
+	TH1F* book(const std::string& name, const std::string& title, unsigned int bins, float low, float high);
+	int writePlotTreeChunk(const std::string& file);
+	int readPlotTreeChunks(const std::string& file, long long chunks, long long entries);
+
+	//shared between workers, owned by the processor that ran setup()
+	bool _ownsShared;
+	DetectorLUTs* _newLUTs;
+	DetectorLUTs* _legacyLUTs;
+	map<pair<int,int>, vector<QuantizedLUT> >* _quantizedLUTs;
+	vector<CSCPattern>* _newPatterns;
+	vector<CSCPattern>* _oldPatterns;
+	EmulationCache* _cache; //0 without --emulation-cache
+	CachedCLCTSearch* _newSearch;
+	CachedCLCTSearch* _oldSearch;
+
+	//input branches
+	CSCInfo::Event* _evt;
+	CSCInfo::Muons* _muons;
+	CSCInfo::Segments* _segments;
+	CSCInfo::RecHits* _recHits;
+	CSCInfo::LCTs* _lcts;
+	CSCInfo::CLCTs* _clcts;
+	CSCInfo::Comparators* _comparators;
+
+	//output tree
+	TTree* _plotTree;
+	//of its entries, those already in the chunks of the checkpoint data, see writeCheckpoint
+	long long _plotTreeChunks;
+	long long _plotTreeSaved;
+	int _patternId;
+	int _ccId;
+	int _legacyLctId;
+	int _EC; // 1-2
+	int _ST; // 1-4
+	int _RI; // 1-4
+	int _CH;
+	float _pt;
+	float _segmentX;
+	float _segmentdXdZ;
+	float _patX;
+	float _legacyLctX;
+
+	//every histogram booked by this worker, in booking order, used for merging
+	vector<TH1*> _hists;
+
+	TH1F* _lutSegmentPosDiff;
+	TH1F* _lutSegmentPosDiff_halfStrip;
+	TH1F* _lutSegmentPosDiff_quarterStrip;
+	TH1F* _lutSegmentPosDiff_eighthStrip;
+	TH1F* _lutSegmentPosDiff_sixteenthStrip;
+	TH1F* _lutSegmentSlopeDiff;
+
+	vector<pair<unsigned int, unsigned int> > _bitBudgets; //position, slope bits
+	vector<TH1F*> _bitBudgetPosDiff;
+	vector<TH1F*> _bitBudgetSlopeDiff;
+	//running sums for the resolution summary
+	vector<double> _bitBudgetN;
+	vector<double> _bitBudgetPosSum;
+	vector<double> _bitBudgetPosSum2;
+	vector<double> _bitBudgetSlopeSum;
+	vector<double> _bitBudgetSlopeSum2;
+
+	map<pair<int,int>, TH1F*> _lutChamberPlots_Pos;
+	map<pair<int,int>, TH1F*> _lutChamberPlots_legacy_Pos; //emulated
+	map<pair<int,int>, TH1F*> _lutChamberPlots_Slope;
+	map<pair<int,int>, TH1F*> _lutChamberPlots_legacy_Slope;
+	map<int, TH1F*> _legacyPatterns_pos; //emulated
+	map<int, TH1F*> _legacyPatterns_pos_real;
+	map<int, TH1F*> _legacyPatterns_slope;
+
+	TH1F* _legacyLUTSegmentPosDiff;
+	TH1F* _legacyLUTSegmentSlopeDiff;
+	TH1F* _clctLayerCount;
+
+	//looks at region of pt [0 - entry1, entry1- entry2, etc]
+	vector<float> _ptRanges;
+	map<float, TH1F*> _ccPos_pt;
+	map<float, TH1F*> _ccSlope_pt;
+	map<float, TH1F*> _legacyPos_pt;
+	map<float, TH1F*> _legacySlope_pt;
+
+	unsigned int _nChambersRanOver;
+	unsigned int _nChambersMultipleInOneLayer;
+	//of this worker, summed up for the summary, as forked workers count in their own copy of the cache
+	CacheLookups _cacheLookups;
+
+	//the segment with the closest of the candidates, one per worker
+	CandidateMatcher _matcher;
 };
 
 
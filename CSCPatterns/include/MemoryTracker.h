@@ -0,0 +1,67 @@
+/*
+ * MemoryTracker.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: agent
+ */
+
+#ifndef CSCPATTERNS_INCLUDE_MEMORYTRACKER_H_
+#define CSCPATTERNS_INCLUDE_MEMORYTRACKER_H_
+
+#include <string>
+#include <vector>
+
+using namespace std;
+
+/* @brief Heap use of one stage
+ */
+struct MemoryStats {
+	unsigned long long calls;
+	unsigned long long allocs;
+	unsigned long long frees;
+	unsigned long long bytesAllocated;
+	unsigned long long bytesFreed;
+};
+
+/* @brief Opt in (--mem) accounting of the heap, per STAGE_TIMER stage.
+ * Replaces the global operator new / delete, which only count while it is
+ * on. Allocations go to the innermost stage of the thread doing them, and
+ * each block keeps that stage in a 16 byte header in front of it, so its
+ * free goes to the same stage whichever stage or thread frees it: live
+ * objects of a stage are those it made that are still around. Also samples
+ * the resident set size of the process
+ */
+class MemoryTracker {
+public:
+	//stage ids above this are counted as outside any stage
+	static const unsigned int MAX_STAGES = 256;
+
+	static void setEnabled(bool enabled);
+	static bool enabled();
+
+	//returns the stage it replaces, to be given back to leaveStage
+	static int enterStage(unsigned int stage);
+	static void leaveStage(int previous);
+
+	//drops what was counted so far, i.e. what a forked child got from its parent
+	static void clear();
+
+	//current resident set size [bytes], also kept for the peak. Sampled by itself
+	// every 1000 calls of the "read" stage
+	static long long sampleRSS();
+
+	//per stage, merged over threads. The last entry is everything outside a stage
+	static void summary(vector<string>& names, vector<MemoryStats>& stats);
+	/* @brief Stages called at least once per entry, which allocate every
+	 * time, are those in the event loop worth fixing. Without entries,
+	 * the calls of the "read" stage are counted as entries
+	 */
+	static void print(long long entries);
+
+	//stages of a forked child, read back by its parent
+	static int send(int fd);
+	static int receive(int fd);
+};
+
+
+#endif /* CSCPATTERNS_INCLUDE_MEMORYTRACKER_H_ */
@@ -0,0 +1,91 @@
+/*
+ * MismatchLog.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: agent
+ */
+
+#ifndef CSCPATTERNS_INCLUDE_MISMATCHLOG_H_
+#define CSCPATTERNS_INCLUDE_MISMATCHLOG_H_
+
+#include <stdio.h>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+#include "CSCClasses.h"
+#include "Emulators.h"
+
+using namespace std;
+
+/* @brief A recorded CLCT the emulation didn't find exactly, with the
+ * CLCTs emulated in its chamber and the chamber's comparator hits
+ */
+struct Mismatch {
+	Mismatch() : entry(-1), run(0), event(0), chamberHash(0), closest(-1) {}
+
+	long long entry;
+	unsigned long long run;
+	unsigned long long event;
+	unsigned int chamberHash;
+	EmulatedCandidate recorded; //key in half strips, code is -1
+	int closest; //index of the emulated one it was matched to, -1 if none
+	vector<EmulatedCandidate> emulated;
+	vector<uint8_t> hits; //half strip, layer, time+1 of each hit, as ChamberHits::_hits
+
+	void setHits(const ChamberHits& c);
+	//c should be empty, made for the chamber of chamberHash
+	void getHits(ChamberHits& c) const;
+};
+
+/* @brief Writes mismatches to a compact binary log. write() only copies
+ * the mismatch into a buffer, full buffers are written to the file on a
+ * background thread, so a job with many mismatches isn't held up by its
+ * output. Read back with MismatchLogReader, or print with ./MismatchPrinter
+ *
+ * Format, native byte order
+ * 	magic "CSCMIS1", version
+ * 	then for each mismatch: a 40 byte record (entry, run, event, chamber hash,
+ * 	closest, number of emulated CLCTs and hits), the recorded and emulated
+ * 	candidates, 5 x int32 each (key, pattern, code, layers, bx) and 3 bytes
+ * 	for each hit
+ */
+class MismatchLogWriter {
+public:
+	static const unsigned int DEFAULT_BUFFER_SIZE = 4 << 20; //bytes
+
+	MismatchLogWriter(unsigned int bufferSize = DEFAULT_BUFFER_SIZE);
+	~MismatchLogWriter();
+
+	int open(const string& file);
+	int write(const Mismatch& m);
+	//writes what's left and waits for the file to be written, -1 if any of it couldn't be
+	int close();
+
+	unsigned long long written() const {return _written;}
+
+private:
+	unsigned int _bufferSize;
+	unsigned long long _written;
+	vector<char> _buffer; //filled by write()
+
+	struct Background; //the thread, and the buffer it is writing
+	Background* _background;
+};
+
+class MismatchLogReader {
+public:
+	MismatchLogReader() : _in(0) {}
+	~MismatchLogReader() {close();}
+
+	int open(const string& file);
+	//0 if read, 1 at the end of the log, -1 if it is cut short
+	int next(Mismatch& m);
+	void close();
+
+private:
+	FILE* _in;
+};
+
+
+#endif /* CSCPATTERNS_INCLUDE_MISMATCHLOG_H_ */
@@ -0,0 +1,53 @@
+/*
+ * PerfCounters.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: agent
+ */
+
+#ifndef CSCPATTERNS_INCLUDE_PERFCOUNTERS_H_
+#define CSCPATTERNS_INCLUDE_PERFCOUNTERS_H_
+
+#include <string>
+#include <vector>
+#include <chrono>
+
+using namespace std;
+
+/* @brief Reading of the counters of a thread, at the start of a stage
+ */
+struct PerfSample {
+	static const unsigned int N_EVENTS = 6;
+	unsigned long long values[N_EVENTS];
+	unsigned long long enabled; //ns the group was enabled / on the cpu, to
+	unsigned long long running; //scale for multiplexing
+	chrono::steady_clock::time_point time;
+};
+
+/* @brief Opt in (--perf) hardware counters of the STAGE_TIMER stages, so
+ * e.g. the clct search of one chamber gets its cycles, instructions, cache
+ * and branch misses. Uses a perf_event_open group per thread, which only
+ * counts that thread. If the counters can't be opened (perf_event_paranoid,
+ * containers, VMs) the stages are still timed
+ */
+class PerfCounters {
+public:
+	enum Event {CYCLES, INSTRUCTIONS, CACHE_REFERENCES, CACHE_MISSES, BRANCHES, BRANCH_MISSES};
+
+	static void setEnabled(bool enabled);
+	static bool enabled();
+
+	static void begin(PerfSample& sample);
+	static void end(unsigned int stage, const PerfSample& begin);
+
+	//closes the counters of this thread and drops the totals, for forked children
+	static void clear();
+	static void print();
+
+	//stages of a forked child, read back by its parent
+	static int send(int fd);
+	static int receive(int fd);
+};
+
+
+#endif /* CSCPATTERNS_INCLUDE_PERFCOUNTERS_H_ */
@@ -0,0 +1,125 @@
+/*
+ * PlotTreeStats.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: agent
+ */
+
+#ifndef CSCPATTERNS_INCLUDE_PLOTTREESTATS_H_
+#define CSCPATTERNS_INCLUDE_PLOTTREESTATS_H_
+
+#include <vector>
+#include <map>
+#include <string>
+#include <utility>
+
+class TTree;
+class TH1D;
+
+using namespace std;
+
+/* @brief Histograms of many keys in one block, filled as TH1D would be:
+ * row k of counts is the underflow, bins and overflow of key k, and stats
+ * holds its sums of w, w^2, wx, wx^2 over the fills in range (TH1::GetStats)
+ */
+class HistogramBlock {
+public:
+	HistogramBlock(unsigned int bins=200, double low=-1., double high=1.);
+
+	void resize(unsigned int keys);
+	void fill(unsigned int key, double x);
+	unsigned int keys() const {return entries.size();}
+
+	//a TH1D with the contents and statistics key would have had, filled directly
+	TH1D* makeHist(unsigned int key, const string& name, const string& title) const;
+
+	unsigned int bins;
+	double low;
+	double high;
+	vector<double> counts; //keys x (bins+2)
+	vector<double> entries; //by key
+	vector<double> stats; //keys x 4
+};
+
+/* @brief Everything the LUT scripts work out of one kind of key: the
+ * pattern and comparator code of the new patterns (code -1 for the others),
+ * in the order they first show up in the tree
+ */
+class KeyStats {
+public:
+	KeyStats(unsigned int bins=200, double low=-1., double high=1.);
+
+	//-1 if it isn't in the tree
+	int index(int pattern, int code=-1) const;
+	unsigned int size() const {return pattern.size();}
+
+	vector<int> pattern;
+	vector<int> code;
+	vector<double> n; //segments
+	vector<double> positionMean; //segment - pattern [strips]
+	vector<double> positionRMS;
+	vector<double> slopeMean; //segment [strips/layer]
+	vector<double> slopeRMS;
+
+	//with bins, segment - pattern and slope, shifted by the mean of their key and not
+	HistogramBlock position;
+	HistogramBlock slope;
+	HistogramBlock unshiftedPosition;
+	HistogramBlock unshiftedSlope;
+
+private:
+	friend class PlotTreeStats;
+	void clear();
+	unsigned int add(int pattern, int code);
+	void addSegment(unsigned int key, double position, double slope);
+	void finish();
+	void fillHists(unsigned int key, double position, double slope);
+
+	map<pair<int,int>, unsigned int> _index;
+	vector<double> _positionSum2;
+	vector<double> _slopeSum2;
+};
+
+/* @brief Reads the plotTree of the resolution analyzers (LUTResolutionAnalyzer,
+ * CLCTMatch files) once, in C++, into the per key statistics and histograms
+ * the python scripts used to build entry by entry, for all the keys at once:
+ * comparator codes (patternId, ccId), patterns (patternId) and legacy
+ * patterns (legacyLctId). Means and RMSs are summed in tree order, as the
+ * scripts did, so they come out the same.
+ *
+ * From python, after gSystem.Load('../lib/PlotTreeStats_cpp'):
+ *
+ * 	stats = r.PlotTreeStats()
+ * 	stats.fill(tree, station, ring)
+ * 	means = np.asarray(stats.cc.positionMean) #no copy, valid while stats is
+ *
+ * Histograms of key k are row k of e.g. stats.cc.position.counts, or
+ * stats.cc.position.makeHist(k, name, title) as a TH1D
+ */
+class PlotTreeStats {
+public:
+	//bins = 0 for the statistics only
+	PlotTreeStats(unsigned int bins=200, double low=-1., double high=1.);
+
+	/* @brief Segments of station and ring, 0 for any, as validEvent in the
+	 * scripts. matchedOnly skips those without a comparator code (ccId -1),
+	 * as createLUT.py. Starts over each call, chain the files to add them up.
+	 * -1 if the tree doesn't have the branches
+	 */
+	int fill(TTree* tree, int station=0, int ring=0, bool matchedOnly=false);
+
+	KeyStats cc;
+	KeyStats patterns;
+	KeyStats legacy;
+
+	//comparator codes found against segments used, every growthStep segments
+	unsigned int growthStep;
+	vector<double> growthSegments;
+	vector<double> growthCodes;
+
+	unsigned long long entries; //read
+	unsigned long long segments; //used
+};
+
+
+#endif /* CSCPATTERNS_INCLUDE_PLOTTREESTATS_H_ */
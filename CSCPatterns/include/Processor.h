@@ -10,20 +10,173 @@
 
 #include <string>
 #include <iostream>
+#include <vector>
+#include <map>
+#include <utility>
+
+class TTree;
+class TChain;
+class TDirectory;
 
 using namespace std;
 
+/* @brief Base class of the analyzers. Either override run(), which owns
+ * the whole job, or implement the hooks below and let the Processor run
+ * the event loop, which can then be split over several threads (-j N)
+ * or local processes (-p N).
+ *
+ * With the hooks, the input can be a comma separated list of files,
+ * each of which can be a glob (quote it), all read as one chain
+ */
 class Processor{
 public:
-	Processor(){};
-	virtual int run(std::string inputfile, std::string outputfile, int start=0, int end=-1){
-		std::cout << "Defined run function in derived class" << std::endl;
-		return -1;
-	};
+	Processor() : _checkpointEvery(100000) {};
+	virtual int run(std::string inputfile, std::string outputfile, int start=0, int end=-1);
 	virtual ~Processor(){}
 
 	//effectively runs main for each processor
 	int main(int argc, char* argv[]);
+
+	/* @brief Runs the event loop over [start,end) split into nThreads
+	 * contiguous ranges, each with its own worker (see makeWorker).
+	 * nThreads = 0 uses all available cores
+	 */
+	int runParallel(const std::string& inputfile, const std::string& outputfile,
+			int start=0, int end=-1, unsigned int nThreads=1);
+
+	/* @brief Forks nProcs processes over [start,end), each sending back what
+	 * its worker did through writeCheckpoint / readCheckpoint, which are merged
+	 * and written to outputfile once, as with threads. nProcs = 0 uses all
+	 * available cores
+	 */
+	int runForked(const std::string& inputfile, const std::string& outputfile,
+			int start=0, int end=-1, unsigned int nProcs=1);
+
+	/* @brief How the event loop reads its input, set from the command line
+	 *
+	 * --cache MB				- TTreeCache size, 0 disables it (default: root's)
+	 * --cache-branches b1,b2	- branches to cache (wildcards ok), otherwise learnt
+	 * --learn N				- entries in the cache learning phase
+	 * --prefetch				- asynchronous prefetching of the next baskets
+	 * --unzip					- decompress baskets on a helper thread
+	 */
+	struct ReadOptions {
+		ReadOptions() : cacheSize(-1), learnEntries(100), prefetch(false), parallelUnzip(false) {}
+		long long cacheSize; //bytes, -1 for root's default
+		std::vector<std::string> cacheBranches;
+		int learnEntries;
+		bool prefetch;
+		bool parallelUnzip;
+	};
+	ReadOptions _readOptions;
+
+	//--emulation-cache file, for the analyzers that emulate CLCTs (see EmulationCache.h)
+	std::string _emulationCache;
+
+	/* @brief Checkpoints of long jobs, set from the command line
+	 *
+	 * --checkpoint file		- every so many entries, writes what the job has done so far
+	 * 							  to file (file.<i> for each of -j / -p i), and starts from
+	 * 							  there if it already exists. Removed once the output is written
+	 * --checkpoint-every N	- entries between checkpoints (100000)
+	 *
+	 * Only processors implementing writeCheckpoint / readCheckpoint (see supportsCheckpoint)
+	 * take --checkpoint.
+	 * A job has to be resumed with the same input, range and -j / -p
+	 */
+	std::string _checkpointFile;
+	long long _checkpointEvery;
+
+protected:
+	/* Event loop hooks, called in order
+	 *
+	 * setup()			- once, on this processor, before any worker is made (load LUTs, etc.)
+	 * makeWorker()		- once per thread, returns a new processor which can share read only state
+	 * beginWorker(t)	- in the worker thread, with its own tree. Set branches and book outputs here.
+	 * 					  Histograms aren't attached to any directory, trees need SetDirectory(0)
+	 * processEntry(i)	- in the worker thread, for every entry, after t->GetEntry(i)
+	 * mergeWorker(w)	- on the first worker, with each of the others in order of their entry ranges
+	 * writeOutput(f)	- on the first worker, once everything is merged
+	 *
+	 * With --checkpoint, and to send what each process did back to the parent with -p
+	 * writeCheckpoint(d)	- in the worker thread, every so many entries, writes everything
+	 * 						  processEntry has filled so far into d
+	 * readCheckpoint(d)	- in the worker thread, after beginWorker, when resuming. Adds back
+	 * 						  what writeCheckpoint wrote, so the output is the same as without
+	 * checkpointData()		- while either of the two runs for --checkpoint, a file next to the
+	 * 						  checkpoint that is kept from one to the next, so what only grows
+	 * 						  (e.g. an output tree) can be appended instead of written again.
+	 * 						  Empty when sending the results of -p
+	 */
+	virtual int setup() {return 0;}
+	virtual Processor* makeWorker() const {return 0;}
+	virtual int beginWorker(TTree* t) {return -1;}
+	virtual int processEntry(long long entry) {return -1;}
+	virtual int mergeWorker(Processor* worker) {return -1;}
+	virtual int writeOutput(const std::string& outputfile) {return -1;}
+	virtual int writeCheckpoint(TDirectory* dir) {return -1;}
+	virtual int readCheckpoint(TDirectory* dir) {return -1;}
+	//true for processors implementing the two above, otherwise --checkpoint is refused
+	virtual bool supportsCheckpoint() const {return false;}
+
+	/* @brief Options of a processor of its own, given each argument the Processor
+	 * doesn't know, argv[i]. Returns how many arguments it used from argv[i] on,
+	 * 0 if it isn't one of its options, -1 if it is but is malformed
+	 */
+	virtual int option(int argc, char* argv[], int i) {return 0;}
+
+	/* @brief Checkpoints of the entries [first, last) of inputfile, for processors
+	 * running their own loop in run(). loadCheckpoint sets next to the entry to go on
+	 * from, first if there is no checkpoint, and calls readCheckpoint. saveCheckpoint
+	 * calls writeCheckpoint and replaces the file only once it's fully written
+	 */
+	int loadCheckpoint(const std::string& file, const std::string& inputfile, long long first, long long last,
+			long long& next);
+	int saveCheckpoint(const std::string& file, const std::string& inputfile, long long first, long long last,
+			long long next);
+	std::string checkpointName(unsigned int worker, unsigned int nWorkers) const;
+	const std::string& checkpointData() const {return _checkpointData;}
+
+private:
+	int runWorker(const std::string& inputfile, long long first, long long last, bool printProgress,
+			const ReadOptions& options, const std::string& checkpoint, long long checkpointEvery, double& seconds);
+	void removeCheckpoints(unsigned int nWorkers) const;
+	std::string _checkpointData; //see checkpointData()
+	int writeState(const std::string& file);
+	int readState(const std::string& file);
+	int mergeStates(const std::string& inputfile, const std::vector<std::string>& parts,
+			const std::string& outputfile) const;
+	void applyReadOptions() const;
+	bool hasEventLoop() const;
+	void entryRange(const std::string& inputfile, int& start, int& end) const;
+	static TChain* openChain(const std::string& inputfile);
+	static int syncFile(const std::string& file);
+	static void printThroughput(const char* type, const std::vector<long long>& entries,
+			const std::vector<double>& seconds, double wallSeconds);
+
+	/* @brief I/O of the event loop, summed over files and workers
+	 */
+	struct IOStats {
+		IOStats() : entries(0), readCalls(0), bytesRead(0), ioSeconds(0), computeSeconds(0), cacheMisses(0) {}
+		long long entries;
+		long long readCalls;
+		long long bytesRead;
+		double ioSeconds; //blocked in GetEntry
+		double computeSeconds; //in processEntry
+		long long cacheMisses;
+	};
+	IOStats _ioStats;
+	//[compressed, uncompressed] bytes of each enabled branch read by the event loop
+	std::map<std::string, std::pair<double,double> > _branchBytes;
+
+	void addFileStats(TTree* t, long long first, long long last);
+	void addWorkerStats(const Processor* worker);
+	int writeWorkerStats(int fd) const;
+	int readWorkerStats(int fd);
+	void printBranchBytes() const;
+	void printIOStats(double wallSeconds) const;
+	int writeStats(const std::string& file, const std::string& processor, const std::string& inputfile,
+			int result, double wallSeconds, unsigned int nProcs, unsigned int nThreads) const;
 };
 
 
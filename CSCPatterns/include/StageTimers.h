@@ -0,0 +1,122 @@
+/*
+ * StageTimers.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: agent
+ */
+
+#ifndef CSCPATTERNS_INCLUDE_STAGETIMERS_H_
+#define CSCPATTERNS_INCLUDE_STAGETIMERS_H_
+
+#include <string>
+#include <vector>
+#include <chrono>
+
+#include "Tracer.h"
+#include "MemoryTracker.h"
+#include "PerfCounters.h"
+
+class TDirectory;
+
+using namespace std;
+
+/* @brief Durations of one stage, in one thread. Percentiles come from a
+ * histogram with 8 bins per power of two of nanoseconds (~10% wide)
+ */
+class StageStats {
+public:
+	StageStats();
+
+	void add(unsigned long long ns);
+	void merge(const StageStats& s);
+	double percentile(double fraction) const; //ns
+
+	unsigned long long count;
+	unsigned long long total; //ns
+	unsigned long long min;
+	unsigned long long max;
+
+	static const unsigned int NBINS = 512;
+	unsigned int bins[NBINS];
+
+private:
+	static unsigned int getBin(unsigned long long ns);
+	static double binCenter(unsigned int bin);
+};
+
+/* @brief Process wide registry of the stage timers. Each thread fills its
+ * own table, which are merged for the summary once the threads are done
+ *
+ * 	STAGE_TIMER("clct search");
+ *
+ * times everything until the end of the enclosing scope
+ */
+class StageTimers {
+public:
+	//id of a stage, registered on first use. Cheap after that if kept, see STAGE_TIMER
+	static unsigned int stage(const string& name);
+	static string name(unsigned int stage);
+	static vector<string> names();
+	static void add(unsigned int stage, unsigned long long ns);
+
+	static void setEnabled(bool enabled);
+	static bool enabled();
+
+	//per stage, merged over all threads, with the amount of threads that used it
+	static void summary(vector<string>& names, vector<StageStats>& stats, vector<unsigned int>& nThreads);
+	static void print();
+	static int write(TDirectory* dir);
+
+	//stages of a forked child, read back by its parent
+	static int send(int fd);
+	static int receive(int fd);
+};
+
+/* @brief Reads / writes all n bytes through a pipe, which can otherwise
+ * come back short. Used to pass results back from forked workers
+ */
+int readFully(int fd, void* buffer, unsigned long n);
+int writeFully(int fd, const void* buffer, unsigned long n);
+
+/* @brief Adds its lifetime to the stage timers and to the trace, what it
+ * allocates to the memory tracker and its hardware counters to the
+ * PerfCounters, whichever are on
+ */
+class ScopedTimer {
+public:
+	ScopedTimer(unsigned int stage) :
+		_stage(stage), _timed(StageTimers::enabled()), _traced(Tracer::enabled()),
+		_tracked(MemoryTracker::enabled()), _counted(PerfCounters::enabled()), _previousStage(-1) {
+		if(_tracked) _previousStage = MemoryTracker::enterStage(stage);
+		if(_timed || _traced) _start = std::chrono::steady_clock::now();
+		if(_counted) PerfCounters::begin(_sample);
+	}
+	~ScopedTimer() {
+		if(_counted) PerfCounters::end(_stage, _sample);
+		if(_timed || _traced) {
+			auto end = std::chrono::steady_clock::now();
+			if(_timed) StageTimers::add(_stage, std::chrono::duration_cast<std::chrono::nanoseconds>(end - _start).count());
+			if(_traced) Tracer::record(_stage, _start, end);
+		}
+		if(_tracked) MemoryTracker::leaveStage(_previousStage);
+	}
+
+private:
+	const unsigned int _stage;
+	const bool _timed;
+	const bool _traced;
+	const bool _tracked;
+	const bool _counted;
+	int _previousStage;
+	PerfSample _sample;
+	std::chrono::steady_clock::time_point _start;
+};
+
+#define STAGE_TIMER_CONCAT_(a, b) a##b
+#define STAGE_TIMER_CONCAT(a, b) STAGE_TIMER_CONCAT_(a, b)
+#define STAGE_TIMER(name) \
+	static const unsigned int STAGE_TIMER_CONCAT(_stageId, __LINE__) = StageTimers::stage(name); \
+	ScopedTimer STAGE_TIMER_CONCAT(_stageTimer, __LINE__)(STAGE_TIMER_CONCAT(_stageId, __LINE__))
+
+
+#endif /* CSCPATTERNS_INCLUDE_STAGETIMERS_H_ */
@@ -0,0 +1,107 @@
+/*
+ * SyntheticEvents.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: agent
+ */
+
+#ifndef CSCPATTERNS_INCLUDE_SYNTHETICEVENTS_H_
+#define CSCPATTERNS_INCLUDE_SYNTHETICEVENTS_H_
+
+#include <vector>
+#include <random>
+
+#include "CSCClasses.h"
+#include "CSCInfo.h"
+
+using namespace std;
+
+/* @brief What goes into a generated chamber
+ */
+struct SyntheticConfig {
+	SyntheticConfig() :
+		seed(1),
+		muons(1.),
+		noise(0.01),
+		showers(0.),
+		efficiency(0.95),
+		legacyPatterns(false) {}
+
+	unsigned int seed;
+	float muons; //mean number of muon tracks per chamber (poisson)
+	float noise; //chance of a random hit per half strip / wire group and layer, i.e. the noise occupancy
+	float showers; //chance of a chamber getting a shower, a dense burst of hits over a few CFEBs
+	float efficiency; //chance of a muon leaving a hit in a layer
+	bool legacyPatterns; //draw the comparator tracks from the legacy envelopes instead of the new ones
+};
+
+/* @brief A generated muon, in the coordinates the emulation reports
+ */
+struct SyntheticMuon {
+	unsigned int station;
+	unsigned int ring;
+	unsigned int endcap;
+	unsigned int chamber;
+	unsigned int patternId; //envelope the comparators were drawn from
+	int keyHalfStrip; //as CLCTCandidate::keyHalfStrip()
+	float position; //[strips] straight line fit of the comparators, at the key layer, as CLCTCandidate::keyStrip()
+	float slope; //[strips / layer]
+	float strips[NLAYERS]; //[strips] of each comparator, -1 in layers without one
+	unsigned int nHits; //comparators
+	int keyWireGroup; //0 based
+	float wireSlope; //wire groups per layer
+	int wireGroups[NLAYERS]; //-1 in layers without a hit
+	int bx; //time bin of the key layer
+};
+
+/* @brief Fake comparator and wire digis, chamber by chamber, in the
+ * CSCInfo format so they can go straight into ChamberHits::fill and
+ * ALCT_ChamberHits::fill. Muons leave a hit in each layer of a pattern
+ * envelope and a near vertical road of wire groups, on top of uniform noise
+ * and, now and then, a shower. The same seed gives the same digis
+ */
+class SyntheticEvents {
+public:
+	SyntheticEvents(const SyntheticConfig& config=SyntheticConfig());
+	~SyntheticEvents();
+
+	//drops the digis and muons made so far
+	void clear();
+
+	//adds the muons and noise of one chamber, returns the number of muons
+	int addChamber(unsigned int station, unsigned int ring, unsigned int endcap, unsigned int chamber);
+
+	const SyntheticConfig& config() const {return _config;}
+	mt19937& random() {return _random;}
+
+	//point to the vectors below, valid as long as this is
+	CSCInfo::Comparators comparators;
+	CSCInfo::Wires wires;
+	vector<SyntheticMuon> muons;
+
+private:
+	void addComparator(const ChamberHits& c, int chamberId, unsigned int layer, int column, unsigned int time);
+	void addWire(int chamberId, unsigned int layer, unsigned int group, unsigned int time);
+	void addShower(const ChamberHits& c, int chamberId, int maxWi);
+
+	SyntheticConfig _config;
+	mt19937 _random;
+	vector<CSCPattern>* _patterns;
+
+	vector<int> _compChamber;
+	vector<size8> _compLayer;
+	vector<size8> _compStrip;
+	vector<size8> _compHalfStrip;
+	vector<size8> _compTime;
+	vector<size8> _compTimeOn;
+
+	vector<size16> _wireChamber;
+	vector<int> _wireGroup;
+	vector<size8> _wireLayer;
+	vector<int> _wireTimeBin;
+	vector<int> _wireBX;
+	vector<uint32_t> _wireTimeBinWord;
+};
+
+
+#endif /* CSCPATTERNS_INCLUDE_SYNTHETICEVENTS_H_ */
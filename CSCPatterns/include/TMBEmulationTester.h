@@ -9,11 +9,74 @@
 #define CSCPATTERNS_INCLUDE_TMBEMULATIONTESTER_H_
 
 #include "../include/Processor.h"
+#include "../include/CandidateMatcher.h"
+#include "../include/EmulationCache.h"
+#include "../include/MismatchLog.h"
 
+#include <vector>
+#include <string>
+
+class TH1F;
+class TH2F;
+class CSCPattern;
+
+namespace CSCInfo {
+class Event;
+class CLCTs;
+class Comparators;
+}
+
+/* @brief Compares the emulated CLCTs to the recorded ones. Runs through the
+ * Processor event loop hooks, so can be split over threads with -j N. Each
+ * worker logs its mismatches to a part of its own, in $TMPDIR, which are
+ * joined in order of their entry ranges next to the output
+ */
 class TMBEmulationTester : public  Processor {
-	int run(std::string inputfile, std::string outputfile, int start=0, int end=-1);
+public:
+	TMBEmulationTester();
+	~TMBEmulationTester();
+
+protected:
+	int setup();
+	Processor* makeWorker() const;
+	int beginWorker(TTree* t);
+	int processEntry(long long entry);
+	int mergeWorker(Processor* worker);
+	int writeOutput(const std::string& outputfile);
+
+private:
+	//shared between workers, owned by the processor that ran setup()
+	bool _ownsShared;
+	vector<CSCPattern>* _oldPatterns;
+	EmulationCache* _cache; //0 without --emulation-cache
+	CachedCLCTSearch* _search;
+
+	//input branches
+	CSCInfo::Event* _evt;
+	CSCInfo::CLCTs* _clcts;
+	CSCInfo::Comparators* _comparators;
+
+	TH1F* _emulationMatching;
+	TH2F* _emulationPattVsOffset;
+	TH1F* _emulationStripDiff;
+	TH1F* _emulatedLayerCount;
+	TH1F* _realLayerCount;
+	TH1F* _emulatedMultiplicity;
+	TH1F* _realMultiplicity;
+
+	//how many times we match to the first clct
+	unsigned int _clct0;
+	unsigned int _matchClct0;
+	unsigned int _pmatchClct0;
+
+	MismatchLogWriter _mismatchLog;
+	//parts of the mismatch log of this worker and those merged into it, in order
+	vector<string> _mismatchParts;
+
+	CacheLookups _cacheLookups;
+	CandidateMatcher _matcher;
 };
 
 
 
-#endif /* CSCPATTERNS_INCLUDE_THREELAYERCLCTEMULATIONANALYZER_H_ */
+#endif /* CSCPATTERNS_INCLUDE_TMBEMULATIONTESTER_H_ */
@@ -0,0 +1,109 @@
+/*
+ * ThresholdScan.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: agent
+ */
+
+#ifndef CSCPATTERNS_INCLUDE_THRESHOLDSCAN_H_
+#define CSCPATTERNS_INCLUDE_THRESHOLDSCAN_H_
+
+#include <vector>
+#include <map>
+#include <tuple>
+
+using namespace std;
+
+/* @brief Weight, sum of the values and of their squares of some entries
+ */
+struct ScanSums {
+	ScanSums(double weight_=0, double value_=0, double value2_=0) :
+		weight(weight_), value(value_), value2(value2_) {}
+	double weight;
+	double value;
+	double value2;
+
+	double mean() const {return weight ? value/weight : 0;}
+	//as TH1::GetRMS
+	double rms() const;
+	ScanSums operator+(const ScanSums& s) const {return ScanSums(weight+s.weight, value+s.value, value2+s.value2);}
+	ScanSums operator-(const ScanSums& s) const {return ScanSums(weight-s.weight, value-s.value, value2-s.value2);}
+};
+
+/* @brief Distributions of a score, e.g. the segments behind a LUT entry, a
+ * quality or a residual, each entry carrying a value along (a residual),
+ * per category of (chamber type, pattern set, pt bin). Filled in one pass,
+ * then curves over any amount of thresholds and coverage intervals are read
+ * from cumulative sums, without going over the entries again.
+ *
+ * With bins = 0 every score is kept and sorted on the first query, so any
+ * threshold is exact. Otherwise the scores are binned in [low, high) and
+ * thresholds are rounded up to the edge of their bin, for fills too many to keep.
+ *
+ * Entries pass a threshold if their score is above it. Queries sort lazily,
+ * so aren't safe to make from several threads at once. From python, after
+ * gSystem.Load('../lib/ThresholdScan_cpp'), the curves are std::vectors,
+ * np.asarray views them
+ */
+class ThresholdScan {
+public:
+	ThresholdScan(unsigned int bins=0, double low=0., double high=1.);
+
+	//made on first use, numbered in that order
+	unsigned int category(int chamberType, int patternSet=0, int ptBin=0);
+	//-1 if it was never made
+	int findCategory(int chamberType, int patternSet=0, int ptBin=0) const;
+	unsigned int categories() const {return _categories.size();}
+
+	void fill(unsigned int category, double score, double value=0., double weight=1.);
+
+	ScanSums total(unsigned int category) const;
+	ScanSums above(unsigned int category, double threshold) const; //score > threshold
+	ScanSums below(unsigned int category, double threshold) const; //score <= threshold
+
+	//one point per threshold
+	vector<double> passing(unsigned int category, const vector<double>& thresholds) const; //weight above
+	vector<double> efficiency(unsigned int category, const vector<double>& thresholds) const; //fraction above
+
+	/* @brief RMS of the values, taking the entries of pass above each threshold
+	 * and those of fail below it, e.g. the LUT offsets from data where they have
+	 * more segments than the threshold and the line fits elsewhere
+	 */
+	vector<double> switchedRMS(unsigned int pass, unsigned int fail, const vector<double>& thresholds) const;
+
+	/* @brief Central interval of the scores holding coverage of the weight, leaving
+	 * (1-coverage)/2 out on each side, as findInterval in makeRezPlots.py.
+	 * Bin centers when binned. -1 if the category is empty
+	 */
+	int interval(unsigned int category, double coverage, double& low, double& high) const;
+
+private:
+	struct Entry {
+		double score;
+		double value;
+		double weight;
+		bool operator<(const Entry& e) const {return score < e.score;}
+	};
+	struct Category {
+		Category() : sorted(true) {}
+		mutable vector<Entry> entries; //without bins
+		mutable vector<ScanSums> bins; //underflow, bins, overflow
+		//cumulative sums up to each entry / bin, excluded, and of everything last
+		mutable vector<ScanSums> cumulative;
+		mutable bool sorted;
+	};
+
+	const Category& prepare(unsigned int category) const;
+	//entries / bins with score <= threshold
+	unsigned int countBelow(const Category& c, double threshold) const;
+	double score(const Category& c, unsigned int i) const;
+
+	unsigned int _bins;
+	double _low;
+	double _high;
+	vector<Category> _categories;
+	map<tuple<int,int,int>, unsigned int> _index;
+};
+
+
+#endif /* CSCPATTERNS_INCLUDE_THRESHOLDSCAN_H_ */
@@ -0,0 +1,54 @@
+/*
+ * Tracer.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: agent
+ */
+
+#ifndef CSCPATTERNS_INCLUDE_TRACER_H_
+#define CSCPATTERNS_INCLUDE_TRACER_H_
+
+#include <string>
+#include <chrono>
+
+using namespace std;
+
+/* @brief One stage of one thread, as on the timeline
+ */
+struct TraceEvent {
+	unsigned int stage; //id from StageTimers::stage()
+	unsigned long long start; //ns since the trace started
+	unsigned long long end;
+	long long first; //entries [first, last) it covers, -1 if none
+	long long last;
+};
+
+/* @brief Timeline of the stages timed with STAGE_TIMER and of the event
+ * loop, written as a JSON file which chrome://tracing or ui.perfetto.dev
+ * open offline. Each thread records into its own ring buffer, so only the
+ * last bufferSize events of a thread are kept. Off unless started, in
+ * which case timed scopes only check a flag
+ */
+class Tracer {
+public:
+	static const unsigned int DEFAULT_BUFFER_SIZE = 1 << 16;
+
+	static void start(const string& file, unsigned int bufferSize = DEFAULT_BUFFER_SIZE);
+	static bool enabled();
+
+	static void record(unsigned int stage, chrono::steady_clock::time_point start,
+			chrono::steady_clock::time_point end, long long first = -1, long long last = -1);
+	//shown on the timeline instead of the thread number
+	static void setThreadName(const string& name);
+
+	//drops the events recorded so far, i.e. those a forked child got from its parent
+	static void clear();
+	static int write();
+
+	//events of a forked child, read back by its parent
+	static int send(int fd);
+	static int receive(int fd);
+};
+
+
+#endif /* CSCPATTERNS_INCLUDE_TRACER_H_ */
@@ -1,4 +1,5 @@
 import ROOT as r
+import numpy as np
 import os
 
 colors = [r.kBlue,r.kBlack, r.kRed-4, r.kGreen+1, r.kBlue+1, r.kMagenta-4, r.kYellow-3, r.kCyan-3, r.kBlue+3, r.kRed+2, r.kOrange+7, r.kBlue-8, 30, 50, 20, r.kYellow, 38]
@@ -7,6 +8,22 @@ colors = [r.kBlue,r.kBlack, r.kRed-4, r.kGreen+1, r.kBlue+1, r.kMagenta-4, r.kYe
 def printProgress(counter, entries):
     if((counter % 10000) == 0) : print("Finished %0.2f%% of events"%(100.*counter/entries))
 
+
+# per (pattern, cc), pattern and legacy pattern statistics and histograms of a plotTree,
+# read in one call in c++ rather than looping over it here, see include/PlotTreeStats.h
+# st, ri = 0 means be indiscriminate, matchedOnly skips segments without a cc
+def loadPlotTreeStats(tree, st=0, ri=0, matchedOnly=False, nbins=200, hist_range=1.):
+    if r.gSystem.Load('../lib/PlotTreeStats_cpp') < 0:
+        print("Error: can't load ../lib/PlotTreeStats_cpp, run make first")
+        return None
+    stats = r.PlotTreeStats(nbins, -hist_range, hist_range)
+    if stats.fill(tree, st, ri, matchedOnly): return None
+    return stats
+
+# numpy view of one of the PlotTreeStats vectors, no copy, only valid while stats is
+def asArray(v):
+    return np.asarray(v)
+
   
 class LUT:
     def __init__(self, isLegacy_=False):
@@ -122,80 +122,27 @@ def createDataLUT(chamber):
     newLUT = common.LUT(False)
     legacyLUT = common.LUT(True)
     
-    # dictionaries that calculate the total offset / slope for a given
-    # pattern / cc combination
-    newLCTPositionSums = {}
-    newLCTSlopeSums = {}
+    # offsets and slopes of each pattern / cc combination, summed in c++
+    stats = common.loadPlotTreeStats(myT, chamber[1], chamber[2], matchedOnly=True, nbins=0)
+    if stats is None: raise IOError("Can't read plotTree of %s"%TRAININGFILE)
+    print("Used %i / %i segments"%(stats.segments, stats.entries))
     
-    legacyLCTPositionSums = {}
-    legacyLCTSlopeSums = {}
-    
-    
-    # for unique cc count vs segments ran over plot
-    ccCountVsSegmentsY         = array('d')
-    ccCountVsSegmentsX         = array('d')
-
     # total pattern/ccs we have entries for
-    totalPatterns = 0
-    #valid segments we have looked at
-    validSegments = 0
+    totalPatterns = stats.cc.size()
     
-    counter = 0
-    entries = myT.GetEntries()
-    for event in myT:
-        printProgress(counter,entries)
-        counter +=1
-        if(event.ccId == -1): continue #ignore unmatched cc's
-        
-        if not validEvent(event, chamber[1], chamber[2]): continue
-        validSegments+=1
-        
-        #######  Now look at the event itself
-        if not (event.patternId in newLCTPositionSums):
-            newLCTPositionSums[event.patternId]  = {}
-            newLCTSlopeSums[event.patternId]   = {}
-            
-        if not(event.ccId in newLCTPositionSums[event.patternId]):
-            newLCTPositionSums[event.patternId][event.ccId] = []
-            newLCTSlopeSums[event.patternId][event.ccId] = []
-            totalPatterns +=1
-
-        if not(event.legacyLctId in legacyLCTPositionSums):
-            legacyLCTPositionSums[event.legacyLctId] = []
-            legacyLCTSlopeSums[event.legacyLctId] = []
-            
-        if not validSegments % 10000:
-            ccCountVsSegmentsX.append(validSegments)
-            ccCountVsSegmentsY.append(totalPatterns)
-        
-        #if event.patternId == 90:
-        #    print "cc = %i segX =%5.2f, patX = %5.2f --- segX - patX = %5.2f"%(event.ccId, event.segmentX, float(event.patX), event.segmentX-event.patX)
-            
-        newLCTPositionSums[event.patternId][event.ccId].append(float(event.segmentX)-float(event.patX))
-        newLCTSlopeSums[event.patternId][event.ccId].append(float(event.segmentdXdZ))
-        
-        #if event.legacyLctId == 9:
-        #    print "segX =%5.2f, patX = %5.2f --- segX - patX = %5.2f"%(event.segmentX, float(event.legacyLctX), event.segmentX-event.legacyLctX)
-         
-        
-        
-        legacyLCTPositionSums[event.legacyLctId].append(float(event.segmentX) - float(event.legacyLctX))
-        legacyLCTSlopeSums[event.legacyLctId].append(float(event.segmentdXdZ))
-     
+    # for unique cc count vs segments ran over plot
+    ccCountVsSegmentsX = common.asArray(stats.growthSegments)
+    ccCountVsSegmentsY = common.asArray(stats.growthCodes)
     
     #now loop over all the patterns we found    
-    for patt in newLCTPositionSums.keys(): 
-        for cc in newLCTPositionSums[patt].keys():
-            position, _ ,nsegments = getStats(newLCTPositionSums, patt, cc)
-            slope, _, _ = getStats(newLCTSlopeSums, patt, cc)
-            newLUT.addEntry(patt, cc, position, slope, nsegments)
-            #if event.patternId == 100 and event.ccId == 1365:
-            #    print "position = %3.2f"%position
+    for patt, cc, position, slope, nsegments in zip(common.asArray(stats.cc.pattern).tolist(), common.asArray(stats.cc.code).tolist(),
+                                                    common.asArray(stats.cc.positionMean).tolist(), common.asArray(stats.cc.slopeMean).tolist(),
+                                                    common.asArray(stats.cc.n).tolist()):
+        newLUT.addEntry(patt, cc, position, slope, int(nsegments))
             
-    for patt in legacyLCTPositionSums:
-            position, _ ,nsegments = getStats2(legacyLCTPositionSums, patt)
-            slope, _, _ = getStats2(legacyLCTSlopeSums, patt)
-            legacyLUT.addLegacyEntry(patt, position, slope, nsegments)
+    for patt, position, slope, nsegments in zip(common.asArray(stats.legacy.pattern).tolist(), common.asArray(stats.legacy.positionMean).tolist(),
+                                                common.asArray(stats.legacy.slopeMean).tolist(), common.asArray(stats.legacy.n).tolist()):
+        legacyLUT.addLegacyEntry(patt, position, slope, int(nsegments))
             
     inF.Close()
     
@@ -204,7 +151,7 @@ def createDataLUT(chamber):
     writeLUT(chamber[0], "%s%s-Legacy.lut"%(LUTWRITEDIR, chamber[0]), legacyLUT)
 
     outF = r.TFile(LUTWRITEDIR+chamber[0]+"-"+LUTROOTFILE,"RECREATE")
-    g = r.TGraph(len(ccCountVsSegmentsX),ccCountVsSegmentsX,ccCountVsSegmentsY)
+    g = r.TGraph(len(ccCountVsSegmentsX),ccCountVsSegmentsX,ccCountVsSegmentsY) if len(ccCountVsSegmentsX) else r.TGraph()
     g.Write()
     outF.Close()
 
@@ -292,12 +239,16 @@ def runTest(chamber, newLUT, legacyLUT, linefitLUT):
     for i in range(3,7):
         h_chi2s[i] = r.TH1F("h_chi2-%ilays"%i, "h_chi2-%ilays; #chi^2; Segments"%i,100, 0.,10.)
          
-    h_differences = []
+    # residuals against the segments behind their LUT entry, the rms at every
+    # threshold is read off at the end, see include/ThresholdScan.h
+    if r.gSystem.Load('../lib/ThresholdScan_cpp') < 0: raise IOError("Can't load ../lib/ThresholdScan_cpp, run make first")
+    scan = r.ThresholdScan()
+    dataSet = scan.category(0, 0) #offsets of the data LUT
+    lineSet = scan.category(0, 1) #line fits
 #     h_lineDiff    = []
 #     h_dataDiff    = []
 # 
-    for i, N in enumerate(nThresholds):
-        h_differences.append(r.TH1F("h_diff%i"%N, "h_diff%i; Segment - LUT [strips]; Segments"%N, 200,-1.,1.))
+#     for i, N in enumerate(nThresholds):
 #         h_lineDiff   .append(r.TH1F("h_line%i"%N, "h_line%i; Segment - LUT [strips]; Segments"%N, 200,-1.,1.))
 #         h_lineDiff[i].SetFillColor(r.kRed)
 #         h_dataDiff   .append(r.TH1F("h_data%i"%N, "h_data%i; Segment - LUT [strips]; Segments"%N, 200,-1.,1.))
@@ -371,11 +322,12 @@ def runTest(chamber, newLUT, legacyLUT, linefitLUT):
             bestSlopeDiff = event.segmentdXdZ - linefitLUT.slopes[patt][cc]
             
         
-        for i, N in enumerate(nThresholds):   
-            if newLUT.nsegments.has_key(patt) and newLUT.nsegments[patt].has_key(cc) and newLUT.nsegments[patt][cc]  > N:
-                h_differences[i].Fill(newPosDiff)
-            else:
-                h_differences[i].Fill(linPosDiff)
+        # above a threshold the data offset is used, the line fit otherwise. Only
+        # what a [-1, 1) histogram would count in its rms
+        nsegments = -1
+        if newLUT.nsegments.has_key(patt) and newLUT.nsegments[patt].has_key(cc): nsegments = newLUT.nsegments[patt][cc]
+        if -1. <= newPosDiff < 1.: scan.fill(dataSet, nsegments, newPosDiff)
+        if -1. <= linPosDiff < 1.: scan.fill(lineSet, nsegments, linPosDiff)
         
         h_newLUT_PosDiff.Fill(newPosDiff)
         h_linLUT_PosDiff.Fill(linPosDiff)
@@ -431,9 +383,10 @@ def runTest(chamber, newLUT, legacyLUT, linefitLUT):
     h_linLUT_SlopeDiff.Write()
     h_bestLUT_SlopeDiff.Write()
      
-    for i, h in enumerate(h_differences):
-        RMSatN.append(h_differences[i].GetRMS())
-        h_differences[i].Write()
+    thresholds = r.std.vector('double')()
+    for N in nThresholds: thresholds.push_back(N)
+    for rms in scan.switchedRMS(dataSet, lineSet, thresholds):
+        RMSatN.append(rms)
         
         
     g_RMSatN = r.TGraph(len(nThresholds),nThresholds,RMSatN)
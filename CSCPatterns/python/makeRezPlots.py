@@ -2,6 +2,7 @@
 import ROOT as r
 import numpy as np
 import math as m
+import common
 
 from array import array
 
@@ -121,66 +122,24 @@ def createHists(chamber):
         freakwencies[pat] = np.zeros(4096) #all the possible comparator codes, initialize their frequency to zero
     
     
-    #init plots
-    ccPosMeans = {}
-    ccSlopeMeans = {}
-    patternPosMeans = {}
-    patternSlopeMeans = {}
-    legacyPosMeans = {}
-    legacySlopeMeans = {}
+    #means of each pattern / cc, then the histograms shifted by them, in one call
+    print("Making Histograms...")
+    stats = common.loadPlotTreeStats(myT, chamber[1], chamber[2], nbins=nbins, hist_range=hist_range)
+    if stats is None: raise IOError("Can't read plotTree")
     
-    unshiftedLegacySlopePlots = {}
-    unshiftedPosSlopePlots = {}
+    patterns = stats.patterns
+    legacy = stats.legacy
+    ccs = stats.cc
     
-    print("Calculating Means...")
-    counter = 0
-    entries = myT.GetEntries()
-    for event in myT:
-        counter +=1
-        printProgress(counter,entries)
-            
-        #check if we shuold look at this event    
-        if not validEvent(event, chamber[1], chamber[2]): continue
-        
-        #fill stuff we dont have yet
-        if not (event.patternId in patternPosMeans):
-            patternPosMeans[event.patternId] = []
-            patternSlopeMeans[event.patternId] = []
-            ccPosMeans[event.patternId] = {}
-            ccSlopeMeans[event.patternId] = {}
-            unshiftedPosSlopePlots[event.patternId] = r.TH1D("unshifted_patSlope%i"%(event.patternId),
-                                               "unshifted_patSlope%i;Slope [strips/layer]; Events"%(event.patternId), 
-                                               nbins,-hist_range,hist_range)
-            
-        if not (event.ccId in ccPosMeans[event.patternId]):
-            ccPosMeans[event.patternId][event.ccId] = []
-            ccSlopeMeans[event.patternId][event.ccId] = []
-            
-        if not (event.legacyLctId in legacyPosMeans) :
-            legacyPosMeans[event.legacyLctId] = []
-            legacySlopeMeans[event.legacyLctId] = []
-            unshiftedLegacySlopePlots[event.legacyLctId] = r.TH1D("unshifted_legSlope%i"%(event.legacyLctId),
-                                               "unshifted_legSlope%i;Slope [strips/layer]; Events"%(event.legacyLctId), 
-                                               nbins,-hist_range,hist_range)
-            
-        patternPosMeans[event.patternId].append(event.segmentX-event.patX)
-        patternSlopeMeans[event.patternId].append(event.segmentdXdZ)
-        ccPosMeans[event.patternId][event.ccId].append(event.segmentX-event.patX)
-        ccSlopeMeans[event.patternId][event.ccId].append(event.segmentdXdZ)
-        legacyPosMeans[event.legacyLctId].append(event.segmentX-event.legacyLctX)
-        legacySlopeMeans[event.legacyLctId].append(event.segmentdXdZ)
-        unshiftedPosSlopePlots[event.patternId].Fill(event.segmentdXdZ)
-        unshiftedLegacySlopePlots[event.legacyLctId].Fill(event.segmentdXdZ)
-        
+    for i in range(patterns.size()):
+        env = patterns.pattern[i]
+        patterns.unshiftedSlope.makeHist(i, "unshifted_patSlope%i"%(env),
+                                         "unshifted_patSlope%i;Slope [strips/layer]; Events"%(env)).Write()
         
-    for env in unshiftedPosSlopePlots:
-        unshiftedPosSlopePlots[env].Write()
-        
-    for leg in unshiftedLegacySlopePlots:
-        unshiftedLegacySlopePlots[leg].Write()    
-    
-    print("Making Histograms...")
-    
+    for i in range(legacy.size()):
+        leg = legacy.pattern[i]
+        legacy.unshiftedSlope.makeHist(i, "unshifted_legSlope%i"%(leg),
+                                       "unshifted_legSlope%i;Slope [strips/layer]; Events"%(leg)).Write()
     
     pattPosPlots = {}
     pattSlopePlots = {}
@@ -190,68 +149,32 @@ def createHists(chamber):
     legacyPosPlots = {}
     legacySlopePlots = {}
     
-    #loop over tree, again
-    counter = 0
-    #calculate these once, so it runs faster
-    calculatedCCPosMeans = {}
-    calculatedCCSlopeMeans = {}
-    calculatedPattPosMeans = {}
-    calculatedPattSlopeMeans = {}
-    calculatedlegacyPosMeans = {}
-    calculatedlegacySlopeMeans = {}
-    for event in myT:
-        counter += 1
-        printProgress(counter,entries)
+    for i in range(patterns.size()):
+        env = patterns.pattern[i]
+        pattPosPlots[env] = patterns.position.makeHist(i, "patPos%i"%(env),
+                                                       "patPos%i;Position Difference [strips]; Events"%(env))
+        pattSlopePlots[env] = patterns.slope.makeHist(i, "patSlope%i"%(env),
+                                                      "patSlope%i;Slope [strips/layer]; Events"%(env))
+        ccPosPlots[env] = {}
+        unshiftedccPosPlots[env] = {}
+        ccSlopePlots[env] = {}
         
-        #check if we shuold look at this event    
-        if not validEvent(event, chamber[1], chamber[2]): continue
+    for i in range(ccs.size()):
+        env = ccs.pattern[i]
+        cc = ccs.code[i]
+        ccPosPlots[env][cc] = ccs.position.makeHist(i, "patPos%i_cc%i"%(env, cc),
+                                                    "patPos%i_cc%i;Position Difference [strips]; Events"%(env, cc))
+        unshiftedccPosPlots[env][cc] = ccs.unshiftedPosition.makeHist(i, "unshiftedPatPos%i_cc%i"%(env, cc),
+                                                                      "unshiftedPatPos%i_cc%i;Position Difference [strips]; Events"%(env, cc))
+        ccSlopePlots[env][cc] = ccs.slope.makeHist(i, "patSlope%i_cc%i"%(env, cc),
+                                                   "patSlope%i_cc%i;Slope [strips/layer]; Events"%(env, cc))
         
-        if not (event.patternId in calculatedPattPosMeans):
-            calculatedPattPosMeans[event.patternId] = sum(patternPosMeans[event.patternId])/float(len(patternPosMeans[event.patternId]))
-            #print("mean for %i is : %f"%(event.patternId, calculatedPattPosMeans[event.patternId]))
-            calculatedPattSlopeMeans[event.patternId] = sum(patternSlopeMeans[event.patternId])/float(len(patternSlopeMeans[event.patternId]))
-            pattPosPlots[event.patternId]= r.TH1D("patPos%i"%(event.patternId),
-                                               "patPos%i;Position Difference [strips]; Events"%(event.patternId), 
-                                               nbins,-hist_range,hist_range)
-            pattSlopePlots[event.patternId] = r.TH1D("patSlope%i"%(event.patternId),
-                                                      "patSlope%i;Slope [strips/layer]; Events"%(event.patternId),
-                                                      nbins,-hist_range,hist_range)
-            calculatedCCPosMeans[event.patternId] = {}
-            calculatedCCSlopeMeans[event.patternId] = {}
-            ccPosPlots[event.patternId] = {}
-            unshiftedccPosPlots[event.patternId] = {}
-            ccSlopePlots[event.patternId] = {}
-        if not (event.ccId in calculatedCCPosMeans[event.patternId]):
-            calculatedCCPosMeans[event.patternId][event.ccId] = sum(ccPosMeans[event.patternId][event.ccId])/float(len(ccPosMeans[event.patternId][event.ccId]))
-            calculatedCCSlopeMeans[event.patternId][event.ccId] = sum(ccSlopeMeans[event.patternId][event.ccId])/float(len(ccSlopeMeans[event.patternId][event.ccId]))
-            ccPosPlots[event.patternId][event.ccId] = r.TH1D("patPos%i_cc%i"%(event.patternId, event.ccId),
-                                                                  "patPos%i_cc%i;Position Difference [strips]; Events"%(event.patternId, event.ccId),
-                                                                  nbins,-hist_range,hist_range)
-            unshiftedccPosPlots[event.patternId][event.ccId]  = r.TH1D("unshiftedPatPos%i_cc%i"%(event.patternId, event.ccId),
-                                                                  "unshiftedPatPos%i_cc%i;Position Difference [strips]; Events"%(event.patternId, event.ccId),
-                                                                  nbins,-hist_range,hist_range)
-            ccSlopePlots[event.patternId][event.ccId] = r.TH1D("patSlope%i_cc%i"%(event.patternId, event.ccId),
-                                                                  "patSlope%i_cc%i;Slope [strips/layer]; Events"%(event.patternId, event.ccId),
-                                                                  nbins,-hist_range,hist_range)
-           
-        if not (event.legacyLctId in calculatedlegacyPosMeans):
-            calculatedlegacyPosMeans[event.legacyLctId] = sum(legacyPosMeans[event.legacyLctId])/float(len(legacyPosMeans[event.legacyLctId]))   
-            calculatedlegacySlopeMeans[event.legacyLctId] = sum(legacySlopeMeans[event.legacyLctId])/float(len(legacySlopeMeans[event.legacyLctId]))
-            legacyPosPlots[event.legacyLctId] = r.TH1D("legacyPos%i"%(event.legacyLctId),"legacyPos%i;Position Difference [strips]; Events"%(event.legacyLctId),
-                                                       nbins,-hist_range,hist_range)
-            legacySlopePlots[event.legacyLctId] = r.TH1D("legacySlope%i"%(event.legacyLctId),"legacySlope%i;Slope [strips/layer]; Events"%(event.legacyLctId),
-                                                         nbins,-hist_range,hist_range)
-          
-    
-        pattPosPlots[event.patternId].Fill(event.segmentX-event.patX - calculatedPattPosMeans[event.patternId])
-        pattSlopePlots[event.patternId].Fill(event.segmentdXdZ - calculatedPattSlopeMeans[event.patternId])
-        ccPosPlots[event.patternId][event.ccId].Fill(event.segmentX-event.patX - calculatedCCPosMeans[event.patternId][event.ccId])
-        unshiftedccPosPlots[event.patternId][event.ccId].Fill(event.segmentX-event.patX)
-        ccSlopePlots[event.patternId][event.ccId].Fill(event.segmentdXdZ - calculatedCCSlopeMeans[event.patternId][event.ccId])
-        legacyPosPlots[event.legacyLctId].Fill(event.segmentX-event.legacyLctX - calculatedlegacyPosMeans[event.legacyLctId])
-        legacySlopePlots[event.legacyLctId].Fill(event.segmentdXdZ-calculatedlegacySlopeMeans[event.legacyLctId])
-    
-    
+    for i in range(legacy.size()):
+        leg = legacy.pattern[i]
+        legacyPosPlots[leg] = legacy.position.makeHist(i, "legacyPos%i"%(leg),
+                                                       "legacyPos%i;Position Difference [strips]; Events"%(leg))
+        legacySlopePlots[leg] = legacy.slope.makeHist(i, "legacySlope%i"%(leg),
+                                                      "legacySlope%i;Slope [strips/layer]; Events"%(leg))
     
     
     print("Writing Histograms...")
@@ -0,0 +1,163 @@
+#!/usr/bin/env python
+#
+# Times whole analyzer jobs over the same input, for a set of thread counts
+# and input occupancies, and writes one json record per job (events/s,
+# chambers/s, peak RSS, I/O share) to plot scaling curves and compare commits.
+#
+# Run from CSCPatterns/ once the executables are made, e.g.
+#
+#   python python/runThroughputBenchmark.py --threads 1,2,4,8 --noise 0.005,0.02,0.05 --label `git rev-parse --short HEAD`
+#
+# Without --input, the inputs are made by ./src/SyntheticTupleGenerator, one
+# per noise occupancy. Processors without the event loop hooks
+# (ALCTEmulationTreeCreator, ComparatorMultiplicityAnalyzer) run single
+# threaded whatever -j is, so only their first thread count is run.
+# LUTResolutionAnalyzer needs the LUTs of its dataset in dat/
+#
+
+from __future__ import print_function
+
+import os
+import sys
+import json
+import time
+import socket
+import argparse
+import subprocess
+
+ANALYZERS = ["LUTBuilder", "TMBEmulationTester", "LUTResolutionAnalyzer",
+             "ALCTEmulationTreeCreator", "ComparatorMultiplicityAnalyzer"]
+
+
+def splitList(arg, convert):
+    return [convert(x) for x in arg.split(",") if x]
+
+
+def makeInputs(args):
+    """ [(label, noise occupancy, file)] """
+    if args.input:
+        return [("input", None, args.input)]
+    inputs = []
+    for noise in args.noise:
+        path = os.path.join(args.workdir, "synthetic_n%i_c%i_noise%g.root" % (args.events, args.chambers, noise))
+        if args.regenerate or not os.path.exists(path):
+            command = ["./src/SyntheticTupleGenerator", path, "--events", str(args.events),
+                       "--chambers", str(args.chambers), "--noise", str(noise), "--seed", str(args.seed)]
+            print("Making input: " + " ".join(command))
+            if subprocess.call(command, stdout=open(os.devnull, "w")):
+                print("Error: couldn't make input: " + path)
+                sys.exit(-1)
+        inputs.append(("noise%g" % noise, noise, path))
+    return inputs
+
+
+def countChambers(path):
+    """ (chambers with comparators or wires summed over the events, events), None without pyroot """
+    try:
+        import ROOT as r
+    except ImportError:
+        return None
+    f = r.TFile.Open(path)
+    if not f or f.IsZombie():
+        return None
+    t = f.Get("CSCDigiTree")
+    t.SetBranchStatus("*", 0)
+    t.SetBranchStatus("comp_ch_id", 1)
+    t.SetBranchStatus("wire_ch_id", 1)
+    chambers = 0
+    for event in t:
+        chambers += len(set(event.comp_ch_id) | set(event.wire_ch_id))
+    events = t.GetEntries()
+    f.Close()
+    return (chambers, events)
+
+
+def runJob(analyzer, threads, path, args):
+    """ Runs one job, returns its record """
+    stats = os.path.join(args.workdir, "stats_%s.json" % analyzer)
+    output = os.path.join(args.workdir, "output_%s.root" % analyzer)
+    if os.path.exists(stats):
+        os.remove(stats)
+    command = ["./src/" + analyzer, "-j", str(threads), "--stats", stats, path, output]
+    if args.max_events > 0:
+        command.append(str(args.max_events))
+    log = open(os.path.join(args.workdir, "log_%s_j%i.txt" % (analyzer, threads)), "w")
+    start = time.time()
+    process = subprocess.Popen(command, stdout=log, stderr=subprocess.STDOUT)
+    _, status, usage = os.wait4(process.pid, 0)
+    wall = time.time() - start
+    log.close()
+
+    record = {"analyzer": analyzer, "threadsRequested": threads, "command": " ".join(command),
+              "exitStatus": os.WEXITSTATUS(status) if os.WIFEXITED(status) else -1,
+              "wallSeconds": wall, "peakRSSkB": usage.ru_maxrss}
+    if not os.path.exists(stats):
+        return record
+    job = json.load(open(stats))
+    record["threads"] = job["threads"] if job["eventLoop"] else 1
+    record["eventLoop"] = job["eventLoop"]
+    record["entries"] = job["entries"]
+    record["eventsPerSecond"] = job["entries"] / wall if wall > 0 else 0
+    record["ioShare"] = job["ioShare"]
+    record["ioSeconds"] = job["ioSeconds"]
+    record["bytesRead"] = job["bytesRead"]
+    record["peakRSSkB"] = max(usage.ru_maxrss, job["peakRSSkB"], job["peakChildRSSkB"])
+    record["stages"] = job["stages"]
+    return record
+
+
+def main():
+    parser = argparse.ArgumentParser(description="End to end throughput of the analyzers")
+    parser.add_argument("--input", help="fixed input instead of synthetic ones")
+    parser.add_argument("--noise", default="0.005,0.02,0.05", help="occupancies of the synthetic inputs")
+    parser.add_argument("--events", type=int, default=5000, help="events of the synthetic inputs")
+    parser.add_argument("--chambers", type=int, default=8, help="chambers with hits per synthetic event")
+    parser.add_argument("--seed", type=int, default=1)
+    parser.add_argument("--regenerate", action="store_true", help="remake synthetic inputs that already exist")
+    parser.add_argument("--threads", default="1,2,4", help="thread counts to run with")
+    parser.add_argument("--analyzers", default=",".join(ANALYZERS))
+    parser.add_argument("--max-events", type=int, default=-1, help="entries each job runs over")
+    parser.add_argument("--workdir", default="throughput", help="inputs, outputs and logs of the jobs")
+    parser.add_argument("--out", default="throughput.json")
+    parser.add_argument("--label", default="", help="name of this run in the json, e.g. the commit")
+    args = parser.parse_args()
+    args.noise = splitList(args.noise, float)
+    args.threads = splitList(args.threads, int)
+    analyzers = splitList(args.analyzers, str)
+
+    if not os.path.isdir(args.workdir):
+        os.makedirs(args.workdir)
+
+    runs = []
+    for label, noise, path in makeInputs(args):
+        counts = countChambers(path)
+        if counts is None and noise is not None:
+            counts = (args.events * args.chambers, args.events)
+        for analyzer in analyzers:
+            for threads in args.threads:
+                record = runJob(analyzer, threads, path, args)
+                record["input"] = label
+                record["noise"] = noise
+                if counts and counts[1] and "entries" in record and record["wallSeconds"] > 0:
+                    #chambers of the entries the job ran over, assuming they are alike
+                    record["chambersPerSecond"] = counts[0] * float(record["entries"]) / counts[1] / record["wallSeconds"]
+                runs.append(record)
+                print("%-32s %-12s -j %-3i %12.1f events/s %12.1f chambers/s %10.1f MB %6.1f%% I/O%s" % (
+                    analyzer, label, record.get("threads", threads), record.get("eventsPerSecond", 0),
+                    record.get("chambersPerSecond", 0), record["peakRSSkB"] / 1024.,
+                    100. * record.get("ioShare", 0), "" if not record["exitStatus"] else "   FAILED (%i)" % record["exitStatus"]))
+                #-j doesn't change anything for these
+                if not record.get("eventLoop", True):
+                    break
+
+    result = {"label": args.label, "host": socket.gethostname(), "cpus": os.sysconf("SC_NPROCESSORS_ONLN"),
+              "config": {"input": args.input, "events": args.events, "chambers": args.chambers,
+                         "seed": args.seed, "maxEvents": args.max_events},
+              "runs": runs}
+    with open(args.out, "w") as out:
+        json.dump(result, out, indent=1)
+    print("Wrote results to file: " + args.out)
+
+
+if __name__ == "__main__":
+    main()
@@ -28,6 +28,8 @@
 #include "../include/CSCHelper.h"
 
 #include "../include/ALCTEmulationTreeCreator.h"
+#include "../include/StageTimers.h"
+#include "../include/CandidateMatcher.h"
 
 using namespace std; 
 
@@ -92,11 +94,16 @@ int ALCTEmulationTreeCreator::run(string inputfile, string outputfile, int start
 	int track_unmatch[3] = {0,0,0};
 	//config.set_narrow_mask_flag(true);
 
+	CandidateMatcher matcher(CandidateMatcher::IN_ORDER, 999); //wire groups
+
 	for(int i = start; i < end; i++) 
 	{
 		if(!(i%100)) printf("%3.2f%% Done --- Processed %u Events\n\n", 100.*(i-start)/(end-start), i-start);
 
-		t->GetEntry(i);
+		{
+			STAGE_TIMER("read");
+			t->GetEntry(i);
+		}
 
 		/**********************
 	 	* CHAMBER LOOP
@@ -127,6 +134,7 @@ int ALCTEmulationTreeCreator::run(string inputfile, string outputfile, int start
 			for (int i=0; i<16; i++)
 			{
 				ALCT_ChamberHits * temp = new ALCT_ChamberHits(ST,RI,CH,EC);
+				STAGE_TIMER("hit filling");
 				temp->fill(wires,i);
 				cvec.push_back(temp);
 			}
@@ -153,10 +161,13 @@ int ALCTEmulationTreeCreator::run(string inputfile, string outputfile, int start
 	 		* RUNNING ALGORITHM
 	 		**********************/
 
-			trig_and_find(cvec, config, end_vec);
-			ghostBuster(end_vec,config);
-			//extract(end_vec,out_vec);
-			extract_sort_cut(end_vec,out_vec);
+			{
+				STAGE_TIMER("alct emulation");
+				trig_and_find(cvec, config, end_vec);
+				ghostBuster(end_vec,config);
+				//extract(end_vec,out_vec);
+				extract_sort_cut(end_vec,out_vec);
+			}
 
 			//cout << "Event = " << i << ", ST = " << ST << ", RI = " << RI << ", CH = " << CH << ", EC = " << EC << "size = " << out_vec.size() << endl << endl;
 
@@ -168,38 +179,45 @@ int ALCTEmulationTreeCreator::run(string inputfile, string outputfile, int start
 	 		* SEGMENT COMPARISON
 	 		**********************/
 
-			for (int iter=0; iter<segments.size(); iter++)
-			{
-				int min_dist = 1000;
-				int marker = - 1; 
+			int chSid1 = CSCHelper::serialize(ST, RI, CH, EC);
+			int chSid2 = chSid1;
 
-				int chSid1 = CSCHelper::serialize(ST, RI, CH, EC);
-				int chSid2 = chSid1;
-				
-				bool me11a	= ST == 1 && RI == 4;
-				bool me11b	= ST == 1 && RI == 1;
+			bool me11a	= ST == 1 && RI == 4;
+			bool me11b	= ST == 1 && RI == 1;
 
-				if (me11a || me11b)
-				{
-					if (me11a) chSid2 = CSCHelper::serialize(ST, 1, CH, EC);
-					if (me11b) chSid2 = CSCHelper::serialize(ST, 4, CH, EC);
-				}
+			if (me11a || me11b)
+			{
+				if (me11a) chSid2 = CSCHelper::serialize(ST, 1, CH, EC);
+				if (me11b) chSid2 = CSCHelper::serialize(ST, 4, CH, EC);
+			}
+
+			std::vector<int> seg_vec; //segments of the chamber, by wire group
+			for (int iter=0; iter<segments.size(); iter++)
+			{
 				if (segments.mu_id->at(iter)==-1) continue; 
 				if (chSid1!=segments.ch_id->at(iter) && chSid2!= segments.ch_id->at(iter)) continue;
 				int pos_seg = segments.pos_y->at(iter)-1;
 				if (pos_seg<0) continue; 
 				num_tot_seg++;
-				for (int j = 0; j<out_vec.size(); j++)
-				{
-					int temp_val = abs((int)(out_vec.at(j)->get_kwg()) - (int)pos_seg); 
-					if (temp_val<min_dist)
-					{
-						min_dist = temp_val;
-						marker = j;
-					}
-				}
+				seg_vec.push_back(pos_seg);
+			}
+
+			//each segment takes the closest alct not taken yet
+			std::vector<int> seg_match;
+			{
+				STAGE_TIMER("matching");
+				matcher.match(seg_vec.size(), [&](unsigned int j){return MatchKey(seg_vec[j]);},
+						out_vec.size(), [&](unsigned int j){return MatchKey(out_vec[j]->get_kwg());}, seg_match);
+			}
+
+			std::vector<bool> alct_matched(out_vec.size(), false);
+			for (int iter=0; iter<seg_vec.size(); iter++)
+			{
+				int pos_seg = seg_vec[iter];
+				int marker = seg_match[iter];
 				if (marker>-1)
 				{
+					int min_dist = abs((int)(out_vec.at(marker)->get_kwg()) - pos_seg);
 					double val = (double)((int)(out_vec.at(marker)->get_kwg()) - (int)pos_seg);
 					if (min_dist>=2.0) cout << "Event = " << i << ", ST = " << ST << ", RI = " << RI << ", CH = " << CH << ", EC = " << EC << ", size = " << cand_size << ", min_dist = " << min_dist << endl << endl;
 					mean_diff+= val;
@@ -208,8 +226,7 @@ int ALCTEmulationTreeCreator::run(string inputfile, string outputfile, int start
 					alct_match[temp]++;
 					int temp2 = (int) (out_vec.at(marker)->get_tracknumber());
 					track_match[temp2]++;
-					out_vec.at(marker)->nix();
-					out_vec.erase(out_vec.begin()+marker);
+					alct_matched[marker] = true;
 					num_seg_matched++;
 					continue; 
 				}
@@ -218,14 +235,14 @@ int ALCTEmulationTreeCreator::run(string inputfile, string outputfile, int start
 
 			for(int iter = 0; iter<out_vec.size(); iter++)
 			{
+				if (alct_matched[iter]) continue;
 				int temp = (int) (out_vec.at(iter)->get_quality());
 				alct_unmatch[temp]++;
 				int temp2 = (int) (out_vec.at(iter)->get_tracknumber());
 				track_unmatch[temp2]++;
+				num_alct_unmatched++;
 			}
 
-			num_alct_unmatched+= out_vec.size();
-
 			/*
 			for (int i=0; i<alcts.size(); i++)
 			{
@@ -487,6 +487,24 @@ int CLCTCandidate::layerCount() const {
 	return _layerMatchCount;
 }
 
+/* @brief Rank of the LUT entry associated with the candidate,
+ * candidates without an entry are ranked last
+ */
+unsigned int CLCTCandidate::qualityRank() const {
+	return _lutEntry ? _lutEntry->rank() : LUTEntry::NO_RANK;
+}
+
+/* @brief Layers (more is better), bend bit (higher is better)
+ * and key half strip (lower is better) packed into a single
+ * integer, used by cfebQuality
+ */
+unsigned long long CLCTCandidate::cfebRank() const {
+	unsigned long long layers = 0xffff - (_layerMatchCount & 0xffff);
+	unsigned long long bend = 0xffff - (_pattern.bendBit() & 0xffff);
+	unsigned long long khs = (unsigned int)(keyHalfStrip() + 0x80000000LL);
+	return (layers << 48) | (bend << 32) | khs;
+}
+
 const ComparatorCode CLCTCandidate::getComparatorCode() const {
 	if(_code){
 	return *_code;
@@ -596,6 +614,9 @@ ChamberHits::ChamberHits(unsigned int station, unsigned int ring,
 			_hits[i][j] = 0;
 		}
 	}
+	for(unsigned int j = 0; j < NLAYERS; j++) _layerHits[j] = 0;
+	for(unsigned int i = 0; i < MAX_CFEBS; i++) _cfebHits[i] = 0;
+	for(unsigned int i = 0; i < 16; i++) _timeHits[i] = 0;
 	_meanHS = -1;
 	_stdHS = -1;
 }
@@ -615,6 +636,9 @@ ChamberHits::ChamberHits(const ChamberHits& c) :
 			_hits[i][j] = c._hits[i][j];
 		}
 	}
+	for(unsigned int j = 0; j < NLAYERS; j++) _layerHits[j] = c._layerHits[j];
+	for(unsigned int i = 0; i < MAX_CFEBS; i++) _cfebHits[i] = c._cfebHits[i];
+	for(unsigned int i = 0; i < 16; i++) _timeHits[i] = c._timeHits[i];
 	_meanHS = c._meanHS;
 	_stdHS = c._stdHS;
 }
@@ -649,6 +673,33 @@ bool ChamberHits::shift(unsigned int lay) const {
 	return me11a ||me11b || oneCFEB ||!(lay%2);
 }
 
+/* @brief Adds n (+1 or -1) hits at _hits[hs][lay] to the layer and cfeb counts
+ */
+void ChamberHits::count(unsigned int hs, unsigned int lay, int n){
+	_layerHits[lay] += n;
+	int cfeb = ((int)hs - (int)shift(lay))/(int)CFEB_HS;
+	if(cfeb < 0) cfeb = 0;
+	if(cfeb >= (int)MAX_CFEBS) cfeb = MAX_CFEBS-1;
+	_cfebHits[cfeb] += n;
+}
+
+unsigned int ChamberHits::layersHit() const {
+	unsigned int layers = 0;
+	for(unsigned int j = 0; j < NLAYERS; j++) if(_layerHits[j]) layers++;
+	return layers;
+}
+
+unsigned int ChamberHits::windowHits(int lowHs, int highHs) const {
+	//the shift puts a hit at most one half strip over
+	int first = (lowHs-1)/(int)CFEB_HS;
+	int last = highHs/(int)CFEB_HS;
+	if(first < 0) first = 0;
+	if(last >= (int)MAX_CFEBS) last = MAX_CFEBS-1;
+	unsigned int hits = 0;
+	for(int cfeb = first; cfeb <= last; cfeb++) hits += _cfebHits[cfeb];
+	return hits;
+}
+
 /* @brief fills the comparator hits class with the comparators given
  *
  */
@@ -690,6 +741,8 @@ int ChamberHits::fill(const CSCInfo::Comparators& c){
 			if(!_hits[halfStripVal][lay]){
 				_hits[halfStripVal][lay] = timeOn+1; //store +1, so we dont run into trouble with hexadecimal
 				_nhits++;
+				_timeHits[timeOn]++;
+				count(halfStripVal, lay, 1);
 			}
 		}
 	}
@@ -732,6 +785,7 @@ int ChamberHits::fill(const CSCInfo::RecHits& r){
 			_hits[iRhStrip][iLay] = r.mu_id->at(thisRh)+2; //store +2, so we dont run into trouble with hexadecimal
 			// rechits not associated with muons have mu_id = -1, and we want them to be positive so we see them -> +2
 			_nhits++;
+			count(iRhStrip, iLay, 1);
 		}
 	}
 	return 0;
@@ -802,6 +856,9 @@ ChamberHits& ChamberHits::operator -=(const CLCTCandidate& mi) {
 				}
 				// if there is an overlap, erase the one in the chamber
 				if(validComparatorTime(_hits[horPos+px][y], startTimeWindow)) {
+					unsigned int tbin = _hits[horPos+px][y]-1;
+					if(tbin < 16 && _timeHits[tbin]) _timeHits[tbin]--;
+					count(horPos+px, y, -1);
 					_hits[horPos+px][y] = 0;
 					_nhits--; //decrement the amount of hits in the chamber
 				}
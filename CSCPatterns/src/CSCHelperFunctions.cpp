@@ -13,9 +13,9 @@
 #include <vector>
 
 
-bool validComparatorTime(const unsigned int time, const unsigned int startTimeWindow) {
+bool validComparatorTime(const unsigned int time, const unsigned int startTimeWindow, const unsigned int timeWindow) {
 	//numbers start at 1, so time bins really go 1-16 here
-	for(unsigned int validTime = startTimeWindow; validTime < startTimeWindow+TIME_CAPTURE_WINDOW; validTime++){
+	for(unsigned int validTime = startTimeWindow; validTime < startTimeWindow+timeWindow; validTime++){
 		if(time < validTime) return false; //speed up zero case
 		if(time == validTime) return true;
 	}
@@ -75,7 +75,8 @@ int printPatternCC(unsigned int pattID,int cc){
 
 
 //calculates the overlap of a pattern on a chamber at a given position and time bin window, returns layers matched
-int getOverlap(const ChamberHits &c, const CSCPattern &p, const int horPos, const int startTimeWindow, bool overlap[NLAYERS][3]){
+int getOverlap(const ChamberHits &c, const CSCPattern &p, const int horPos, const int startTimeWindow, bool overlap[NLAYERS][3],
+		const unsigned int timeWindow){
 
 
 	unsigned int layersMatched  = 0;
@@ -102,7 +103,7 @@ int getOverlap(const ChamberHits &c, const CSCPattern &p, const int horPos, cons
 				}
 
 				//check the overlap of the actual chamber distribution
-				if(validComparatorTime((c._hits)[horPos+px][y], startTimeWindow)) {
+				if(validComparatorTime((c._hits)[horPos+px][y], startTimeWindow, timeWindow)) {
 					overlap[y][overlapColumn] = true;
 					inLayer = true;
 				} else {
@@ -122,7 +123,8 @@ int getOverlap(const ChamberHits &c, const CSCPattern &p, const int horPos, cons
 
 //looks if a chamber "c" contains an envelope "p" at the location horPos returns
 //the number of matched layers
-int legacyLayersMatched(const ChamberHits &c, const CSCPattern &p, const int horPos, const int startTimeWindow){
+int legacyLayersMatched(const ChamberHits &c, const CSCPattern &p, const int horPos, const int startTimeWindow,
+		const unsigned int timeWindow){
 
 	bool matchedLayers[NLAYERS];
 	for(unsigned int imlc = 0; imlc < NLAYERS; imlc++) matchedLayers[imlc] = false; //initialize
@@ -136,7 +138,7 @@ int legacyLayersMatched(const ChamberHits &c, const CSCPattern &p, const int hor
 			//this accounts for checking patterns along the edges of the chamber that may extend
 			//past the bounds
 			if( (int)horPos+(int)px < 0 ||  horPos+px >= N_MAX_HALF_STRIPS) continue;
-			if(validComparatorTime((c._hits)[horPos+px][y],startTimeWindow) && p._pat[px][y]) {
+			if(validComparatorTime((c._hits)[horPos+px][y],startTimeWindow, timeWindow) && p._pat[px][y]) {
 				matchedLayers[y] = true;
 			}
 		}
@@ -151,14 +153,15 @@ int legacyLayersMatched(const ChamberHits &c, const CSCPattern &p, const int hor
 //looks if a chamber "c" contains a pattern "p". returns -1 if error, and the number of matched layers if ,
 // run successfully, match info is stored in variable mi
 // previousCandidates are a list of clcts you found earlier, which tell you which regions in the chamber not to look
-int containsPattern(const ChamberHits &c, const CSCPattern &p,  CLCTCandidate *&mi,const vector<CLCTCandidate*>&previousCandidates){
+int containsPattern(const ChamberHits &c, const CSCPattern &p,  CLCTCandidate *&mi,const vector<CLCTCandidate*>&previousCandidates,
+		const CLCTConfig& config){
 
 	//overlap between tested super pattern and chamber hits
 	bool overlap [NLAYERS][3] = {false};
 	int bestHorizontalIndex = 0;
 
 	unsigned int maxMatchedLayers = 0;
-	unsigned int time=7;//valid time starts at 7 (given first bin is 1)
+	unsigned int time=config.startTime;//valid time starts at 7 (given first bin is 1)
 
 
 
@@ -170,22 +173,23 @@ int containsPattern(const ChamberHits &c, const CSCPattern &p,  CLCTCandidate *&
 		//check if region is in the busy window, if using old tmb logic
 		bool isInBusyWindow = false;
 		for(auto cand : previousCandidates){
-			if(x <= cand->_horizontalIndex + (int)BUSY_WINDOW &&
-					x >= cand->_horizontalIndex - (int)BUSY_WINDOW){
+			if(x <= cand->_horizontalIndex + config.busyWindow &&
+					x >= cand->_horizontalIndex - config.busyWindow){
 				isInBusyWindow = true;
 				break;
 			}
 		}
 		if(isInBusyWindow) continue;
+		if(config.skipQuietRegions && c.windowHits(x, x+MAX_PATTERN_WIDTH-1) < config.layerRequirement) continue;
 
 		// Cycle through each time window, if comphits, look in all possible windows (1-4 to 13-16).
 		// also ignore bins 1 & 2 if using comp hits, talk with Cameron.
 		//Nov 5. - Only time bins that are used are 6,7,8,9 from zero or 7,8,9,10 here
 		int matchedLayerCount = 0;
 		if(p._isLegacy){
-			matchedLayerCount = legacyLayersMatched(c,p,x,time);
+			matchedLayerCount = legacyLayersMatched(c,p,x,time,config.timeWindow);
 		} else {
-			matchedLayerCount = getOverlap(c,p,x,time, overlap);
+			matchedLayerCount = getOverlap(c,p,x,time, overlap,config.timeWindow);
 			if(matchedLayerCount < 0) {
 				if(DEBUG >= 0) printf("Error: cannot get overlap for pattern\n");
 				return -1;
@@ -208,7 +212,7 @@ int containsPattern(const ChamberHits &c, const CSCPattern &p,  CLCTCandidate *&
 		}
 	}
 
-	if(!p._isLegacy && getOverlap(c,p,bestHorizontalIndex,time, overlap) < 0){
+	if(!p._isLegacy && getOverlap(c,p,bestHorizontalIndex,time, overlap,config.timeWindow) < 0){
 		printf("Error: cannot get overlap for pattern\n");
 		return -1;
 	}
@@ -234,10 +238,13 @@ int containsPattern(const ChamberHits &c, const CSCPattern &p,  CLCTCandidate *&
 // values of where NOT to search, following the current implementation of the TMB described here:
 // https://github.com/csc-fw/otmb_fw_docs/blob/master/tmb2013-2005_spec.pdf
 // note that this is currently NOT the key half strip, but some constant off of it ( MAX_PATTERN_WIDTH / 2? )
-int searchForMatch(const ChamberHits &c, const vector<CSCPattern>* ps, vector<CLCTCandidate*>& m, bool useBusyWindow){
+int searchForMatch(const ChamberHits &c, const vector<CSCPattern>* ps, vector<CLCTCandidate*>& m, bool useBusyWindow,
+		const CLCTConfig& config){
 
 
-	if(c.nhits() < N_LAYER_REQUIREMENT) return 0; //we're done
+	if(c.nhits() < config.layerRequirement) return 0; //we're done
+	if(config.maxCLCTs && m.size() >= config.maxCLCTs) return 0;
+	if(config.skipQuietRegions && c.layersHit() < config.layerRequirement) return 0;
 	ChamberHits shrinkingChamber = c;
 
 	CLCTCandidate *bestMatch = 0;
@@ -247,7 +254,7 @@ int searchForMatch(const ChamberHits &c, const vector<CSCPattern>* ps, vector<CL
 		CLCTCandidate *thisMatch = 0;
 		if(useBusyWindow){
 			//need to pass the previous candidates if using busy window, to block out region of where to look
-			if(containsPattern(c,ps->at(ip),thisMatch,m) < 0) {
+			if(containsPattern(c,ps->at(ip),thisMatch,m,config) < 0) {
 				if(DEBUG >= 0){
 					printf("Error: pattern algorithm failed - isLegacy = %i\n", ps->at(ip)._isLegacy);
 					c.print();
@@ -256,7 +263,7 @@ int searchForMatch(const ChamberHits &c, const vector<CSCPattern>* ps, vector<CL
 				return -1;
 			}
 		}else{
-			if(containsPattern(c,ps->at(ip),thisMatch) < 0) {
+			if(containsPattern(c,ps->at(ip),thisMatch,vector<CLCTCandidate*>(),config) < 0) {
 				if(DEBUG >= 0){
 					printf("Error: pattern algorithm failed - isLegacy = %i\n", ps->at(ip)._isLegacy);
 					c.print();
@@ -268,22 +275,12 @@ int searchForMatch(const ChamberHits &c, const vector<CSCPattern>* ps, vector<CL
 
 
 
-		vector<CLCTCandidate*> matches;
-		matches.push_back(bestMatch);
-		matches.push_back(thisMatch);
-
-		sort(matches.begin(), matches.end(), CLCTCandidate::cfebQuality);
-
-
-		//remove the last element from the array, i.e. the worst of the two
-		matches.pop_back();
-
-		//the best match is the one which is sorted to the front
-		bestMatch = matches.front();
+		//keep the better of the two, ties go to the newer match
+		if(CLCTCandidate::cfebQuality(thisMatch, bestMatch)) bestMatch = thisMatch;
 	}
 
 	//we have a valid best match
-	if(bestMatch && bestMatch->layerCount() >=(int) N_LAYER_REQUIREMENT){
+	if(bestMatch && bestMatch->layerCount() >=(int) config.layerRequirement){
 		if(DEBUG > 0){
 			c.print();
 			//printChamber(c);
@@ -293,11 +290,26 @@ int searchForMatch(const ChamberHits &c, const vector<CSCPattern>* ps, vector<CL
 		//WARNING: using a busy window smaller than the max pattern size may cause this emulation to perform
 		// differently than expected, since we are removing hits here
 		shrinkingChamber-=*bestMatch; //subtract all the hits associated with the match from the chamber
-		return searchForMatch(shrinkingChamber, ps, m,useBusyWindow); //find the next one
+		return searchForMatch(shrinkingChamber, ps, m,useBusyWindow,config); //find the next one
 	}else return 0; //add nothing if we don't find anything
 }
 
 
+int showerFlag(const ChamberHits& c, const ShowerConfig& config){
+	if(!config.startTime){
+		cout << "Error: shower start time is 0, time bins start at 1" << endl;
+		return -1;
+	}
+	unsigned int hits = 0;
+	for(unsigned int tbin = config.startTime-1; tbin < config.startTime-1+config.timeWindow && tbin < 16; tbin++){
+		hits += c.timeHits(tbin);
+	}
+	int flag = 0;
+	while(flag < 3 && hits >= config.thresholds[flag]) flag++;
+	return flag;
+}
+
+
 int makeLUT(TTree* t, DetectorLUTs& newLUTs, DetectorLUTs& legacyLUTs){
     int patternId = 0;
     int ccId = 0;
@@ -78,6 +78,70 @@ int main(int argc, char* argv[])
 				<< " ccId: " << cand->comparatorCodeId() << endl;
 	}
 
+	cout << "-- Testing Ranking --" << endl;
+	//the packed ranks against the field by field comparisons they replaced,
+	// on the line fit LUT, or the LUT given as argv[1]
+	LUT lut("ranking");
+	if(argc > 1 ? lut.loadText(argv[1]) : lut.loadLinearFits()) return -1;
+	if(!lut.isFinal() && lut.makeFinal()) return -1;
+
+	//priority (layers, chi2, slope)
+	auto legacyQuality = [](const CLCTCandidate* c1, const CLCTCandidate* c2){
+		const LUTEntry* l1 = c1->_lutEntry;
+		const LUTEntry* l2 = c2->_lutEntry;
+		if(l1->_layers != l2->_layers) return l1->_layers > l2->_layers;
+		if(l1->_chi2 != l2->_chi2) return l1->_chi2 < l2->_chi2;
+		return abs(l1->slope()) < abs(l2->slope());
+	};
+	vector<CLCTCandidate*> ranked;
+	for(auto& it : lut){
+		CLCTCandidate* cand = new CLCTCandidate(newP->front(), 0, 0, it.second._layers);
+		cand->_lutEntry = &it.second;
+		ranked.push_back(cand);
+	}
+	stable_sort(ranked.begin(), ranked.end(), [](const CLCTCandidate* c1, const CLCTCandidate* c2){
+		return c1->qualityRank() < c2->qualityRank();
+	});
+	//in order of rank, neighbours are either better or as good as each other by the fields too
+	unsigned int qualityDiffs = 0;
+	for(unsigned int i = 1; i < ranked.size(); i++){
+		CLCTCandidate* c1 = ranked[i-1];
+		CLCTCandidate* c2 = ranked[i];
+		bool better = c1->qualityRank() < c2->qualityRank();
+		if(legacyQuality(c1, c2) != better || legacyQuality(c2, c1)) qualityDiffs++;
+	}
+	cout << "\t qualityRank: " << ranked.size() << " entries, " << qualityDiffs << " out of order" << endl;
+	for(auto cand : ranked) delete cand;
+
+	//sort by layers, bend bit, key half strip
+	auto legacyCfebQuality = [](const CLCTCandidate* c1, const CLCTCandidate* c2){
+		if(c1->layerCount() != c2->layerCount()) return c1->layerCount() > c2->layerCount();
+		if(c1->_pattern.bendBit() != c2->_pattern.bendBit()) return c1->_pattern.bendBit() > c2->_pattern.bendBit();
+		return c1->keyHalfStrip() < c2->keyHalfStrip();
+	};
+	vector<CLCTCandidate*> cfebCandidates;
+	for(auto patterns : {newP, oldP}){
+		for(auto& patt : *patterns){
+			for(int horInd = 0; horInd < 2*(int)CFEB_HS; horInd += 7){
+				for(int layers = 3; layers <= (int)NLAYERS; layers++){
+					cfebCandidates.push_back(new CLCTCandidate(patt, horInd, 0, layers));
+				}
+			}
+		}
+	}
+	unsigned int cfebDiffs = 0;
+	for(auto c1 : cfebCandidates){
+		for(auto c2 : cfebCandidates){
+			if((c1->cfebRank() < c2->cfebRank()) != legacyCfebQuality(c1, c2)) cfebDiffs++;
+		}
+	}
+	cout << "\t cfebRank: " << cfebCandidates.size() << " candidates, " << cfebDiffs << " pairs out of order" << endl;
+	for(auto cand : cfebCandidates) delete cand;
+	if(qualityDiffs || cfebDiffs) {
+		cout << "Error: ranks don't order candidates as the field by field comparisons" << endl;
+		return -1;
+	}
+
 	cout << "-- Testing Matching Algorithm --" << endl;
 	CSCInfo::Comparators comps;
 	comps.ch_id = new std::vector<int>();
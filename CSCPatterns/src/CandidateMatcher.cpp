@@ -0,0 +1,200 @@
+/*
+ * CandidateMatcher.cpp
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: agent
+ */
+
+#include "../include/CandidateMatcher.h"
+
+#include <algorithm>
+
+
+void CandidateMatcher::match(unsigned int nFirst, const Key& first, unsigned int nSecond, const Key& second, vector<MatchedPair>& pairs){
+	pairs.clear();
+	match(nFirst, first, nSecond, second, _matches);
+	for(unsigned int i = 0; i < nFirst; i++){
+		if(_matches[i] < 0) continue;
+		MatchedPair p;
+		p.first = i;
+		p.second = _matches[i];
+		p.separation = first(i).position - second(p.second).position;
+		pairs.push_back(p);
+	}
+}
+
+void CandidateMatcher::match(unsigned int nFirst, const Key& first, unsigned int nSecond, const Key& second, vector<int>& matchOfFirst){
+	matchOfFirst.assign(nFirst, -1);
+	if(!nFirst || !nSecond) return;
+	sortSecond(nSecond, second);
+	switch(_mode){
+	case NEAREST:
+		nearest(nFirst, first, matchOfFirst);
+		break;
+	case IN_ORDER:
+		inOrder(nFirst, first, matchOfFirst);
+		break;
+	case CLOSEST_FIRST:
+		closestFirst(nFirst, first, matchOfFirst);
+		break;
+	}
+}
+
+void CandidateMatcher::sortSecond(unsigned int nSecond, const Key& second){
+	_second.clear();
+	for(unsigned int i = 0; i < nSecond; i++){
+		MatchKey k = second(i);
+		if(isnan(k.position)) continue;
+		Entry e;
+		e.chamber = k.chamber;
+		e.position = k.position;
+		e.index = i;
+		_second.push_back(e);
+	}
+	sort(_second.begin(), _second.end());
+}
+
+/* @brief First of the second collection at or after the key
+ */
+unsigned int CandidateMatcher::lowerBound(const MatchKey& k) const {
+	return lower_bound(_second.begin(), _second.end(), k, [](const Entry& e, const MatchKey& key){
+		if(e.chamber != key.chamber) return e.chamber < key.chamber;
+		return e.position < key.position;
+	}) - _second.begin();
+}
+
+/* @brief Of the closest entries on the left and right (-1 for none),
+ * which is closer, -1 if neither is within the tolerance
+ */
+int CandidateMatcher::closer(const MatchKey& k, int left, int right) const {
+	int best = -1;
+	float bestDistance = 0;
+	for(int i : {left, right}){
+		if(i < 0 || _second[i].chamber != k.chamber) continue;
+		float distance = fabs(k.position - _second[i].position);
+		if(distance > _tolerance) continue;
+		if(best < 0 || distance < bestDistance ||
+				(distance == bestDistance && _second[i].index < _second[best].index)){
+			best = i;
+			bestDistance = distance;
+		}
+	}
+	return best;
+}
+
+int CandidateMatcher::untakenRight(unsigned int i){
+	unsigned int root = i;
+	while(_right[root] != root) root = _right[root];
+	while(_right[i] != root){
+		unsigned int next = _right[i];
+		_right[i] = root;
+		i = next;
+	}
+	return root < _second.size() ? (int)root : -1;
+}
+
+int CandidateMatcher::untakenLeft(int i){
+	if(i < 0) return -1;
+	int root = i;
+	while(root >= 0 && _left[root] != root) root = _left[root];
+	while(i >= 0 && _left[i] != root){
+		int next = _left[i];
+		_left[i] = root;
+		i = next;
+	}
+	return root;
+}
+
+void CandidateMatcher::nearest(unsigned int nFirst, const Key& first, vector<int>& matchOfFirst){
+	const int n = _second.size();
+	for(unsigned int i = 0; i < nFirst; i++){
+		MatchKey k = first(i);
+		if(isnan(k.position)) continue;
+		int right = lowerBound(k);
+		int left = right-1;
+		if(right >= n) right = -1;
+		//entries just as far, further out, can have a lower index
+		if(left >= 0){
+			float distance = fabs(k.position - _second[left].position);
+			for(int j = left-1; j >= 0 && _second[j].chamber == k.chamber &&
+					fabs(k.position - _second[j].position) == distance; j--){
+				if(_second[j].index < _second[left].index) left = j;
+			}
+		}
+		if(right >= 0){
+			float distance = fabs(k.position - _second[right].position);
+			for(int j = right+1; j < n && _second[j].chamber == k.chamber &&
+					fabs(k.position - _second[j].position) == distance; j++){
+				if(_second[j].index < _second[right].index) right = j;
+			}
+		}
+		int best = closer(k, left, right);
+		if(best >= 0) matchOfFirst[i] = _second[best].index;
+	}
+}
+
+void CandidateMatcher::inOrder(unsigned int nFirst, const Key& first, vector<int>& matchOfFirst){
+	const int n = _second.size();
+	_right.resize(n+1);
+	_left.resize(n);
+	for(int j = 0; j <= n; j++) _right[j] = j;
+	for(int j = 0; j < n; j++) _left[j] = j;
+
+	for(unsigned int i = 0; i < nFirst; i++){
+		MatchKey k = first(i);
+		if(isnan(k.position)) continue;
+		int bound = lowerBound(k);
+		int right = untakenRight(bound);
+		int left = untakenLeft(bound-1);
+		if(left >= 0){
+			float distance = fabs(k.position - _second[left].position);
+			for(int j = untakenLeft(left-1); j >= 0 && _second[j].chamber == k.chamber &&
+					fabs(k.position - _second[j].position) == distance; j = untakenLeft(j-1)){
+				if(_second[j].index < _second[left].index) left = j;
+			}
+		}
+		if(right >= 0){
+			float distance = fabs(k.position - _second[right].position);
+			for(int j = untakenRight(right+1); j >= 0 && _second[j].chamber == k.chamber &&
+					fabs(k.position - _second[j].position) == distance; j = untakenRight(j+1)){
+				if(_second[j].index < _second[right].index) right = j;
+			}
+		}
+		int best = closer(k, left, right);
+		if(best < 0) continue;
+		matchOfFirst[i] = _second[best].index;
+		_right[best] = best+1;
+		_left[best] = best-1;
+	}
+}
+
+void CandidateMatcher::closestFirst(unsigned int nFirst, const Key& first, vector<int>& matchOfFirst){
+	const unsigned int n = _second.size();
+	_pairs.clear();
+	for(unsigned int i = 0; i < nFirst; i++){
+		MatchKey k = first(i);
+		if(isnan(k.position)) continue;
+		for(unsigned int j = lowerBound(MatchKey(k.position - _tolerance, k.chamber));
+				j < n && _second[j].chamber == k.chamber; j++){
+			float distance = fabs(k.position - _second[j].position);
+			if(_second[j].position > k.position && distance > _tolerance) break;
+			if(distance > _tolerance) continue;
+			Pair p;
+			p.distance = distance;
+			p.first = i;
+			p.second = _second[j].index;
+			_pairs.push_back(p);
+		}
+	}
+	sort(_pairs.begin(), _pairs.end());
+
+	//indexed by the second's index
+	unsigned int nSecond = 0;
+	for(auto& e : _second) nSecond = max(nSecond, e.index+1);
+	_taken.assign(nSecond, 0);
+	for(auto& p : _pairs){
+		if(matchOfFirst[p.first] >= 0 || _taken[p.second]) continue;
+		matchOfFirst[p.first] = p.second;
+		_taken[p.second] = 1;
+	}
+}
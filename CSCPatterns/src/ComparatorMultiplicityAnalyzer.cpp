@@ -34,6 +34,7 @@
 #include "../include/CSCHelper.h"
 
 #include "../include/ComparatorMultiplicityAnalyzer.h"
+#include "../include/StageTimers.h"
 
 using namespace std;
 
@@ -82,7 +83,8 @@ int ComparatorMultiplicityAnalyzer::run(string inputfile, string outputfile, int
 	// Map to look at probability
 	// TODO: incorporate this functionality into LUT class once it is more figured out
 	//
-	//LUT bayesLUT("bayes", LINEFIT_LUT_PATH);
+	//LUT bayesLUT("bayes");
+	//bayesLUT.loadLinearFits();
 
 	//
 	// OUTPUT TREE
@@ -107,6 +109,15 @@ int ComparatorMultiplicityAnalyzer::run(string inputfile, string outputfile, int
 		clctRMS.push_back(rms);
 	}
 
+	//high multiplicity trigger flag, from the hit counts filling the chamber makes
+	const ShowerConfig showerConfig;
+	vector<TH1F*> showerFlags;
+	for(auto& name : CHAMBER_NAMES){
+		TH1F* flag = new TH1F(("h_showerFlag_"+name).c_str(), ("h_showerFlag_"+name+"; Shower (none, loose, nominal, tight); Chambers").c_str(), 4, 0, 4);
+		showerFlags.push_back(flag);
+	}
+	TH2F* h_showerFlagVsGenP = new TH2F("h_showerFlagVsGenP", "h_showerFlagVsGenP; Gen P [GeV]; Shower (none, loose, nominal, tight)", 60, 100., 6000., 4, 0, 4);
+
 	TH1F* h_nChambersShowered = new TH1F("h_nChambersShowered", "h_nChambersShowered; Amount of Showering (>1 CLCT) Chambers In Event; Events", 20, 0, 20);
 	TH2F* h_multiplicityVsPt = new TH2F("h_multiplicityVsPt", "h_multiplicityVsPt; Pt [GeV]; CLCT Multiplicity",  40, 0, 400,10, 1, 11);
 	TH2F* h_multiplicityVsP = new TH2F("h_multiplicityVsP", "h_multiplicityVsP; P [GeV]; CLCT Multiplicity",  80, 0, 800,10, 1, 11);
@@ -174,7 +185,10 @@ int ComparatorMultiplicityAnalyzer::run(string inputfile, string outputfile, int
 	for(int i = start; i < end; i++) {
 		if(!(i%100)) printf("%3.2f%% Done --- Processed %u Events\n", 100.*(i-start)/(end-start), i-start);
 
-		t->GetEntry(i);
+		{
+			STAGE_TIMER("read");
+			t->GetEntry(i);
+		}
 
 		float genP = 0;
 
@@ -294,6 +308,14 @@ int ComparatorMultiplicityAnalyzer::run(string inputfile, string outputfile, int
 
 			if(chamberCompHits.fill(comparators)) return -1;
 
+			if(chamberCompHits.nhits()){
+				int flag = showerFlag(chamberCompHits, showerConfig);
+				for(unsigned int ic = 0; ic < NCHAMBERS; ic++){
+					if(ST == CHAMBER_ST_RI[ic][0] && RI == CHAMBER_ST_RI[ic][1]) showerFlags.at(ic)->Fill(flag);
+				}
+				h_showerFlagVsGenP->Fill(genP, flag);
+			}
+
 			ChamberHits chamberRecHits(ST,RI,EC,CH);
 
 			if(chamberRecHits.fill(recHits)) return -1;
@@ -443,6 +465,8 @@ int ComparatorMultiplicityAnalyzer::run(string inputfile, string outputfile, int
 	}
 
 	for(auto& hist: clctRMS) hist->Write();
+	for(auto& hist: showerFlags) hist->Write();
+	h_showerFlagVsGenP->Write();
 	h_multiplicityVsPt->Write();
 	h_multiplicityVsP->Write();
 
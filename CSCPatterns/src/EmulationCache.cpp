@@ -0,0 +1,362 @@
+/*
+ * EmulationCache.cpp
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: agent
+ */
+
+#include "../include/EmulationCache.h"
+#include "../include/CSCHelper.h"
+
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/file.h>
+#include <iostream>
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+
+namespace {
+
+const char CACHE_MAGIC[8] = {'C','S','C','E','M','C','1','\0'};
+const uint32_t CACHE_VERSION = 1;
+
+struct CacheHeader {
+	char magic[8];
+	uint32_t version;
+	uint32_t reserved;
+};
+
+struct IndexEntry {
+	uint64_t run;
+	uint64_t event;
+	uint64_t version;
+	uint32_t chamberHash;
+	uint32_t reserved;
+	uint64_t offset;
+};
+
+struct CacheFooter {
+	uint64_t indexOffset;
+	uint64_t nEntries;
+	char magic[8];
+};
+
+EmulationKey key(const IndexEntry& e){
+	return EmulationKey(e.run, e.event, e.chamberHash, e.version);
+}
+
+bool entryLess(const IndexEntry& a, const IndexEntry& b){
+	return key(a) < key(b);
+}
+
+//reads all of [offset, offset+size), -1 if it can't
+int readAt(int fd, void* data, size_t size, off_t offset){
+	char* bytes = (char*)data;
+	while(size){
+		ssize_t n = pread(fd, bytes, size, offset);
+		if(n <= 0) return -1;
+		bytes += n;
+		size -= n;
+		offset += n;
+	}
+	return 0;
+}
+
+int writeAt(int fd, const void* data, size_t size, off_t offset){
+	const char* bytes = (const char*)data;
+	while(size){
+		ssize_t n = pwrite(fd, bytes, size, offset);
+		if(n <= 0) return -1;
+		bytes += n;
+		size -= n;
+		offset += n;
+	}
+	return 0;
+}
+
+//FNV-1a
+void fnv(unsigned long long& h, const void* data, size_t size){
+	const unsigned char* bytes = (const unsigned char*)data;
+	for(size_t i = 0; i < size; i++){
+		h ^= bytes[i];
+		h *= 1099511628211ULL;
+	}
+}
+
+void fnv(unsigned long long& h, long long value){
+	fnv(h, &value, sizeof(value));
+}
+
+}
+
+bool EmulationKey::operator<(const EmulationKey& k) const {
+	if(run != k.run) return run < k.run;
+	if(event != k.event) return event < k.event;
+	if(chamberHash != k.chamberHash) return chamberHash < k.chamberHash;
+	return version < k.version;
+}
+
+bool EmulationKey::operator==(const EmulationKey& k) const {
+	return run == k.run && event == k.event && chamberHash == k.chamberHash && version == k.version;
+}
+
+struct EmulationCache::State {
+	State() : fd(-1), pid(0), end(0), hits(0), misses(0) {}
+
+	int fd;
+	pid_t pid; //that opened it, the only one writing to it
+	off_t end; //of the entries, where the next one goes
+	vector<IndexEntry> index; //sorted, what was in the file
+	vector<IndexEntry> added; //put since, in no order
+	mutable mutex m; //of end and added
+	mutable atomic<unsigned long long> hits;
+	mutable atomic<unsigned long long> misses;
+};
+
+EmulationCache::EmulationCache() :
+	_state(0)
+{}
+
+EmulationCache::~EmulationCache(){
+	close();
+}
+
+int EmulationCache::open(const string& file){
+	close();
+	int fd = ::open(file.c_str(), O_RDWR | O_CREAT, 0644);
+	if(fd < 0){
+		cout << "Error: can't open emulation cache: " << file << endl;
+		return -1;
+	}
+	//held until the fd is closed, by this process and its forked children
+	if(flock(fd, LOCK_EX | LOCK_NB)){
+		cout << "Error: emulation cache is in use by another job: " << file << endl;
+		::close(fd);
+		return -1;
+	}
+	_file = file;
+	_state = new State();
+	_state->fd = fd;
+	_state->pid = getpid();
+
+	struct stat st;
+	CacheHeader header;
+	CacheFooter footer;
+	bool valid = !fstat(fd, &st) && st.st_size >= (off_t)(sizeof(header) + sizeof(footer)) &&
+			!readAt(fd, &header, sizeof(header), 0) &&
+			!memcmp(header.magic, CACHE_MAGIC, sizeof(CACHE_MAGIC)) && header.version == CACHE_VERSION &&
+			!readAt(fd, &footer, sizeof(footer), st.st_size - sizeof(footer)) &&
+			!memcmp(footer.magic, CACHE_MAGIC, sizeof(CACHE_MAGIC)) &&
+			footer.indexOffset + footer.nEntries*sizeof(IndexEntry) + sizeof(footer) == (uint64_t)st.st_size;
+	if(valid){
+		_state->index.resize(footer.nEntries);
+		if(footer.nEntries && readAt(fd, &_state->index[0], footer.nEntries*sizeof(IndexEntry), footer.indexOffset)) valid = false;
+		_state->end = footer.indexOffset;
+		//the index is written again on close(), until then the file isn't a valid cache
+		if(valid && ftruncate(fd, _state->end)){
+			cout << "Error: can't write to emulation cache: " << file << endl;
+			close();
+			return -1;
+		}
+	}
+	if(!valid){
+		if(st.st_size) cout << "Warning: emulation cache wasn't closed or is from another version, starting over: " << file << endl;
+		_state->index.clear();
+		memset(&header, 0, sizeof(header));
+		memcpy(header.magic, CACHE_MAGIC, sizeof(CACHE_MAGIC));
+		header.version = CACHE_VERSION;
+		if(ftruncate(fd, 0) || writeAt(fd, &header, sizeof(header), 0)){
+			cout << "Error: can't write to emulation cache: " << file << endl;
+			close();
+			return -1;
+		}
+		_state->end = sizeof(header);
+	}
+	return 0;
+}
+
+int EmulationCache::get(const EmulationKey& k, int& status, vector<EmulatedCandidate>& found) const {
+	if(!_state) return 1;
+	IndexEntry e;
+	memset(&e, 0, sizeof(e));
+	e.run = k.run;
+	e.event = k.event;
+	e.version = k.version;
+	e.chamberHash = k.chamberHash;
+	auto it = lower_bound(_state->index.begin(), _state->index.end(), e, entryLess);
+	if(it == _state->index.end() || !(key(*it) == k)){
+		_state->misses++;
+		return 1;
+	}
+
+	int8_t head[2];
+	if(readAt(_state->fd, head, sizeof(head), it->offset)){
+		_state->misses++;
+		return 1;
+	}
+	vector<int32_t> values(5*(uint8_t)head[1]);
+	if(values.size() && readAt(_state->fd, &values[0], values.size()*sizeof(int32_t), it->offset+sizeof(head))){
+		_state->misses++;
+		return 1;
+	}
+	status = head[0];
+	for(unsigned int i = 0; i < values.size(); i += 5){
+		found.push_back(EmulatedCandidate(values[i], values[i+1], values[i+2], values[i+3], values[i+4]));
+	}
+	_state->hits++;
+	return 0;
+}
+
+int EmulationCache::put(const EmulationKey& k, int status, const vector<EmulatedCandidate>& found){
+	if(!_state || _state->pid != getpid()) return -1;
+	unsigned int n = found.size() < 255 ? found.size() : 255;
+	vector<char> record(2 + 5*sizeof(int32_t)*n);
+	record[0] = status;
+	record[1] = n;
+	for(unsigned int i = 0; i < n; i++){
+		const EmulatedCandidate& c = found[i];
+		int32_t values[5] = {c.key, c.pattern, c.code, c.layers, c.bx};
+		memcpy(&record[2 + i*sizeof(values)], values, sizeof(values));
+	}
+
+	IndexEntry e;
+	memset(&e, 0, sizeof(e));
+	e.run = k.run;
+	e.event = k.event;
+	e.version = k.version;
+	e.chamberHash = k.chamberHash;
+
+	lock_guard<mutex> lock(_state->m);
+	e.offset = _state->end;
+	if(writeAt(_state->fd, &record[0], record.size(), e.offset)) return -1;
+	_state->end += record.size();
+	_state->added.push_back(e);
+	return 0;
+}
+
+int EmulationCache::close(){
+	if(!_state) return 0;
+	int result = 0;
+	if(_state->pid == getpid()){
+		vector<IndexEntry>& index = _state->index;
+		index.insert(index.end(), _state->added.begin(), _state->added.end());
+		stable_sort(index.begin(), index.end(), entryLess);
+		//the same chamber put twice, keep the first
+		index.erase(unique(index.begin(), index.end(),
+				[](const IndexEntry& a, const IndexEntry& b){return key(a) == key(b);}), index.end());
+
+		CacheFooter footer;
+		memset(&footer, 0, sizeof(footer));
+		footer.indexOffset = _state->end;
+		footer.nEntries = index.size();
+		memcpy(footer.magic, CACHE_MAGIC, sizeof(CACHE_MAGIC));
+		off_t footerOffset = _state->end + index.size()*sizeof(IndexEntry);
+		if((index.size() && writeAt(_state->fd, &index[0], index.size()*sizeof(IndexEntry), _state->end)) ||
+				writeAt(_state->fd, &footer, sizeof(footer), footerOffset) ||
+				ftruncate(_state->fd, footerOffset + sizeof(footer)) ||
+				fsync(_state->fd)){
+			cout << "Error: can't write to emulation cache: " << _file << endl;
+			result = -1;
+		}
+	}
+	::close(_state->fd);
+	delete _state;
+	_state = 0;
+	return result;
+}
+
+unsigned long long EmulationCache::hits() const {
+	return _state ? _state->hits.load() : 0;
+}
+
+unsigned long long EmulationCache::misses() const {
+	return _state ? _state->misses.load() : 0;
+}
+
+unsigned long long EmulationCache::size() const {
+	if(!_state) return 0;
+	lock_guard<mutex> lock(_state->m);
+	return _state->index.size() + _state->added.size();
+}
+
+void EmulationCache::printSummary() const {
+	CacheLookups lookups;
+	lookups.hits = hits();
+	lookups.misses = misses();
+	printSummary(lookups);
+}
+
+void EmulationCache::printSummary(const CacheLookups& lookups) const {
+	if(!_state) return;
+	unsigned long long all = lookups.hits + lookups.misses;
+	printf("Emulation cache: %llu / %llu chambers read from %s (%.1f%%), %llu entries\n", lookups.hits, all,
+			_file.c_str(), all ? 100.*lookups.hits/all : 0., size());
+}
+
+unsigned long long EmulationCache::version(const string& emulator, const vector<CSCPattern>* patterns,
+		bool useBusyWindow, const CLCTConfig& config){
+	unsigned long long h = 14695981039346656037ULL;
+	fnv(h, CACHE_VERSION);
+	fnv(h, emulator.c_str(), emulator.size());
+	if(patterns){
+		for(auto& p : *patterns){
+			fnv(h, p._id);
+			fnv(h, p._isLegacy);
+			fnv(h, p._pat, sizeof(p._pat));
+		}
+	}
+	fnv(h, useBusyWindow);
+	fnv(h, config.busyWindow);
+	fnv(h, config.layerRequirement);
+	fnv(h, config.timeWindow);
+	fnv(h, config.startTime);
+	fnv(h, config.maxCLCTs);
+	fnv(h, config.skipQuietRegions);
+	return h;
+}
+
+CachedCLCTSearch::CachedCLCTSearch(const vector<CSCPattern>* patterns, bool useBusyWindow, const CLCTConfig& config) :
+	_patterns(patterns),
+	_useBusyWindow(useBusyWindow),
+	_config(config),
+	_version(EmulationCache::version("searchForMatch", patterns, useBusyWindow, config))
+{}
+
+int CachedCLCTSearch::find(EmulationCache* cache, unsigned long long run, unsigned long long event,
+		const ChamberHits& c, vector<CLCTCandidate*>& m, CacheLookups* lookups) const {
+	if(!cache || !cache->isOpen()) return searchForMatch(c, _patterns, m, _useBusyWindow, _config);
+
+	EmulationKey key(run, event, CSCHelper::serialize(c._station, c._ring, c._chamber, c._endcap), _version);
+	int status = 0;
+	vector<EmulatedCandidate> found;
+	if(!cache->get(key, status, found)){
+		//make the candidates searchForMatch would have, from the patterns they were found with
+		vector<const CSCPattern*> patterns;
+		for(auto& f : found){
+			patterns.push_back(0);
+			for(auto& pattern : *_patterns) if((int)pattern._id == f.pattern) patterns.back() = &pattern;
+		}
+		if(std::find(patterns.begin(), patterns.end(), (const CSCPattern*)0) == patterns.end()){
+			for(unsigned int i = 0; i < found.size(); i++){
+				const EmulatedCandidate& f = found[i];
+				const CSCPattern& p = *patterns[i];
+				int horizontalIndex = f.key - MAX_PATTERN_WIDTH/2 + 1;
+				if(p._isLegacy) m.push_back(new CLCTCandidate(p, horizontalIndex, f.bx, f.layers));
+				else m.push_back(new CLCTCandidate(p, ComparatorCode(f.code), horizontalIndex, f.bx));
+			}
+			if(lookups) lookups->hits++;
+			return status;
+		}
+		found.clear();
+	}
+
+	if(lookups) lookups->misses++;
+	unsigned int before = m.size();
+	status = searchForMatch(c, _patterns, m, _useBusyWindow, _config);
+	for(unsigned int i = before; i < m.size(); i++) found.push_back(Emulators::candidate(*m[i]));
+	cache->put(key, status, found);
+	return status;
+}
@@ -0,0 +1,563 @@
+/*
+ * EmulationSweepAnalyzer.cpp
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: agent
+ */
+
+#include <TTree.h>
+#include <TFile.h>
+#include <TH1F.h>
+#include <TDirectory.h>
+#include <TVectorD.h>
+
+#include <string>
+#include <vector>
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <stdio.h>
+#include <stdlib.h>
+#include <chrono>
+
+#include "../include/CSCInfo.h"
+#include "../include/CSCHelper.h"
+#include "../include/CSCConstants.h"
+#include "../include/CSCClasses.h"
+#include "../include/EmulationSweepAnalyzer.h"
+#include "../include/StageTimers.h"
+
+using namespace std;
+
+//seconds and counts of SweepResult, as saved in checkpoints
+const unsigned int N_SWEEP_COUNTERS = 7;
+
+int main(int argc, char* argv[]){
+	EmulationSweepAnalyzer p;
+	return p.main(argc,argv);
+}
+
+SweepResult::SweepResult() :
+	clctSeconds(0),
+	alctSeconds(0),
+	clctChambers(0),
+	clctFailures(0),
+	clctCandidates(0),
+	alctChambers(0),
+	alctCandidates(0),
+	clctMultiplicity(0),
+	alctMultiplicity(0),
+	clctSegmentPt(0),
+	clctMatchedPt(0),
+	alctSegmentPt(0),
+	alctMatchedPt(0),
+	clctPosDiff(0),
+	alctPosDiff(0),
+	showerFlag(0)
+{}
+
+EmulationSweepAnalyzer::EmulationSweepAnalyzer() :
+	_clctName("tmb"),
+	_alctName("alct"),
+	_clct(0),
+	_alct(0),
+	_clctTolerance(1),
+	_alctTolerance(2),
+	_muons(0),
+	_segments(0),
+	_comparators(0),
+	_wires(0)
+{}
+
+EmulationSweepAnalyzer::~EmulationSweepAnalyzer(){
+	delete _muons;
+	delete _segments;
+	delete _comparators;
+	delete _wires;
+	for(auto h : _hists) delete h;
+}
+
+int EmulationSweepAnalyzer::parseConfig(const string& line, SweepConfig& config){
+	stringstream ss(line);
+	if(!(ss >> config.name)) return -1;
+	config.clct = CLCTConfig();
+	config.alct = ALCTConfig();
+	config.shower = ShowerConfig();
+	string setting;
+	while(ss >> setting){
+		size_t equals = setting.find('=');
+		if(equals == string::npos || equals+1 == setting.size()){
+			cout << "Error: expected key=value, got: " << setting << endl;
+			return -1;
+		}
+		const string key = setting.substr(0, equals);
+		const int value = atoi(setting.c_str()+equals+1);
+		CLCTConfig& c = config.clct;
+		ALCTConfig& a = config.alct;
+		ShowerConfig& s = config.shower;
+		if((key == "start_time" || key == "shower_start") && value < 1){
+			cout << "Error: time bins start at 1, got: " << setting << endl;
+			return -1;
+		}
+		if(key == "busy_window") c.busyWindow = value;
+		else if(key == "layers") c.layerRequirement = value;
+		else if(key == "time_window") c.timeWindow = value;
+		else if(key == "start_time") c.startTime = value;
+		else if(key == "max_clcts") c.maxCLCTs = value;
+		else if(key == "skip_quiet") c.skipQuietRegions = value;
+		else if(key == "shower_start") s.startTime = value;
+		else if(key == "shower_window") s.timeWindow = value;
+		else if(key == "shower_loose") s.thresholds[0] = value;
+		else if(key == "shower_nominal") s.thresholds[1] = value;
+		else if(key == "shower_tight") s.thresholds[2] = value;
+		else if(key == "fifo_tbins" && value <= 16) a.set_fifo_tbins(value); //16 time bins are filled
+		else if(key == "fifo_pretrig") a.set_fifo_pretrig(value);
+		else if(key == "drift_delay") a.set_drift_delay(value);
+		else if(key == "nplanes_hit_pretrig") a.set_nplanes_hit_pretrig(value);
+		else if(key == "nplanes_hit_pattern") a.set_nplanes_hit_pattern(value);
+		else if(key == "nplanes_accel_pretrig") a.set_nplanes_accel_pretrig(value);
+		else if(key == "nplanes_accel_pattern") a.set_nplanes_accel_pattern(value);
+		else if(key == "trig_mode") a.set_trig_mode(value);
+		else if(key == "accel_mode") a.set_accel_mode(value);
+		else if(key == "hit_persist") a.set_hit_persist(value);
+		else if(key == "l1a_window") a.set_l1a_window(value);
+		else if(key == "ghost_cancel") a.set_ghost_cancel(value);
+		else if(key == "narrow_mask") a.set_narrow_mask_flag(value);
+		else {
+			cout << "Error: unknown or out of range setting: " << setting << endl;
+			return -1;
+		}
+	}
+	return 0;
+}
+
+int EmulationSweepAnalyzer::readConfigs(const string& file){
+	ifstream in(file.c_str());
+	if(!in){
+		cout << "Error: can't open sweep file: " << file << endl;
+		return -1;
+	}
+	string line;
+	while(getline(in, line)){
+		line = line.substr(0, line.find('#'));
+		if(line.find_first_not_of(" \t\r") == string::npos) continue;
+		SweepConfig config;
+		if(parseConfig(line, config)) return -1;
+		_configs.push_back(config);
+	}
+	return 0;
+}
+
+int EmulationSweepAnalyzer::option(int argc, char* argv[], int i){
+	const string arg = argv[i];
+	const bool hasValue = i+1 < argc;
+	if(arg == "--sweep" && hasValue) return readConfigs(argv[i+1]) ? -1 : 2;
+	if(arg == "--config" && hasValue){
+		SweepConfig config;
+		if(parseConfig(argv[i+1], config)) return -1;
+		_configs.push_back(config);
+		return 2;
+	}
+	if(arg == "--clct" && hasValue) _clctName = argv[i+1];
+	else if(arg == "--alct" && hasValue) _alctName = argv[i+1];
+	else if(arg == "--clct-tolerance" && hasValue) _clctTolerance = atof(argv[i+1]);
+	else if(arg == "--alct-tolerance" && hasValue) _alctTolerance = atof(argv[i+1]);
+	else return 0;
+	return 2;
+}
+
+/* @brief Picks the emulators, they are shared by all the workers
+ */
+int EmulationSweepAnalyzer::setup() {
+	if(_configs.empty()){
+		SweepConfig config;
+		parseConfig("default", config);
+		_configs.push_back(config);
+	}
+	for(unsigned int i = 0; i < _configs.size(); i++){
+		for(unsigned int j = 0; j < i; j++){
+			if(_configs[i].name != _configs[j].name) continue;
+			cout << "Error: two configurations named: " << _configs[i].name << endl;
+			return -1;
+		}
+	}
+	if(_clctName != "none" && !(_clct = Emulators::findCLCT(_clctName))){
+		cout << "Error: no clct emulator named: " << _clctName << endl;
+		return -1;
+	}
+	if(_alctName != "none" && !(_alct = Emulators::findALCT(_alctName))){
+		cout << "Error: no alct emulator named: " << _alctName << endl;
+		return -1;
+	}
+	cout << "Sweeping " << _configs.size() << " configurations of " << _clctName << " and " << _alctName << endl;
+	return 0;
+}
+
+Processor* EmulationSweepAnalyzer::makeWorker() const {
+	EmulationSweepAnalyzer* worker = new EmulationSweepAnalyzer();
+	worker->_configs = _configs;
+	worker->_clctName = _clctName;
+	worker->_alctName = _alctName;
+	worker->_clct = _clct;
+	worker->_alct = _alct;
+	worker->_clctTolerance = _clctTolerance;
+	worker->_alctTolerance = _alctTolerance;
+	return worker;
+}
+
+TH1F* EmulationSweepAnalyzer::book(const string& name, const string& title, unsigned int bins, float low, float high){
+	TH1F* h = new TH1F(name.c_str(), title.c_str(), bins, low, high);
+	_hists.push_back(h);
+	return h;
+}
+
+int EmulationSweepAnalyzer::beginWorker(TTree* t) {
+	CSCInfo::disableAll(t);
+	_muons = new CSCInfo::Muons(t);
+	_segments = new CSCInfo::Segments(t);
+	_comparators = new CSCInfo::Comparators(t);
+	_wires = new CSCInfo::Wires(t);
+
+	_muons->select({"pt"});
+	_segments->select({"mu_id", "ch_id", "pos_x", "pos_y"});
+	if(_clct) _comparators->select({"ch_id", "lay", "strip", "halfStrip", "bestTime"});
+	else _comparators->select({"ch_id"});
+	if(_alct) _wires->select({"ch_id", "lay", "group", "timeBin", "timeBinWord"});
+	else _wires->select({"ch_id"});
+
+	_clctMatcher = CandidateMatcher(CandidateMatcher::NEAREST, _clctTolerance);
+	_alctMatcher = CandidateMatcher(CandidateMatcher::NEAREST, _alctTolerance);
+
+	_results.resize(_configs.size());
+	for(auto& r : _results){
+		r.clctMultiplicity = book("h_clctMultiplicity", "h_clctMultiplicity; CLCTs; Chambers", 10, 0, 10);
+		r.alctMultiplicity = book("h_alctMultiplicity", "h_alctMultiplicity; ALCTs; Chambers", 10, 0, 10);
+		r.clctSegmentPt = book("h_clctSegmentPt", "h_clctSegmentPt; Pt [GeV]; Segments", 50, 0, 100);
+		r.clctMatchedPt = book("h_clctMatchedPt", "h_clctMatchedPt; Pt [GeV]; Segments with a CLCT", 50, 0, 100);
+		r.alctSegmentPt = book("h_alctSegmentPt", "h_alctSegmentPt; Pt [GeV]; Segments", 50, 0, 100);
+		r.alctMatchedPt = book("h_alctMatchedPt", "h_alctMatchedPt; Pt [GeV]; Segments with an ALCT", 50, 0, 100);
+		r.clctPosDiff = book("h_clctPosDiff", "h_clctPosDiff; Seg - CLCT [strips]; Segments", 100, -2, 2);
+		r.alctPosDiff = book("h_alctPosDiff", "h_alctPosDiff; Seg - ALCT [wire groups]; Segments", 40, -5, 5);
+		r.showerFlag = book("h_showerFlag", "h_showerFlag; Shower (none, loose, nominal, tight); Chambers", 4, 0, 4);
+	}
+	return 0;
+}
+
+/* @brief Fills the comparator hits once, then runs every configuration on them
+ */
+void EmulationSweepAnalyzer::emulateCLCTs(unsigned int chamberHash){
+	CSCHelper::ChamberId c = CSCHelper::unserialize(chamberHash);
+
+	_segmentPos.clear();
+	_segmentPt.clear();
+	for(unsigned int iseg = 0; iseg < _segments->size(); iseg++){
+		if((unsigned int)_segments->ch_id->at(iseg) != chamberHash) continue;
+		int mu = _segments->mu_id->at(iseg);
+		if(mu == -1) continue;
+		float segmentX = _segments->pos_x->at(iseg);
+		if(CSCHelper::segmentIsOnEdgeOfChamber(segmentX, c.station, c.ring)) continue;
+		_segmentPos.push_back(segmentX);
+		_segmentPt.push_back(_muons->pt->at(mu));
+	}
+	if(!_hasComparators[chamberHash] && _segmentPos.empty()) return;
+
+	ChamberHits compHits(c.station, c.ring, c.endcap, c.chamber);
+	if(_hasComparators[chamberHash]){
+		STAGE_TIMER("hit filling");
+		if(compHits.fill(*_comparators)) return;
+	}
+
+	for(unsigned int ic = 0; ic < _configs.size(); ic++){
+		SweepResult& r = _results[ic];
+		_found.clear();
+		if(_hasComparators[chamberHash]){
+			STAGE_TIMER("clct emulation");
+			auto t1 = chrono::steady_clock::now();
+			int status = _clct->find(compHits, _configs[ic].clct, _found);
+			r.clctSeconds += chrono::duration<double>(chrono::steady_clock::now()-t1).count();
+			r.clctChambers++;
+			r.showerFlag->Fill(showerFlag(compHits, _configs[ic].shower));
+			if(status){
+				//as the analyzers, chambers that can't be emulated are left out
+				r.clctFailures++;
+				continue;
+			}
+			r.clctCandidates += _found.size();
+			r.clctMultiplicity->Fill(_found.size());
+		}
+
+		STAGE_TIMER("matching");
+		_clctMatcher.match(_segmentPos.size(), [this](unsigned int i){return MatchKey(_segmentPos[i]);},
+				_found.size(), [this](unsigned int i){return MatchKey(_found[i].key/2. + 1);}, _matches);
+		for(unsigned int iseg = 0; iseg < _segmentPos.size(); iseg++){
+			r.clctSegmentPt->Fill(_segmentPt[iseg]);
+			if(_matches[iseg] < 0) continue;
+			r.clctMatchedPt->Fill(_segmentPt[iseg]);
+			r.clctPosDiff->Fill(_segmentPos[iseg] - (_found[_matches[iseg]].key/2. + 1));
+		}
+	}
+}
+
+/* @brief Fills the 16 time bins of the wires once, then runs every
+ * configuration on them. ME1/1b is read along with ME1/1a, as in
+ * ALCTEmulationTreeCreator
+ */
+void EmulationSweepAnalyzer::emulateALCTs(unsigned int chamberHash){
+	CSCHelper::ChamberId c = CSCHelper::unserialize(chamberHash);
+	const unsigned int ST = c.station;
+	const unsigned int RI = c.ring;
+	const unsigned int CH = c.chamber;
+	const unsigned int EC = c.endcap;
+	if(ST == 1 && RI == 1) return;
+
+	unsigned int chSid1 = chamberHash;
+	unsigned int chSid2 = ST == 1 && RI == 4 ? CSCHelper::serialize(ST, 1, CH, EC) : chSid1;
+	const bool hasWires = _hasWires[chSid1] || _hasWires[chSid2];
+
+	_segmentPos.clear();
+	_segmentPt.clear();
+	for(unsigned int iseg = 0; iseg < _segments->size(); iseg++){
+		unsigned int segHash = _segments->ch_id->at(iseg);
+		if(segHash != chSid1 && segHash != chSid2) continue;
+		int mu = _segments->mu_id->at(iseg);
+		if(mu == -1) continue;
+		int pos_seg = _segments->pos_y->at(iseg)-1;
+		if(pos_seg < 0) continue;
+		_segmentPos.push_back(pos_seg);
+		_segmentPt.push_back(_muons->pt->at(mu));
+	}
+	if(!hasWires && _segmentPos.empty()) return;
+
+	vector<ALCT_ChamberHits*> cvec;
+	if(hasWires){
+		STAGE_TIMER("hit filling");
+		for(int tbin = 0; tbin < 16; tbin++){
+			ALCT_ChamberHits* hits = new ALCT_ChamberHits(ST, RI, CH, EC);
+			hits->fill(*_wires, tbin);
+			cvec.push_back(hits);
+		}
+	}
+
+	for(unsigned int ic = 0; ic < _configs.size(); ic++){
+		SweepResult& r = _results[ic];
+		_found.clear();
+		if(hasWires){
+			STAGE_TIMER("alct emulation");
+			auto t1 = chrono::steady_clock::now();
+			_alct->find(cvec, _configs[ic].alct, _found);
+			r.alctSeconds += chrono::duration<double>(chrono::steady_clock::now()-t1).count();
+			r.alctChambers++;
+			r.alctCandidates += _found.size();
+			r.alctMultiplicity->Fill(_found.size());
+		}
+
+		STAGE_TIMER("matching");
+		_alctMatcher.match(_segmentPos.size(), [this](unsigned int i){return MatchKey(_segmentPos[i]);},
+				_found.size(), [this](unsigned int i){return MatchKey(_found[i].key);}, _matches);
+		for(unsigned int iseg = 0; iseg < _segmentPos.size(); iseg++){
+			r.alctSegmentPt->Fill(_segmentPt[iseg]);
+			if(_matches[iseg] < 0) continue;
+			r.alctMatchedPt->Fill(_segmentPt[iseg]);
+			r.alctPosDiff->Fill(_segmentPos[iseg] - _found[_matches[iseg]].key);
+		}
+	}
+	wipe(cvec);
+}
+
+int EmulationSweepAnalyzer::processEntry(long long entry) {
+
+	//chambers with anything to emulate, so the empty ones are skipped
+	_hasComparators.assign(CSCHelper::MAX_CHAMBER_HASH, 0);
+	_hasWires.assign(CSCHelper::MAX_CHAMBER_HASH, 0);
+	for(auto id : *_comparators->ch_id) if(id >= 0 && (unsigned int)id < _hasComparators.size()) _hasComparators[id] = 1;
+	for(auto id : *_wires->ch_id) if(id >= 0 && (unsigned int)id < _hasWires.size()) _hasWires[id] = 1;
+
+	for(unsigned int chamberHash = 0; chamberHash < CSCHelper::MAX_CHAMBER_HASH; chamberHash++){
+		CSCHelper::ChamberId c = CSCHelper::unserialize(chamberHash);
+		if(!CSCHelper::isValidChamber(c.station, c.ring, c.chamber, c.endcap)) continue;
+		if(_clct) emulateCLCTs(chamberHash);
+		if(_alct) emulateALCTs(chamberHash);
+	}
+	return 0;
+}
+
+int EmulationSweepAnalyzer::mergeWorker(Processor* worker) {
+	EmulationSweepAnalyzer* w = dynamic_cast<EmulationSweepAnalyzer*>(worker);
+	if(!w || w->_hists.size() != _hists.size() || w->_results.size() != _results.size()) return -1;
+
+	for(unsigned int i=0; i < _hists.size(); i++) _hists[i]->Add(w->_hists[i]);
+
+	for(unsigned int ic = 0; ic < _results.size(); ic++){
+		SweepResult& r = _results[ic];
+		const SweepResult& o = w->_results[ic];
+		r.clctSeconds += o.clctSeconds;
+		r.alctSeconds += o.alctSeconds;
+		r.clctChambers += o.clctChambers;
+		r.clctFailures += o.clctFailures;
+		r.clctCandidates += o.clctCandidates;
+		r.alctChambers += o.alctChambers;
+		r.alctCandidates += o.alctCandidates;
+	}
+	return 0;
+}
+
+/* @brief Histograms by booking order and the counters of each configuration
+ */
+int EmulationSweepAnalyzer::writeCheckpoint(TDirectory* dir) {
+	for(unsigned int i=0; i < _hists.size(); i++) dir->WriteTObject(_hists[i], ("h" + to_string(i)).c_str());
+
+	TVectorD counters(N_SWEEP_COUNTERS*_results.size());
+	for(unsigned int ic = 0; ic < _results.size(); ic++){
+		const SweepResult& r = _results[ic];
+		const unsigned int i = N_SWEEP_COUNTERS*ic;
+		counters[i] = r.clctSeconds;
+		counters[i+1] = r.alctSeconds;
+		counters[i+2] = r.clctChambers;
+		counters[i+3] = r.clctFailures;
+		counters[i+4] = r.clctCandidates;
+		counters[i+5] = r.alctChambers;
+		counters[i+6] = r.alctCandidates;
+	}
+	return dir->WriteTObject(&counters, "counters") > 0 ? 0 : -1;
+}
+
+/* @brief Adds the checkpoint to what beginWorker booked, which is still empty
+ */
+int EmulationSweepAnalyzer::readCheckpoint(TDirectory* dir) {
+	for(unsigned int i=0; i < _hists.size(); i++){
+		TH1* saved = 0;
+		dir->GetObject(("h" + to_string(i)).c_str(), saved);
+		if(!saved) {
+			cout << "Error: checkpoint is missing histogram " << _hists[i]->GetName() << endl;
+			return -1;
+		}
+		_hists[i]->Add(saved);
+		delete saved;
+	}
+
+	TVectorD* counters = 0;
+	dir->GetObject("counters", counters);
+	if(!counters || counters->GetNrows() != (int)(N_SWEEP_COUNTERS*_results.size())) {
+		cout << "Error: checkpoint is missing the counters, or is of other configurations" << endl;
+		delete counters;
+		return -1;
+	}
+	for(unsigned int ic = 0; ic < _results.size(); ic++){
+		SweepResult& r = _results[ic];
+		const unsigned int i = N_SWEEP_COUNTERS*ic;
+		r.clctSeconds = (*counters)[i];
+		r.alctSeconds = (*counters)[i+1];
+		r.clctChambers = (*counters)[i+2];
+		r.clctFailures = (*counters)[i+3];
+		r.clctCandidates = (*counters)[i+4];
+		r.alctChambers = (*counters)[i+5];
+		r.alctCandidates = (*counters)[i+6];
+	}
+	delete counters;
+	return 0;
+}
+
+int EmulationSweepAnalyzer::writeOutput(const string& outputfile) {
+
+	TFile * outF = new TFile(outputfile.c_str(),"RECREATE");
+	if(!outF){
+		printf("Failed to open output file: %s\n", outputfile.c_str());
+		return -1;
+	}
+
+	//one entry per configuration, to plot against its settings
+	string name;
+	int busyWindow, layers, timeWindow, startTime;
+	int fifoTbins, fifoPretrig, driftDelay, nplanesHitPretrig, nplanesHitPattern, trigMode, accelMode, hitPersist;
+	int maxCLCTs, skipQuiet, showerNominal;
+	float clctEfficiency, alctEfficiency, clctsPerChamber, alctsPerChamber, clctSeconds, alctSeconds, showerRate;
+	TTree* sweep = new TTree("sweep", "Efficiency and multiplicity of each configuration");
+	sweep->Branch("name", &name);
+	sweep->Branch("busyWindow", &busyWindow, "busyWindow/I");
+	sweep->Branch("layers", &layers, "layers/I");
+	sweep->Branch("timeWindow", &timeWindow, "timeWindow/I");
+	sweep->Branch("startTime", &startTime, "startTime/I");
+	sweep->Branch("maxCLCTs", &maxCLCTs, "maxCLCTs/I");
+	sweep->Branch("skipQuiet", &skipQuiet, "skipQuiet/I");
+	sweep->Branch("showerNominal", &showerNominal, "showerNominal/I");
+	sweep->Branch("fifoTbins", &fifoTbins, "fifoTbins/I");
+	sweep->Branch("fifoPretrig", &fifoPretrig, "fifoPretrig/I");
+	sweep->Branch("driftDelay", &driftDelay, "driftDelay/I");
+	sweep->Branch("nplanesHitPretrig", &nplanesHitPretrig, "nplanesHitPretrig/I");
+	sweep->Branch("nplanesHitPattern", &nplanesHitPattern, "nplanesHitPattern/I");
+	sweep->Branch("trigMode", &trigMode, "trigMode/I");
+	sweep->Branch("accelMode", &accelMode, "accelMode/I");
+	sweep->Branch("hitPersist", &hitPersist, "hitPersist/I");
+	sweep->Branch("clctEfficiency", &clctEfficiency, "clctEfficiency/F");
+	sweep->Branch("alctEfficiency", &alctEfficiency, "alctEfficiency/F");
+	sweep->Branch("clctsPerChamber", &clctsPerChamber, "clctsPerChamber/F");
+	sweep->Branch("alctsPerChamber", &alctsPerChamber, "alctsPerChamber/F");
+	sweep->Branch("clctSeconds", &clctSeconds, "clctSeconds/F");
+	sweep->Branch("alctSeconds", &alctSeconds, "alctSeconds/F");
+	sweep->Branch("showerRate", &showerRate, "showerRate/F"); //at least nominal
+
+	cout << "\033[94m=== Emulation Sweep ===\033[0m" << endl;
+	printf("%-24s %10s %12s %10s %10s %10s %12s %10s\n", "config", "CLCT eff", "CLCTs/ch", "failed", "CLCT [s]",
+			"ALCT eff", "ALCTs/ch", "ALCT [s]");
+	for(unsigned int ic = 0; ic < _configs.size(); ic++){
+		const SweepConfig& c = _configs[ic];
+		const SweepResult& r = _results[ic];
+
+		name = c.name;
+		busyWindow = c.clct.busyWindow;
+		layers = c.clct.layerRequirement;
+		timeWindow = c.clct.timeWindow;
+		startTime = c.clct.startTime;
+		maxCLCTs = c.clct.maxCLCTs;
+		skipQuiet = c.clct.skipQuietRegions;
+		showerNominal = c.shower.thresholds[1];
+		fifoTbins = c.alct.get_fifo_tbins();
+		fifoPretrig = c.alct.get_fifo_pretrig();
+		driftDelay = c.alct.get_drift_delay();
+		nplanesHitPretrig = c.alct.get_nplanes_hit_pretrig();
+		nplanesHitPattern = c.alct.get_nplanes_hit_pattern();
+		trigMode = c.alct.get_trig_mode();
+		accelMode = c.alct.get_accel_mode();
+		hitPersist = c.alct.get_hit_persist();
+		double clctSegments = r.clctSegmentPt->GetEntries();
+		double alctSegments = r.alctSegmentPt->GetEntries();
+		clctEfficiency = clctSegments ? r.clctMatchedPt->GetEntries()/clctSegments : 0;
+		alctEfficiency = alctSegments ? r.alctMatchedPt->GetEntries()/alctSegments : 0;
+		unsigned long long clctEmulated = r.clctChambers - r.clctFailures;
+		clctsPerChamber = clctEmulated ? 1.*r.clctCandidates/clctEmulated : 0;
+		alctsPerChamber = r.alctChambers ? 1.*r.alctCandidates/r.alctChambers : 0;
+		clctSeconds = r.clctSeconds;
+		alctSeconds = r.alctSeconds;
+		double showerChambers = r.showerFlag->GetEntries();
+		showerRate = showerChambers ? (r.showerFlag->GetBinContent(3)+r.showerFlag->GetBinContent(4))/showerChambers : 0;
+		sweep->Fill();
+
+		printf("%-24s %10.4f %12.3f %10llu %10.2f %10.4f %12.3f %10.2f\n", c.name.c_str(), clctEfficiency, clctsPerChamber,
+				r.clctFailures, clctSeconds, alctEfficiency, alctsPerChamber, alctSeconds);
+
+		TDirectory* dir = outF->mkdir(c.name.c_str());
+		if(!dir){
+			printf("Failed to make directory: %s\n", c.name.c_str());
+			outF->Close();
+			return -1;
+		}
+		dir->cd();
+		r.clctMultiplicity->Write();
+		r.alctMultiplicity->Write();
+		r.clctSegmentPt->Write();
+		r.clctMatchedPt->Write();
+		r.alctSegmentPt->Write();
+		r.alctMatchedPt->Write();
+		r.clctPosDiff->Write();
+		r.alctPosDiff->Write();
+		r.showerFlag->Write();
+	}
+
+	outF->cd();
+	sweep->Write();
+	outF->Close();
+
+	cout << "Wrote to file: " << outputfile << endl;
+
+	return 0;
+}
@@ -0,0 +1,581 @@
+/*
+ * EmulatorEquivalenceChecker.cpp
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: agent
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <iostream>
+#include <sstream>
+#include <vector>
+#include <string>
+#include <chrono>
+
+using namespace std;
+
+#include <TTree.h>
+#include <TFile.h>
+
+#include "../include/CSCConstants.h"
+#include "../include/CSCClasses.h"
+#include "../include/CSCHelperFunctions.h"
+#include "../include/ALCTHelperFunctions.h"
+#include "../include/CSCInfo.h"
+#include "../include/CSCHelper.h"
+#include "../include/Emulators.h"
+
+
+namespace {
+
+/* Report format, native byte order
+ *
+ * ReportHeader, then for each divergence
+ * 	DivergenceRecord
+ * 	nReference + nTest candidates, 5 x int32 each (key, pattern, code, layers, bx)
+ * 	nHits hits of the chamber image, 3 bytes for a clct (column, layer, time+1 as in
+ * 	ChamberHits::_hits), 4 for an alct (wire group, layer, 16 bit word of the time bins it is on in)
+ */
+const char REPORT_MAGIC[8] = {'C','S','C','E','Q','V','1','\0'};
+const unsigned int REPORT_VERSION = 1;
+const unsigned int NAME_SIZE = 32;
+
+enum EmulatorType {
+	CLCT = 0,
+	ALCT = 1
+};
+
+struct ReportHeader {
+	char magic[8];
+	uint32_t version;
+	uint32_t reserved;
+	char clctNames[2][NAME_SIZE]; //reference, test
+	char alctNames[2][NAME_SIZE];
+};
+
+struct DivergenceRecord {
+	int64_t entry;
+	uint64_t run;
+	uint64_t event;
+	uint16_t chamberHash;
+	uint8_t type;
+	int8_t status[2]; //what each implementation returned
+	uint8_t nCandidates[2];
+	uint8_t reserved;
+	uint16_t nHits;
+	uint16_t reserved2;
+	uint32_t reserved3;
+};
+
+/* @brief Timing and agreement of one side of the comparison
+ */
+struct Side {
+	Side() : ns(0), chambers(0), candidates(0), failures(0) {}
+	unsigned long long ns;
+	unsigned long long chambers;
+	unsigned long long candidates;
+	unsigned long long failures; //chambers it couldn't emulate
+};
+
+struct Comparison {
+	Comparison() : compared(0), divergent(0), written(0) {
+		for(unsigned int i = 0; i < 7; i++) fields[i] = 0;
+	}
+	Side sides[2];
+	unsigned long long compared;
+	unsigned long long divergent;
+	unsigned long long written;
+	//candidates at the same rank that disagree in: key, pattern, code, layers, bx; then status, multiplicity
+	unsigned long long fields[7];
+};
+
+const char* FIELD_NAMES[7] = {"key", "pattern", "code", "layers", "bx", "status", "multiplicity"};
+
+string chamberName(unsigned int hash){
+	CSCHelper::ChamberId c = CSCHelper::unserialize(hash);
+	char name[32];
+	snprintf(name, sizeof(name), "ME%c%u/%u/%u", c.endcap == 1 ? '+' : '-', c.station, c.ring, c.chamber);
+	return name;
+}
+
+/* @brief Counts what disagrees among the first candidates of each, all of them
+ * if first is 0, returns true if anything does
+ */
+bool compare(int statusA, const vector<EmulatedCandidate>& a, int statusB, const vector<EmulatedCandidate>& b,
+		unsigned int first, Comparison& comparison){
+	comparison.compared++;
+	bool divergent = false;
+	if(statusA != statusB) {
+		comparison.fields[5]++;
+		divergent = true;
+	}
+	const unsigned int nA = first && first < a.size() ? first : a.size();
+	const unsigned int nB = first && first < b.size() ? first : b.size();
+	if(nA != nB){
+		comparison.fields[6]++;
+		divergent = true;
+	}
+	for(unsigned int i = 0; i < nA && i < nB; i++){
+		if(a[i] == b[i]) continue;
+		divergent = true;
+		if(a[i].key != b[i].key) comparison.fields[0]++;
+		if(a[i].pattern != b[i].pattern) comparison.fields[1]++;
+		if(a[i].code != b[i].code) comparison.fields[2]++;
+		if(a[i].layers != b[i].layers) comparison.fields[3]++;
+		if(a[i].bx != b[i].bx) comparison.fields[4]++;
+	}
+	if(divergent) comparison.divergent++;
+	return divergent;
+}
+
+int writeCandidates(FILE* out, const vector<EmulatedCandidate>& candidates, unsigned int n){
+	for(unsigned int i = 0; i < n; i++){
+		const EmulatedCandidate& c = candidates[i];
+		int32_t values[5] = {c.key, c.pattern, c.code, c.layers, c.bx};
+		if(fwrite(values, sizeof(values), 1, out) != 1) return -1;
+	}
+	return 0;
+}
+
+int writeRecord(FILE* out, DivergenceRecord& record, int statusA, const vector<EmulatedCandidate>& a,
+		int statusB, const vector<EmulatedCandidate>& b, const vector<uint8_t>& image){
+	record.status[0] = statusA;
+	record.status[1] = statusB;
+	record.nCandidates[0] = a.size() < 255 ? a.size() : 255;
+	record.nCandidates[1] = b.size() < 255 ? b.size() : 255;
+	record.nHits = image.size()/(record.type == CLCT ? 3 : 4);
+	if(fwrite(&record, sizeof(record), 1, out) != 1 ||
+			writeCandidates(out, a, record.nCandidates[0]) ||
+			writeCandidates(out, b, record.nCandidates[1]) ||
+			(image.size() && fwrite(&image[0], image.size(), 1, out) != 1)) {
+		cout << "Error: can't write to report" << endl;
+		return -1;
+	}
+	return 0;
+}
+
+void clctImage(const ChamberHits& c, vector<uint8_t>& image){
+	image.clear();
+	for(unsigned int x = 0; x < N_MAX_HALF_STRIPS; x++){
+		for(unsigned int y = 0; y < NLAYERS; y++){
+			if(!c._hits[x][y]) continue;
+			image.push_back(x);
+			image.push_back(y);
+			image.push_back(c._hits[x][y]);
+		}
+	}
+}
+
+void alctImage(const vector<ALCT_ChamberHits*>& tbins, vector<uint8_t>& image){
+	image.clear();
+	const unsigned int maxWi = tbins.front()->get_maxWi();
+	for(unsigned int x = 0; x < maxWi && x < N_KEY_WIRE_GROUPS; x++){
+		for(unsigned int y = 0; y < NLAYERS; y++){
+			uint16_t word = 0;
+			for(unsigned int tbin = 0; tbin < tbins.size() && tbin < 16; tbin++){
+				if(tbins[tbin]->_hits[x][y]) word |= 1u << tbin;
+			}
+			if(!word) continue;
+			image.push_back(x);
+			image.push_back(y);
+			image.push_back(word & 0xff);
+			image.push_back(word >> 8);
+		}
+	}
+}
+
+/* @brief Runs one implementation, adding the time it took to its side
+ */
+template<class F, class... Args>
+int timed(Side& side, vector<EmulatedCandidate>& found, F& find, Args&... args){
+	auto t1 = chrono::steady_clock::now();
+	int status = find(args..., found);
+	auto t2 = chrono::steady_clock::now();
+	side.ns += chrono::duration_cast<chrono::nanoseconds>(t2-t1).count();
+	side.chambers++;
+	side.candidates += found.size();
+	if(status) side.failures++;
+	return status;
+}
+
+void printComparison(const char* type, const string names[2], const Comparison& c, unsigned long long events){
+	for(unsigned int i = 0; i < 2; i++){
+		const Side& s = c.sides[i];
+		double seconds = 1e-9*s.ns;
+		printf("%s %-10s %-24s %12.1f events/s %14.1f chambers/s %10llu candidates %8llu failed   (%.2f s)\n",
+				type, i ? "test" : "reference", names[i].c_str(),
+				seconds > 0 ? events/seconds : 0., seconds > 0 ? s.chambers/seconds : 0.,
+				s.candidates, s.failures, seconds);
+	}
+	const double speedup = c.sides[1].ns ? (double)c.sides[0].ns/c.sides[1].ns : 0.;
+	printf("%s speedup of the test: %.2fx, divergent chambers: %llu / %llu (%llu written)\n",
+			type, speedup, c.divergent, c.compared, c.written);
+	if(!c.divergent) return;
+	printf("%s disagreeing:", type);
+	for(unsigned int i = 0; i < 7; i++) if(c.fields[i]) printf(" %s = %llu", FIELD_NAMES[i], c.fields[i]);
+	printf("\n");
+}
+
+void copyName(char* destination, const string& name){
+	strncpy(destination, name.c_str(), NAME_SIZE-1);
+	destination[NAME_SIZE-1] = 0;
+}
+
+void splitPair(const string& arg, string names[2]){
+	size_t comma = arg.find(',');
+	names[0] = arg.substr(0, comma);
+	names[1] = comma == string::npos ? names[0] : arg.substr(comma+1);
+}
+
+void listEmulators(){
+	cout << "CLCT emulators:" << endl;
+	for(auto& e : Emulators::clct()) printf("  %-24s %s\n", e.name.c_str(), e.description.c_str());
+	cout << "ALCT emulators:" << endl;
+	for(auto& e : Emulators::alct()) printf("  %-24s %s\n", e.name.c_str(), e.description.c_str());
+}
+
+void usage(){
+	cout << "Usage: ./EmulatorEquivalenceChecker input.root report.bin [options]" << endl;
+	cout << "       ./EmulatorEquivalenceChecker --print report.bin [first] [last]" << endl;
+	cout << "       ./EmulatorEquivalenceChecker --list" << endl;
+	cout << "  --clct ref,test   clct emulators to compare (tmb,tmb), none to skip" << endl;
+	cout << "  --alct ref,test   alct emulators to compare (alct,alct), none to skip" << endl;
+	cout << "  --first N         clcts compared, the first N of each (the fewer either emulator stops at, or all)" << endl;
+	cout << "  --max N           divergences written to the report (100), all are counted" << endl;
+	cout << "  --start N         first entry (0)" << endl;
+	cout << "  --events N        entries to run over (all)" << endl;
+}
+
+/***************************
+ * PRINTING A REPORT
+ ***************************/
+
+int readCandidates(FILE* in, unsigned int n, vector<EmulatedCandidate>& candidates){
+	candidates.clear();
+	for(unsigned int i = 0; i < n; i++){
+		int32_t values[5];
+		if(fread(values, sizeof(values), 1, in) != 1) return -1;
+		candidates.push_back(EmulatedCandidate(values[0], values[1], values[2], values[3], values[4]));
+	}
+	return 0;
+}
+
+void printCandidates(const char* type, const char* names[2], const vector<EmulatedCandidate> candidates[2]){
+	printf("  %-10s %-24s %5s %7s %5s %7s %3s\n", "", "", type, "pattern", "code", "layers", "bx");
+	for(unsigned int side = 0; side < 2; side++){
+		if(candidates[side].empty()) printf("  %-10s %-24s  none\n", side ? "test" : "reference", names[side]);
+		for(unsigned int i = 0; i < candidates[side].size(); i++){
+			const EmulatedCandidate& c = candidates[side][i];
+			bool differs = i >= candidates[!side].size() || c != candidates[!side][i];
+			printf("  %-10s %-24s %5i %7i %5i %7i %3i%s\n", i ? "" : (side ? "test" : "reference"), i ? "" : names[side],
+					c.key, c.pattern, c.code, c.layers, c.bx, differs ? "  <--" : "");
+		}
+	}
+}
+
+/* @brief Wire groups of each layer, as the first time bin they are on in (hex)
+ */
+void printWires(const ALCT_ChamberHits& c, const vector<uint16_t>& words){
+	printf("==== Printing Chamber  ST = %i, RI = %i, CH = %i, EC = %i====\n", c._station, c._ring, c._chamber, c._endcap);
+	for(unsigned int y = 0; y < NLAYERS; y++){
+		for(unsigned int x = c.get_minWi(); x < c.get_maxWi(); x++){
+			uint16_t word = words[x*NLAYERS+y];
+			if(!word) {
+				printf("-");
+				continue;
+			}
+			unsigned int first = 0;
+			while(!((word >> first) & 1)) first++;
+			printf("%X", first);
+		}
+		printf("\n");
+	}
+}
+
+int printReport(const string& reportfile, long long first, long long last){
+	FILE* in = fopen(reportfile.c_str(), "rb");
+	if(!in){
+		cout << "Error: can't open report: " << reportfile << endl;
+		return -1;
+	}
+	ReportHeader header;
+	if(fread(&header, sizeof(header), 1, in) != 1 ||
+			memcmp(header.magic, REPORT_MAGIC, sizeof(REPORT_MAGIC)) ||
+			header.version != REPORT_VERSION){
+		cout << "Error: not an equivalence report: " << reportfile << endl;
+		fclose(in);
+		return -1;
+	}
+	printf("CLCT: %s vs %s, ALCT: %s vs %s\n", header.clctNames[0], header.clctNames[1],
+			header.alctNames[0], header.alctNames[1]);
+
+	DivergenceRecord record;
+	vector<EmulatedCandidate> candidates[2];
+	vector<uint8_t> image;
+	long long index = 0;
+	for(; fread(&record, sizeof(record), 1, in) == 1; index++){
+		if(readCandidates(in, record.nCandidates[0], candidates[0]) ||
+				readCandidates(in, record.nCandidates[1], candidates[1])){
+			cout << "Error: report is cut short: " << reportfile << endl;
+			fclose(in);
+			return -1;
+		}
+		const bool isCLCT = record.type == CLCT;
+		image.resize(record.nHits*(isCLCT ? 3 : 4));
+		if(image.size() && fread(&image[0], image.size(), 1, in) != 1){
+			cout << "Error: report is cut short: " << reportfile << endl;
+			fclose(in);
+			return -1;
+		}
+		if(index < first || (last >= 0 && index >= last)) continue;
+
+		CSCHelper::ChamberId id = CSCHelper::unserialize(record.chamberHash);
+		printf("\n\033[94m=== Divergence %lli: %s in %s, entry %lli, run %llu, event %llu ===\033[0m\n", index,
+				isCLCT ? "CLCT" : "ALCT", chamberName(record.chamberHash).c_str(), (long long)record.entry,
+				(unsigned long long)record.run, (unsigned long long)record.event);
+		if(record.status[0] != record.status[1]) printf("  status: reference = %i, test = %i\n", record.status[0], record.status[1]);
+		const char* names[2] = {isCLCT ? header.clctNames[0] : header.alctNames[0], isCLCT ? header.clctNames[1] : header.alctNames[1]};
+		printCandidates(isCLCT ? "hs" : "wg", names, candidates);
+
+		if(isCLCT){
+			ChamberHits c(id.station, id.ring, id.endcap, id.chamber);
+			for(unsigned int i = 0; i+2 < image.size(); i += 3){
+				if(image[i] < N_MAX_HALF_STRIPS && image[i+1] < NLAYERS) c._hits[image[i]][image[i+1]] = image[i+2];
+			}
+			c.print();
+		} else {
+			ALCT_ChamberHits c(id.station, id.ring, id.chamber, id.endcap);
+			vector<uint16_t> words(N_KEY_WIRE_GROUPS*NLAYERS, 0);
+			for(unsigned int i = 0; i+3 < image.size(); i += 4){
+				if(image[i] < N_KEY_WIRE_GROUPS && image[i+1] < NLAYERS) words[image[i]*NLAYERS+image[i+1]] = image[i+2] | (image[i+3] << 8);
+			}
+			printWires(c, words);
+		}
+	}
+	fclose(in);
+	printf("\n%lli divergences in report: %s\n", index, reportfile.c_str());
+	return 0;
+}
+
+}
+
+/* @brief Runs two CLCT and two ALCT emulator implementations (see Emulators.h)
+ * side by side over a tuple, on the same hits. Every chamber's candidates are
+ * compared, the first divergences are written to a binary report along with the
+ * chamber's hits, and the events/s of each implementation is printed, so a faster
+ * emulation path can be shown to match the reference before it is used
+ */
+int main(int argc, char* argv[]){
+	if(argc >= 2 && string(argv[1]) == "--list"){
+		listEmulators();
+		return 0;
+	}
+	if(argc >= 3 && string(argv[1]) == "--print"){
+		long long first = argc > 3 ? atoll(argv[3]) : 0;
+		long long last = argc > 4 ? atoll(argv[4]) : (argc > 3 ? first+1 : -1);
+		return printReport(argv[2], first, last);
+	}
+	if(argc < 3 || argv[1][0] == '-' || argv[2][0] == '-'){
+		usage();
+		return -1;
+	}
+	const string inputfile = argv[1];
+	const string reportfile = argv[2];
+	string clctNames[2] = {"tmb", "tmb"};
+	string alctNames[2] = {"alct", "alct"};
+	unsigned long long maxDivergences = 100;
+	int firstCLCTs = -1;
+	long long start = 0;
+	long long nEvents = -1;
+
+	for(int i = 3; i < argc; i++){
+		string arg = argv[i];
+		bool hasValue = i+1 < argc;
+		if(arg == "--clct" && hasValue) splitPair(argv[++i], clctNames);
+		else if(arg == "--alct" && hasValue) splitPair(argv[++i], alctNames);
+		else if(arg == "--first" && hasValue) firstCLCTs = atoi(argv[++i]);
+		else if(arg == "--max" && hasValue) maxDivergences = atoll(argv[++i]);
+		else if(arg == "--start" && hasValue) start = atoll(argv[++i]);
+		else if(arg == "--events" && hasValue) nEvents = atoll(argv[++i]);
+		else {
+			usage();
+			return -1;
+		}
+	}
+
+	const bool runCLCTs = clctNames[0] != "none";
+	const bool runALCTs = alctNames[0] != "none";
+	const CLCTEmulator* clctEmulators[2] = {0, 0};
+	const ALCTEmulator* alctEmulators[2] = {0, 0};
+	for(unsigned int i = 0; i < 2; i++){
+		if(runCLCTs && !(clctEmulators[i] = Emulators::findCLCT(clctNames[i]))){
+			cout << "Error: no clct emulator named: " << clctNames[i] << endl;
+			listEmulators();
+			return -1;
+		}
+		if(runALCTs && !(alctEmulators[i] = Emulators::findALCT(alctNames[i]))){
+			cout << "Error: no alct emulator named: " << alctNames[i] << endl;
+			listEmulators();
+			return -1;
+		}
+	}
+
+	//an emulator stopping at the TMB's two would differ from one finding them all in every busy chamber
+	if(firstCLCTs < 0) {
+		firstCLCTs = 0;
+		for(unsigned int i = 0; runCLCTs && i < 2; i++){
+			unsigned int most = clctEmulators[i]->maxCandidates;
+			if(most && (!firstCLCTs || (int)most < firstCLCTs)) firstCLCTs = most;
+		}
+	}
+	if(runCLCTs && firstCLCTs) printf("Comparing the first %i clcts of each emulator\n", firstCLCTs);
+
+	auto t1 = chrono::steady_clock::now();
+	cout << "Running over file: " << inputfile << endl;
+
+	TFile* f = TFile::Open(inputfile.c_str());
+	if(!f){
+		cout << "Error: can't open file: " << inputfile << endl;
+		return -1;
+	}
+	TTree* t = (TTree*)f->Get("CSCDigiTree");
+	if(!t){
+		cout << "Error: can't find tree: CSCDigiTree" << endl;
+		return -1;
+	}
+	CSCInfo::disableAll(t);
+	CSCInfo::Event evt(t);
+	CSCInfo::Comparators comparators(t);
+	CSCInfo::Wires wires(t);
+
+	FILE* out = fopen(reportfile.c_str(), "wb");
+	if(!out){
+		cout << "Error: can't open report: " << reportfile << endl;
+		return -1;
+	}
+	ReportHeader header;
+	memset(&header, 0, sizeof(header));
+	memcpy(header.magic, REPORT_MAGIC, sizeof(REPORT_MAGIC));
+	header.version = REPORT_VERSION;
+	for(unsigned int i = 0; i < 2; i++){
+		copyName(header.clctNames[i], clctNames[i]);
+		copyName(header.alctNames[i], alctNames[i]);
+	}
+	if(fwrite(&header, sizeof(header), 1, out) != 1){
+		cout << "Error: can't write to report: " << reportfile << endl;
+		fclose(out);
+		return -1;
+	}
+
+	long long end = nEvents < 0 ? t->GetEntries() : start + nEvents;
+	if(end > t->GetEntries()) end = t->GetEntries();
+	printf("Starting Event = %lli, Ending Event = %lli\n", start, end);
+
+	const CLCTConfig clctConfig;
+	ALCTConfig alctConfig[2];
+	Comparison clctComparison;
+	Comparison alctComparison;
+	unsigned long long fillNs = 0;
+	vector<EmulatedCandidate> found[2];
+	vector<uint8_t> image;
+	int result = 0;
+
+	for(long long i = start; i < end && !result; i++){
+		if(!((i-start)%10000)) printf("%3.2f%% Done --- Processed %lli Events\n", 100.*(i-start)/(end-start), i-start);
+		t->GetEntry(i);
+
+		DivergenceRecord record;
+		memset(&record, 0, sizeof(record));
+		record.entry = i;
+		record.run = evt.RunNumber;
+		record.event = evt.EventNumber;
+
+		//alternate which goes first, so neither always gets the warm cache
+		const unsigned int firstSide = i%2;
+
+		for(unsigned int chamberHash = 0; chamberHash < CSCHelper::MAX_CHAMBER_HASH && !result; chamberHash++){
+			CSCHelper::ChamberId c = CSCHelper::unserialize(chamberHash);
+			unsigned int EC = c.endcap;
+			unsigned int ST = c.station;
+			unsigned int RI = c.ring;
+			unsigned int CH = c.chamber;
+			if(!CSCHelper::isValidChamber(ST,RI,CH,EC)) continue;
+			record.chamberHash = chamberHash;
+
+			//clcts, in every chamber as TMBEmulationTester
+			if(runCLCTs){
+				auto f1 = chrono::steady_clock::now();
+				ChamberHits compHits(ST, RI, EC, CH);
+				if(compHits.fill(comparators)) {
+					result = -1;
+					break;
+				}
+				fillNs += chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now()-f1).count();
+
+				int status[2] = {0, 0};
+				for(unsigned int n = 0; n < 2; n++){
+					unsigned int side = (firstSide + n)%2;
+					found[side].clear();
+					status[side] = timed(clctComparison.sides[side], found[side], clctEmulators[side]->find, compHits, clctConfig);
+				}
+				if(compare(status[0], found[0], status[1], found[1], firstCLCTs, clctComparison) &&
+						clctComparison.written < maxDivergences){
+					record.type = CLCT;
+					clctImage(compHits, image);
+					if(writeRecord(out, record, status[0], found[0], status[1], found[1], image)) result = -1;
+					clctComparison.written++;
+				}
+			}
+
+			//alcts, ME1/1a is read along with ME1/1b, as ALCTEmulationTreeCreator
+			if(runALCTs && !(ST == 1 && RI == 1)){
+				auto f1 = chrono::steady_clock::now();
+				vector<ALCT_ChamberHits*> cvec;
+				for(int tbin = 0; tbin < 16; tbin++){
+					ALCT_ChamberHits* hits = new ALCT_ChamberHits(ST, RI, CH, EC);
+					hits->fill(wires, tbin);
+					cvec.push_back(hits);
+				}
+				fillNs += chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now()-f1).count();
+
+				int status[2] = {0, 0};
+				for(unsigned int n = 0; n < 2; n++){
+					unsigned int side = (firstSide + n)%2;
+					found[side].clear();
+					status[side] = timed(alctComparison.sides[side], found[side], alctEmulators[side]->find, cvec, alctConfig[side]);
+				}
+				if(compare(status[0], found[0], status[1], found[1], 0, alctComparison) && alctComparison.written < maxDivergences){
+					record.type = ALCT;
+					alctImage(cvec, image);
+					if(writeRecord(out, record, status[0], found[0], status[1], found[1], image)) result = -1;
+					alctComparison.written++;
+				}
+				wipe(cvec);
+			}
+		}
+	}
+	if(fclose(out)){
+		cout << "Error: can't write to report: " << reportfile << endl;
+		result = -1;
+	}
+	f->Close();
+	delete f;
+	if(result) return result;
+
+	const unsigned long long events = end > start ? end - start : 0;
+	cout << "\033[94m=== Emulator Equivalence ===\033[0m" << endl;
+	printf("Hit filling, shared: %.2f s\n", 1e-9*fillNs);
+	if(runCLCTs) printComparison("CLCT", clctNames, clctComparison, events);
+	if(runALCTs) printComparison("ALCT", alctNames, alctComparison, events);
+
+	const bool equivalent = !clctComparison.divergent && !alctComparison.divergent;
+	if(equivalent) cout << "Implementations are equivalent over " << events << " events" << endl;
+	else cout << "Wrote " << clctComparison.written + alctComparison.written << " divergences to report: " << reportfile << endl;
+
+	auto t2 = chrono::steady_clock::now();
+	printf("Time elapsed: %.1f s\n", chrono::duration<double>(t2-t1).count());
+	return equivalent ? 0 : 1;
+}
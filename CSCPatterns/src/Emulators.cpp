@@ -0,0 +1,125 @@
+/*
+ * Emulators.cpp
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: agent
+ */
+
+#include "../include/Emulators.h"
+#include "../include/CSCHelperFunctions.h"
+
+#include <memory>
+
+
+namespace {
+
+/* @brief searchForMatch over a set of patterns, made once and shared
+ * by all the calls
+ */
+CLCTEmulator clctSearch(const string& name, const string& description, bool legacy, bool useBusyWindow, bool fast=false){
+	shared_ptr<vector<CSCPattern>> patterns(legacy ? createOldPatterns() : createNewPatterns());
+	CLCTEmulator e;
+	e.name = name;
+	e.description = description;
+	e.maxCandidates = fast ? 2 : 0;
+	e.find = [patterns, useBusyWindow, fast](const ChamberHits& c, const CLCTConfig& config, vector<EmulatedCandidate>& found){
+		vector<CLCTCandidate*> candidates;
+		CLCTConfig fastConfig = config;
+		if(fast){
+			//as the TMB, which sends out the best two
+			fastConfig.skipQuietRegions = true;
+			if(!fastConfig.maxCLCTs) fastConfig.maxCLCTs = 2;
+		}
+		int status = searchForMatch(c, patterns.get(), candidates, useBusyWindow, fastConfig);
+		for(auto clct : candidates){
+			if(!status) found.push_back(Emulators::candidate(*clct));
+			delete clct;
+		}
+		return status;
+	};
+	return e;
+}
+
+/* @brief The ALCT board as ALCTEmulationTreeCreator runs it, with
+ * or without the ghost cancellation
+ */
+ALCTEmulator alctSearch(const string& name, const string& description, bool cancelGhosts){
+	ALCTEmulator e;
+	e.name = name;
+	e.description = description;
+	e.find = [cancelGhosts](vector<ALCT_ChamberHits*>& tbins, ALCTConfig& config, vector<EmulatedCandidate>& found){
+		if(tbins.empty()) return -1;
+		vector<vector<ALCTCandidate*>> end_vec;
+		vector<ALCTCandidate*> out_vec;
+		for(int tbin = 0; tbin < config.get_fifo_tbins()-config.get_drift_delay(); tbin++){
+			vector<ALCTCandidate*> row;
+			for(int j = 0; j < (int)tbins.front()->get_maxWi(); j++) row.push_back(new ALCTCandidate(j,1));
+			end_vec.push_back(row);
+		}
+		trig_and_find(tbins, config, end_vec);
+		if(cancelGhosts) ghostBuster(end_vec, config);
+		extract_sort_cut(end_vec, out_vec);
+		for(auto alct : out_vec) found.push_back(Emulators::candidate(*alct));
+		wipe(out_vec);
+		return 0;
+	};
+	return e;
+}
+
+vector<CLCTEmulator>& clctRegistry(){
+	static vector<CLCTEmulator> emulators = {
+			clctSearch("tmb", "legacy patterns with the busy window, as the TMB (reference)", true, true),
+			clctSearch("tmb-no-busy-window", "legacy patterns, searching the whole chamber for every candidate", true, false),
+			clctSearch("tmb-fast", "tmb skipping cfebs with too few hits, stopping at two clcts", true, true, true),
+			clctSearch("new", "new patterns and comparator codes, as LUTBuilder", false, false)
+	};
+	return emulators;
+}
+
+vector<ALCTEmulator>& alctRegistry(){
+	static vector<ALCTEmulator> emulators = {
+			alctSearch("alct", "trig_and_find, ghostBuster and extract_sort_cut, as the ALCT board (reference)", true),
+			alctSearch("alct-no-ghostbuster", "without the ghost cancellation", false)
+	};
+	return emulators;
+}
+
+}
+
+const vector<CLCTEmulator>& Emulators::clct(){
+	return clctRegistry();
+}
+
+const vector<ALCTEmulator>& Emulators::alct(){
+	return alctRegistry();
+}
+
+const CLCTEmulator* Emulators::findCLCT(const string& name){
+	for(auto& e : clctRegistry()) if(e.name == name) return &e;
+	return 0;
+}
+
+const ALCTEmulator* Emulators::findALCT(const string& name){
+	for(auto& e : alctRegistry()) if(e.name == name) return &e;
+	return 0;
+}
+
+int Emulators::add(const CLCTEmulator& e){
+	if(findCLCT(e.name)) return -1;
+	clctRegistry().push_back(e);
+	return 0;
+}
+
+int Emulators::add(const ALCTEmulator& e){
+	if(findALCT(e.name)) return -1;
+	alctRegistry().push_back(e);
+	return 0;
+}
+
+EmulatedCandidate Emulators::candidate(const CLCTCandidate& c){
+	return EmulatedCandidate(c.keyHalfStrip(), c.patternId(), c.comparatorCodeId(), c.layerCount(), c._startTime);
+}
+
+EmulatedCandidate Emulators::candidate(const ALCTCandidate& c){
+	return EmulatedCandidate(c.get_kwg(), c.get_pattern(), -1, c.get_quality(), c.get_first_bx());
+}
@@ -0,0 +1,485 @@
+/*
+ * KernelBenchmark.cpp
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: agent
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <sched.h>
+#include <unistd.h>
+#include <iostream>
+#include <fstream>
+#include <vector>
+#include <string>
+#include <chrono>
+#include <random>
+#include <algorithm>
+#include <functional>
+
+using namespace std;
+
+#include "../include/CSCConstants.h"
+#include "../include/CSCClasses.h"
+#include "../include/CSCHelperFunctions.h"
+#include "../include/ALCTHelperFunctions.h"
+#include "../include/LUTClasses.h"
+#include "../include/SyntheticEvents.h"
+
+
+/* Chamber types the synthetic chambers go through in turn. Not ME1/1a,
+ * whose strips are counted on from ME1/1b
+ */
+const unsigned int N_CHAMBER_TYPES = 9;
+const unsigned int CHAMBER_TYPES[N_CHAMBER_TYPES][2] = {
+		{1,1}, {1,2}, {1,3}, {2,1}, {2,2}, {3,1}, {3,2}, {4,1}, {4,2}
+};
+
+//results go here, so the compiler can't drop the kernels
+volatile long long sink = 0;
+
+/* @brief One kernel. prepare and cleanup are run around every sample
+ * and aren't timed. run goes over all the chambers once and returns
+ * how many operations it did
+ */
+struct Benchmark {
+	string name;
+	string op; //what one operation is
+	function<void()> prepare;
+	function<long long()> run;
+	function<void()> cleanup;
+};
+
+/* @brief ns per operation over the samples
+ */
+struct Result {
+	string name;
+	string op;
+	long long ops; //per sample
+	vector<double> samples;
+	double mean;
+	double stddev;
+	double min;
+	double median;
+	double p90;
+	double max;
+};
+
+struct Chamber {
+	Chamber(unsigned int st, unsigned int ri, unsigned int ch, const SyntheticConfig& config) :
+		station(st), ring(ri), endcap(1), chamber(ch), digis(config) {
+		digis.addChamber(station, ring, endcap, chamber);
+	}
+	unsigned int station;
+	unsigned int ring;
+	unsigned int endcap;
+	unsigned int chamber;
+	SyntheticEvents digis; //just this chamber, as if it were alone in its event
+};
+
+/* @brief The ALCT emulation inputs of one chamber, as made in
+ * ALCTEmulationTreeCreator: a chamber image per time bin, and a row of
+ * candidates per time bin that trig_and_find can pretrigger on
+ */
+struct ALCTInput {
+	vector<ALCT_ChamberHits*> cvec;
+	vector<vector<ALCTCandidate*>> end_vec;
+
+	void make(const Chamber& c, const ALCTConfig& config, bool fill){
+		for(int i = 0; i < 16; i++){
+			ALCT_ChamberHits* hits = new ALCT_ChamberHits(c.station, c.ring, c.chamber, c.endcap);
+			if(fill) hits->fill(c.digis.wires, i);
+			cvec.push_back(hits);
+		}
+		for(int i = 0; i < config.get_fifo_tbins()-config.get_drift_delay(); i++){
+			vector<ALCTCandidate*> row;
+			for(int j = 0; j < (int)cvec.front()->get_maxWi(); j++) row.push_back(new ALCTCandidate(j,1));
+			end_vec.push_back(row);
+		}
+	}
+
+	//extract_sort_cut deletes all but the best two per time bin
+	void clear(){
+		vector<ALCTCandidate*> out_vec;
+		extract_sort_cut(end_vec, out_vec);
+		wipe(out_vec);
+		wipe(cvec);
+		cvec.clear();
+		end_vec.clear();
+	}
+};
+
+double percentile(const vector<double>& sorted, double fraction){
+	if(sorted.empty()) return 0;
+	double pos = fraction*(sorted.size()-1);
+	unsigned int i = (unsigned int)pos;
+	if(i+1 >= sorted.size()) return sorted.back();
+	return sorted[i] + (pos-i)*(sorted[i+1]-sorted[i]);
+}
+
+Result measure(Benchmark& b, unsigned int warmup, unsigned int samples){
+	Result r;
+	r.name = b.name;
+	r.op = b.op;
+	r.ops = 0;
+	for(unsigned int i = 0; i < warmup+samples; i++){
+		if(b.prepare) b.prepare();
+		auto start = chrono::steady_clock::now();
+		long long ops = b.run();
+		auto end = chrono::steady_clock::now();
+		if(b.cleanup) b.cleanup();
+		if(i < warmup || ops <= 0) continue;
+		r.ops = ops;
+		r.samples.push_back((double)chrono::duration_cast<chrono::nanoseconds>(end - start).count()/ops);
+	}
+
+	vector<double> sorted = r.samples;
+	sort(sorted.begin(), sorted.end());
+	double sum = 0;
+	for(double x : sorted) sum += x;
+	r.mean = sorted.size() ? sum/sorted.size() : 0;
+	double var = 0;
+	for(double x : sorted) var += (x-r.mean)*(x-r.mean);
+	r.stddev = sorted.size() > 1 ? sqrt(var/(sorted.size()-1)) : 0;
+	r.min = sorted.size() ? sorted.front() : 0;
+	r.max = sorted.size() ? sorted.back() : 0;
+	r.median = percentile(sorted, 0.5);
+	r.p90 = percentile(sorted, 0.9);
+	return r;
+}
+
+int writeJSON(const string& file, const string& label, const SyntheticConfig& config, unsigned int nChambers,
+		unsigned int warmup, unsigned int samples, const vector<Result>& results){
+	ofstream out(file.c_str());
+	if(!out){
+		cout << "Error: can't open json file: " << file << endl;
+		return -1;
+	}
+	char buffer[1024];
+	snprintf(buffer, sizeof(buffer), "{\n\"label\":\"%s\",\n\"config\":{\"seed\":%u,\"chambers\":%u,\"muons\":%g,\"noise\":%g,"
+			"\"efficiency\":%g,\"warmup\":%u,\"samples\":%u},\n\"unit\":\"ns/op\",\n\"benchmarks\":[\n",
+			label.c_str(), config.seed, nChambers, config.muons, config.noise, config.efficiency, warmup, samples);
+	out << buffer;
+	for(unsigned int i = 0; i < results.size(); i++){
+		const Result& r = results[i];
+		snprintf(buffer, sizeof(buffer), "{\"name\":\"%s\",\"op\":\"%s\",\"ops\":%lli,\"mean\":%.3f,\"stddev\":%.3f,"
+				"\"min\":%.3f,\"median\":%.3f,\"p90\":%.3f,\"max\":%.3f,\"samples\":[",
+				r.name.c_str(), r.op.c_str(), r.ops, r.mean, r.stddev, r.min, r.median, r.p90, r.max);
+		out << buffer;
+		for(unsigned int j = 0; j < r.samples.size(); j++){
+			snprintf(buffer, sizeof(buffer), "%s%.3f", j ? "," : "", r.samples[j]);
+			out << buffer;
+		}
+		out << "]}" << (i+1 < results.size() ? "," : "") << endl;
+	}
+	out << "]}" << endl;
+	out.close();
+	if(!out){
+		cout << "Error: failed writing json file: " << file << endl;
+		return -1;
+	}
+	cout << "Wrote results to file: " << file << endl;
+	return 0;
+}
+
+void usage(){
+	cout << "Usage: ./KernelBenchmark [options]" << endl;
+	cout << "  --chambers N    synthetic chambers per sample (200)" << endl;
+	cout << "  --muons X       mean muons per chamber (1)" << endl;
+	cout << "  --noise X       noise occupancy, chance of a hit per half strip / wire group and layer (0.01)" << endl;
+	cout << "  --seed N        seed of the synthetic chambers (1)" << endl;
+	cout << "  --samples N     timed samples per benchmark (20)" << endl;
+	cout << "  --warmup N      untimed samples before those (3)" << endl;
+	cout << "  --filter text   only run benchmarks whose name contains text" << endl;
+	cout << "  --cpu N         pin to a cpu, for steadier timings" << endl;
+	cout << "  --json file     write the results, to compare between commits" << endl;
+	cout << "  --label text    name of this run in the json, e.g. the commit" << endl;
+}
+
+/* @brief Times the emulation and LUT kernels on synthetic chambers, see usage()
+ */
+int main(int argc, char* argv[]){
+	SyntheticConfig config;
+	unsigned int nChambers = 200;
+	unsigned int samples = 20;
+	unsigned int warmup = 3;
+	int cpu = -1;
+	string filter;
+	string json;
+	string label;
+
+	for(int i = 1; i < argc; i++){
+		string arg = argv[i];
+		bool hasValue = i+1 < argc;
+		if(arg == "--chambers" && hasValue) nChambers = atoi(argv[++i]);
+		else if(arg == "--muons" && hasValue) config.muons = atof(argv[++i]);
+		else if(arg == "--noise" && hasValue) config.noise = atof(argv[++i]);
+		else if(arg == "--seed" && hasValue) config.seed = atoi(argv[++i]);
+		else if(arg == "--samples" && hasValue) samples = atoi(argv[++i]);
+		else if(arg == "--warmup" && hasValue) warmup = atoi(argv[++i]);
+		else if(arg == "--filter" && hasValue) filter = argv[++i];
+		else if(arg == "--cpu" && hasValue) cpu = atoi(argv[++i]);
+		else if(arg == "--json" && hasValue) json = argv[++i];
+		else if(arg == "--label" && hasValue) label = argv[++i];
+		else {
+			usage();
+			return -1;
+		}
+	}
+	if(!nChambers || !samples){
+		cout << "Error: need at least one chamber and one sample" << endl;
+		return -1;
+	}
+
+	if(cpu >= 0){
+		cpu_set_t set;
+		CPU_ZERO(&set);
+		CPU_SET(cpu, &set);
+		if(sched_setaffinity(0, sizeof(set), &set)) cout << "Warning: can't pin to cpu " << cpu << endl;
+	}
+
+	/*****************************
+	 * SYNTHETIC INPUTS
+	 *****************************/
+
+	vector<Chamber*> chambers;
+	vector<ChamberHits*> compHits;
+	unsigned long long nComparators = 0;
+	unsigned long long nWires = 0;
+	for(unsigned int i = 0; i < nChambers; i++){
+		SyntheticConfig chamberConfig = config;
+		chamberConfig.seed = config.seed + i;
+		const unsigned int* type = CHAMBER_TYPES[i % N_CHAMBER_TYPES];
+		Chamber* c = new Chamber(type[0], type[1], i % 18 + 1, chamberConfig);
+		chambers.push_back(c);
+		ChamberHits* hits = new ChamberHits(c->station, c->ring, c->endcap, c->chamber);
+		if(hits->fill(c->digis.comparators)) return -1;
+		compHits.push_back(hits);
+		nComparators += c->digis.comparators.size();
+		nWires += c->digis.wires.size();
+	}
+
+	vector<CSCPattern>* newPatterns = createNewPatterns();
+	vector<CSCPattern>* oldPatterns = createOldPatterns();
+
+	//random overlaps, for the comparator codes
+	mt19937 random(config.seed);
+	vector<ComparatorCode> overlaps(NCOMPARATOR_CODES);
+	for(auto& o : overlaps){
+		for(unsigned int y = 0; y < NLAYERS; y++){
+			for(unsigned int x = 0; x < 3; x++) o._hits[y][x] = random() & 1;
+		}
+	}
+
+	LUT lut("linearFits");
+	if(lut.loadLinearFits() || lut.makeFinal()) return -1;
+
+	//keys of the clcts the new patterns find, or any if there are none
+	vector<LUTKey> keys;
+	for(auto c : compHits){
+		vector<CLCTCandidate*> clcts;
+		//fails on more than one hit in a layer of an envelope, skipped as in the analyzers
+		bool skip = searchForMatch(*c, newPatterns, clcts);
+		for(auto clct : clcts) {
+			if(!skip) keys.push_back(clct->key());
+			delete clct;
+		}
+	}
+	if(keys.empty()){
+		for(unsigned int i = 0; i < NCOMPARATOR_CODES; i++) keys.push_back(LUTKey(PATTERN_IDS[i % NPATTERNS], i));
+	}
+
+	char tmpdir[] = "/tmp/KernelBenchmarkXXXXXX";
+	if(!mkdtemp(tmpdir)){
+		cout << "Error: can't make a temporary directory" << endl;
+		return -1;
+	}
+	const string textFile = string(tmpdir) + "/linearFits.lut";
+	const string pslPrefix = string(tmpdir) + "/linearFits";
+
+	//LUT I/O announces itself, keep it out of the results
+	ofstream devnull("/dev/null");
+	streambuf* coutBuffer = cout.rdbuf();
+	cout.rdbuf(devnull.rdbuf());
+	int lutStatus = lut.writeToText(textFile);
+	cout.rdbuf(coutBuffer);
+	if(lutStatus) return -1;
+
+	ALCTConfig alctConfig;
+	vector<ALCTInput> alctInputs(chambers.size());
+
+	printf("\033[94m=== Kernel Benchmark ===\033[0m\n");
+	printf("%u chambers, %.2f muons per chamber, noise occupancy %.3f, seed %u -> %.1f comparators, %.1f wires per chamber\n",
+			nChambers, config.muons, config.noise, config.seed, (double)nComparators/nChambers, (double)nWires/nChambers);
+	printf("%u warmup + %u timed samples per benchmark\n", warmup, samples);
+
+	/*****************************
+	 * BENCHMARKS
+	 *****************************/
+
+	vector<Benchmark> benchmarks;
+
+	benchmarks.push_back({"ComparatorCode", "code", nullptr, [&](){
+		for(auto& o : overlaps) sink += ComparatorCode(o._hits).getId();
+		return (long long)overlaps.size();
+	}, nullptr});
+
+	benchmarks.push_back({"ChamberHits::fill", "chamber", nullptr, [&](){
+		for(auto c : chambers){
+			ChamberHits hits(c->station, c->ring, c->endcap, c->chamber);
+			hits.fill(c->digis.comparators);
+			sink += hits.nhits();
+		}
+		return (long long)chambers.size();
+	}, nullptr});
+
+	//every position of every envelope containsPattern looks at
+	benchmarks.push_back({"getOverlap (new)", "position", nullptr, [&](){
+		long long n = 0;
+		bool overlap[NLAYERS][3];
+		for(auto c : compHits){
+			for(auto& p : *newPatterns){
+				for(int x = (int)c->minHs() -(int)MAX_PATTERN_WIDTH/2+1; x < (int)c->maxHs() - (int)MAX_PATTERN_WIDTH/2+1; x++){
+					sink += getOverlap(*c, p, x, 7, overlap);
+					n++;
+				}
+			}
+		}
+		return n;
+	}, nullptr});
+
+	benchmarks.push_back({"legacyLayersMatched (legacy)", "position", nullptr, [&](){
+		long long n = 0;
+		for(auto c : compHits){
+			for(auto& p : *oldPatterns){
+				for(int x = (int)c->minHs() -(int)MAX_PATTERN_WIDTH/2+1; x < (int)c->maxHs() - (int)MAX_PATTERN_WIDTH/2+1; x++){
+					sink += legacyLayersMatched(*c, p, x, 7);
+					n++;
+				}
+			}
+		}
+		return n;
+	}, nullptr});
+
+	for(auto patterns : {newPatterns, oldPatterns}){
+		const string set = patterns == newPatterns ? " (new)" : " (legacy)";
+		benchmarks.push_back({"containsPattern" + set, "chamber x envelope", nullptr, [&, patterns](){
+			long long n = 0;
+			for(auto c : compHits){
+				for(auto& p : *patterns){
+					CLCTCandidate* mi = 0;
+					sink += containsPattern(*c, p, mi);
+					delete mi;
+					n++;
+				}
+			}
+			return n;
+		}, nullptr});
+
+		//busy window as used with each set, TMBEmulationTester for the legacy one and LUTBuilder for the new one
+		benchmarks.push_back({"searchForMatch" + set, "chamber", nullptr, [&, patterns](){
+			for(auto c : compHits){
+				vector<CLCTCandidate*> clcts;
+				sink += searchForMatch(*c, patterns, clcts, patterns == oldPatterns);
+				sink += clcts.size();
+				for(auto clct : clcts) delete clct;
+			}
+			return (long long)compHits.size();
+		}, nullptr});
+	}
+
+	benchmarks.push_back({"LUT::getEntry", "lookup", nullptr, [&](){
+		for(auto& k : keys){
+			const LUTEntry* e = 0;
+			if(!lut.getEntry(k, e)) sink += e->_layers;
+		}
+		return (long long)keys.size();
+	}, nullptr});
+
+	LUT* loaded = 0;
+	benchmarks.push_back({"LUT::loadText", "file", [&](){
+		loaded = new LUT("loaded");
+	}, [&](){
+		cout.rdbuf(devnull.rdbuf());
+		int status = loaded->loadText(textFile);
+		cout.rdbuf(coutBuffer);
+		return status ? -1LL : 1LL;
+	}, [&](){
+		sink += loaded->size();
+		delete loaded;
+		loaded = 0;
+	}});
+
+	benchmarks.push_back({"LUT::writeToPSLs", "file set", nullptr, [&](){
+		cout.rdbuf(devnull.rdbuf());
+		int status = lut.writeToPSLs(pslPrefix);
+		cout.rdbuf(coutBuffer);
+		return status ? -1LL : 1LL;
+	}, nullptr});
+
+	benchmarks.push_back({"ALCT_ChamberHits::fill", "chamber", [&](){
+		for(unsigned int i = 0; i < chambers.size(); i++) alctInputs[i].make(*chambers[i], alctConfig, false);
+	}, [&](){
+		for(unsigned int i = 0; i < chambers.size(); i++){
+			for(int t = 0; t < 16; t++) alctInputs[i].cvec[t]->fill(chambers[i]->digis.wires, t);
+		}
+		return (long long)chambers.size();
+	}, [&](){
+		for(auto& in : alctInputs) in.clear();
+	}});
+
+	benchmarks.push_back({"trig_and_find", "chamber", [&](){
+		for(unsigned int i = 0; i < chambers.size(); i++) alctInputs[i].make(*chambers[i], alctConfig, true);
+	}, [&](){
+		for(auto& in : alctInputs) trig_and_find(in.cvec, alctConfig, in.end_vec);
+		return (long long)alctInputs.size();
+	}, [&](){
+		for(auto& in : alctInputs) in.clear();
+	}});
+
+	benchmarks.push_back({"ghostBuster", "chamber", [&](){
+		for(unsigned int i = 0; i < chambers.size(); i++) {
+			alctInputs[i].make(*chambers[i], alctConfig, true);
+			trig_and_find(alctInputs[i].cvec, alctConfig, alctInputs[i].end_vec);
+		}
+	}, [&](){
+		for(auto& in : alctInputs) ghostBuster(in.end_vec, alctConfig);
+		return (long long)alctInputs.size();
+	}, [&](){
+		for(auto& in : alctInputs) in.clear();
+	}});
+
+	/*****************************
+	 * RUNNING
+	 *****************************/
+
+	vector<Result> results;
+	printf("%-30s %-18s %12s %12s %8s %12s %12s %12s %12s\n", "benchmark", "op", "mean [ns/op]", "stddev", "rel [%]",
+			"min", "median", "p90", "max");
+	for(auto& b : benchmarks){
+		if(filter.size() && b.name.find(filter) == string::npos) continue;
+		Result r = measure(b, warmup, samples);
+		if(r.samples.empty()){
+			cout << "Error: " << b.name << " failed" << endl;
+			continue;
+		}
+		printf("%-30s %-18s %12.1f %12.1f %8.1f %12.1f %12.1f %12.1f %12.1f\n", r.name.c_str(), r.op.c_str(),
+				r.mean, r.stddev, r.mean ? 100.*r.stddev/r.mean : 0., r.min, r.median, r.p90, r.max);
+		results.push_back(r);
+	}
+
+	remove(textFile.c_str());
+	for(unsigned int i = 0; i < NPATTERNS; i++) remove((pslPrefix + "-" + to_string(PATTERN_IDS[i]) + ".psl").c_str());
+	rmdir(tmpdir);
+
+	for(auto c : chambers) delete c;
+	for(auto c : compHits) delete c;
+	delete newPatterns;
+	delete oldPatterns;
+
+	if(json.size() && writeJSON(json, label, config, nChambers, warmup, samples, results)) return -1;
+	return 0;
+}
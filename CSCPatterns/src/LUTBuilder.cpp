@@ -10,9 +10,14 @@
 #include <TTree.h>
 #include <TFile.h>
 
+#include <stdio.h>
+
 #include "../include/CSCInfo.h"
 #include "../include/CSCHelper.h"
 #include "../include/CSCHelperFunctions.h"
+#include "../include/StageTimers.h"
+#include "../include/CandidateMatcher.h"
+#include "../include/EmulationCache.h"
 
 int main(int argc, char* argv[]){
 	LUTBuilder p;
@@ -26,190 +31,296 @@ struct SegmentMatch {
 	float pt;
 };
 
-int LUTBuilder::run(std::string inputfile, std::string outputfile, int start, int end) {
-
-	cout << "Running over file: " << inputfile << endl;
-
-
-	TFile* f = TFile::Open(inputfile.c_str());
-	if(!f) throw "Can't open file";
-
-	TTree* t =  (TTree*)f->Get("CSCDigiTree");
-	if(!t) throw "Can't find tree";
+LUTBuilder::LUTBuilder() :
+	_ownsShared(false),
+	_lineFits(0),
+	_newPatterns(0),
+	_oldPatterns(0),
+	_cache(0),
+	_newSearch(0),
+	_oldSearch(0),
+	_evt(0),
+	_muons(0),
+	_segments(0),
+	_comparators(0),
+	_lut(0),
+	_matcher(CandidateMatcher::NEAREST)
+{
+}
 
-	//
-	// SET INPUT BRANCHES
-	//
+LUTBuilder::~LUTBuilder(){
+	delete _evt;
+	delete _muons;
+	delete _segments;
+	delete _comparators;
+	delete _lut;
+
+	if(_ownsShared){
+		delete _lineFits;
+		delete _newPatterns;
+		delete _oldPatterns;
+		delete _cache;
+		delete _newSearch;
+		delete _oldSearch;
+	}
+}
 
-	CSCInfo::Event evt(t);
-	CSCInfo::Muons muons(t);
-	CSCInfo::Segments segments(t);
-	CSCInfo::RecHits recHits(t);
-	CSCInfo::LCTs lcts(t);
-	CSCInfo::CLCTs clcts(t);
-	CSCInfo::Comparators comparators(t);
+/* @brief Makes the patterns and the line fit LUT, done once and shared by all the workers
+ */
+int LUTBuilder::setup() {
+	_ownsShared = true;
 
 	//
 	// MAKE ALL THE PATTERNS
 	//
 
-
-	vector<CSCPattern>* newEnvelopes = createNewPatterns();
-	vector<CSCPattern>* oldEnvelopes = createOldPatterns();
-
+	{
+		STAGE_TIMER("pattern creation");
+		_newPatterns = createNewPatterns();
+		_oldPatterns = createOldPatterns();
+	}
+	_newSearch = new CachedCLCTSearch(_newPatterns);
+	_oldSearch = new CachedCLCTSearch(_oldPatterns);
 
 	//
 	// Map to look at probability
 	// TODO: incorporate this functionality into LUT class once it is more figured out
 	//
-	LUT bayesLUT("bayes", LINEFIT_LUT_PATH);
+	_lineFits = new LUT("bayes");
+	if(_lineFits->loadLinearFits()) {
+		cout << "Error: can't make line fit LUT" << endl;
+		return -1;
+	}
 
+	//clcts of a previous run over the same events, if given one
+	if(!_emulationCache.empty()){
+		_cache = new EmulationCache();
+		if(_cache->open(_emulationCache)) return -1;
+	}
+
+	return 0;
+}
+
+Processor* LUTBuilder::makeWorker() const {
+	LUTBuilder* worker = new LUTBuilder();
+	worker->_lineFits = _lineFits;
+	worker->_newPatterns = _newPatterns;
+	worker->_oldPatterns = _oldPatterns;
+	worker->_cache = _cache;
+	worker->_newSearch = _newSearch;
+	worker->_oldSearch = _oldSearch;
+	return worker;
+}
+
+/* @brief Sets the input branches and starts this worker's LUT from the line fits
+ */
+int LUTBuilder::beginWorker(TTree* t) {
 
 	//
-	// TREE ITERATION
+	// SET INPUT BRANCHES
 	//
 
+	//only read what is used below
+	CSCInfo::disableAll(t);
+	_evt = new CSCInfo::Event(t);
+	_muons = new CSCInfo::Muons(t);
+	_segments = new CSCInfo::Segments(t);
+	_comparators = new CSCInfo::Comparators(t);
 
-	if(end > t->GetEntries() || end < 0) end = t->GetEntries();
+	if(_cache) _evt->select({"RunNumber", "EventNumber"});
+	else _evt->select({});
+	_muons->select({"pt"});
+	_segments->select({"mu_id", "ch_id", "pos_x", "dxdz"});
+	_comparators->select({"ch_id", "lay", "strip", "halfStrip", "bestTime"});
 
-	printf("Starting Event = %i, Ending Event = %i\n", start, end);
+	_lut = new LUT(*_lineFits);
+	return 0;
+}
 
-	for(int i = start; i < end; i++) {
-		if(!(i%100)) printf("%3.2f%% Done --- Processed %u Events\n", 100.*(i-start)/(end-start), i-start);
+int LUTBuilder::processEntry(long long entry) {
+	//
+	//Iterate through all possible chambers
+	//
+	for(int chamberHash = 0; chamberHash < (int)CSCHelper::MAX_CHAMBER_HASH; chamberHash++){
+		CSCHelper::ChamberId c = CSCHelper::unserialize(chamberHash);
 
-		t->GetEntry(i);
+		unsigned int EC = c.endcap;
+		unsigned int ST = c.station;
+		unsigned int RI = c.ring;
+		unsigned int CH = c.chamber;
+
+		if(!CSCHelper::isValidChamber(ST,RI,CH,EC)) continue;
 
 		//
-		//Iterate through all possible chambers
+		// Emulate the TMB to find all the CLCTs
 		//
-		for(int chamberHash = 0; chamberHash < (int)CSCHelper::MAX_CHAMBER_HASH; chamberHash++){
-			CSCHelper::ChamberId c = CSCHelper::unserialize(chamberHash);
-
-			unsigned int EC = c.endcap;
-			unsigned int ST = c.station;
-			unsigned int RI = c.ring;
-			unsigned int CH = c.chamber;
 
-			if(!CSCHelper::isValidChamber(ST,RI,CH,EC)) continue;
+		ChamberHits compHits(ST, RI, EC, CH);
 
-			//
-			// Emulate the TMB to find all the CLCTs
-			//
-
-			ChamberHits compHits(ST, RI, EC, CH);
+		{
+			STAGE_TIMER("hit filling");
+			if(compHits.fill(*_comparators)) return -1;
+		}
 
-			if(compHits.fill(comparators)) return -1;
+		vector<CLCTCandidate*> newSetMatch;
+		vector<CLCTCandidate*> oldSetMatch;
 
-			vector<CLCTCandidate*> newSetMatch;
-			vector<CLCTCandidate*> oldSetMatch;
+		//get all the clcts in the chamber
 
-			//get all the clcts in the chamber
+		bool multipleInOneLayer = false;
+		{
+			STAGE_TIMER("clct search");
+			multipleInOneLayer = _oldSearch->find(_cache, _evt->RunNumber, _evt->EventNumber, compHits, oldSetMatch, &_cacheLookups) ||
+					_newSearch->find(_cache, _evt->RunNumber, _evt->EventNumber, compHits, newSetMatch, &_cacheLookups);
+		}
+		if(multipleInOneLayer) {
+			oldSetMatch.clear();
+			newSetMatch.clear();
+			continue;
+		}
 
-			if(searchForMatch(compHits, oldEnvelopes,oldSetMatch) || searchForMatch(compHits, newEnvelopes,newSetMatch)) {
-				oldSetMatch.clear();
-				newSetMatch.clear();
-				continue;
-			}
+		//TODO: currently no implementation dealing with cases where we find one and not other
+		if(!oldSetMatch.size() || !newSetMatch.size()) {
+			oldSetMatch.clear();
+			newSetMatch.clear();
+			continue;
+		}
 
-			//TODO: currently no implementation dealing with cases where we find one and not other
-			if(!oldSetMatch.size() || !newSetMatch.size()) {
-				oldSetMatch.clear();
-				newSetMatch.clear();
-				continue;
-			}
 
+		vector<int> matchedNewId;
+		vector<int> matchedOldId;
 
-			vector<int> matchedNewId;
-			vector<int> matchedOldId;
 
+		vector<SegmentMatch> matchedNew;
 
-			vector<SegmentMatch> matchedNew;
+		//segments in the chamber, away from its edges
+		vector<unsigned int> chamberSegments;
+		for(unsigned int thisSeg = 0; thisSeg < _segments->size(); thisSeg++){
+			int segHash = _segments->ch_id->at(thisSeg);
+			if(segHash != chamberHash) continue;
+			// IGNORE SEGMENTS AT THE EDGES OF THE CHAMBERS
+			if(CSCHelper::segmentIsOnEdgeOfChamber(_segments->pos_x->at(thisSeg), ST,RI)) continue;
+			chamberSegments.push_back(thisSeg);
+		}
 
+		//
+		// find the closest of the clcts in the chamber to each segment
+		//
 
-			//iterate through segments
-			for(unsigned int thisSeg = 0; thisSeg < segments.size(); thisSeg++){
-				int segHash = segments.ch_id->at(thisSeg);
-				if(segHash != chamberHash) continue;
+		vector<int> closestOldMatches;
+		vector<int> closestNewMatches;
+		{
+			STAGE_TIMER("matching");
+			auto segmentKey = [&](unsigned int i){return MatchKey(_segments->pos_x->at(chamberSegments[i]));};
+			_matcher.match(chamberSegments.size(), segmentKey,
+					oldSetMatch.size(), [&](unsigned int i){return MatchKey(oldSetMatch[i]->keyStrip());}, closestOldMatches);
+			_matcher.match(chamberSegments.size(), segmentKey,
+					newSetMatch.size(), [&](unsigned int i){return MatchKey(newSetMatch[i]->keyStrip());}, closestNewMatches);
+		}
 
+		//iterate through segments
+		for(unsigned int iseg = 0; iseg < chamberSegments.size(); iseg++){
+			unsigned int thisSeg = chamberSegments[iseg];
+			STAGE_TIMER("matching");
 
-				float segmentX = segments.pos_x->at(thisSeg); //strips
-				float segmentdXdZ = segments.dxdz->at(thisSeg);
-				float Pt = muons.pt->at(segments.mu_id->at(thisSeg));
 
+			float segmentX = _segments->pos_x->at(thisSeg); //strips
+			float segmentdXdZ = _segments->dxdz->at(thisSeg);
+			float Pt = _muons->pt->at(_segments->mu_id->at(thisSeg));
 
-				// IGNORE SEGMENTS AT THE EDGES OF THE CHAMBERS
-				if(CSCHelper::segmentIsOnEdgeOfChamber(segmentX, ST,RI)) continue;
+			int closestOldMatchIndex = closestOldMatches[iseg];
+			int closestNewMatchIndex = closestNewMatches[iseg];
+			if(closestOldMatchIndex < 0 || closestNewMatchIndex < 0) continue;
 
-				//
-				// find all the clcts that are in the chamber, and match
-				//
+			if(DEBUG > 0) cout << "--- Segment Position: " << segmentX << " [strips] ---" << endl;
+			if(DEBUG > 0) cout << "Legacy Match: " << oldSetMatch.at(closestOldMatchIndex)->keyStrip() << " [strips]" << endl;
+			if(DEBUG > 0) cout << "New Match: " << newSetMatch.at(closestNewMatchIndex)->keyStrip() << " [strips]" << endl;
 
-				if(DEBUG > 0) cout << "--- Segment Position: " << segmentX << " [strips] ---" << endl;
-				if(DEBUG > 0) cout << "Legacy Match: (";
-				int closestOldMatchIndex = findClosestToSegment(oldSetMatch,segmentX);
-				if(DEBUG > 0) cout << ") [strips]" << endl;
+			/* TODO currently not optimum selection could
+			 * have a case where clct1 and clct2 are closest to seg1,
+			 * clct1 could match seg2, but gets ignore by this procedure.
+			 * CandidateMatcher::CLOSEST_FIRST would do it, but changes the LUTs
+			 */
+			if(find(matchedNewId.begin(), matchedNewId.end(), closestNewMatchIndex) == matchedNewId.end()){
 
+				auto& clct = newSetMatch.at(closestNewMatchIndex);
 
-				if(DEBUG > 0)cout << "New Match: (";
-				int closestNewMatchIndex = findClosestToSegment(newSetMatch,segmentX);
-				if(DEBUG > 0) cout << ") [strips]" << endl;
+				float clctX = clct->keyStrip();
 
-				/* TODO currently not optimum selection could
-				 * have a case where clct1 and clct2 are closest to seg1,
-				 * clct1 could match seg2, but gets ignore by this procedure
-				 */
-				if(find(matchedNewId.begin(), matchedNewId.end(), closestNewMatchIndex) == matchedNewId.end()){
+				SegmentMatch thisMatch;
+				thisMatch.clctIndex = closestNewMatchIndex;
+				thisMatch.posOffset = segmentX-clctX;
+				thisMatch.slopeOffset = segmentdXdZ;
+				thisMatch.pt = Pt;
 
-					auto& clct = newSetMatch.at(closestNewMatchIndex);
+				matchedNewId.push_back(closestNewMatchIndex);
+				matchedNew.push_back(thisMatch); //not the most elegant, but fuck it
 
-					float clctX = clct->keyStrip();
+			}
+			if(find(matchedOldId.begin(),matchedOldId.end(), closestOldMatchIndex) == matchedOldId.end()){
+				matchedOldId.push_back(closestOldMatchIndex);
+			}
+		}
 
-					SegmentMatch thisMatch;
-					thisMatch.clctIndex = closestNewMatchIndex;
-					thisMatch.posOffset = segmentX-clctX;
-					thisMatch.slopeOffset = segmentdXdZ;
-					thisMatch.pt = Pt;
+		for(int iclct=0; iclct < (int)newSetMatch.size(); iclct++){
+			auto& clct = newSetMatch.at(iclct);
+			LUTEntry* entry = 0;
+			STAGE_TIMER("lut filling");
 
-					matchedNewId.push_back(closestNewMatchIndex);
-					matchedNew.push_back(thisMatch); //not the most elegant, but fuck it
+			if(_lut->editEntry(clct->key(),entry)){
+				return -1;
+			}
 
+			bool foundSegment = false;
+			for(auto segMatch : matchedNew){
+				if(segMatch.clctIndex == iclct){
+					foundSegment = true;
+					float pt = segMatch.pt;
+					float pos = segMatch.posOffset;
+					float slope = segMatch.slopeOffset;
+					entry->addCLCT(newSetMatch.size(), pt, pos,slope);
 				}
-				if(find(matchedOldId.begin(),matchedOldId.end(), closestOldMatchIndex) == matchedOldId.end()){
-					matchedOldId.push_back(closestOldMatchIndex);
-				}
 			}
+			if(!foundSegment){
+				entry->addCLCT(newSetMatch.size());
+			}
+		}
 
-			for(int iclct=0; iclct < (int)newSetMatch.size(); iclct++){
-				auto& clct = newSetMatch.at(iclct);
-				LUTEntry* entry = 0;
 
-				if(bayesLUT.editEntry(clct->key(),entry)){
-					return -1;
-				}
+		oldSetMatch.clear();
+		newSetMatch.clear();
+	}
+	return 0;
+}
 
-				bool foundSegment = false;
-				for(auto segMatch : matchedNew){
-					if(segMatch.clctIndex == iclct){
-						foundSegment = true;
-						float pt = segMatch.pt;
-						float pos = segMatch.posOffset;
-						float slope = segMatch.slopeOffset;
-						entry->addCLCT(newSetMatch.size(), pt, pos,slope);
-					}
-				}
-				if(!foundSegment){
-					entry->addCLCT(newSetMatch.size());
-				}
-			}
+/* @brief Adds the clcts of another worker, which ran over the entries following this one's
+ */
+int LUTBuilder::mergeWorker(Processor* worker) {
+	LUTBuilder* w = dynamic_cast<LUTBuilder*>(worker);
+	if(!w || !_lut || !w->_lut) return -1;
 
+	_cacheLookups.hits += w->_cacheLookups.hits;
+	_cacheLookups.misses += w->_cacheLookups.misses;
+	return _lut->addCLCTs(*w->_lut);
+}
 
-			oldSetMatch.clear();
-			newSetMatch.clear();
-		}
+int LUTBuilder::writeOutput(const std::string& outputfile) {
+	//every worker is done with it
+	if(_cache){
+		_cache->printSummary(_cacheLookups);
+		if(_cache->close()) return -1;
 	}
 
-	bayesLUT.writeToROOT(outputfile);
+	if(_lut->writeToROOT(outputfile)) return -1;
 
 	cout << "Wrote to file: " << outputfile << endl;
 	return 0;
 }
+
+int LUTBuilder::writeCheckpoint(TDirectory* dir) {
+	return _lut ? _lut->writeCLCTs(dir) : -1;
+}
+
+int LUTBuilder::readCheckpoint(TDirectory* dir) {
+	return _lut ? _lut->loadCLCTs(dir) : -1;
+}
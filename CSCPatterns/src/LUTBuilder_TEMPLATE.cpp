@@ -63,9 +63,8 @@ int LUTBuilder_TEMPLATE::run(std::string inputfile, std::string outputfile, int
 	//
 	// LUT
 	//
-	//TODO: need to fix to use LINEFIT_LUT_PATH and make it capable on LXPLUS as well as LPC
-	LUT demoLUT("demo", "dat/linearFits.lut");
-	//LUT demoLUT("demo", string("dat/linearFits.lut"));
+	LUT demoLUT("demo");
+	if(demoLUT.loadLinearFits()) throw "Can't make line fit LUT";
 	demoLUT.print();
 	return 0;
 
@@ -11,11 +11,14 @@
 #include <vector>
 #include <set>
 #include <math.h>
+#include <stdio.h>
 
 
 //TEMP
 #include "TFile.h"
 #include "TH1F.h"
+#include "TKey.h"
+#include "TList.h"
 #include "../include/CSCConstants.h"
 #include "../include/CSCClasses.h"
 #include "../include/CSCHelperFunctions.h"
@@ -70,6 +73,7 @@ LUTEntry::LUTEntry():
 						_quality(-1)
 {
 	_isFinal = false;
+	_rank = NO_RANK;
 }
 
 LUTEntry::LUTEntry(float position, float slope, unsigned long nsegments, float pt, unsigned long nclcts,
@@ -84,9 +88,20 @@ LUTEntry::LUTEntry(float position, float slope, unsigned long nsegments, float p
 						_multiplicity(multiplicity),
 						_quality(quality){
 	_isFinal = false;
+	_rank = NO_RANK;
 }
 
 int LUTEntry::loadTree(TTree* tree) {
+	if(_isFinal) return -1;
+	_nclcts = tree->GetEntries();
+	_nsegments = 0;
+	if(addTree(tree)) return -1;
+	return makeFinal();
+}
+
+/* @brief Adds the clcts of a tree written by makeTree
+ */
+int LUTEntry::addTree(TTree* tree) {
 	if(_isFinal) return -1;
 	bool hasSegment;
 	float position;
@@ -99,18 +114,17 @@ int LUTEntry::loadTree(TTree* tree) {
 	tree->SetBranchAddress("pt",&pt);
 	tree->SetBranchAddress("multiplicity", &multiplicity);
 
-	_nclcts = tree->GetEntries();
-	_nsegments = 0;
-	for(unsigned int i =0; i < _nclcts; i++){
+	const long long clcts = tree->GetEntries();
+	for(long long i =0; i < clcts; i++){
 		tree->GetEntry(i);
-		if(hasSegment)_nsegments++;
 		_hasSegment.push_back(hasSegment);
 		_positionOffsets.push_back(position);
 		_slopeOffsets.push_back(slope);
 		_pts.push_back(pt);
 		_clctMultiplicities.push_back(multiplicity);
 	}
-	return makeFinal();
+	tree->ResetBranchAddresses();
+	return 0;
 }
 
 /*@brief adds a CLCT to the entry, if pt > -1., we are also adding a segment
@@ -219,6 +233,15 @@ float LUTEntry::multiplicity() const{
 	return _multiplicity;
 }
 
+/* @brief Packed quality rank, set once the LUT is final.
+ * Layers (more is better) are in the top 8 bits, the order in
+ * chi2 then |slope| (smaller is better) among all entries of the LUT
+ * in the lower 24. Only comparable between entries of the same LUT
+ */
+unsigned int LUTEntry::rank() const{
+	return _rank;
+}
+
 /* @brief Makes a tree out of the variables obtained from each individual clct / segment
  *
  */
@@ -314,7 +337,7 @@ _isLegacy(isLegacy)
 	_nclcts = 0;
 	_nsegments = 0;
 	_sortOrder = "cslxk";
-	_orderedLUT = set<pair<LUTKey,LUTEntry>, LUTLambda>(_lutFunc);
+	compileSortOrder(_sortOrder, _sortChain);
 }
 
 LUT::LUT():
@@ -334,6 +357,22 @@ LUT::LUT(const string& name, const char*  lutfile, const bool isLegacy):
 	LUT(name, string(lutfile),isLegacy){
 }
 
+/* @brief The ordering holds iterators into _lut, so it has
+ * to be rebuilt against the copied map
+ */
+LUT::LUT(const LUT& l):
+	_name(l._name),
+	_isFinal(l._isFinal),
+	_isLegacy(l._isLegacy),
+	_nclcts(l._nclcts),
+	_nsegments(l._nsegments),
+	_sortOrder(l._sortOrder),
+	_sortChain(l._sortChain),
+	_lut(l._lut)
+{
+	if(_isFinal) order();
+}
+
 int LUT::setEntry(const LUTKey& k,const LUTEntry& e){
 	if(_isFinal) {
 		return -1;
@@ -372,17 +411,13 @@ int LUT::getEntry(const LUTKey& k, const LUTEntry*& e, bool debug) const{
 		cout << "Need to finalize LUT to access entries" <<endl;
 		return -1;
 	}
-	if(debug) cout << "Looking for [ " << k._pattern << ", " << k._code << "] in orderedLUT (size:" << _orderedLUT.size() << ") " <<endl;
-	for(auto& x: _orderedLUT){
-		if(debug) cout << "[" << x.first._pattern << ", " << x.first._code << "]: " <<
-				"[qual = " << x.second.quality() << "]" << endl;
-
-		if(k == x.first){
-			e = &(x.second);
-			return 0;
-		}
-	}
-	return -1;
+	if(debug) cout << "Looking for [ " << k._pattern << ", " << k._code << "] in LUT (size:" << _lut.size() << ") " <<endl;
+	auto it = _lut.find(k);
+	if(it == _lut.end()) return -1;
+	if(debug) cout << "[" << it->first._pattern << ", " << it->first._code << "]: " <<
+			"[qual = " << it->second.quality() << "]" << endl;
+	e = &(it->second);
+	return 0;
 }
 
 
@@ -435,7 +470,7 @@ void LUT::print(unsigned int minClcts,unsigned int minSegments,unsigned int minL
 	 */
 /*
 	double norm = 0;
-	for(auto& x: _orderedLUT){
+	for(auto& x: *this){
 		//probability the code shows up at all
 		double p_cc = (double)x.second.nclcts()/nclcts();
 		//probability the code shows up, given we have a real muon
@@ -445,7 +480,7 @@ void LUT::print(unsigned int minClcts,unsigned int minSegments,unsigned int minL
 	double p_mu = 1./norm;
 */
 
-	for(auto& x: _orderedLUT){
+	for(auto& x: *this){
 		const LUTKey& k = x.first;
 		const LUTEntry& e = x.second;
 
@@ -585,6 +620,84 @@ int LUT::loadText(const string& textfile){
 	return 0;
 }
 
+/* @brief Fills the LUT with a straight line fit to the hits of
+ * every new pattern / comparator code combination, the same
+ * as LUTLinearFitWriter_Macro used to write to linearFits.lut.
+ *
+ * Fits y = a + b*x with x = layer - 2 (key layer), y = half strip
+ * within the pattern relative to its center, using closed form least
+ * squares with unit weights. Codes with less than two hits are skipped.
+ */
+int LUT::loadLinearFits(){
+	if(_isFinal) return -1;
+	if(_isLegacy) {
+		cout << "Error: line fits only exist for new patterns" << endl;
+		return -1;
+	}
+	vector<CSCPattern>* newPatterns = createNewPatterns();
+
+	for(auto patt = newPatterns->begin(); patt != newPatterns->end(); ++patt){
+		for(int code = 0; code < (int)NCOMPARATOR_CODES; code++){
+			int hits [MAX_PATTERN_WIDTH][NLAYERS];
+			if(patt->recoverPatternCCCombination(code, hits)){
+				cout << "Error: CC evaluation has failed" << endl;
+				delete newPatterns;
+				return -1;
+			}
+
+			unsigned int n = 0;
+			double x[NLAYERS*MAX_PATTERN_WIDTH];
+			double y[NLAYERS*MAX_PATTERN_WIDTH];
+			double sumx = 0;
+			double sumy = 0;
+			double sumx2 = 0;
+			double sumxy = 0;
+			for(unsigned int i =0; i < NLAYERS; i++){
+				for(unsigned int j =0; j < MAX_PATTERN_WIDTH; j++){
+					if(!hits[j][i]) continue;
+					x[n] = (int)i-2; //shift to key half strip layer (layer 3)
+					y[n] = j-(MAX_PATTERN_WIDTH-1)/2.;
+					sumx += x[n];
+					sumy += y[n];
+					sumx2 += x[n]*x[n];
+					sumxy += x[n]*y[n];
+					n++;
+				}
+			}
+
+			//can't fit a line
+			if(n < 2) continue;
+
+			//at most one hit per layer, so delta is never 0 here
+			double delta = n*sumx2 - sumx*sumx;
+			double b = (n*sumxy - sumx*sumy)/delta;
+			double a = (sumy - b*sumx)/n;
+			double chi2 = 0;
+			for(unsigned int k = 0; k < n; k++){
+				double residual = y[k] - a - b*x[k];
+				chi2 += residual*residual;
+			}
+
+			//
+			// Some funky sign issues, slope is opposite the expected sign,
+			// and offset is off by 0.5 strips, and need to convert to strips
+			//
+			float offset = 0.5*a - 0.75;
+			float slope = -0.5*b;
+
+			// same defaults as a line fit loaded with loadText()
+			LUTEntry entry(offset, slope, 0, 0, 0, 0, -1., n, chi2);
+			if(setEntry(LUTKey(patt->_id, code), entry)) {
+				delete newPatterns;
+				return -1;
+			}
+		}
+	}
+	delete newPatterns;
+	if(DEBUG > 1) cout << "lut.size():" << _lut.size() << endl;
+	return 0;
+}
+
 int LUT::writeToText(const string& filename) {
 		cout << "\033[94m=== Writing LUT ===\033[0m" << endl;
 		cout << "Writing to file: " << filename << endl;
@@ -596,7 +709,7 @@ int LUT::writeToText(const string& filename) {
 		}
 		if(!_isFinal)makeFinal();
 
-		for(auto& it : _orderedLUT){
+		for(auto& it : *this){
 
 			// pat code - pos slope nseg qual layers chi2
 			myfile << it.first._pattern << " ";
@@ -628,7 +741,7 @@ int LUT::writeToROOT(const string& filename){
 
 
 	outF->cd();
-	for(auto& it :_orderedLUT){
+	for(auto& it : *this){
 		int patt = it.first._pattern;
 		int cc = it.first._code;
 		string treeName = string("p" + to_string(patt) + "_cc" + to_string(cc));
@@ -641,66 +754,234 @@ int LUT::writeToROOT(const string& filename){
 	return 0;
 }
 
+/* @brief Writes a tree of the clcts of each entry that has any, named as
+ * in writeToROOT, into dir. Doesn't finalize the LUT, loadCLCTs adds them
+ * back to a LUT that is still being built
+ */
+int LUT::writeCLCTs(TDirectory* dir) const {
+	if(_isFinal) return -1;
+	dir->cd();
+	for(auto& it : _lut){
+		if(!it.second._clctMultiplicities.size()) continue;
+		int patt = it.first._pattern;
+		int cc = it.first._code;
+		string treeName = string("p" + to_string(patt) + "_cc" + to_string(cc));
+		TTree* thisTree = it.second.makeTree(treeName);
+		if(!thisTree) return -1;
+		thisTree->Write();
+		delete thisTree;
+	}
+	return 0;
+}
+
+int LUT::loadCLCTs(TDirectory* dir) {
+	if(_isFinal) return -1;
+	TList* keys = dir->GetListOfKeys();
+	for(int i = 0; keys && i < keys->GetSize(); i++){
+		TKey* key = (TKey*)keys->At(i);
+		int patt = 0;
+		int cc = 0;
+		if(sscanf(key->GetName(), "p%i_cc%i", &patt, &cc) != 2) continue;
+		LUTEntry* entry = 0;
+		TTree* t = 0;
+		dir->GetObject(key->GetName(), t);
+		if(!t || editEntry(LUTKey(patt, cc), entry) || entry->addTree(t)) {
+			cout << "Error: can't load clcts of entry: " << key->GetName() << endl;
+			delete t;
+			return -1;
+		}
+		delete t;
+	}
+	return 0;
+}
+
+int LUT::addCLCTs(const LUT& l) {
+	if(_isFinal || l._isFinal) return -1;
+	for(auto& it : l._lut){
+		const LUTEntry& from = it.second;
+		if(!from._clctMultiplicities.size()) continue;
+		LUTEntry* entry = 0;
+		if(editEntry(it.first, entry)) {
+			cout << "Error: can't add clcts of entry: p" << it.first._pattern << "_cc" << it.first._code << endl;
+			return -1;
+		}
+		entry->_hasSegment.insert(entry->_hasSegment.end(), from._hasSegment.begin(), from._hasSegment.end());
+		entry->_positionOffsets.insert(entry->_positionOffsets.end(), from._positionOffsets.begin(), from._positionOffsets.end());
+		entry->_slopeOffsets.insert(entry->_slopeOffsets.end(), from._slopeOffsets.begin(), from._slopeOffsets.end());
+		entry->_pts.insert(entry->_pts.end(), from._pts.begin(), from._pts.end());
+		entry->_clctMultiplicities.insert(entry->_clctMultiplicities.end(),
+				from._clctMultiplicities.begin(), from._clctMultiplicities.end());
+	}
+	return 0;
+}
+
 /* @brief Writes pattern Specific LUTs (PSLs),
  * readable by the OTMB. One for each pattern
  */
 int LUT::writeToPSLs(const string& fileprefix){
 	cout << "\033[94m=== Writing PSL ===\033[0m" << endl;
-	if(!_isFinal)makeFinal();
+	vector<unsigned int> words;
+	if(encodePSLs(words)) return -1;
+	return writePSLWords(fileprefix, words);
+}
 
-	/* Stored if we every need these plots later...
-	cout << "writing test.root file" << endl;
-	TFile * outF = new TFile("temp.root","RECREATE");
-	TH1F* h_poffsets = new TH1F("pos_offsets","Linear Fit Position Offsets", 200, -2, 2);
-	h_poffsets->GetXaxis()->SetTitle("Centered Segment Offset [half-strips]");
-	h_poffsets->GetYaxis()->SetTitle("Comparator Codes");
+/* @brief Encodes the whole (final) LUT into PSL words in a single
+ * pass over the table. The words are laid out pattern by pattern,
+ * in the order of PATTERN_IDS, with NCOMPARATOR_CODES words each.
+ * Codes that aren't in the LUT, or have less than 3 layers, are 0
+ */
+int LUT::encodePSLs(vector<unsigned int>& words){
+	if(!_isFinal && makeFinal()) return -1;
+	words.assign(NPATTERNS*NCOMPARATOR_CODES, 0);
 
-	TH1F* h_soffsets = new TH1F("slope_offsets", "Linear Fit Slope Offsets", 200, -2, 2);
-	h_soffsets->GetXaxis()->SetTitle("Segment Slope Offset [ hs / layer]");
-	h_soffsets->GetYaxis()->SetTitle("Comparator Codes");
-	 */
+	for(auto& x: _lut){
+		const LUTKey& k = x.first;
+		if(k._code < 0 || k._code >= (int)NCOMPARATOR_CODES) continue;
+		int pattIndex = -1;
+		for(unsigned int i = 0; i < NPATTERNS; i++){
+			if((int)PATTERN_IDS[i] == k._pattern) {
+				pattIndex = i;
+				break;
+			}
+		}
+		if(pattIndex < 0 || x.second._layers < 3) continue;
+		words[pattIndex*NCOMPARATOR_CODES + k._code] = convertToPSLLine(x.second);
+	}
+	return 0;
+}
 
+/* @brief Writes words made by encodePSLs() to one file per pattern.
+ * Each file is formatted in memory and written with a single call
+ */
+int LUT::writePSLWords(const string& fileprefix, const vector<unsigned int>& words){
+	if(words.size() != NPATTERNS*NCOMPARATOR_CODES){
+		cout << "Error: expected " << NPATTERNS*NCOMPARATOR_CODES << " PSL words, got " << words.size() << endl;
+		return -1;
+	}
+	static const char hexDigits[] = "0123456789abcdef";
+	const unsigned int nDigits = 5; //18 bits
+	const unsigned int lineLength = nDigits+1;
+	string buffer(NCOMPARATOR_CODES*lineLength, '\n');
 
 	for(unsigned int i = 0; i < NPATTERNS; i++){
-		unsigned int pattern = PATTERN_IDS[i];
-		string thisPattFilename = fileprefix + "-" + to_string(pattern) + ".psl";
-		cout << "Writing to file: " << thisPattFilename << endl;
-		ofstream outfile;
-		outfile.open(thisPattFilename);
+		string thisPattFilename = fileprefix + "-" + to_string(PATTERN_IDS[i]) + ".psl";
+		if(DEBUG > 0) cout << "Writing to file: " << thisPattFilename << endl;
+
+		for(unsigned int ccode = 0; ccode < NCOMPARATOR_CODES; ccode++){
+			unsigned int word = words[i*NCOMPARATOR_CODES + ccode];
+			char* line = &buffer[ccode*lineLength];
+			for(int d = nDigits-1; d >= 0; d--){
+				line[d] = hexDigits[word & 0xf];
+				word >>= 4;
+			}
+		}
+
+		ofstream outfile(thisPattFilename, ios::binary);
 		if(!outfile){
 			cerr << "Error: can't write file" << endl;
 			return -1;
 		}
+		outfile.write(buffer.data(), buffer.size());
+		if(!outfile){
+			cerr << "Error: failed writing file: " << thisPattFilename << endl;
+			return -1;
+		}
+	}
+	return 0;
+}
 
-		for(unsigned int ccode = 0; ccode < NCOMPARATOR_CODES; ccode++){
-			unsigned int outnum = 0;
-			const LUTEntry* e = 0;
-			if(getEntry(LUTKey(pattern,ccode), e) || (e && e->_layers < 3)){
-				//we couldn't find the key in the LUT
-				outnum = convertToPSLLine(LUTEntry());
-			}else {
-				outnum = convertToPSLLine(*e);
-				/*
-				h_poffsets->Fill(2.*e->position()-0.5);
-				h_soffsets->Fill(2.*e->slope());
-				if(abs(2.*e->position()-0.5) > 2){
-					printPatternCC(pattern, (int) ccode);
+/* @brief Reads a set of PSLs (fileprefix-<pattern>.psl) back into
+ * words, laid out the same as in encodePSLs()
+ */
+int LUT::readPSLs(const string& fileprefix, vector<unsigned int>& words){
+	words.assign(NPATTERNS*NCOMPARATOR_CODES, 0);
+	for(unsigned int i = 0; i < NPATTERNS; i++){
+		string thisPattFilename = fileprefix + "-" + to_string(PATTERN_IDS[i]) + ".psl";
+		ifstream infile(thisPattFilename, ios::binary);
+		if(!infile){
+			cout << "Error: unable to open file:" << thisPattFilename << endl;
+			return -1;
+		}
+		string buffer((istreambuf_iterator<char>(infile)), istreambuf_iterator<char>());
+
+		unsigned int ccode = 0;
+		unsigned int word = 0;
+		unsigned int nDigits = 0;
+		for(char c : buffer){
+			if(c == '\n' || c == '\r'){
+				if(!nDigits) continue;
+				if(ccode >= NCOMPARATOR_CODES) {
+					cout << "Error: too many lines in " << thisPattFilename << endl;
+					return -1;
 				}
-				*/
+				words[i*NCOMPARATOR_CODES + ccode++] = word;
+				word = 0;
+				nDigits = 0;
+				continue;
 			}
+			unsigned int digit;
+			if(c >= '0' && c <= '9') digit = c - '0';
+			else if(c >= 'a' && c <= 'f') digit = c - 'a' + 10;
+			else if(c >= 'A' && c <= 'F') digit = c - 'A' + 10;
+			else {
+				cout << "Error: bad character in " << thisPattFilename << " line " << ccode+1 << endl;
+				return -1;
+			}
+			word = (word << 4) | digit;
+			nDigits++;
+		}
+		if(nDigits && ccode < NCOMPARATOR_CODES) words[i*NCOMPARATOR_CODES + ccode++] = word;
+		if(ccode != NCOMPARATOR_CODES){
+			cout << "Error: " << thisPattFilename << " has " << ccode << " lines, expected " << NCOMPARATOR_CODES << endl;
+			return -1;
+		}
+	}
+	return 0;
+}
 
-			outfile << hex << setw(5) << setfill('0')  << outnum << endl;
+/* @brief Fills the LUT with the quantized entries stored in a set of PSLs.
+ * Codes written as 0 (not in the LUT, or < 3 layers) are left out
+ */
+int LUT::loadPSLs(const string& fileprefix){
+	if(_isFinal) return -1;
+	vector<unsigned int> words;
+	if(readPSLs(fileprefix, words)) return -1;
+	for(unsigned int i = 0; i < NPATTERNS; i++){
+		for(unsigned int ccode = 0; ccode < NCOMPARATOR_CODES; ccode++){
+			unsigned int word = words[i*NCOMPARATOR_CODES + ccode];
+			if(!word) continue;
+			if(setEntry(LUTKey(PATTERN_IDS[i], ccode), convertFromPSLLine(word))) return -1;
 		}
-		outfile.close();
 	}
-	/*
-	h_poffsets->Write();
-	h_soffsets->Write();
-	outF->Close();
-	*/
 	return 0;
 }
 
+/* @brief Compares two sets of PSLs word by word,
+ * returns the amount of words that differ, or -1 if
+ * the files couldn't be read
+ */
+int LUT::comparePSLs(const string& prefix1, const string& prefix2, bool verbose){
+	vector<unsigned int> words1;
+	vector<unsigned int> words2;
+	if(readPSLs(prefix1, words1) || readPSLs(prefix2, words2)) return -1;
+
+	int differences = 0;
+	for(unsigned int i = 0; i < words1.size(); i++){
+		if(words1[i] == words2[i]) continue;
+		differences++;
+		if(!verbose) continue;
+		LUTEntry e1 = convertFromPSLLine(words1[i]);
+		LUTEntry e2 = convertFromPSLLine(words2[i]);
+		printf("patt: %3i cc: %4i | %05x [pos: %6.3f slp: %6.3f lay: %i] != %05x [pos: %6.3f slp: %6.3f lay: %i]\n",
+				PATTERN_IDS[i/NCOMPARATOR_CODES], i%NCOMPARATOR_CODES,
+				words1[i], e1.position(), e1.slope(), e1._layers,
+				words2[i], e2.position(), e2.slope(), e2._layers);
+	}
+	if(verbose) cout << prefix1 << " vs " << prefix2 << ": " << differences << " / " << words1.size() << " words differ" << endl;
+	return differences;
+}
+
+
 /* @brief Once all segments have been put into the LUT,
  * this recalculates the positions / slopes and puts them
  * all in order
@@ -715,12 +996,9 @@ int LUT::makeFinal(){
 		if(x.second.makeFinal()) return -1;
 		_nclcts += x.second.nclcts();
 		_nsegments += x.second.nsegments();
-		bool inserted = _orderedLUT.insert(x).second;
-		if(!inserted) {
-			cout << "Error: did not insert into ordered lut" << endl;
-			return -1;
-		}
 	}
+	if(rankEntries()) return -1;
+	if(order()) return -1;
 	if(DEBUG>0) cout <<"madeFinal: "<< _name<<" lut.size():" << _lut.size() << " orderedLUT.size(): "<< _orderedLUT.size() << endl;
 	_isFinal = true;
 	return 0;
@@ -728,17 +1006,113 @@ int LUT::makeFinal(){
 
 int LUT::sort(const string& sortOrder){
 	if(makeFinal()) return -1;
-
-	//TODO: could be done in a nicer way...
+	if(compileSortOrder(sortOrder, _sortChain)) return -1;
 	_sortOrder = sortOrder;
+	return order();
+}
 
-	_orderedLUT.clear();
+/* @brief Sets the packed rank of every entry (see LUTEntry::rank()),
+ * following the ordering of CLCTCandidate::quality
+ */
+int LUT::rankEntries(){
+	vector<LUTEntry*> entries;
+	entries.reserve(_lut.size());
+	for(auto& x: _lut) entries.push_back(&(x.second));
+	if(entries.size() >= (1 << 24)) {
+		cout << "Error: too many entries to rank" << endl;
+		return -1;
+	}
 
-	for(auto& x: _lut){
-		_orderedLUT.insert(x);
+	std::sort(entries.begin(), entries.end(),
+			[](const LUTEntry* e1, const LUTEntry* e2){
+		if(e1->_chi2 != e2->_chi2) return e1->_chi2 < e2->_chi2;
+		return abs(e1->slope()) < abs(e2->slope());
+	});
+
+	unsigned int fitRank = 0;
+	for(unsigned int i = 0; i < entries.size(); i++){
+		LUTEntry* e = entries[i];
+		if(i && (e->_chi2 != entries[i-1]->_chi2 ||
+				abs(e->slope()) != abs(entries[i-1]->slope()))) fitRank++;
+		unsigned int layers = e->_layers < 0xff ? e->_layers : 0xff;
+		e->_rank = ((0xff - layers) << 24) | fitRank;
 	}
-	//_orderedLUT = newOrderedLUT;
+	return 0;
+}
 
+/* @brief Translates the sort string into the chain of fields
+ * used by order(), returns -1 on an unknown character
+ */
+int LUT::compileSortOrder(const string& sortOrder, vector<char>& chain){
+	vector<char> newChain;
+	for(auto c: sortOrder){
+		switch (c) {
+		case 'p':
+		case 's':
+		case 'c':
+		case 'l':
+		case 'm':
+		case 'x':
+		case 'e':
+		case 'k':
+			newChain.push_back(c);
+			break;
+		default:
+			cout << "Error: unknown LUT sort character: " << c << endl;
+			return -1;
+		}
+	}
+	chain = newChain;
+	return 0;
+}
+
+/* @brief Value of a single field in the sort chain,
+ * signed such that larger values come first
+ */
+double LUT::sortValue(char field, const LUTKey& k, const LUTEntry& e){
+	switch (field) {
+	case 'p': return e.probability();
+	case 's': return e.nsegments();
+	case 'c': return e.nclcts();
+	case 'l': return e._layers;
+	case 'm': return e.multiplicity();
+	case 'x': return -e._chi2; //x^2, smaller is better
+	case 'e': return e.pt(); //energy
+	case 'k': return k._pattern*(double)NCOMPARATOR_CODES + k._code; //same as LUTKey::operator<
+	default: return 0;
+	}
+}
+
+/* @brief Rebuilds the ordering of the LUT as a permutation
+ * of the entries in _lut. Each field of the sort chain is
+ * evaluated once per entry, so the whole thing is one
+ * std::sort of indices. Ties fall back on the key order.
+ */
+int LUT::order(){
+	_entries.clear();
+	_entries.reserve(_lut.size());
+	for(auto it = _lut.cbegin(); it != _lut.cend(); ++it) _entries.push_back(it);
+
+	const unsigned int nfields = _sortChain.size();
+	vector<double> values(_entries.size()*nfields);
+	for(unsigned int i = 0; i < _entries.size(); i++){
+		for(unsigned int f = 0; f < nfields; f++){
+			values[i*nfields+f] = sortValue(_sortChain[f], _entries[i]->first, _entries[i]->second);
+		}
+	}
+
+	_orderedLUT.resize(_entries.size());
+	for(unsigned int i = 0; i < _orderedLUT.size(); i++) _orderedLUT[i] = i;
+
+	std::sort(_orderedLUT.begin(), _orderedLUT.end(),
+			[&values, nfields](unsigned int i1, unsigned int i2){
+		const double* v1 = &values[i1*nfields];
+		const double* v2 = &values[i2*nfields];
+		for(unsigned int f = 0; f < nfields; f++){
+			if(v1[f] != v2[f]) return v1[f] > v2[f];
+		}
+		return i1 < i2;
+	});
 	return 0;
 }
 
@@ -758,63 +1132,41 @@ int LUT::nsegments() {
 	return _nsegments;
 }
 
+// See email "CLCT output to Track Finder"
+// Need position offset range of [-2,2] hs, and 0.125 half-strip resolution to make proper use of our new scheme
+// [2 - (-2)]/ 0.25 = 16 -> 4 bits
+//
+//Need slope offset range of [-2,2] hs/layer and 0.125 hs/layer resolution
+// [2- (-2)] / 0.125 = 32 -> 5 bits
+//
+// use 9 bits to store quality
+// temporarily just the number of layers in the code
+const unsigned int PSL_OUT_BITS = 18; //amount of bits we can write to
+const unsigned int PSL_POSITION_RANGE = 2;
+const unsigned int PSL_POSITION_BITS = 4;
+const unsigned int PSL_SLOPE_RANGE = 2;
+const unsigned int PSL_SLOPE_BITS = 5;
+const unsigned int PSL_QUALITY_BITS = PSL_OUT_BITS - PSL_SLOPE_BITS - PSL_POSITION_BITS;
+
 int LUT::convertToPSLLine(const LUTEntry& e){
 	if(e == LUTEntry()){ //we just have the default constructor
 		return 0;
 	}
 
+	unsigned int positionBits = QuantizedLUT::positionToBits(e.position(), PSL_POSITION_BITS);
+	unsigned int slopeBits = QuantizedLUT::slopeToBits(e.slope(), PSL_SLOPE_BITS);
 
-	const unsigned int nOutBits = 18; //amount of bits we can write to
-
-	// See email "CLCT output to Track Finder"
-	// Need position offset range of [-2,2] hs, and 0.125 half-strip resolution to make proper use of our new scheme
-	// [2 - (-2)]/ 0.25 = 16 -> 4 bits
-	const unsigned int positionRange = 2;
-	const unsigned int nPositionBits = 4;
-	float epsilon = 0.00001; // for putting quantities just below maxmimum
-	//const unsigned int positionBins = (2*positionRange)*(nPositionBits);
-
-	//convert to halfstrips, and center distribution in positive region (don't have to worry about signs) for shipping
-	float centeredHsPosition = 2.*e.position()-0.5 + positionRange;
-	if(centeredHsPosition < 0) centeredHsPosition = 0; //cut things outside bounds, shouldn't be many
-	else if(centeredHsPosition >= 2.*positionRange) centeredHsPosition = 2.*positionRange-epsilon;
-	//make it fit within 4 bits, this expression seems a bit shaky... only works for even ranges?
-	unsigned int positionBits = (unsigned int)floor(centeredHsPosition*pow(2, nPositionBits-positionRange));
-
-	//
-	//Need slope offset range of [-2,2] hs/layer and 0.125 hs/layer resolution
-	// [2- (-2)] / 0.125 = 32 -> 5 bits
-
-	const unsigned int slopeRange = 2;
-	const unsigned int nSlopeBits = 5;
-	float centeredHsSlope = 2.*e.slope() + slopeRange;
-	if(centeredHsSlope < 0) {
-		//cout << centeredHsSlope << endl;
-		centeredHsSlope = 0;
-	}
-	else if(centeredHsSlope >=2.*slopeRange) {
-		centeredHsSlope = 2.*slopeRange-epsilon;
-	}
-
-	unsigned int slopeBits = (unsigned int)floor(centeredHsSlope*pow(2,nSlopeBits-slopeRange));
-
-
-	//
-	// use 9 bits to store quality
-	// temporarily just the number of layers in the code
-	//
-	const unsigned int nQualityBits = nOutBits - nSlopeBits - nPositionBits;
 	unsigned int qualityBits = e._layers;
 
 	//bits we will eventually convert to the string we write
-	unsigned int outBits = (positionBits << (nOutBits-nPositionBits)) | (slopeBits << (nOutBits-nPositionBits-nSlopeBits)) | qualityBits;
+	unsigned int outBits = (positionBits << (PSL_OUT_BITS-PSL_POSITION_BITS)) | (slopeBits << (PSL_OUT_BITS-PSL_POSITION_BITS-PSL_SLOPE_BITS)) | qualityBits;
 	//if(DEBUG > 3){
 	if(outBits > 262143){
-		bitset<nPositionBits> p(positionBits);
-		bitset<nSlopeBits> s(slopeBits);
-		bitset<nQualityBits> q(qualityBits);
+		bitset<PSL_POSITION_BITS> p(positionBits);
+		bitset<PSL_SLOPE_BITS> s(slopeBits);
+		bitset<PSL_QUALITY_BITS> q(qualityBits);
 		cout << "pos: " << p << " slope: " << s << " qual: "<< q << endl;
-		bitset<nOutBits> o(outBits);
+		bitset<PSL_OUT_BITS> o(outBits);
 		cout << "out: " << o << endl;
 		cout << outBits << endl;
 	}
@@ -822,6 +1174,115 @@ int LUT::convertToPSLLine(const LUTEntry& e){
 	return outBits;
 }
 
+/* @brief Inverse of convertToPSLLine(), position and slope are
+ * put in the center of their bins, so re-encoding the entry
+ * gives back the same word
+ */
+LUTEntry LUT::convertFromPSLLine(unsigned int word){
+	if(!word) return LUTEntry();
+
+	unsigned int positionBits = (word >> (PSL_OUT_BITS-PSL_POSITION_BITS)) & ((1 << PSL_POSITION_BITS)-1);
+	unsigned int slopeBits = (word >> (PSL_OUT_BITS-PSL_POSITION_BITS-PSL_SLOPE_BITS)) & ((1 << PSL_SLOPE_BITS)-1);
+	unsigned int qualityBits = word & ((1 << PSL_QUALITY_BITS)-1);
+
+	float position = QuantizedLUT::bitsToPosition(positionBits, PSL_POSITION_BITS);
+	float slope = QuantizedLUT::bitsToSlope(slopeBits, PSL_SLOPE_BITS);
+
+	return LUTEntry(position, slope, 0, -1, 0, -1, -1, qualityBits, 0);
+}
+
+
+//
+// QuantizedLUT
+//
+
+QuantizedLUT::QuantizedLUT(unsigned int positionBits, unsigned int slopeBits):
+	_positionBits(positionBits),
+	_slopeBits(slopeBits){
+}
+
+/* @brief Quantizes the position and slope of every entry
+ * in a (final) LUT with the new patterns
+ */
+int QuantizedLUT::fill(const LUT& lut){
+	if(!lut.isFinal()){
+		cout << "Error: need to finalize LUT before quantizing it" << endl;
+		return -1;
+	}
+	_position.assign(NPATTERNS*NCOMPARATOR_CODES, 0.);
+	_slope.assign(NPATTERNS*NCOMPARATOR_CODES, 0.);
+	_hasEntry.assign(NPATTERNS*NCOMPARATOR_CODES, false);
+	for(auto& x: lut){
+		int index = getIndex(x.first);
+		if(index < 0) continue;
+		_position[index] = bitsToPosition(positionToBits(x.second.position(), _positionBits), _positionBits);
+		_slope[index] = bitsToSlope(slopeToBits(x.second.slope(), _slopeBits), _slopeBits);
+		_hasEntry[index] = true;
+	}
+	return 0;
+}
+
+/* @brief Gets the quantized position offset [strips] and slope [strips/layer],
+ * returns -1 if the key isn't in the LUT
+ */
+int QuantizedLUT::getEntry(const LUTKey& k, float& position, float& slope) const{
+	int index = getIndex(k);
+	if(index < 0 || !_hasEntry[index]) return -1;
+	position = _position[index];
+	slope = _slope[index];
+	return 0;
+}
+
+int QuantizedLUT::getIndex(const LUTKey& k){
+	if(k._code < 0 || k._code >= (int)NCOMPARATOR_CODES) return -1;
+	for(unsigned int i = 0; i < NPATTERNS; i++){
+		if((int)PATTERN_IDS[i] == k._pattern) return i*NCOMPARATOR_CODES + k._code;
+	}
+	return -1;
+}
+
+/* @brief Position offset [strips] -> nBits, covering
+ * [-2,2] half strips, same as in the PSLs
+ */
+unsigned int QuantizedLUT::positionToBits(float position, unsigned int nBits){
+	float epsilon = 0.00001; // for putting quantities just below maxmimum
+
+	//convert to halfstrips, and center distribution in positive region (don't have to worry about signs) for shipping
+	float centeredHsPosition = 2.*position-0.5 + PSL_POSITION_RANGE;
+	if(centeredHsPosition < 0) centeredHsPosition = 0; //cut things outside bounds, shouldn't be many
+	else if(centeredHsPosition >= 2.*PSL_POSITION_RANGE) centeredHsPosition = 2.*PSL_POSITION_RANGE-epsilon;
+	unsigned int bits = (unsigned int)floor(centeredHsPosition*pow(2, nBits)/(2.*PSL_POSITION_RANGE));
+	unsigned int maxBits = (1 << nBits) - 1;
+	return bits > maxBits ? maxBits : bits;
+}
+
+/* @brief Center of the bin, in strips
+ */
+float QuantizedLUT::bitsToPosition(unsigned int bits, unsigned int nBits){
+	float centeredHsPosition = (bits+0.5)*(2.*PSL_POSITION_RANGE)/pow(2, nBits);
+	return (centeredHsPosition - PSL_POSITION_RANGE + 0.5)/2.;
+}
+
+/* @brief Slope [strips/layer] -> nBits, covering
+ * [-2,2] half strips / layer, same as in the PSLs
+ */
+unsigned int QuantizedLUT::slopeToBits(float slope, unsigned int nBits){
+	float epsilon = 0.00001;
+	float centeredHsSlope = 2.*slope + PSL_SLOPE_RANGE;
+	if(centeredHsSlope < 0) centeredHsSlope = 0;
+	else if(centeredHsSlope >= 2.*PSL_SLOPE_RANGE) centeredHsSlope = 2.*PSL_SLOPE_RANGE-epsilon;
+	unsigned int bits = (unsigned int)floor(centeredHsSlope*pow(2, nBits)/(2.*PSL_SLOPE_RANGE));
+	unsigned int maxBits = (1 << nBits) - 1;
+	return bits > maxBits ? maxBits : bits;
+}
+
+/* @brief Center of the bin, in strips / layer
+ */
+float QuantizedLUT::bitsToSlope(unsigned int bits, unsigned int nBits){
+	float centeredHsSlope = (bits+0.5)*(2.*PSL_SLOPE_RANGE)/pow(2, nBits);
+	return (centeredHsSlope - PSL_SLOPE_RANGE)/2.;
+}
+
 
 //
 // DetectorLUTs
@@ -863,7 +1324,9 @@ int DetectorLUTs::addEntry(const string& name, int station, int ring, const stri
 		if(DEBUG >0) cout << "Adding LUT: " << lutpath << endl;
 		if(!lutpath.size()) {
 			if(!_isLegacy){ //default to line fits if not legacy
-				_luts.insert(make_pair(key, LUT(name,LINEFIT_LUT_PATH, _isLegacy)));
+				LUT lineFits(name, _isLegacy);
+				if(lineFits.loadLinearFits()) return -1;
+				_luts.insert(make_pair(key, lineFits));
 			}else {
 				_luts.insert(make_pair(key, LUT(name, _isLegacy)));
 			}
@@ -927,6 +1390,37 @@ int DetectorLUTs::writeAll(const string& path) {
 	return 0;
 }
 
+/* @brief Writes the PSLs of every chamber type, path+name-<pattern>.psl.
+ * Everything is encoded before any file is written
+ */
+int DetectorLUTs::writeAllPSLs(const string& path) {
+	cout << "\033[94m=== Writing PSLs ===\033[0m" << endl;
+	if(makeFinal()) return -1;
+	vector<pair<string, vector<unsigned int> > > allWords;
+	allWords.reserve(_luts.size());
+	for(auto& l : _luts){
+		allWords.push_back(make_pair(path+l.second._name, vector<unsigned int>()));
+		if(l.second.encodePSLs(allWords.back().second)) return -1;
+	}
+	for(auto& w : allWords){
+		if(LUT::writePSLWords(w.first, w.second)) return -1;
+	}
+	return 0;
+}
+
+/* @brief Compares the PSLs of every chamber type in two directories,
+ * returns the total amount of differing words, or -1 on a read failure
+ */
+int DetectorLUTs::compareAllPSLs(const string& path1, const string& path2, bool verbose){
+	int differences = 0;
+	for(unsigned int i = 0; i < NCHAMBERS; i++){
+		int diff = LUT::comparePSLs(path1+CHAMBER_NAMES[i], path2+CHAMBER_NAMES[i], verbose);
+		if(diff < 0) return -1;
+		differences += diff;
+	}
+	return differences;
+}
+
 
 
 
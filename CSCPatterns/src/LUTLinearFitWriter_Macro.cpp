@@ -7,8 +7,6 @@
 
 #include "../include/CSCHelperFunctions.h"
 #include "../include/CSCClasses.h"
-#include <TGraph.h>
-#include <TF1.h>
 #include <TSystem.h>
 #include <TH1F.h>
 
@@ -18,36 +16,10 @@
 
 using namespace std;
 
-float HS_ERROR = 0.288675; //uncertainty per layer in half strips 1/sqrt(12)
-
-
-/* get fit parameter errors for y = mx + b fit
- * see page 188 in Taylor - Error Analysis for derivation
- */
-int getErrors(const vector<int>& x,const vector<int>& y, float& sigmaM, float& sigmaB) {
-
-	int N = x.size();
-	if(!N) return -1;
-
-	float sumx = 0;
-	float sumx2 = 0;
-	for(int i =0; i < N; i++){
-		sumx += x[i];
-		sumx2 += x[i]*x[i];
-	}
-
-	float delta = N*sumx2 - sumx*sumx;
-
-	sigmaM = HS_ERROR * sqrt(1.*N/delta);
-	sigmaB = HS_ERROR * sqrt(sumx2/delta);
-
-	return 0;
-}
-
-
 int LUTLinearFitWriter_Macro(){
 	gSystem->Load("../lib/CSCClasses_cpp.so");
 	gSystem->Load("../lib/CSCHelperFunctions_cpp.so");
+	gSystem->Load("../lib/LUTClasses_cpp.so");
 
 
 	//all the patterns we will fit
@@ -58,12 +30,13 @@ int LUTLinearFitWriter_Macro(){
 	//output file stream to write the fits
 	const string outName = "../dat/linearFits.lut";
 
-	ofstream output;
-	output.open(outName.c_str());
-	if(!output.is_open()){
-		cout << "can't open file:" << endl;
+	//fits are done in LUT::loadLinearFits()
+	LUT lut("linearFits");
+	if(lut.loadLinearFits()){
+		cout << "Error: failed making line fits" << endl;
+		return -1;
 	}
-	//output << "Pattern\tCC\tOffset\tSlope\tChi2\tNDF\tSlopeErr\tOffErr\n";
+	lut.sort("k");
 
 	//Used to calculate span of position offsets
 	float maxOffset = -1;
@@ -73,97 +46,19 @@ int LUTLinearFitWriter_Macro(){
 	float minPatt = 1;
 	float minCode = 1;
 
-	// for each pattern
-	for(auto patt = newPatterns->begin(); patt != newPatterns->end(); ++patt){
-		// iterate through each possible comparator code
-		for(int code = 0; code < 4096; code++){
-
-
-			if(DEBUG >0) {
-				cout << "Evaluating Pattern: " << patt->getName() << " CC: " << code << endl;
-			}
-			int hits [MAX_PATTERN_WIDTH][NLAYERS];
-
-			if(patt->recoverPatternCCCombination(code, hits)){
-				cout << "Error: CC evaluation has failed" << endl;
+	for(auto& x : lut){
+		const float offset = x.second.position();
+		if(x.second._layers >= N_LAYER_REQUIREMENT){
+			if(offset < minOffset) {
+				minOffset = offset;
+				minPatt = x.first._pattern;
+				minCode = x.first._code;
 			}
-
-			//put the coordinates in the hits into a vector
-			// x = layer, y = position in that layer
-			vector<int> x;
-			vector<int> y;
-
-			for(unsigned int i =0; i < NLAYERS; i++){
-				for(unsigned int j =0; j < MAX_PATTERN_WIDTH; j++){
-					if(DEBUG > 0) cout << hits[j][i];
-					if(hits[j][i]){
-						x.push_back(i-2); //shift to key half strip layer (layer 3)
-						y.push_back(j-(MAX_PATTERN_WIDTH-1)/2.);
-					}
-				}
-				if(DEBUG > 0) cout << endl;
+			if(offset > maxOffset) {
+				maxOffset = offset;
+				maxPatt = x.first._pattern;
+				maxCode = x.first._code;
 			}
-
-			//skip if we only have less than two hits (can't fit a line)
-			if(x.size() <  2) continue;
-
-			// for each combination fit a straight line
-			TGraph* gr = new TGraph(x.size(), &x[0], &y[0]);
-
-			TF1* fit = new TF1("fit", "[0]+[1]*x", -3, 4);
-			gr->Fit("fit");
-
-			//
-			// Some funky sign issues, slope is opposite the expected sign,
-			// and offset is off by 0.5 strips, and need to convert to strips
-			//
-
-			//double offset = 0.5*fit->GetParameter(0) + 0.25; //offset between the two
-			//double slope = -0.5*fit->GetParameter(1);
-			double offset = 0.5*fit->GetParameter(0) - 0.75; //offset between the two
-			double slope = -0.5*fit->GetParameter(1);
-			double chi2 = fit->GetChisquare();
-			double ndf = fit->GetNDF();
-
-
-
-			float sigmaM, sigmaB;
-
-			getErrors(x,y,sigmaM,sigmaB);
-
-			sigmaM *=0.5; //hs to strips
-			sigmaB *=0.5;
-
-			if(DEBUG > 0) cout << "Offset: " << offset<<
-					" Slope: " << slope << endl;
-
-
-            // formatted as: pattern (cc) - position slope nsegments (quality layers chi2)
-
-			int layers = ndf+2;
-			int nsegments = 0; //set default
-			float quality = -1.; //set default
-
-			output << patt->getName() << " " << code << " ~ " <<
-					offset << " " << slope << " " <<
-					nsegments << " " << quality << " " <<
-					layers << " " << chi2 << "\n";
-					//sigmaB << "\t" << sigmaM <<"\n";
-
-			if(layers >= N_LAYER_REQUIREMENT){
-				if(offset < minOffset) {
-					minOffset = offset;
-					minPatt = patt->_id;
-					minCode = code;
-				}
-				if(offset > maxOffset) {
-					maxOffset = offset;
-					maxPatt = patt->_id;
-					maxCode = code;
-				}
-			}
-
-			delete gr;
 		}
 	}
 
@@ -179,8 +74,7 @@ int LUTLinearFitWriter_Macro(){
 			patt->printCode(maxCode);
 		}
 	}
-	cout << "Wrote to: " << outName<< endl;
-	output.close();
+	// formatted as: pattern (cc) - position slope nsegments (quality layers chi2)
+	if(lut.writeToText(outName)) return -1;
 	return 0;
 }
-
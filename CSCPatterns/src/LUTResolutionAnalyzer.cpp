@@ -10,6 +10,10 @@
 #include <TFile.h>
 #include <TH1F.h>
 #include <TH2F.h>
+#include <TList.h>
+#include <TDirectory.h>
+#include <TVectorD.h>
+#include <TParameter.h>
 //#include <TROOT.h>
 
 
@@ -21,10 +25,12 @@
 #include <string>
 #include <vector>
 #include <iostream>
+#include <sstream>
 #include <stdio.h>
 #include <algorithm>
 #include <chrono>
 #include <time.h>
+#include <math.h>
 
 
 //using soft-links, if it doesn't work, is in ../../CSCDigiTuples/include/<name>
@@ -36,6 +42,8 @@
 #include "../include/CSCHelperFunctions.h"
 #include "../include/LUTClasses.h"
 #include "../include/LUTResolutionAnalyzer.h"
+#include "../include/EmulationCache.h"
+#include "../include/StageTimers.h"
 
 
 using namespace std;
@@ -44,16 +52,25 @@ using namespace std;
 
 // TODO: Check for TMB Headers
 
-/* TODO: Multithreading
- *
- * - open files in main thread
- * - make histograms in main thread (following recipe here: https://root.cern.ch/doc/v612/imt101__parTreeProcessing_8C.html)
- * - make tree in main thread, using same recipe book
- * - pass tree to new function PatternFinderThread(ttree*(?)), should return a ttree as well
- * - join threads
- * - combine output trees, and write output file: https://root-forum.cern.ch/t/merging-ttrees-on-the-fly/1833
- *
+/* Position / slope bit widths to evaluate the new LUTs at, all in the
+ * same pass, unless given --bit-budgets. Offsets are quantized as in the
+ * PSLs (see QuantizedLUT), {4,5} is what is currently shipped
  */
+const unsigned int N_DEFAULT_BIT_BUDGETS = 10;
+const unsigned int DEFAULT_BIT_BUDGETS[N_DEFAULT_BIT_BUDGETS][2] = {
+		{2,3},
+		{3,3},
+		{3,4},
+		{4,4},
+		{4,5},
+		{5,4},
+		{5,5},
+		{5,6},
+		{6,6},
+		{8,8}
+};
+//widest a position or slope can be quantized to
+const unsigned int MAX_BUDGET_BITS = 16;
 
 int main(int argc, char* argv[]){
 	LUTResolutionAnalyzer p;
@@ -61,17 +78,118 @@ int main(int argc, char* argv[]){
 }
 
 
+LUTResolutionAnalyzer::LUTResolutionAnalyzer() :
+	_ownsShared(false),
+	_newLUTs(0),
+	_legacyLUTs(0),
+	_quantizedLUTs(0),
+	_newPatterns(0),
+	_oldPatterns(0),
+	_cache(0),
+	_newSearch(0),
+	_oldSearch(0),
+	_evt(0),
+	_muons(0),
+	_segments(0),
+	_recHits(0),
+	_lcts(0),
+	_clcts(0),
+	_comparators(0),
+	_plotTree(0),
+	_plotTreeChunks(0),
+	_plotTreeSaved(0),
+	_patternId(0),
+	_ccId(0),
+	_legacyLctId(0),
+	_EC(0),
+	_ST(0),
+	_RI(0),
+	_CH(0),
+	_pt(0),
+	_segmentX(0),
+	_segmentdXdZ(0),
+	_patX(0),
+	_legacyLctX(0),
+	_lutSegmentPosDiff(0),
+	_lutSegmentPosDiff_halfStrip(0),
+	_lutSegmentPosDiff_quarterStrip(0),
+	_lutSegmentPosDiff_eighthStrip(0),
+	_lutSegmentPosDiff_sixteenthStrip(0),
+	_lutSegmentSlopeDiff(0),
+	_legacyLUTSegmentPosDiff(0),
+	_legacyLUTSegmentSlopeDiff(0),
+	_clctLayerCount(0),
+	_nChambersRanOver(0),
+	_nChambersMultipleInOneLayer(0),
+	_matcher(CandidateMatcher::NEAREST)
+{
+	_ptRanges.push_back(20);
+	_ptRanges.push_back(50);
+	_ptRanges.push_back(100);
+	_ptRanges.push_back(200);
+	_ptRanges.push_back(500);
+	for(unsigned int ib=0; ib < N_DEFAULT_BIT_BUDGETS; ib++){
+		_bitBudgets.push_back(make_pair(DEFAULT_BIT_BUDGETS[ib][0], DEFAULT_BIT_BUDGETS[ib][1]));
+	}
+}
 
-int LUTResolutionAnalyzer::run(string inputfile, string outputfile, int start, int end) {
-
-	cout << "Running over file: " << inputfile << endl;
-
+LUTResolutionAnalyzer::~LUTResolutionAnalyzer(){
+	delete _evt;
+	delete _muons;
+	delete _segments;
+	delete _recHits;
+	delete _lcts;
+	delete _clcts;
+	delete _comparators;
+	delete _plotTree;
+	for(auto h : _hists) delete h;
+
+	if(_ownsShared){
+		delete _newLUTs;
+		delete _legacyLUTs;
+		delete _quantizedLUTs;
+		delete _newPatterns;
+		delete _oldPatterns;
+		delete _cache;
+		delete _newSearch;
+		delete _oldSearch;
+	}
+}
 
-	TFile* f = TFile::Open(inputfile.c_str());
-	if(!f) throw "Can't open file";
+/* @brief --bit-budgets posBits:slopeBits,posBits:slopeBits,... replaces the
+ * default bit budgets
+ */
+int LUTResolutionAnalyzer::option(int argc, char* argv[], int i){
+	if(string(argv[i]) != "--bit-budgets") return 0;
+	if(i+1 >= argc) return -1;
+
+	vector<pair<unsigned int, unsigned int> > budgets;
+	stringstream ss(argv[i+1]);
+	string budget;
+	while(getline(ss, budget, ',')){
+		unsigned int posBits = 0;
+		unsigned int slopeBits = 0;
+		char end = 0;
+		if(sscanf(budget.c_str(), "%u:%u%c", &posBits, &slopeBits, &end) != 2 ||
+				!posBits || !slopeBits || posBits > MAX_BUDGET_BITS || slopeBits > MAX_BUDGET_BITS){
+			cout << "Error: expected position:slope bits, each 1 to " << MAX_BUDGET_BITS << ", got: " << budget << endl;
+			return -1;
+		}
+		auto b = make_pair(posBits, slopeBits);
+		if(std::find(budgets.begin(), budgets.end(), b) != budgets.end()){
+			cout << "Error: bit budget given twice: " << budget << endl;
+			return -1;
+		}
+		budgets.push_back(b);
+	}
+	if(budgets.empty()) return -1;
+	_bitBudgets = budgets;
+	return 2;
+}
 
-	TTree* t =  (TTree*)f->Get("CSCDigiTree");
-	if(!t) throw "Can't find tree";
+/* @brief Loads the LUTs and patterns, done once and shared by all the workers
+ */
+int LUTResolutionAnalyzer::setup() {
 
 	//
 	// MAKE LUT
@@ -80,16 +198,17 @@ int LUTResolutionAnalyzer::run(string inputfile, string outputfile, int start, i
 	string dataset = "Charmonium/charmonium2016F+2017BCEF";
 	//string dataset = "SingleMuon/zskim2018D";
 
-	DetectorLUTs newLUTs;
-	DetectorLUTs legacyLUTs(true);
+	_ownsShared = true;
+	_newLUTs = new DetectorLUTs();
+	_legacyLUTs = new DetectorLUTs(true);
 
 	const string newLutPath = "dat/"+dataset+"/luts/";
 	const string legacyLutPath = "dat/"+dataset+"/luts/";
 
 	cout << "Loading Luts..." << endl;
 	//check if we have made .lut files already
-	if(newLUTs.loadAll(newLutPath) ||
-			legacyLUTs.loadAll(legacyLutPath)){
+	if(_newLUTs->loadAll(newLutPath) ||
+			_legacyLUTs->loadAll(legacyLutPath)){
 		printf("Could not find .lut files, recreating them...\n");
 		//string lutFilepath = "/home/wnash/workspace/CSCUCLA/CSCPatterns/dat/"+dataset+"/CLCTMatch-Full.root";
 		string lutFilepath = "/uscms/home/wnash/CSCUCLA/CSCPatterns/dat/"+dataset+"/CLCTMatch-Full.root";
@@ -105,95 +224,141 @@ int LUTResolutionAnalyzer::run(string inputfile, string outputfile, int start, i
 			printf("Can't find lutTree\n");
 			return -1;
 		}
-		if(makeLUT(lutTree, newLUTs, legacyLUTs)){
+		if(makeLUT(lutTree, *_newLUTs, *_legacyLUTs)){
 			cout << "Error: couldn't create LUT" << endl;
 			return -1;
 		}
 
-		newLUTs.writeAll("dat/"+dataset+"/luts/");
-		legacyLUTs.writeAll("dat/"+dataset+"/luts/");
+		_newLUTs->writeAll("dat/"+dataset+"/luts/");
+		_legacyLUTs->writeAll("dat/"+dataset+"/luts/");
 	} else {
-		newLUTs.makeFinal();
-		legacyLUTs.makeFinal();
+		_newLUTs->makeFinal();
+		_legacyLUTs->makeFinal();
 	}
 
 	cout << "Loaded LUTS" << endl;
 
-	//pointers used to look at different LUT's
-	//const LUT* thisLUT = 0;
-	//const LUTEntry* thisEntry = 0;
-
+	//quantized copies of the new LUTs, one for each bit budget
+	_quantizedLUTs = new map<pair<int,int>, vector<QuantizedLUT> >();
+	for(unsigned int i=0; i < NCHAMBERS; i++){
+		auto key = make_pair((int)CHAMBER_ST_RI[i][0],(int)CHAMBER_ST_RI[i][1]);
+		const LUT* lut = 0;
+		if(_newLUTs->getLUT(key.first, key.second, lut)){
+			printf("Error: can't access LUT for: %i %i\n", key.first, key.second);
+			return -1;
+		}
+		vector<QuantizedLUT>& qluts = (*_quantizedLUTs)[key];
+		for(auto& budget : _bitBudgets){
+			qluts.push_back(QuantizedLUT(budget.first, budget.second));
+			if(qluts.back().fill(*lut)) return -1;
+		}
+	}
 
 	//
-	// SET INPUT BRANCHES
+	// MAKE ALL THE PATTERNS
 	//
 
-	CSCInfo::Event evt(t);
-	CSCInfo::Muons muons(t);
-	CSCInfo::Segments segments(t);
-	CSCInfo::RecHits recHits(t);
-	CSCInfo::LCTs lcts(t);
-	CSCInfo::CLCTs clcts(t);
-	CSCInfo::Comparators comparators(t);
+	_newPatterns = createNewPatterns();
+	_oldPatterns = createOldPatterns();
+	_newSearch = new CachedCLCTSearch(_newPatterns);
+	_oldSearch = new CachedCLCTSearch(_oldPatterns);
+
+	//clcts of a previous run over the same events, if given one
+	if(!_emulationCache.empty()){
+		_cache = new EmulationCache();
+		if(_cache->open(_emulationCache)) return -1;
+	}
+
+	return 0;
+}
+
+Processor* LUTResolutionAnalyzer::makeWorker() const {
+	LUTResolutionAnalyzer* worker = new LUTResolutionAnalyzer();
+	worker->_newLUTs = _newLUTs;
+	worker->_legacyLUTs = _legacyLUTs;
+	worker->_quantizedLUTs = _quantizedLUTs;
+	worker->_newPatterns = _newPatterns;
+	worker->_oldPatterns = _oldPatterns;
+	worker->_cache = _cache;
+	worker->_newSearch = _newSearch;
+	worker->_oldSearch = _oldSearch;
+	worker->_bitBudgets = _bitBudgets;
+	return worker;
+}
+
+TH1F* LUTResolutionAnalyzer::book(const string& name, const string& title, unsigned int bins, float low, float high){
+	TH1F* h = new TH1F(name.c_str(), title.c_str(), bins, low, high);
+	_hists.push_back(h);
+	return h;
+}
+
+/* @brief Sets the input branches and books the output tree and histograms
+ */
+int LUTResolutionAnalyzer::beginWorker(TTree* t) {
 
 	//
-	// MAKE ALL THE PATTERNS
+	// SET INPUT BRANCHES
 	//
 
-
-	vector<CSCPattern>* newPatterns= createNewPatterns();
-	vector<CSCPattern>* oldPatterns = createOldPatterns();
+	//only read what is used below
+	CSCInfo::disableAll(t);
+	_evt = new CSCInfo::Event(t);
+	_muons = new CSCInfo::Muons(t);
+	_segments = new CSCInfo::Segments(t);
+	_recHits = new CSCInfo::RecHits(t);
+	_lcts = new CSCInfo::LCTs(t);
+	_clcts = new CSCInfo::CLCTs(t);
+	_comparators = new CSCInfo::Comparators(t);
+
+	if(_cache) _evt->select({"RunNumber", "EventNumber"});
+	else _evt->select({});
+	_lcts->select({});
+	_muons->select({"pt"});
+	_segments->select({"mu_id", "ch_id", "pos_x", "dxdz"});
+	_clcts->select({"ch_id", "keyStrip", "pattern"});
+	_comparators->select({"ch_id", "lay", "strip", "halfStrip", "bestTime"});
+	if(USE_COMP_HITS || !DEBUG) _recHits->select({});
+	else _recHits->select({"mu_id", "ch_id", "lay", "pos_x"});
 
 	//
 	// OUTPUT TREE
 	//
 
-	int patternId = 0;
-	int ccId = 0;
-	int legacyLctId = 0;
-	int EC = 0; // 1-2
-	int ST = 0; // 1-4
-	int RI = 0; // 1-4
-	int CH = 0;
-	float pt = 0;
-	float segmentX = 0;
-	float segmentdXdZ = 0;
-	float patX = 0;
-	float legacyLctX = 0;
-
-	TFile * outF = new TFile(outputfile.c_str(),"RECREATE");
-	if(!outF){
-		printf("Failed to open output file: %s\n", outputfile.c_str());
-		return -1;
+	_plotTree = new TTree("plotTree","TTree holding processed info for CSCPatterns studies");
+	_plotTree->SetDirectory(0);
+	_plotTree->Branch("EC",&_EC,"EC/I");
+	_plotTree->Branch("ST",&_ST,"ST/I");
+	_plotTree->Branch("RI",&_RI,"RI/I");
+	_plotTree->Branch("CH",&_CH,"CH/I");
+	_plotTree->Branch("patternId", &_patternId, "patternId/I");
+	_plotTree->Branch("ccId", &_ccId, "ccId/I");
+	_plotTree->Branch("legacyLctId", &_legacyLctId, "legacyLctId/I");
+	_plotTree->Branch("pt", &_pt, "pt/F");
+	_plotTree->Branch("segmentX", &_segmentX, "segmentX/F");
+	_plotTree->Branch("segmentdXdZ", &_segmentdXdZ, "segmentdXdZ/F");
+	_plotTree->Branch("patX", &_patX, "patX/F");
+	_plotTree->Branch("legacyLctX", &_legacyLctX, "legacyLctX/F");
+
+	_lutSegmentPosDiff = book("h_lutSegmentPosDiff", "h_lutSegmentPosDiff", 100, -1, 1);
+	_lutSegmentPosDiff_halfStrip = book("h_lutSegmentPosDiff_halfStrip", "h_lutSegmentPosDiff_halfStrip", 100, -1, 1);
+	_lutSegmentPosDiff_quarterStrip = book("h_lutSegmentPosDiff_quarterStrip", "h_lutSegmentPosDiff_quarterStrip", 100, -1, 1);
+	_lutSegmentPosDiff_eighthStrip = book("h_lutSegmentPosDiff_eighthStrip", "h_lutSegmentPosDiff_eighthStrip", 100, -1, 1);
+	_lutSegmentPosDiff_sixteenthStrip = book("h_lutSegmentPosDiff_sixteenthStrip", "h_lutSegmentPosDiff_sixteenthStrip", 100, -1, 1);
+	_lutSegmentSlopeDiff = book("h_lutSegmentSlopeDiff", "h_lutSegmentSlopeDiff", 100, -1, 1);
+
+	_bitBudgetN.assign(_bitBudgets.size(), 0.);
+	_bitBudgetPosSum.assign(_bitBudgets.size(), 0.);
+	_bitBudgetPosSum2.assign(_bitBudgets.size(), 0.);
+	_bitBudgetSlopeSum.assign(_bitBudgets.size(), 0.);
+	_bitBudgetSlopeSum2.assign(_bitBudgets.size(), 0.);
+	for(auto& budget : _bitBudgets){
+		string suffix = "_p" + to_string(budget.first) + "_s" + to_string(budget.second);
+		string posName = "h_lutSegmentPosDiff" + suffix;
+		string slopeName = "h_lutSegmentSlopeDiff" + suffix;
+		_bitBudgetPosDiff.push_back(book(posName, posName+"; Seg - LUT [strips]; CLCTs", 100, -1, 1));
+		_bitBudgetSlopeDiff.push_back(book(slopeName, slopeName+"; Seg - LUT [strips/layer]; CLCTs", 100, -1, 1));
 	}
 
-	TTree * plotTree = new TTree("plotTree","TTree holding processed info for CSCPatterns studies");
-	plotTree->Branch("EC",&EC,"EC/I");
-	plotTree->Branch("ST",&ST,"ST/I");
-	plotTree->Branch("RI",&RI,"RI/I");
-	plotTree->Branch("CH",&CH,"CH/I");
-	plotTree->Branch("patternId", &patternId, "patternId/I");
-	plotTree->Branch("ccId", &ccId, "ccId/I");
-	plotTree->Branch("legacyLctId", &legacyLctId, "legacyLctId/I");
-	plotTree->Branch("pt", &pt, "pt/F");
-	plotTree->Branch("segmentX", &segmentX, "segmentX/F");
-	plotTree->Branch("segmentdXdZ", &segmentdXdZ, "segmentdXdZ/F");
-	plotTree->Branch("patX", &patX, "patX/F");
-	plotTree->Branch("legacyLctX", &legacyLctX, "legacyLctX/F");
-
-	TH1F* lutSegmentPosDiff = new TH1F("h_lutSegmentPosDiff", "h_lutSegmentPosDiff", 100, -1, 1);
-	TH1F* lutSegmentPosDiff_halfStrip = new TH1F("h_lutSegmentPosDiff_halfStrip", "h_lutSegmentPosDiff_halfStrip", 100, -1, 1);
-	TH1F* lutSegmentPosDiff_quarterStrip = new TH1F("h_lutSegmentPosDiff_quarterStrip", "h_lutSegmentPosDiff_quarterStrip", 100, -1, 1);
-	TH1F* lutSegmentPosDiff_eighthStrip = new TH1F("h_lutSegmentPosDiff_eighthStrip", "h_lutSegmentPosDiff_eighthStrip", 100, -1, 1);
-	TH1F* lutSegmentPosDiff_sixteenthStrip = new TH1F("h_lutSegmentPosDiff_sixteenthStrip", "h_lutSegmentPosDiff_sixteenthStrip", 100, -1, 1);
-	TH1F* lutSegmentSlopeDiff = new TH1F("h_lutSegmentSlopeDiff", "h_lutSegmentSlopeDiff", 100, -1, 1);
-
-
-	map<pair<int,int>, TH1F*> lutChamberPlots_Pos;
-	map<pair<int,int>, TH1F*> lutChamberPlots_legacy_Pos; //emulated
-	//map<pair<int,int>, TH1F*> lutChamberPlots_legacy_Pos_real; //actual recorded clcts
-	map<pair<int,int>, TH1F*> lutChamberPlots_Slope;
-	map<pair<int,int>, TH1F*> lutChamberPlots_legacy_Slope;
 	for(unsigned int i=0; i < NCHAMBERS; i++){
 		unsigned int station = CHAMBER_ST_RI[i][0];
 		unsigned int ring = CHAMBER_ST_RI[i][1];
@@ -201,441 +366,623 @@ int LUTResolutionAnalyzer::run(string inputfile, string outputfile, int start, i
 
 		string posName = string("h_"+CHAMBER_NAMES[i]) + "_posDiff";
 		string posLegacyName = string("h_"+CHAMBER_NAMES[i]) + "_legacy_posDiff";
-		//string posLegacyRealName = string("h_"+CHAMBER_NAMES[i]) + "_legacy_posDiff_real";
 		string slopeName = string("h_"+CHAMBER_NAMES[i]) + "_legacy_slopeDiff";
 		string slopeLegacyName = string("h_"+CHAMBER_NAMES[i]) + "_slopeDiff";
-		auto posHist = new TH1F(posName.c_str(), string(posName+string("; Seg- LUT [strips]; CLCTs")).c_str(), 100,-1,1);
-		auto posLegacyHist = new TH1F(posLegacyName.c_str(), string(posLegacyName+string("; Seg- LUT [strips]; CLCTs")).c_str(), 100,-1,1);
-		//auto posLegacyRealHist = new TH1F(posLegacyRealName.c_str(), string(posLegacyRealName+string("; Seg- KS [strips]; CLCTs")).c_str(), 100,-1,1);
-		auto slopeHist = new TH1F(slopeName.c_str(), string(slopeName+string("; Seg - LUT [strips]; CLCTs")).c_str(), 100,-1,1);
-		auto slopeLegacyHist = new TH1F(slopeLegacyName.c_str(), string(slopeLegacyName+string("; Seg - LUT [strips]; CLCTs")).c_str(), 100,-1,1);
-		lutChamberPlots_Pos[key] = posHist;
-		lutChamberPlots_legacy_Pos[key] = posLegacyHist;
-		//lutChamberPlots_legacy_Pos_real[key] = posLegacyRealHist;
-		lutChamberPlots_Slope[key] = slopeHist;
-		lutChamberPlots_legacy_Slope[key] = slopeLegacyHist;
+		_lutChamberPlots_Pos[key] = book(posName, posName+string("; Seg- LUT [strips]; CLCTs"), 100,-1,1);
+		_lutChamberPlots_legacy_Pos[key] = book(posLegacyName, posLegacyName+string("; Seg- LUT [strips]; CLCTs"), 100,-1,1);
+		_lutChamberPlots_Slope[key] = book(slopeName, slopeName+string("; Seg - LUT [strips]; CLCTs"), 100,-1,1);
+		_lutChamberPlots_legacy_Slope[key] = book(slopeLegacyName, slopeLegacyName+string("; Seg - LUT [strips]; CLCTs"), 100,-1,1);
 	}
-	map<int, TH1F*> legacyPatterns_pos; //emulated
-	map<int, TH1F*> legacyPatterns_pos_real;
-	map<int, TH1F*> legacyPatterns_slope;
 	for(unsigned int i =0; i < NLEGACYPATTERNS; i++){
 		string name = string("h_legacy_") + to_string(LEGACY_PATTERN_IDS[i]);
 		string posName = name + "_pos";
 		string posRealName = name + "_real_pos";
 		string slopeName = name + "_slope";
-		auto pos = new TH1F(posName.c_str(), posName.c_str(), 100, -1,1);
-		auto posReal = new TH1F(posRealName.c_str(), posName.c_str(), 100, -1,1);
-		auto slope = new TH1F(slopeName.c_str(), slopeName.c_str(), 100, -1,1);
-		legacyPatterns_pos[LEGACY_PATTERN_IDS[i]] = pos;
-		legacyPatterns_pos_real[LEGACY_PATTERN_IDS[i]] = posReal;
-		legacyPatterns_slope[LEGACY_PATTERN_IDS[i]] = slope;
+		_legacyPatterns_pos[LEGACY_PATTERN_IDS[i]] = book(posName, posName, 100, -1,1);
+		_legacyPatterns_pos_real[LEGACY_PATTERN_IDS[i]] = book(posRealName, posName, 100, -1,1);
+		_legacyPatterns_slope[LEGACY_PATTERN_IDS[i]] = book(slopeName, slopeName, 100, -1,1);
 	}
 
-	TH1F* legacyLUTSegmentPosDiff = new TH1F("h_legacyPosDiff", "h_legacyPosDiff; lut - seg[strips]; segments",100,-1,1);
-	//TH1F* legacyLUTSegmentPosDiff = new TH1F("h_legacyPosDiff", "h_legacyPosDiff; lut - seg[strips]; segments",400,-4,4);
-	TH1F* legacyLUTSegmentSlopeDiff = new TH1F("h_legacySlopeDiff", "h_legacySlopeDiff; lut - seg [strips/lay]", 100, -1,1);
-	TH1F* h_clctLayerCount = new TH1F("h_clctLayerCount", "h_clctlayerCount", 7,0,7);
-
-	map<float, TH1F*> ccPos_pt;
-	map<float, TH1F*> ccSlope_pt;
-	map<float, TH1F*> legacyPos_pt;
-	map<float, TH1F*> legacySlope_pt;
-
-	//looks at region of pt [0 - entry1, entry1- entry2, etc]
-	vector<float> ptRanges;
-	ptRanges.push_back(20);
-	ptRanges.push_back(50);
-	ptRanges.push_back(100);
-	ptRanges.push_back(200);
-	ptRanges.push_back(500);
-
-	for(unsigned int ipt = 0; ipt < ptRanges.size(); ipt++){
-		string lower = (ipt == 0) ? "0" : to_string(round(ptRanges.at(ipt-1)));
-		float thisPt = ptRanges.at(ipt);
+	_legacyLUTSegmentPosDiff = book("h_legacyPosDiff", "h_legacyPosDiff; lut - seg[strips]; segments",100,-1,1);
+	_legacyLUTSegmentSlopeDiff = book("h_legacySlopeDiff", "h_legacySlopeDiff; lut - seg [strips/lay]", 100, -1,1);
+	_clctLayerCount = book("h_clctLayerCount", "h_clctlayerCount", 7,0,7);
+
+	for(unsigned int ipt = 0; ipt < _ptRanges.size(); ipt++){
+		string lower = (ipt == 0) ? "0" : to_string(round(_ptRanges.at(ipt-1)));
+		float thisPt = _ptRanges.at(ipt);
 		string upper = to_string(round(thisPt));
 		string rangeStr = "_"+lower+"_"+upper;
 
-		TH1F* ccPos = new TH1F(("h_ccPos"+rangeStr).c_str(), ("h_ccPos"+rangeStr+";Segment-LUT[strips]; Segments").c_str(), 100, -1,1);
-		TH1F* ccSlope = new TH1F(("h_ccSlope"+rangeStr).c_str(), ("h_ccSlope"+rangeStr+";Segment-LUT[strips/layers]; Segments").c_str(), 100, -1,1);
-		TH1F* legPos = new TH1F(("h_legPos"+rangeStr).c_str(), ("h_legPos"+rangeStr+";Segment-LUT[strips]; Segments").c_str(), 100, -1,1);
-		TH1F* legSlope = new TH1F(("h_legSlope"+rangeStr).c_str(), ("h_legSlope"+rangeStr+";Segment-LUT[strips/layer]; Segments").c_str(), 100, -1,1);
-		ccPos_pt[thisPt] = ccPos;
-		ccSlope_pt[thisPt] = ccSlope;
-		legacyPos_pt[thisPt] = legPos;
-		legacySlope_pt[thisPt] = legSlope;
+		_ccPos_pt[thisPt] = book("h_ccPos"+rangeStr, "h_ccPos"+rangeStr+";Segment-LUT[strips]; Segments", 100, -1,1);
+		_ccSlope_pt[thisPt] = book("h_ccSlope"+rangeStr, "h_ccSlope"+rangeStr+";Segment-LUT[strips/layers]; Segments", 100, -1,1);
+		_legacyPos_pt[thisPt] = book("h_legPos"+rangeStr, "h_legPos"+rangeStr+";Segment-LUT[strips]; Segments", 100, -1,1);
+		_legacySlope_pt[thisPt] = book("h_legSlope"+rangeStr, "h_legSlope"+rangeStr+";Segment-LUT[strips/layer]; Segments", 100, -1,1);
 	}
 
-
-	//t->SetBranchAddress("Event_EventNumber", &evt.EventNumber);
-
-	//CSCInfo::Muons muons;
-	//t->SetBranchAddress("muon_pt", &muons.pt);
-
-	/*
-	if(end > t->GetEntries() || end < 0) end = t->GetEntries();
-
-	printf("Starting Event = %i, Ending Event = %i\n", start, end);
-	for(int i = start; i < end; i++) {
-		if(!(i%10000)) printf("%3.2f%% Done --- Processed %u Events\n", 100.*(i-start)/(end-start), i-start);
-
-		t->GetEntry(i);
-		//printf("EventNum = %llu\n", evt.EventNumber);
-		for(unsigned int j = 0; j < muons.size(); j++) {
-			printf("muon_pt: %f\n", muons.pt[j]);
-		}
-
-	}
 	return 0;
-*/
+}
 
-	//
-	// TREE ITERATION
-	//
+int LUTResolutionAnalyzer::processEntry(long long entry) {
 
-	unsigned int nChambersRanOver = 0;
-	unsigned int nChambersMultipleInOneLayer = 0;
+	//iterate through segments
+	for(unsigned int thisSeg = 0; thisSeg < _segments->size(); thisSeg++){
+		int chamberHash = _segments->ch_id->at(thisSeg);
+		CSCHelper::ChamberId c = CSCHelper::unserialize(chamberHash);
 
-	if(end > t->GetEntries() || end < 0) end = t->GetEntries();
+		_EC = c.endcap;
+		_ST = c.station;
+		_RI = c.ring;
+		_CH = c.chamber;
 
-	printf("Starting Event = %i, Ending Event = %i\n", start, end);
-	//t->SetImplicitMT(true);
+		_segmentX = _segments->pos_x->at(thisSeg); //strips
+		_segmentdXdZ = _segments->dxdz->at(thisSeg);
+		_pt = _muons->pt->at(_segments->mu_id->at(thisSeg));
+		//if(_pt > 12) continue; //REMOVE ME
+		//if(_pt < 40) continue; //REMOVE ME
 
 
-	for(int i = start; i < end; i++) {
-		if(!(i%10000)) printf("%3.2f%% Done --- Processed %u Events\n", 100.*(i-start)/(end-start), i-start);
 
-		t->GetEntry(i);
+		// IGNORE SEGMENTS AT THE EDGES OF THE CHAMBERS
+		if(CSCHelper::segmentIsOnEdgeOfChamber(_segmentX, _ST,_RI)) continue;
 
-		//iterate through segments
-		for(unsigned int thisSeg = 0; thisSeg < segments.size(); thisSeg++){
-			int chamberHash = segments.ch_id->at(thisSeg);
-			CSCHelper::ChamberId c = CSCHelper::unserialize(chamberHash);
 
-			EC = c.endcap;
-			ST = c.station;
-			RI = c.ring;
-			CH = c.chamber;
+		ChamberHits theseRHHits(_ST, _RI, _EC, _CH,false);
+		ChamberHits theseCompHits(_ST, _RI, _EC, _CH);
 
-			segmentX = segments.pos_x->at(thisSeg); //strips
-			segmentdXdZ = segments.dxdz->at(thisSeg);
-			pt = muons.pt->at(segments.mu_id->at(thisSeg));
-			//if(pt > 12) continue; //REMOVE ME
-			//if(pt < 40) continue; //REMOVE ME
+		{
+			STAGE_TIMER("hit filling");
+			if(theseCompHits.fill(*_comparators)) return -1;
 
+			if (!USE_COMP_HITS && DEBUG > 0) if(theseRHHits.fill(*_recHits)) return -1;
+		}
 
+		vector<CLCTCandidate*> newSetMatch;
+		vector<CLCTCandidate*> oldSetMatch;
 
-			// IGNORE SEGMENTS AT THE EDGES OF THE CHAMBERS
-			if(CSCHelper::segmentIsOnEdgeOfChamber(segmentX, ST,RI)) continue;
+		ChamberHits* testChamber;
+		testChamber = USE_COMP_HITS ? &theseCompHits : &theseRHHits;
 
+		_nChambersRanOver++;
 
-			ChamberHits theseRHHits(ST, RI, EC, CH,false);
-			ChamberHits theseCompHits(ST, RI, EC, CH);
+		//now run on comparator hits
+		if(DEBUG > 0) printf("~~~~ Matches for Muon: %lli,  Segment %i ~~~\n",entry,  thisSeg);
+		bool multipleInOneLayer = false;
+		{
+			STAGE_TIMER("clct search");
+			multipleInOneLayer = _oldSearch->find(_cache, _evt->RunNumber, _evt->EventNumber, *testChamber, oldSetMatch, &_cacheLookups) ||
+					_newSearch->find(_cache, _evt->RunNumber, _evt->EventNumber, *testChamber, newSetMatch, &_cacheLookups);
+		}
+		if(multipleInOneLayer) {
+		/*Temporary, to test if busy window is effecting strange behavior with pattersn 8 and 9
+		 *
+		 */
+		//if(searchForMatch(*testChamber, _oldPatterns,oldSetMatch,true) || searchForMatch(*testChamber, _newPatterns,newSetMatch,true)) {
+			oldSetMatch.clear();
+			newSetMatch.clear();
+			_nChambersMultipleInOneLayer++;
+			continue;
+		}
 
-			if(theseCompHits.fill(comparators)) return -1;
+		//TODO: currently no implementation dealing with cases where we find one and not other
+		if(!oldSetMatch.size() || !newSetMatch.size()) {
+			oldSetMatch.clear();
+			newSetMatch.clear();
+			continue;
+		}
 
-			if (!USE_COMP_HITS && DEBUG > 0) if(theseRHHits.fill(recHits)) return -1;
+		//Now compare with LUT data
 
-			vector<CLCTCandidate*> newSetMatch;
-			vector<CLCTCandidate*> oldSetMatch;
+		/* NEW LUTS
+		 *
+		 */
 
-			ChamberHits* testChamber;
-			testChamber = USE_COMP_HITS ? &theseCompHits : &theseRHHits;
+		{
+			STAGE_TIMER("lut lookup");
+			if(setLUTEntries(newSetMatch, *_newLUTs, _ST, _RI)) return -1;
+		}
 
-			nChambersRanOver++;
 
-			//now run on comparator hits
-			if(DEBUG > 0) printf("~~~~ Matches for Muon: %i,  Segment %i ~~~\n",i,  thisSeg);
-			if(searchForMatch(*testChamber, oldPatterns,oldSetMatch) || searchForMatch(*testChamber, newPatterns,newSetMatch)) {
-			/*Temporary, to test if busy window is effecting strange behavior with pattersn 8 and 9
-			 *
-			 */
-			//if(searchForMatch(*testChamber, oldPatterns,oldSetMatch,true) || searchForMatch(*testChamber, newPatterns,newSetMatch,true)) {
-				oldSetMatch.clear();
-				newSetMatch.clear();
-				nChambersMultipleInOneLayer++;
-				continue;
+		/* TODO: use CLCTCandidate::quality to see what gets you the first candidate as the right segment
+		 * each time a la Nick
+		 */
+
+
+		// fill the numerator if it is within our capture window
+		//float posCaptureWindow = 0.30; //strips
+		//float slopeCaptureWindow = 0.25; //strips/layer
+
+
+		bool foundMatchingCandidate = false;
+		float minX = 1e5;
+		float minX_halfStrip = 1e5;
+		float minX_quarterStrip = 1e5;
+		float minX_eighthStrip = 1e5;
+		float minX_sixteenthStrip = 1e5;
+		float mindXdZ = 1e5;
+		CLCTCandidate* bestCLCT = 0;
+
+		vector<int> closest;
+		auto segmentKey = [&](unsigned int){return MatchKey(_segmentX);};
+		{
+			STAGE_TIMER("matching");
+			//the candidate with the lut position closest to the segment
+			_matcher.match(1, segmentKey, newSetMatch.size(),
+					[&](unsigned int i){return MatchKey(newSetMatch[i]->position());}, closest);
+			if(closest[0] >= 0){
+				bestCLCT = newSetMatch.at(closest[0]);
+				float lutX = bestCLCT->position();
+				float lutdXdZ = bestCLCT->slope();
+
+				minX = _segmentX - lutX;
+				minX_halfStrip = _segmentX-round(2.*lutX)/2.;
+				minX_quarterStrip =  _segmentX- round(4.*lutX)/4.;
+				minX_eighthStrip = _segmentX - round(8.*lutX)/8.;
+				minX_sixteenthStrip = _segmentX - round(16.*lutX)/16.;
+				mindXdZ = _segmentdXdZ - lutdXdZ;
+				foundMatchingCandidate = true;
 			}
-
-			//TODO: currently no implementation dealing with cases where we find one and not other
-			if(!oldSetMatch.size() || !newSetMatch.size()) {
-				oldSetMatch.clear();
-				newSetMatch.clear();
-				continue;
+		}
+		if(foundMatchingCandidate ){
+			STAGE_TIMER("histogram filling");
+			_lutSegmentPosDiff->Fill(minX);
+			_lutSegmentPosDiff_halfStrip->Fill(minX_halfStrip);
+			_lutSegmentPosDiff_quarterStrip->Fill(minX_quarterStrip);
+			_lutSegmentPosDiff_eighthStrip->Fill(minX_eighthStrip);
+			_lutSegmentPosDiff_sixteenthStrip->Fill(minX_sixteenthStrip);
+			_lutSegmentSlopeDiff->Fill(mindXdZ);
+
+			//same clct, with each of the quantized LUTs (shared, so no operator[])
+			auto qluts = _quantizedLUTs->find(make_pair(_ST,_RI));
+			for(unsigned int ib=0; qluts != _quantizedLUTs->end() && ib < qluts->second.size(); ib++){
+				float qPos = 0;
+				float qSlope = 0;
+				if(qluts->second[ib].getEntry(bestCLCT->key(), qPos, qSlope)) continue;
+				float qxDiff = _segmentX - (bestCLCT->keyStrip() + qPos);
+				float qdxdzDiff = _segmentdXdZ - qSlope;
+				_bitBudgetPosDiff[ib]->Fill(qxDiff);
+				_bitBudgetSlopeDiff[ib]->Fill(qdxdzDiff);
+				_bitBudgetN[ib]++;
+				_bitBudgetPosSum[ib] += qxDiff;
+				_bitBudgetPosSum2[ib] += qxDiff*qxDiff;
+				_bitBudgetSlopeSum[ib] += qdxdzDiff;
+				_bitBudgetSlopeSum2[ib] += qdxdzDiff*qdxdzDiff;
 			}
 
-			//Now compare with LUT data
-
-			/* NEW LUTS
-			 *
-			 */
-
-			if(setLUTEntries(newSetMatch, newLUTs, ST, RI)) return -1;
-
-
-			/* TODO: use this sorting thing to see what gets you the first candidate as the right segment
-			 * each time a la Nick
-			 */
-			//sort the matches
-			//sort(newSetMatch.begin(), newSetMatch.end(), CLCTCandidate::quality);
-
-
-
-			// fill the numerator if it is within our capture window
-			//float posCaptureWindow = 0.30; //strips
-			//float slopeCaptureWindow = 0.25; //strips/layer
-
-
-			bool foundMatchingCandidate = false;
-			float minX = 1e5;
-			float minX_halfStrip = 1e5;
-			float minX_quarterStrip = 1e5;
-			float minX_eighthStrip = 1e5;
-			float minX_sixteenthStrip = 1e5;
-			float mindXdZ = 1e5;
-
-			//look through all the candidates, until we find the first match
-			for(auto& clct: newSetMatch){
-				//depending on how many clcts were allowed to look at,
-				// look until we find one
-				//const LUTEntry* iEntry = newSetMatch.at(iclct)->_lutEntry;
-
+			//fill chamber specific stuff
+			auto chamberKey = make_pair(_ST,_RI);
+			_lutChamberPlots_Pos[chamberKey]->Fill(minX);
+			_lutChamberPlots_Slope[chamberKey]->Fill(mindXdZ);
+
+			for(unsigned int ipt = 0; ipt < _ptRanges.size(); ipt++){
+				float lower = (ipt == 0) ? 0 : _ptRanges.at(ipt-1);
+				float upper = _ptRanges.at(ipt);
+				if(_pt >= lower && _pt < upper){
+					_ccPos_pt[upper]->Fill(minX);
+					_ccSlope_pt[upper]->Fill(mindXdZ);
+				}
+			}
 
-				float lutX = clct->position();
-				float lutdXdZ =clct->slope();
 
+		}
 
-				float xDiff = segmentX - lutX;
-				float xDiff_halfStrip = segmentX-round(2.*lutX)/2.;
-				float xDiff_quarterStrip =  segmentX- round(4.*lutX)/4.;
-				float xDiff_eighthStrip = segmentX - round(8.*lutX)/8.;
-				float xDiff_sixteenthStrip = segmentX - round(16.*lutX)/16.;
-				float dxdzDiff = segmentdXdZ - lutdXdZ;
-				//cout << " EC " << EC << "ST: " <<ST << endl;
-				//cout << "xDiff " << xDiff << "nsegs " << newSetMatch.at(iclct)->_lutEntry->nsegments() <<endl;
+		//if(foundMatchingCandidate) foundOneMatchEffNum->Fill(Pt);
 
-				if(abs(xDiff) < abs(minX)){
-					minX = xDiff;
-					minX_halfStrip = xDiff_halfStrip;
-					minX_quarterStrip = xDiff_quarterStrip;
-					minX_eighthStrip = xDiff_eighthStrip;
-					minX_sixteenthStrip = xDiff_sixteenthStrip;
-					mindXdZ = dxdzDiff;
-					foundMatchingCandidate = true;
-				}
+		/*
+		 *  OLD LUTS
+		 */
+		{
+			STAGE_TIMER("lut lookup");
+			if(setLUTEntries(oldSetMatch, *_legacyLUTs, _ST,_RI)) return -1;
+		}
 
+		bool foundMatchingCandidate_legacy = false;
+		float minX_legacy = 1e5;
+		float mindXdZ_legacy = 1e5;
+
+		int bestLegacyPattern = -1;
+		{
+			STAGE_TIMER("matching");
+			_matcher.match(1, segmentKey, oldSetMatch.size(),
+					[&](unsigned int i){return MatchKey(oldSetMatch[i]->position());}, closest);
+			if(closest[0] >= 0){
+				auto& clct = oldSetMatch.at(closest[0]);
+				minX_legacy = _segmentX - clct->position();
+				mindXdZ_legacy = _segmentdXdZ - clct->slope();
+				bestLegacyPattern = clct->_pattern._id;
+				foundMatchingCandidate_legacy = true;
 			}
-			if(foundMatchingCandidate ){
-				lutSegmentPosDiff->Fill(minX);
-				lutSegmentPosDiff_halfStrip->Fill(minX_halfStrip);
-				lutSegmentPosDiff_quarterStrip->Fill(minX_quarterStrip);
-				lutSegmentPosDiff_eighthStrip->Fill(minX_eighthStrip);
-				lutSegmentPosDiff_sixteenthStrip->Fill(minX_sixteenthStrip);
-				lutSegmentSlopeDiff->Fill(mindXdZ);
-
-				//fill chamber specific stuff
-				auto chamberKey = make_pair(ST,RI);
-				lutChamberPlots_Pos[chamberKey]->Fill(minX);
-				lutChamberPlots_Slope[chamberKey]->Fill(mindXdZ);
-
-				for(unsigned int ipt = 0; ipt < ptRanges.size(); ipt++){
-					float lower = (ipt == 0) ? 0 : ptRanges.at(ipt-1);
-					float upper = ptRanges.at(ipt);
-					if(pt >= lower && pt < upper){
-						ccPos_pt[upper]->Fill(minX);
-						ccSlope_pt[upper]->Fill(mindXdZ);
-					}
+		}
+		if(foundMatchingCandidate_legacy){
+			STAGE_TIMER("histogram filling");
+			_legacyLUTSegmentPosDiff->Fill(minX_legacy);
+			_legacyLUTSegmentSlopeDiff->Fill(mindXdZ_legacy);
+
+			auto chamberKey = make_pair(_ST,_RI);
+			_lutChamberPlots_legacy_Pos[chamberKey]->Fill(minX_legacy);
+			_lutChamberPlots_legacy_Slope[chamberKey]->Fill(mindXdZ_legacy);
+
+			_legacyPatterns_pos[bestLegacyPattern]->Fill(minX_legacy);
+			_legacyPatterns_slope[bestLegacyPattern]->Fill(mindXdZ_legacy);
+
+			for(unsigned int ipt = 0; ipt < _ptRanges.size(); ipt++){
+				float lower = (ipt == 0) ? 0 : _ptRanges.at(ipt-1);
+				float upper = _ptRanges.at(ipt);
+				if(_pt >= lower && _pt < upper){
+					_legacyPos_pt[upper]->Fill(minX_legacy);
+					_legacySlope_pt[upper]->Fill(mindXdZ_legacy);
 				}
-
-
 			}
 
-			//if(foundMatchingCandidate) foundOneMatchEffNum->Fill(Pt);
 
+			//compare 21 and 31, one should be flipped, the other not
 			/*
-			 *  OLD LUTS
-			 */
-			if(setLUTEntries(oldSetMatch, legacyLUTs, ST,RI)) return -1;
-
-			bool foundMatchingCandidate_legacy = false;
-			float minX_legacy = 1e5;
-			float mindXdZ_legacy = 1e5;
-
-			int bestLegacyPattern = -1;
-			for(auto& clct: oldSetMatch){
-				float lutX = clct->position();
-				float lutdXdZ = clct->slope();
-
-				float xDiff = segmentX-lutX;
-				float dxdzDiff = segmentdXdZ - lutdXdZ;
-				if(abs(xDiff) < abs(minX_legacy)){
-				//if(abs(xDiff) < abs(minX_legacy) && abs(dxdzDiff) < abs(mindXdZ_legacy)){
-						minX_legacy = xDiff;
-						mindXdZ_legacy = dxdzDiff;
-						bestLegacyPattern = clct->_pattern._id;
-						foundMatchingCandidate_legacy = true;
+			if((_ST == 2 && _RI == 1) || (_ST == 3 && _RI == 1)) {
+				if(abs(minX_legacy) > 0.3){
+					theseCompHits.print();
+					for(auto& clct: oldSetMatch){
+						printPattern(clct->_pattern);
 					}
-			}
-			if(foundMatchingCandidate_legacy){
-				legacyLUTSegmentPosDiff->Fill(minX_legacy);
-				legacyLUTSegmentSlopeDiff->Fill(mindXdZ_legacy);
-
-				auto chamberKey = make_pair(ST,RI);
-				lutChamberPlots_legacy_Pos[chamberKey]->Fill(minX_legacy);
-				lutChamberPlots_legacy_Slope[chamberKey]->Fill(mindXdZ_legacy);
-
-				legacyPatterns_pos[bestLegacyPattern]->Fill(minX_legacy);
-				legacyPatterns_slope[bestLegacyPattern]->Fill(mindXdZ_legacy);
-
-				for(unsigned int ipt = 0; ipt < ptRanges.size(); ipt++){
-					float lower = (ipt == 0) ? 0 : ptRanges.at(ipt-1);
-					float upper = ptRanges.at(ipt);
-					if(pt >= lower && pt < upper){
-						legacyPos_pt[upper]->Fill(minX_legacy);
-						legacySlope_pt[upper]->Fill(mindXdZ_legacy);
+					cout << "--- Segment Position: " << _segmentX << " [strips] Slope: " << _segmentdXdZ << " [strips/layer]---" << endl;
+					cout << "Legacy Match: (";
+					for(auto& clct: oldSetMatch){
+						cout << clct->keyStrip() << ", ";
 					}
-				}
-
-
-				//compare 21 and 31, one should be flipped, the other not
-				/*
-				if((ST == 2 && RI == 1) || (ST == 3 && RI == 1)) {
-					if(abs(minX_legacy) > 0.3){
-						theseCompHits.print();
-						for(auto& clct: oldSetMatch){
-							printPattern(clct->_pattern);
-						}
-						cout << "--- Segment Position: " << segmentX << " [strips] Slope: " << segmentdXdZ << " [strips/layer]---" << endl;
-						cout << "Legacy Match: (";
-						for(auto& clct: oldSetMatch){
-							cout << clct->keyStrip() << ", ";
-						}
-						cout << ") [strips]" << endl;
-						cout << "Legacy Match LUT: (";
-						for(auto& clct: oldSetMatch){
-							cout << "[" << clct->position() << ", " << clct->slope() << "], ";
-						}
-						cout << ") [strips]" << endl;
-
+					cout << ") [strips]" << endl;
+					cout << "Legacy Match LUT: (";
+					for(auto& clct: oldSetMatch){
+						cout << "[" << clct->position() << ", " << clct->slope() << "], ";
 					}
-				}
-				*/
-			}
+					cout << ") [strips]" << endl;
 
-
-			//
-			// Iterate over real clcts
-			//
-			bool foundMatchingCandidate_real = false;
-			float minX_real = 1e5;
-			int bestRealPattern = -1;
-			for(unsigned int iclct=0; iclct < clcts.size(); iclct++){
-				int clctHash = clcts.ch_id->at(iclct);
-				if(clctHash != chamberHash) continue;
-				float clctHSPos = clcts.keyStrip->at(iclct);
-				float clctSPos = clctHSPos/2. + 1; //conver to real strips...
-
-				float xDiff= segmentX - clctSPos;
-				if(abs(xDiff) < abs(minX_real)){
-					minX_real = xDiff;
-					bestRealPattern = clcts.pattern->at(iclct);
-					foundMatchingCandidate_real = true;
 				}
 			}
-			if(foundMatchingCandidate_real){
-				legacyPatterns_pos_real[bestRealPattern]->Fill(minX_real);
-			}
+			*/
+		}
 
 
-			if(DEBUG > 0) cout << "--- Segment Position: " << segmentX << " [strips] ---" << endl;
-			if(DEBUG > 0) cout << "Legacy Match: (";
-			int closestOldMatchIndex = findClosestToSegment(oldSetMatch,segmentX);
-			if(DEBUG > 0) cout << ") [strips]" << endl;
+		//
+		// Iterate over real clcts
+		//
+		bool foundMatchingCandidate_real = false;
+		float minX_real = 1e5;
+		int bestRealPattern = -1;
+		vector<unsigned int> realCLCTs;
+		for(unsigned int iclct=0; iclct < _clcts->size(); iclct++){
+			int clctHash = _clcts->ch_id->at(iclct);
+			if(clctHash == chamberHash) realCLCTs.push_back(iclct);
+		}
+		_matcher.match(1, segmentKey, realCLCTs.size(), [&](unsigned int i){
+			float clctHSPos = _clcts->keyStrip->at(realCLCTs[i]);
+			return MatchKey(clctHSPos/2. + 1); //conver to real strips...
+		}, closest);
+		if(closest[0] >= 0){
+			unsigned int iclct = realCLCTs[closest[0]];
+			minX_real = _segmentX - (_clcts->keyStrip->at(iclct)/2. + 1);
+			bestRealPattern = _clcts->pattern->at(iclct);
+			foundMatchingCandidate_real = true;
+		}
+		if(foundMatchingCandidate_real){
+			_legacyPatterns_pos_real[bestRealPattern]->Fill(minX_real);
+		}
 
 
-			if(DEBUG > 0)cout << "New Match: (";
-			int closestNewMatchIndex = findClosestToSegment(newSetMatch,segmentX);
-			if(DEBUG > 0) cout << ") [strips]" << endl;
+		//closest by key strip, as findClosestToSegment
+		_matcher.match(1, segmentKey, oldSetMatch.size(),
+				[&](unsigned int i){return MatchKey(oldSetMatch[i]->keyStrip());}, closest);
+		int closestOldMatchIndex = max(closest[0], 0);
+		_matcher.match(1, segmentKey, newSetMatch.size(),
+				[&](unsigned int i){return MatchKey(newSetMatch[i]->keyStrip());}, closest);
+		int closestNewMatchIndex = max(closest[0], 0);
 
-			// Fill Tree Data
+		if(DEBUG > 0) cout << "--- Segment Position: " << _segmentX << " [strips] ---" << endl;
+		if(DEBUG > 0) cout << "Legacy Match: " << oldSetMatch.at(closestOldMatchIndex)->keyStrip() << " [strips]" << endl;
+		if(DEBUG > 0) cout << "New Match: " << newSetMatch.at(closestNewMatchIndex)->keyStrip() << " [strips]" << endl;
 
-			patX = newSetMatch.at(closestNewMatchIndex)->keyStrip();
-			ccId = newSetMatch.at(closestNewMatchIndex)->comparatorCodeId();
-			patternId = newSetMatch.at(closestNewMatchIndex)->patternId();
-			legacyLctId = oldSetMatch.at(closestOldMatchIndex)->patternId();
-			legacyLctX = oldSetMatch.at(closestOldMatchIndex)->keyStrip();
+		// Fill Tree Data
 
-			plotTree->Fill();
+		_patX = newSetMatch.at(closestNewMatchIndex)->keyStrip();
+		_ccId = newSetMatch.at(closestNewMatchIndex)->comparatorCodeId();
+		_patternId = newSetMatch.at(closestNewMatchIndex)->patternId();
+		_legacyLctId = oldSetMatch.at(closestOldMatchIndex)->patternId();
+		_legacyLctX = oldSetMatch.at(closestOldMatchIndex)->keyStrip();
 
-			h_clctLayerCount->Fill(newSetMatch.at(closestNewMatchIndex)->layerCount());
+		{
+			STAGE_TIMER("histogram filling");
+			_plotTree->Fill();
+		}
 
-			//CLCTCandidate* bestCLCT = newSetMatch.at(closestNewMatchIndex);
+		_clctLayerCount->Fill(newSetMatch.at(closestNewMatchIndex)->layerCount());
 
+		//CLCTCandidate* bestCLCT = newSetMatch.at(closestNewMatchIndex);
 
 
-			//Clear everything
 
-			oldSetMatch.clear();
-			newSetMatch.clear();
-		}
+		//Clear everything
 
+		oldSetMatch.clear();
+		newSetMatch.clear();
 	}
+	return 0;
+}
 
+/* @brief Adds the histograms, counters and output tree of another worker,
+ * which ran over the entries following this one's
+ */
+int LUTResolutionAnalyzer::mergeWorker(Processor* worker) {
+	LUTResolutionAnalyzer* w = dynamic_cast<LUTResolutionAnalyzer*>(worker);
+	if(!w || w->_hists.size() != _hists.size() || w->_bitBudgets != _bitBudgets) return -1;
+
+	for(unsigned int i=0; i < _hists.size(); i++) _hists[i]->Add(w->_hists[i]);
+
+	for(unsigned int ib=0; ib < _bitBudgets.size(); ib++){
+		_bitBudgetN[ib] += w->_bitBudgetN[ib];
+		_bitBudgetPosSum[ib] += w->_bitBudgetPosSum[ib];
+		_bitBudgetPosSum2[ib] += w->_bitBudgetPosSum2[ib];
+		_bitBudgetSlopeSum[ib] += w->_bitBudgetSlopeSum[ib];
+		_bitBudgetSlopeSum2[ib] += w->_bitBudgetSlopeSum2[ib];
+	}
 
+	_nChambersRanOver += w->_nChambersRanOver;
+	_nChambersMultipleInOneLayer += w->_nChambersMultipleInOneLayer;
+	_cacheLookups.hits += w->_cacheLookups.hits;
+	_cacheLookups.misses += w->_cacheLookups.misses;
 
-	printf("fraction with >1 in layer is %i/%i = %f\n", nChambersMultipleInOneLayer, nChambersRanOver, 1.*nChambersMultipleInOneLayer/nChambersRanOver);
+	TList trees;
+	trees.Add(w->_plotTree);
+	_plotTree->Merge(&trees);
 
+	return 0;
+}
 
-	outF->cd();
-	plotTree->Write();
-	lutSegmentPosDiff->Write();
-	lutSegmentPosDiff_halfStrip->Write();
-	lutSegmentPosDiff_quarterStrip->Write();
-	lutSegmentPosDiff_eighthStrip->Write();
-	lutSegmentPosDiff_sixteenthStrip->Write();
-	lutSegmentSlopeDiff->Write();
-
-	legacyLUTSegmentPosDiff->Write();
-	legacyLUTSegmentSlopeDiff->Write();
-
-	for(auto entry: ccPos_pt) entry.second->Write();
-	for(auto entry: ccSlope_pt) entry.second->Write();
-	for(auto entry: legacyPos_pt) entry.second->Write();
-	for(auto entry: legacySlope_pt) entry.second->Write();
-
-	for(auto entry: lutChamberPlots_Pos) entry.second->Write();
-	for(auto entry: lutChamberPlots_legacy_Pos) entry.second->Write();
-	for(auto entry: lutChamberPlots_Slope) entry.second->Write();
-	for(auto entry: lutChamberPlots_legacy_Slope) entry.second->Write();
-	for(auto entry: legacyPatterns_pos) entry.second->Write();
-	for(auto entry: legacyPatterns_pos_real) entry.second->Write();
-	for(auto entry: legacyPatterns_slope) entry.second->Write();
-	h_clctLayerCount->Write();
-	/*
-	lutSegmentPosDiff->Write();
-	lutSegmentSlopeDiff->Write();
-
-	for(unsigned int isegeff = 0; isegeff < segEffNums.size(); isegeff++){
-		segEffNums.at(isegeff)->Write();
+/* @brief Histograms by booking order, the counters and the output tree. With
+ * --checkpoint, only the entries of the tree filled since the last checkpoint
+ * are written, as one more chunk of checkpointData(), so each entry is written
+ * once however many checkpoints a job makes
+ */
+int LUTResolutionAnalyzer::writeCheckpoint(TDirectory* dir) {
+	for(unsigned int i=0; i < _hists.size(); i++) dir->WriteTObject(_hists[i], ("h" + to_string(i)).c_str());
+
+	const unsigned int nBudgets = _bitBudgets.size();
+	TVectorD counters(5*nBudgets+4);
+	for(unsigned int ib=0; ib < nBudgets; ib++){
+		counters[5*ib] = _bitBudgetN[ib];
+		counters[5*ib+1] = _bitBudgetPosSum[ib];
+		counters[5*ib+2] = _bitBudgetPosSum2[ib];
+		counters[5*ib+3] = _bitBudgetSlopeSum[ib];
+		counters[5*ib+4] = _bitBudgetSlopeSum2[ib];
+	}
+	counters[5*nBudgets] = _nChambersRanOver;
+	counters[5*nBudgets+1] = _nChambersMultipleInOneLayer;
+	counters[5*nBudgets+2] = _cacheLookups.hits;
+	counters[5*nBudgets+3] = _cacheLookups.misses;
+	dir->WriteTObject(&counters, "counters");
+
+	if(checkpointData().empty()) {
+		//the results of a forked worker, made in dir, written with the file
+		dir->cd();
+		TList trees;
+		trees.Add(_plotTree);
+		return TTree::MergeTrees(&trees) ? 0 : -1;
 	}
-	segEffDen->Write();
-
-	//defined as : for every segment, we have at least one clct matched within the range
-	foundOneMatchEffNum->Write();
-	foundOneMatchEffDen->Write();
-*/
-	outF->Close();
 
-	cout << "Wrote to file: " << outputfile << endl;
+	if(writePlotTreeChunk(checkpointData())) return -1;
+	TParameter<Long64_t> chunks("plotTreeChunks", _plotTreeChunks);
+	TParameter<Long64_t> entries("plotTreeEntries", _plotTreeSaved);
+	dir->WriteTObject(&chunks);
+	dir->WriteTObject(&entries);
+	return 0;
+}
 
-//	cout << "Fraction with >1 in layer is " <<  (*nChambersMultipleInOneLayer.Get()) << "/" <<
-//			(*nChambersRanOver.Get()) << " = " << 1.*(*nChambersMultipleInOneLayer.Get())/(*nChambersRanOver.Get()) << endl;
+/* @brief Appends the entries of the output tree not yet in file as chunk<i>,
+ * starting the file over with the first chunk
+ */
+int LUTResolutionAnalyzer::writePlotTreeChunk(const string& file) {
+	const long long nEntries = _plotTree->GetEntries();
+	if(nEntries == _plotTreeSaved) return 0;
+
+	TFile* f = TFile::Open(file.c_str(), _plotTreeChunks ? "UPDATE" : "RECREATE");
+	if(!f || f->IsZombie()) {
+		cout << "Error: can't write plotTree to: " << file << endl;
+		delete f;
+		return -1;
+	}
+	//filled through the branch addresses it shares with _plotTree
+	TTree* chunk = _plotTree->CloneTree(0);
+	chunk->SetDirectory(f);
+	for(long long i = _plotTreeSaved; i < nEntries; i++){
+		_plotTree->GetEntry(i);
+		chunk->Fill();
+	}
+	//the key of a chunk left over by a job killed before its checkpoint was renamed is replaced
+	int result = chunk->Write(("chunk" + to_string(_plotTreeChunks)).c_str(), TObject::kOverwrite) > 0 ? 0 : -1;
+	//deletes chunk
+	f->Close();
+	delete f;
+	if(result) {
+		cout << "Error: can't write plotTree to: " << file << endl;
+		return -1;
+	}
+	_plotTreeChunks++;
+	_plotTreeSaved = nEntries;
+	return 0;
+}
 
+/* @brief Merges the first chunks of file into the output tree, which then
+ * should have entries
+ */
+int LUTResolutionAnalyzer::readPlotTreeChunks(const string& file, long long chunks, long long entries) {
+	if(chunks) {
+		TFile* f = TFile::Open(file.c_str());
+		if(!f || f->IsZombie()) {
+			cout << "Error: can't open the plotTree of the checkpoint: " << file << endl;
+			delete f;
+			return -1;
+		}
+		for(long long i = 0; i < chunks; i++){
+			TTree* chunk = 0;
+			f->GetObject(("chunk" + to_string(i)).c_str(), chunk);
+			if(!chunk) {
+				cout << "Error: " << file << " is missing chunk" << i << " of plotTree" << endl;
+				f->Close();
+				delete f;
+				return -1;
+			}
+			TList trees;
+			trees.Add(chunk);
+			_plotTree->Merge(&trees);
+		}
+		f->Close();
+		delete f;
+	}
+	if(_plotTree->GetEntries() != entries) {
+		cout << "Error: plotTree of the checkpoint has " << _plotTree->GetEntries() << " entries, not " << entries << endl;
+		return -1;
+	}
+	_plotTreeChunks = chunks;
+	_plotTreeSaved = entries;
 	return 0;
+}
+
+/* @brief Adds the checkpoint to what beginWorker booked, which is still empty
+ */
+int LUTResolutionAnalyzer::readCheckpoint(TDirectory* dir) {
+	for(unsigned int i=0; i < _hists.size(); i++){
+		TH1* saved = 0;
+		dir->GetObject(("h" + to_string(i)).c_str(), saved);
+		if(!saved) {
+			cout << "Error: checkpoint is missing histogram " << _hists[i]->GetName() << endl;
+			return -1;
+		}
+		_hists[i]->Add(saved);
+		delete saved;
+	}
+
+	const unsigned int nBudgets = _bitBudgets.size();
+	TVectorD* counters = 0;
+	dir->GetObject("counters", counters);
+	if(!counters || counters->GetNrows() != (int)(5*nBudgets+4)) {
+		cout << "Error: checkpoint is missing the counters, or is of other bit budgets" << endl;
+		delete counters;
+		return -1;
+	}
+	for(unsigned int ib=0; ib < nBudgets; ib++){
+		_bitBudgetN[ib] = (*counters)[5*ib];
+		_bitBudgetPosSum[ib] = (*counters)[5*ib+1];
+		_bitBudgetPosSum2[ib] = (*counters)[5*ib+2];
+		_bitBudgetSlopeSum[ib] = (*counters)[5*ib+3];
+		_bitBudgetSlopeSum2[ib] = (*counters)[5*ib+4];
+	}
+	_nChambersRanOver = (*counters)[5*nBudgets];
+	_nChambersMultipleInOneLayer = (*counters)[5*nBudgets+1];
+	_cacheLookups.hits = (*counters)[5*nBudgets+2];
+	_cacheLookups.misses = (*counters)[5*nBudgets+3];
+	delete counters;
+
+	TParameter<Long64_t>* chunks = 0;
+	TParameter<Long64_t>* entries = 0;
+	dir->GetObject("plotTreeChunks", chunks);
+	dir->GetObject("plotTreeEntries", entries);
+	if(chunks && entries) {
+		int result = checkpointData().empty() ? -1 :
+				readPlotTreeChunks(checkpointData(), chunks->GetVal(), entries->GetVal());
+		delete chunks;
+		delete entries;
+		return result;
+	}
+	delete chunks;
+	delete entries;
 
+	TTree* saved = 0;
+	dir->GetObject("plotTree", saved);
+	if(!saved) {
+		cout << "Error: checkpoint is missing plotTree" << endl;
+		return -1;
+	}
+	TList trees;
+	trees.Add(saved);
+	_plotTree->Merge(&trees);
+	return 0;
 }
 
+int LUTResolutionAnalyzer::writeOutput(const string& outputfile) {
+
+	printf("fraction with >1 in layer is %i/%i = %f\n", _nChambersMultipleInOneLayer, _nChambersRanOver, 1.*_nChambersMultipleInOneLayer/_nChambersRanOver);
+
+	//one bin per bit, at least up to 10
+	unsigned int maxBits = 10;
+	for(auto& budget : _bitBudgets) maxBits = max(maxBits, max(budget.first, budget.second));
+	TH2F* bitBudgetPosRes = new TH2F("h_bitBudgetPosRes", "h_bitBudgetPosRes; Position Bits; Slope Bits",
+			maxBits, 0.5, maxBits+0.5, maxBits, 0.5, maxBits+0.5);
+	TH2F* bitBudgetSlopeRes = new TH2F("h_bitBudgetSlopeRes", "h_bitBudgetSlopeRes; Position Bits; Slope Bits",
+			maxBits, 0.5, maxBits+0.5, maxBits, 0.5, maxBits+0.5);
+
+	cout << "\033[94m=== Resolution vs Bit Budget ===\033[0m" << endl;
+	printf("%8s %8s %8s %10s %14s %10s %14s\n", "posBits", "slpBits", "total", "CLCTs", "posRMS[strips]", "slopeRMS", "[strips/layer]");
+	for(unsigned int ib=0; ib < _bitBudgets.size(); ib++){
+		const unsigned int posBits = _bitBudgets[ib].first;
+		const unsigned int slopeBits = _bitBudgets[ib].second;
+		double n = _bitBudgetN[ib];
+		double posMean = n ? _bitBudgetPosSum[ib]/n : 0;
+		double slopeMean = n ? _bitBudgetSlopeSum[ib]/n : 0;
+		double posRMS = n ? sqrt(max(0., _bitBudgetPosSum2[ib]/n - posMean*posMean)) : 0;
+		double slopeRMS = n ? sqrt(max(0., _bitBudgetSlopeSum2[ib]/n - slopeMean*slopeMean)) : 0;
+		printf("%8u %8u %8u %10.0f %14.4f %10.4f\n", posBits, slopeBits, posBits+slopeBits, n, posRMS, slopeRMS);
+		bitBudgetPosRes->Fill(posBits, slopeBits, posRMS);
+		bitBudgetSlopeRes->Fill(posBits, slopeBits, slopeRMS);
+	}
+
+	TFile * outF = new TFile(outputfile.c_str(),"RECREATE");
+	if(!outF){
+		printf("Failed to open output file: %s\n", outputfile.c_str());
+		return -1;
+	}
 
+	outF->cd();
+	_plotTree->SetDirectory(outF);
+	_plotTree->Write();
+	_lutSegmentPosDiff->Write();
+	_lutSegmentPosDiff_halfStrip->Write();
+	_lutSegmentPosDiff_quarterStrip->Write();
+	_lutSegmentPosDiff_eighthStrip->Write();
+	_lutSegmentPosDiff_sixteenthStrip->Write();
+	_lutSegmentSlopeDiff->Write();
+
+	for(auto h: _bitBudgetPosDiff) h->Write();
+	for(auto h: _bitBudgetSlopeDiff) h->Write();
+	bitBudgetPosRes->Write();
+	bitBudgetSlopeRes->Write();
+
+	_legacyLUTSegmentPosDiff->Write();
+	_legacyLUTSegmentSlopeDiff->Write();
+
+	for(auto entry: _ccPos_pt) entry.second->Write();
+	for(auto entry: _ccSlope_pt) entry.second->Write();
+	for(auto entry: _legacyPos_pt) entry.second->Write();
+	for(auto entry: _legacySlope_pt) entry.second->Write();
+
+	for(auto entry: _lutChamberPlots_Pos) entry.second->Write();
+	for(auto entry: _lutChamberPlots_legacy_Pos) entry.second->Write();
+	for(auto entry: _lutChamberPlots_Slope) entry.second->Write();
+	for(auto entry: _lutChamberPlots_legacy_Slope) entry.second->Write();
+	for(auto entry: _legacyPatterns_pos) entry.second->Write();
+	for(auto entry: _legacyPatterns_pos_real) entry.second->Write();
+	for(auto entry: _legacyPatterns_slope) entry.second->Write();
+	_clctLayerCount->Write();
+
+	//the file owns the tree now
+	outF->Close();
+	_plotTree = 0;
+	delete bitBudgetPosRes;
+	delete bitBudgetSlopeRes;
 
+	cout << "Wrote to file: " << outputfile << endl;
 
+	//every worker is done with it
+	if(_cache){
+		_cache->printSummary(_cacheLookups);
+		if(_cache->close()) return -1;
+	}
 
+	return 0;
 
+}
@@ -0,0 +1,307 @@
+/*
+ * MemoryTracker.cpp
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: agent
+ */
+
+#include "../include/MemoryTracker.h"
+#include "../include/StageTimers.h"
+
+#include <iostream>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <new>
+#include <atomic>
+#include <unistd.h>
+#include <sys/resource.h>
+
+
+/* Counted from inside operator new, so nothing here can use new itself:
+ * the tables are calloc'd and kept in a fixed array, and the thread
+ * locals are plain pointers / ints
+ */
+namespace {
+
+const unsigned int MAX_THREADS = 4096;
+const unsigned int NO_STAGE = MemoryTracker::MAX_STAGES;
+//calls of the "read" stage, i.e. entries, between RSS samples
+const unsigned int RSS_SAMPLE_EVERY = 1000;
+
+struct ThreadMemory {
+	MemoryStats stages[MemoryTracker::MAX_STAGES+1]; //last is outside any stage
+};
+
+/* @brief In front of every block operator new returns, whether or not
+ * tracking is on, so a free is charged to the stage that allocated it.
+ * 16 bytes keeps the block aligned as malloc's
+ */
+struct BlockHeader {
+	int stage; //-1 if allocated while not tracking
+	unsigned int unused;
+	unsigned long long bytes;
+};
+static_assert(sizeof(BlockHeader) == 16, "the header has to keep blocks 16 byte aligned");
+
+ThreadMemory* tables[MAX_THREADS];
+atomic<unsigned int> nTables(0);
+atomic<bool> tracking(false);
+atomic<long long> startRSS(0);
+atomic<long long> peakRSS(0);
+
+thread_local ThreadMemory* threadTable = 0;
+thread_local int currentStage = -1;
+
+ThreadMemory* newTable(){
+	ThreadMemory* table = (ThreadMemory*)calloc(1, sizeof(ThreadMemory));
+	if(!table) return 0;
+	unsigned int i = nTables.fetch_add(1);
+	if(i >= MAX_THREADS) {
+		free(table);
+		return 0;
+	}
+	tables[i] = table;
+	return table;
+}
+
+inline unsigned int innermostStage(){
+	return currentStage >= 0 && currentStage < (int)NO_STAGE ? currentStage : NO_STAGE;
+}
+
+//of stage, in the table of this thread. Tables are summed, so frees of other threads' blocks add up
+inline MemoryStats* stageStats(unsigned int stage){
+	if(!threadTable) threadTable = newTable();
+	if(!threadTable) return 0;
+	return &threadTable->stages[stage];
+}
+
+inline void* allocate(size_t n){
+	BlockHeader* header = (BlockHeader*)malloc(sizeof(BlockHeader) + n);
+	if(!header) return 0;
+	header->stage = -1;
+	header->bytes = n;
+	if(tracking.load(memory_order_relaxed)) {
+		unsigned int stage = innermostStage();
+		MemoryStats* s = stageStats(stage);
+		if(s) {
+			header->stage = stage;
+			s->allocs++;
+			s->bytesAllocated += n;
+		}
+	}
+	return header+1;
+}
+
+inline void deallocate(void* p){
+	if(!p) return;
+	BlockHeader* header = (BlockHeader*)p - 1;
+	if(header->stage >= 0 && tracking.load(memory_order_relaxed)) {
+		MemoryStats* s = stageStats(header->stage);
+		if(s) {
+			s->frees++;
+			s->bytesFreed += header->bytes;
+		}
+	}
+	free(header);
+}
+
+void add(MemoryStats& to, const MemoryStats& from){
+	to.calls += from.calls;
+	to.allocs += from.allocs;
+	to.frees += from.frees;
+	to.bytesAllocated += from.bytesAllocated;
+	to.bytesFreed += from.bytesFreed;
+}
+
+}
+
+void* operator new(size_t n){
+	void* p = allocate(n);
+	if(!p) throw bad_alloc();
+	return p;
+}
+
+void* operator new[](size_t n){
+	return operator new(n);
+}
+
+void* operator new(size_t n, const nothrow_t&) noexcept {
+	return allocate(n);
+}
+
+void* operator new[](size_t n, const nothrow_t& tag) noexcept {
+	return operator new(n, tag);
+}
+
+void operator delete(void* p) noexcept {
+	deallocate(p);
+}
+
+void operator delete[](void* p) noexcept {
+	operator delete(p);
+}
+
+void operator delete(void* p, const nothrow_t&) noexcept {
+	operator delete(p);
+}
+
+void operator delete[](void* p, const nothrow_t&) noexcept {
+	operator delete(p);
+}
+
+
+void MemoryTracker::setEnabled(bool enabled){
+	if(enabled && !startRSS) startRSS = sampleRSS();
+	tracking = enabled;
+}
+
+bool MemoryTracker::enabled(){
+	return tracking.load(memory_order_relaxed);
+}
+
+/* @brief Also samples the RSS every so many entries read, as the event
+ * loop and processors running their own each time a "read" stage
+ */
+int MemoryTracker::enterStage(unsigned int stage){
+	static const unsigned int readStage = StageTimers::stage("read");
+	int previous = currentStage;
+	currentStage = stage;
+	MemoryStats* s = stageStats(innermostStage());
+	if(s) {
+		s->calls++;
+		if(stage == readStage && s->calls % RSS_SAMPLE_EVERY == 1) sampleRSS();
+	}
+	return previous;
+}
+
+void MemoryTracker::leaveStage(int previous){
+	currentStage = previous;
+}
+
+void MemoryTracker::clear(){
+	unsigned int n = nTables;
+	if(n > MAX_THREADS) n = MAX_THREADS;
+	for(unsigned int i = 0; i < n; i++) memset(tables[i], 0, sizeof(ThreadMemory));
+}
+
+long long MemoryTracker::sampleRSS(){
+	long long pages = 0;
+	FILE* f = fopen("/proc/self/statm", "r");
+	if(f) {
+		if(fscanf(f, "%*s %lli", &pages) != 1) pages = 0;
+		fclose(f);
+	}
+	long long rss = pages*sysconf(_SC_PAGESIZE);
+	long long peak = peakRSS;
+	while(rss > peak && !peakRSS.compare_exchange_weak(peak, rss));
+	return rss;
+}
+
+/* @brief Only call once the tracked threads are done
+ */
+void MemoryTracker::summary(vector<string>& names, vector<MemoryStats>& stats){
+	names = StageTimers::names();
+	if(names.size() > MAX_STAGES) names.resize(MAX_STAGES);
+	MemoryStats zero;
+	memset(&zero, 0, sizeof(zero));
+	stats.assign(names.size()+1, zero);
+	unsigned int n = nTables;
+	if(n > MAX_THREADS) n = MAX_THREADS;
+	for(unsigned int i = 0; i < n; i++){
+		for(unsigned int stage = 0; stage < names.size(); stage++) add(stats[stage], tables[i]->stages[stage]);
+		add(stats.back(), tables[i]->stages[NO_STAGE]);
+	}
+	names.push_back("(no stage)");
+}
+
+void MemoryTracker::print(long long entries){
+	if(!enabled()) return;
+	vector<string> names;
+	vector<MemoryStats> stats;
+	summary(names, stats);
+	//processors running their own loop, an entry each time they read one
+	if(entries <= 0){
+		for(unsigned int i = 0; i+1 < names.size(); i++) if(names[i] == "read") entries = stats[i].calls;
+	}
+
+	struct rusage self, children;
+	getrusage(RUSAGE_SELF, &self);
+	getrusage(RUSAGE_CHILDREN, &children);
+	const double MB = 1024.*1024.;
+
+	cout << "\033[94m=== Memory ===\033[0m" << endl;
+	printf("RSS at start %.1f MB, sampled peak %.1f MB, at end %.1f MB, max %.1f MB",
+			startRSS/MB, peakRSS/MB, sampleRSS()/MB, self.ru_maxrss/1024.);
+	if(children.ru_maxrss) printf(" (largest child %.1f MB)", children.ru_maxrss/1024.);
+	printf("\n");
+	printf("%-20s %12s %12s %11s %14s %12s %10s\n", "stage", "calls", "allocs", "allocs/call",
+			"allocated [MB]", "live objects", "live [MB]");
+	vector<string> hot;
+	for(unsigned int i = 0; i < names.size(); i++){
+		const MemoryStats& s = stats[i];
+		if(!s.allocs && !s.frees) continue;
+		bool last = i == names.size()-1;
+		//called for every entry, and allocating every time
+		bool inLoop = !last && entries > 0 && (long long)s.calls >= entries && s.allocs >= s.calls;
+		char perCall[32] = "-";
+		if(s.calls) snprintf(perCall, sizeof(perCall), "%.1f", (double)s.allocs/s.calls);
+		printf("%-20s %12llu %12llu %11s %14.1f %12lli %10.1f%s\n", names[i].c_str(), s.calls, s.allocs, perCall,
+				s.bytesAllocated/MB, (long long)(s.allocs - s.frees), ((double)s.bytesAllocated - s.bytesFreed)/MB,
+				inLoop ? " *" : "");
+		if(inLoop) {
+			char text[128];
+			snprintf(text, sizeof(text), "%s (%.1f per entry)", names[i].c_str(), (double)s.allocs/entries);
+			hot.push_back(text);
+		}
+	}
+	if(hot.size()){
+		cout << "Allocating in the event loop (*):";
+		for(unsigned int i = 0; i < hot.size(); i++) cout << (i ? ", " : " ") << hot[i];
+		cout << endl;
+	}
+}
+
+/* @brief Sends [n] then [name length, name, stats] for each stage, then
+ * the stats outside of any stage
+ */
+int MemoryTracker::send(int fd){
+	if(!enabled()) return 0;
+	vector<string> names;
+	vector<MemoryStats> stats;
+	summary(names, stats);
+
+	unsigned int n = names.size()-1;
+	if(writeFully(fd, &n, sizeof(n))) return -1;
+	for(unsigned int i = 0; i < n; i++){
+		unsigned int length = names[i].size();
+		if(writeFully(fd, &length, sizeof(length)) ||
+				writeFully(fd, names[i].c_str(), length) ||
+				writeFully(fd, &stats[i], sizeof(MemoryStats))) return -1;
+	}
+	return writeFully(fd, &stats.back(), sizeof(MemoryStats));
+}
+
+/* @brief Adds the stages of another process as one more thread
+ */
+int MemoryTracker::receive(int fd){
+	if(!enabled()) return 0;
+	ThreadMemory* table = newTable();
+	if(!table) return -1;
+	unsigned int n = 0;
+	if(readFully(fd, &n, sizeof(n))) return -1;
+	for(unsigned int i = 0; i < n; i++){
+		unsigned int length = 0;
+		MemoryStats s;
+		if(readFully(fd, &length, sizeof(length))) return -1;
+		string name(length, ' ');
+		if(readFully(fd, &name[0], length) ||
+				readFully(fd, &s, sizeof(MemoryStats))) return -1;
+		unsigned int stage = StageTimers::stage(name);
+		add(table->stages[stage < NO_STAGE ? stage : NO_STAGE], s);
+	}
+	MemoryStats s;
+	if(readFully(fd, &s, sizeof(MemoryStats))) return -1;
+	add(table->stages[NO_STAGE], s);
+	return 0;
+}
@@ -0,0 +1,237 @@
+/*
+ * MismatchLog.cpp
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: agent
+ */
+
+#include "../include/MismatchLog.h"
+
+#include <string.h>
+#include <iostream>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+namespace {
+
+const char LOG_MAGIC[8] = {'C','S','C','M','I','S','1','\0'};
+const uint32_t LOG_VERSION = 1;
+
+struct LogHeader {
+	char magic[8];
+	uint32_t version;
+	uint32_t reserved;
+};
+
+struct MismatchRecord {
+	int64_t entry;
+	uint64_t run;
+	uint64_t event;
+	uint16_t chamberHash;
+	int8_t closest;
+	uint8_t nEmulated;
+	uint16_t nHits;
+	uint16_t reserved;
+	uint32_t reserved2;
+};
+
+void append(vector<char>& buffer, const void* data, size_t size){
+	const char* bytes = (const char*)data;
+	buffer.insert(buffer.end(), bytes, bytes+size);
+}
+
+void appendCandidate(vector<char>& buffer, const EmulatedCandidate& c){
+	int32_t values[5] = {c.key, c.pattern, c.code, c.layers, c.bx};
+	append(buffer, values, sizeof(values));
+}
+
+int readCandidate(FILE* in, EmulatedCandidate& c){
+	int32_t values[5];
+	if(fread(values, sizeof(values), 1, in) != 1) return -1;
+	c = EmulatedCandidate(values[0], values[1], values[2], values[3], values[4]);
+	return 0;
+}
+
+}
+
+void Mismatch::setHits(const ChamberHits& c){
+	hits.clear();
+	for(unsigned int x = 0; x < N_MAX_HALF_STRIPS; x++){
+		for(unsigned int y = 0; y < NLAYERS; y++){
+			if(!c._hits[x][y]) continue;
+			hits.push_back(x);
+			hits.push_back(y);
+			hits.push_back(c._hits[x][y]);
+		}
+	}
+}
+
+void Mismatch::getHits(ChamberHits& c) const {
+	for(unsigned int i = 0; i+2 < hits.size(); i += 3){
+		if(hits[i] < N_MAX_HALF_STRIPS && hits[i+1] < NLAYERS) c._hits[hits[i]][hits[i+1]] = hits[i+2];
+	}
+}
+
+/***************************
+ * WRITER
+ ***************************/
+
+struct MismatchLogWriter::Background {
+	Background(FILE* out_) : out(out_), closing(false), failed(false) {}
+
+	//writes each buffer handed to it, until closed
+	void loop(){
+		unique_lock<mutex> lock(m);
+		while(true){
+			condition.wait(lock, [this]{return !pending.empty() || closing;});
+			if(pending.empty()) return;
+			lock.unlock();
+			bool ok = fwrite(&pending[0], pending.size(), 1, out) == 1;
+			lock.lock();
+			if(!ok) failed = true;
+			pending.clear();
+			condition.notify_all();
+		}
+	}
+
+	//swaps in a full buffer once the last one is written
+	void hand(vector<char>& buffer){
+		unique_lock<mutex> lock(m);
+		condition.wait(lock, [this]{return pending.empty();});
+		pending.swap(buffer);
+		condition.notify_all();
+	}
+
+	FILE* out;
+	vector<char> pending;
+	mutex m;
+	condition_variable condition;
+	thread writer;
+	bool closing;
+	bool failed;
+};
+
+MismatchLogWriter::MismatchLogWriter(unsigned int bufferSize) :
+	_bufferSize(bufferSize),
+	_written(0),
+	_background(0)
+{}
+
+MismatchLogWriter::~MismatchLogWriter(){
+	close();
+}
+
+int MismatchLogWriter::open(const string& file){
+	close();
+	FILE* out = fopen(file.c_str(), "wb");
+	if(!out){
+		cout << "Error: can't open mismatch log: " << file << endl;
+		return -1;
+	}
+	LogHeader header;
+	memset(&header, 0, sizeof(header));
+	memcpy(header.magic, LOG_MAGIC, sizeof(LOG_MAGIC));
+	header.version = LOG_VERSION;
+	if(fwrite(&header, sizeof(header), 1, out) != 1){
+		cout << "Error: can't write to mismatch log: " << file << endl;
+		fclose(out);
+		return -1;
+	}
+	_written = 0;
+	_buffer.clear();
+	_buffer.reserve(_bufferSize);
+	_background = new Background(out);
+	_background->writer = thread(&Background::loop, _background);
+	return 0;
+}
+
+int MismatchLogWriter::write(const Mismatch& m){
+	if(!_background) return -1;
+	MismatchRecord record;
+	memset(&record, 0, sizeof(record));
+	record.entry = m.entry;
+	record.run = m.run;
+	record.event = m.event;
+	record.chamberHash = m.chamberHash;
+	record.closest = m.closest;
+	record.nEmulated = m.emulated.size() < 255 ? m.emulated.size() : 255;
+	record.nHits = m.hits.size()/3;
+
+	append(_buffer, &record, sizeof(record));
+	appendCandidate(_buffer, m.recorded);
+	for(unsigned int i = 0; i < record.nEmulated; i++) appendCandidate(_buffer, m.emulated[i]);
+	if(record.nHits) append(_buffer, &m.hits[0], 3*record.nHits);
+	_written++;
+
+	if(_buffer.size() >= _bufferSize) _background->hand(_buffer);
+	return 0;
+}
+
+int MismatchLogWriter::close(){
+	if(!_background) return 0;
+	if(_buffer.size()) _background->hand(_buffer);
+	{
+		lock_guard<mutex> lock(_background->m);
+		_background->closing = true;
+		_background->condition.notify_all();
+	}
+	_background->writer.join();
+	bool failed = _background->failed;
+	if(fclose(_background->out)) failed = true;
+	delete _background;
+	_background = 0;
+	if(failed) {
+		cout << "Error: can't write to mismatch log" << endl;
+		return -1;
+	}
+	return 0;
+}
+
+/***************************
+ * READER
+ ***************************/
+
+int MismatchLogReader::open(const string& file){
+	close();
+	_in = fopen(file.c_str(), "rb");
+	if(!_in){
+		cout << "Error: can't open mismatch log: " << file << endl;
+		return -1;
+	}
+	LogHeader header;
+	if(fread(&header, sizeof(header), 1, _in) != 1 ||
+			memcmp(header.magic, LOG_MAGIC, sizeof(LOG_MAGIC)) ||
+			header.version != LOG_VERSION){
+		cout << "Error: not a mismatch log: " << file << endl;
+		close();
+		return -1;
+	}
+	return 0;
+}
+
+int MismatchLogReader::next(Mismatch& m){
+	if(!_in) return -1;
+	MismatchRecord record;
+	size_t size = fread(&record, 1, sizeof(record), _in);
+	if(!size && feof(_in)) return 1;
+	if(size != sizeof(record)) return -1;
+	m.entry = record.entry;
+	m.run = record.run;
+	m.event = record.event;
+	m.chamberHash = record.chamberHash;
+	m.closest = record.closest;
+	if(readCandidate(_in, m.recorded)) return -1;
+	m.emulated.resize(record.nEmulated);
+	for(unsigned int i = 0; i < record.nEmulated; i++){
+		if(readCandidate(_in, m.emulated[i])) return -1;
+	}
+	m.hits.resize(3*record.nHits);
+	if(record.nHits && fread(&m.hits[0], m.hits.size(), 1, _in) != 1) return -1;
+	return 0;
+}
+
+void MismatchLogReader::close(){
+	if(_in) fclose(_in);
+	_in = 0;
+}
@@ -0,0 +1,120 @@
+/*
+ * MismatchPrinter.cpp
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: agent
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <iostream>
+#include <vector>
+#include <string>
+
+using namespace std;
+
+#include "../include/CSCConstants.h"
+#include "../include/CSCClasses.h"
+#include "../include/CSCHelperFunctions.h"
+#include "../include/CSCHelper.h"
+#include "../include/MismatchLog.h"
+
+
+namespace {
+
+void usage(){
+	cout << "Usage: ./MismatchPrinter mismatches.bin [first] [last] [options]" << endl;
+	cout << "  prints mismatches [first, last) of a TMBEmulationTester log, all of them without first" << endl;
+	cout << "  --event N         only those of event number N" << endl;
+	cout << "  --chamber N       only those of chamber hash N" << endl;
+	cout << "  --summary         only count them, by chamber" << endl;
+}
+
+/* @brief As TMBEmulationTester printed them
+ */
+void print(long long index, const Mismatch& m, const vector<CSCPattern>& patterns){
+	CSCHelper::ChamberId id = CSCHelper::unserialize(m.chamberHash);
+	printf("\n\033[94m=== Mismatch %lli: ME%c%u/%u/%u, entry %lli, run %llu, event %llu ===\033[0m\n", index,
+			id.endcap == 1 ? '+' : '-', id.station, id.ring, id.chamber, m.entry, m.run, m.event);
+	cout << "~~~ No Perfect Match Found ~~~ " << endl;
+	ChamberHits c(id.station, id.ring, id.endcap, id.chamber);
+	m.getHits(c);
+	c.print();
+	cout << "Real CLCT: pat: " << m.recorded.pattern << " layers: "<< m.recorded.layers << " pos: "<< m.recorded.key <<" [hs]"<< endl;
+	if(m.closest >= 0 && m.closest < (int)m.emulated.size()) {
+		const EmulatedCandidate& emu = m.emulated[m.closest];
+		cout << "Emulated: pat: " << emu.pattern << " layers: " << emu.layers <<
+				" pos: " << emu.key << " [hs]" << endl;
+		for(auto& p : patterns){
+			if(p._id == (unsigned int)emu.pattern) printPattern(p);
+		}
+	}else{
+		cout << "No matching emu" << endl;
+	}
+	cout << "Using emulated CLCT: " << m.closest+1 << " / " << m.emulated.size() << endl;
+}
+
+}
+
+/* @brief Pretty prints chosen entries of the binary mismatch log
+ * TMBEmulationTester writes next to its output
+ */
+int main(int argc, char* argv[]){
+	vector<string> args;
+	long long event = -1;
+	long long chamber = -1;
+	bool summary = false;
+	for(int i = 1; i < argc; i++){
+		string arg = argv[i];
+		bool hasValue = i+1 < argc;
+		if(arg == "--event" && hasValue) event = atoll(argv[++i]);
+		else if(arg == "--chamber" && hasValue) chamber = atoll(argv[++i]);
+		else if(arg == "--summary") summary = true;
+		else if(arg[0] == '-') {
+			usage();
+			return -1;
+		}
+		else args.push_back(arg);
+	}
+	if(args.empty() || args.size() > 3){
+		usage();
+		return -1;
+	}
+	const long long first = args.size() > 1 ? atoll(args[1].c_str()) : 0;
+	const long long last = args.size() > 2 ? atoll(args[2].c_str()) : (args.size() > 1 ? first+1 : -1);
+
+	MismatchLogReader log;
+	if(log.open(args[0])) return -1;
+
+	vector<CSCPattern>* patterns = createOldPatterns();
+	vector<unsigned long long> perChamber(CSCHelper::MAX_CHAMBER_HASH, 0);
+
+	Mismatch m;
+	long long index = 0;
+	long long shown = 0;
+	int status = 0;
+	for(; !(status = log.next(m)); index++){
+		if(index < first || (last >= 0 && index >= last)) continue;
+		if(event >= 0 && m.event != (unsigned long long)event) continue;
+		if(chamber >= 0 && m.chamberHash != chamber) continue;
+		shown++;
+		if(m.chamberHash < perChamber.size()) perChamber[m.chamberHash]++;
+		if(!summary) print(index, m, *patterns);
+	}
+	delete patterns;
+	if(status < 0){
+		cout << "Error: mismatch log is cut short after " << index << " mismatches: " << args[0] << endl;
+		return -1;
+	}
+
+	if(summary){
+		cout << "\033[94m=== Mismatches by Chamber ===\033[0m" << endl;
+		for(unsigned int hash = 0; hash < perChamber.size(); hash++){
+			if(!perChamber[hash]) continue;
+			CSCHelper::ChamberId id = CSCHelper::unserialize(hash);
+			printf("ME%c%u/%u/%-3u (%3u) %10llu\n", id.endcap == 1 ? '+' : '-', id.station, id.ring, id.chamber, hash, perChamber[hash]);
+		}
+	}
+	printf("\n%lli / %lli mismatches shown from: %s\n", shown, index, args[0].c_str());
+	return 0;
+}
@@ -114,7 +114,8 @@ int OTMBFirmwareTester::run(string inputfile, string outputfile, int start, int
 
 
 	//load demo lookup table
-	LUT lut("linearFits","dat/linearFits.lut");
+	LUT lut("linearFits");
+	if(lut.loadLinearFits()) return -1;
 	lut.makeFinal();
 	lut.writeToPSLs("linearFit");
 
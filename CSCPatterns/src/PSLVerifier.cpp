@@ -0,0 +1,39 @@
+/*
+ * PSLVerifier.cpp
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: agent
+ */
+
+#include "../include/CSCHelperFunctions.h"
+#include <iostream>
+
+using namespace std;
+
+/* @brief Compares two sets of pattern specific LUTs word by word,
+ * either for a single chamber (file prefixes), or for every chamber
+ * type (directories, with -a)
+ */
+int main(int argc, char* argv[])
+{
+	int differences = 0;
+	switch(argc){
+	case 3:
+		differences = LUT::comparePSLs(argv[1], argv[2]);
+		break;
+	case 4:
+		if(string(argv[1]) == "-a"){
+			differences = DetectorLUTs::compareAllPSLs(argv[2], argv[3]);
+			if(differences >= 0) cout << "Total: " << differences << " words differ" << endl;
+			break;
+		}
+		//fall through
+	default:
+		cout << "Gave "<< argc-1 << " arguments, usage is:" << endl;
+		cout << "./PSLVerifier prefix1 prefix2" << endl;
+		cout << "./PSLVerifier -a path1/ path2/" << endl;
+		return -1;
+	}
+	if(differences < 0) return -1;
+	return differences ? 1 : 0;
+}
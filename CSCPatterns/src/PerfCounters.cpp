@@ -0,0 +1,287 @@
+/*
+ * PerfCounters.cpp
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: agent
+ */
+
+#include "../include/PerfCounters.h"
+#include "../include/StageTimers.h"
+
+#include <iostream>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <mutex>
+#include <atomic>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+
+
+namespace {
+
+const unsigned int N_EVENTS = PerfSample::N_EVENTS;
+
+const struct {
+	unsigned int type;
+	unsigned long long config;
+} EVENTS[N_EVENTS] = {
+		{PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES},
+		{PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS},
+		{PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_REFERENCES},
+		{PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES},
+		{PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_INSTRUCTIONS},
+		{PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES}
+};
+
+struct StageTotals {
+	StageTotals() : calls(0), counted(0), ns(0) {
+		for(unsigned int i = 0; i < N_EVENTS; i++) values[i] = 0;
+	}
+	unsigned long long calls;
+	unsigned long long counted; //calls with the counters open
+	unsigned long long ns;
+	double values[N_EVENTS]; //scaled for multiplexing
+
+	void add(const StageTotals& t){
+		calls += t.calls;
+		counted += t.counted;
+		ns += t.ns;
+		for(unsigned int i = 0; i < N_EVENTS; i++) values[i] += t.values[i];
+	}
+};
+
+struct ThreadCounters {
+	ThreadCounters() : tried(false), leader(-1), nOpen(0) {
+		for(unsigned int i = 0; i < N_EVENTS; i++) {
+			fds[i] = -1;
+			index[i] = -1;
+		}
+	}
+	bool tried;
+	int leader;
+	int fds[N_EVENTS];
+	int index[N_EVENTS]; //position in the group read, -1 if it couldn't be opened
+	unsigned int nOpen;
+	vector<StageTotals> stages;
+};
+
+mutex& registryMutex(){
+	static mutex m;
+	return m;
+}
+
+vector<ThreadCounters*>& threadTables(){
+	static vector<ThreadCounters*> tables;
+	return tables;
+}
+
+atomic<bool> counting(false);
+atomic<bool> warned(false);
+atomic<unsigned int> openEvents(0); //bit per event opened in any thread
+
+ThreadCounters* newTable(){
+	lock_guard<mutex> lock(registryMutex());
+	threadTables().push_back(new ThreadCounters());
+	return threadTables().back();
+}
+
+ThreadCounters* threadCounters(){
+	static thread_local ThreadCounters* counters = newTable();
+	return counters;
+}
+
+long perfEventOpen(perf_event_attr* attr, int groupFd){
+	return syscall(__NR_perf_event_open, attr, 0, -1, groupFd, 0);
+}
+
+/* @brief Opens the group on the calling thread, cycles leading. Members
+ * that aren't supported are left out, without the leader nothing is counted
+ */
+void openGroup(ThreadCounters* c){
+	c->tried = true;
+	for(unsigned int i = 0; i < N_EVENTS; i++){
+		perf_event_attr attr;
+		memset(&attr, 0, sizeof(attr));
+		attr.size = sizeof(attr);
+		attr.type = EVENTS[i].type;
+		attr.config = EVENTS[i].config;
+		attr.disabled = i == 0;
+		attr.exclude_kernel = 1;
+		attr.exclude_hv = 1;
+		attr.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+		int fd = perfEventOpen(&attr, i == 0 ? -1 : c->leader);
+		if(fd < 0){
+			if(i) continue;
+			if(!warned.exchange(true)){
+				printf("Warning: can't open hardware counters (%s), only timing the stages. "
+						"See /proc/sys/kernel/perf_event_paranoid\n", strerror(errno));
+			}
+			return;
+		}
+		if(i == 0) c->leader = fd;
+		c->fds[i] = fd;
+		c->index[i] = c->nOpen++;
+		openEvents |= 1u << i;
+	}
+	ioctl(c->leader, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+	ioctl(c->leader, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+}
+
+bool readGroup(const ThreadCounters* c, PerfSample& s){
+	if(c->leader < 0) return false;
+	unsigned long long buffer[3+N_EVENTS]; //nr, time enabled, time running, values
+	if(read(c->leader, buffer, sizeof(buffer)) < (ssize_t)(3+c->nOpen)*8) return false;
+	s.enabled = buffer[1];
+	s.running = buffer[2];
+	for(unsigned int i = 0; i < N_EVENTS; i++) s.values[i] = c->index[i] < 0 ? 0 : buffer[3+c->index[i]];
+	return true;
+}
+
+void closeGroup(ThreadCounters* c){
+	for(unsigned int i = 0; i < N_EVENTS; i++){
+		if(c->fds[i] >= 0) close(c->fds[i]);
+		c->fds[i] = -1;
+		c->index[i] = -1;
+	}
+	c->leader = -1;
+	c->nOpen = 0;
+	c->tried = false;
+}
+
+/* @brief Per stage, merged over threads
+ */
+void summary(vector<string>& names, vector<StageTotals>& totals){
+	names = StageTimers::names();
+	totals.assign(names.size(), StageTotals());
+	lock_guard<mutex> lock(registryMutex());
+	for(auto table : threadTables()){
+		for(unsigned int i = 0; i < table->stages.size() && i < totals.size(); i++) totals[i].add(table->stages[i]);
+	}
+}
+
+}
+
+void PerfCounters::setEnabled(bool enabled){
+	counting = enabled;
+}
+
+bool PerfCounters::enabled(){
+	return counting.load(memory_order_relaxed);
+}
+
+void PerfCounters::begin(PerfSample& sample){
+	ThreadCounters* c = threadCounters();
+	if(!c->tried) openGroup(c);
+	if(!readGroup(c, sample)) sample.running = 0;
+	//last, so opening and reading the counters isn't timed
+	sample.time = chrono::steady_clock::now();
+}
+
+void PerfCounters::end(unsigned int stage, const PerfSample& begin){
+	auto time = chrono::steady_clock::now();
+	ThreadCounters* c = threadCounters();
+	PerfSample sample;
+	bool counted = begin.running && readGroup(c, sample);
+
+	if(stage >= c->stages.size()) c->stages.resize(stage+1);
+	StageTotals& t = c->stages[stage];
+	t.calls++;
+	t.ns += chrono::duration_cast<chrono::nanoseconds>(time - begin.time).count();
+	if(!counted) return;
+	//scale up if the group was only on the cpu part of the time
+	unsigned long long enabled = sample.enabled - begin.enabled;
+	unsigned long long running = sample.running - begin.running;
+	double scale = running && running < enabled ? (double)enabled/running : 1.;
+	t.counted++;
+	for(unsigned int i = 0; i < N_EVENTS; i++) t.values[i] += scale*(sample.values[i] - begin.values[i]);
+}
+
+void PerfCounters::clear(){
+	closeGroup(threadCounters());
+	lock_guard<mutex> lock(registryMutex());
+	for(auto table : threadTables()) table->stages.clear();
+}
+
+/* @brief Per call of each stage, i.e. per chamber for those that run on one
+ */
+void PerfCounters::print(){
+	if(!enabled()) return;
+	vector<string> names;
+	vector<StageTotals> totals;
+	summary(names, totals);
+
+	bool any = false;
+	for(auto& t : totals) if(t.calls) any = true;
+	if(!any) return;
+
+	const unsigned int events = openEvents;
+	auto has = [events](Event e){ return (events >> e) & 1; };
+	char columns[6][32];
+
+	cout << "\033[94m=== Performance Counters ===\033[0m" << endl;
+	if(!events) cout << "Hardware counters unavailable, timing only" << endl;
+	printf("%-20s %12s %14s %14s %14s %6s %14s %15s\n", "stage", "calls", "time/call [us]",
+			"cycles/call", "instr/call", "IPC", "cache miss [%]", "branch miss [%]");
+	for(unsigned int i = 0; i < names.size(); i++){
+		const StageTotals& t = totals[i];
+		if(!t.calls) continue;
+		for(auto& column : columns) strcpy(column, "-");
+		if(t.counted){
+			const double* v = t.values;
+			if(has(CYCLES)) snprintf(columns[0], 32, "%.0f", v[CYCLES]/t.counted);
+			if(has(INSTRUCTIONS)) snprintf(columns[1], 32, "%.0f", v[INSTRUCTIONS]/t.counted);
+			if(has(CYCLES) && has(INSTRUCTIONS) && v[CYCLES] > 0) snprintf(columns[2], 32, "%.2f", v[INSTRUCTIONS]/v[CYCLES]);
+			if(has(CACHE_REFERENCES) && has(CACHE_MISSES) && v[CACHE_REFERENCES] > 0)
+				snprintf(columns[3], 32, "%.1f", 100.*v[CACHE_MISSES]/v[CACHE_REFERENCES]);
+			if(has(BRANCHES) && has(BRANCH_MISSES) && v[BRANCHES] > 0)
+				snprintf(columns[4], 32, "%.2f", 100.*v[BRANCH_MISSES]/v[BRANCHES]);
+		}
+		printf("%-20s %12llu %14.2f %14s %14s %6s %14s %15s\n", names[i].c_str(), t.calls, 1e-3*t.ns/t.calls,
+				columns[0], columns[1], columns[2], columns[3], columns[4]);
+	}
+}
+
+/* @brief Sends the events that could be opened, [n] then
+ * [name length, name, totals] for each stage
+ */
+int PerfCounters::send(int fd){
+	if(!enabled()) return 0;
+	vector<string> names;
+	vector<StageTotals> totals;
+	summary(names, totals);
+
+	unsigned int events = openEvents;
+	unsigned int n = names.size();
+	if(writeFully(fd, &events, sizeof(events)) || writeFully(fd, &n, sizeof(n))) return -1;
+	for(unsigned int i = 0; i < n; i++){
+		unsigned int length = names[i].size();
+		if(writeFully(fd, &length, sizeof(length)) ||
+				writeFully(fd, names[i].c_str(), length) ||
+				writeFully(fd, &totals[i], sizeof(StageTotals))) return -1;
+	}
+	return 0;
+}
+
+int PerfCounters::receive(int fd){
+	if(!enabled()) return 0;
+	unsigned int events = 0;
+	unsigned int n = 0;
+	if(readFully(fd, &events, sizeof(events)) || readFully(fd, &n, sizeof(n))) return -1;
+	openEvents |= events;
+	ThreadCounters* table = newTable();
+	for(unsigned int i = 0; i < n; i++){
+		unsigned int length = 0;
+		StageTotals t;
+		if(readFully(fd, &length, sizeof(length))) return -1;
+		string name(length, ' ');
+		if(readFully(fd, &name[0], length) ||
+				readFully(fd, &t, sizeof(StageTotals))) return -1;
+		unsigned int stage = StageTimers::stage(name);
+		if(stage >= table->stages.size()) table->stages.resize(stage+1);
+		table->stages[stage].add(t);
+	}
+	return 0;
+}
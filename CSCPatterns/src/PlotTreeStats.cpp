@@ -0,0 +1,219 @@
+/*
+ * PlotTreeStats.cpp
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: agent
+ */
+
+#include "../include/PlotTreeStats.h"
+
+#include <iostream>
+#include <math.h>
+#include <algorithm>
+
+#include <TTree.h>
+#include <TH1D.h>
+
+using namespace std;
+
+//
+// HistogramBlock
+//
+
+HistogramBlock::HistogramBlock(unsigned int bins_, double low_, double high_) :
+	bins(bins_), low(low_), high(high_) {
+}
+
+void HistogramBlock::resize(unsigned int keys){
+	if(!bins) return;
+	counts.resize((unsigned long)keys*(bins+2), 0.);
+	entries.resize(keys, 0.);
+	stats.resize(4*(unsigned long)keys, 0.);
+}
+
+/* @brief Same bin as TAxis::FindBin, statistics only in range
+ */
+void HistogramBlock::fill(unsigned int key, double x){
+	unsigned int bin = 0; //underflow
+	if(!(x < high)) bin = bins+1; //overflow, nan too as in root
+	else if(x >= low) bin = 1 + (unsigned int)(bins*(x-low)/(high-low));
+	counts[(unsigned long)key*(bins+2)+bin]++;
+	entries[key]++;
+	if(bin && bin <= bins){
+		double* s = &stats[4*(unsigned long)key];
+		s[0] += 1;
+		s[1] += 1;
+		s[2] += x;
+		s[3] += x*x;
+	}
+}
+
+TH1D* HistogramBlock::makeHist(unsigned int key, const string& name, const string& title) const {
+	if(key >= keys()) return 0;
+	TH1D* h = new TH1D(name.c_str(), title.c_str(), bins, low, high);
+	for(unsigned int bin = 0; bin < bins+2; bin++) h->SetBinContent(bin, counts[(unsigned long)key*(bins+2)+bin]);
+	double s[4];
+	copy(stats.begin()+4*key, stats.begin()+4*key+4, s);
+	h->PutStats(s);
+	h->SetEntries(entries[key]);
+	return h;
+}
+
+//
+// KeyStats
+//
+
+KeyStats::KeyStats(unsigned int bins, double low, double high) :
+	position(bins, low, high),
+	slope(bins, low, high),
+	unshiftedPosition(bins, low, high),
+	unshiftedSlope(bins, low, high) {
+}
+
+int KeyStats::index(int pattern_, int code_) const {
+	auto it = _index.find(make_pair(pattern_, code_));
+	return it == _index.end() ? -1 : (int)it->second;
+}
+
+void KeyStats::clear(){
+	*this = KeyStats(position.bins, position.low, position.high);
+}
+
+unsigned int KeyStats::add(int pattern_, int code_){
+	auto it = _index.insert(make_pair(make_pair(pattern_, code_), (unsigned int)pattern.size()));
+	if(it.second){
+		pattern.push_back(pattern_);
+		code.push_back(code_);
+		n.push_back(0.);
+		positionMean.push_back(0.);
+		slopeMean.push_back(0.);
+		_positionSum2.push_back(0.);
+		_slopeSum2.push_back(0.);
+	}
+	return it.first->second;
+}
+
+//the means are sums until finish()
+void KeyStats::addSegment(unsigned int key, double position_, double slope_){
+	n[key]++;
+	positionMean[key] += position_;
+	_positionSum2[key] += position_*position_;
+	slopeMean[key] += slope_;
+	_slopeSum2[key] += slope_*slope_;
+}
+
+/* @brief Population RMS, sqrt(<x^2> - <x>^2), as getStats in createLUT.py
+ */
+void KeyStats::finish(){
+	positionRMS.resize(size());
+	slopeRMS.resize(size());
+	for(unsigned int i = 0; i < size(); i++){
+		positionMean[i] /= n[i];
+		slopeMean[i] /= n[i];
+		positionRMS[i] = sqrt(max(0., _positionSum2[i]/n[i] - positionMean[i]*positionMean[i]));
+		slopeRMS[i] = sqrt(max(0., _slopeSum2[i]/n[i] - slopeMean[i]*slopeMean[i]));
+	}
+	position.resize(size());
+	slope.resize(size());
+	unshiftedPosition.resize(size());
+	unshiftedSlope.resize(size());
+}
+
+void KeyStats::fillHists(unsigned int key, double position_, double slope_){
+	position.fill(key, position_ - positionMean[key]);
+	slope.fill(key, slope_ - slopeMean[key]);
+	unshiftedPosition.fill(key, position_);
+	unshiftedSlope.fill(key, slope_);
+}
+
+//
+// PlotTreeStats
+//
+
+PlotTreeStats::PlotTreeStats(unsigned int bins, double low, double high) :
+	cc(bins, low, high),
+	patterns(bins, low, high),
+	legacy(bins, low, high),
+	growthStep(10000),
+	entries(0),
+	segments(0) {
+}
+
+int PlotTreeStats::fill(TTree* tree, int station, int ring, bool matchedOnly){
+	cc.clear();
+	patterns.clear();
+	legacy.clear();
+	growthSegments.clear();
+	growthCodes.clear();
+	entries = 0;
+	segments = 0;
+	if(!tree) return -1;
+
+	int ST = 0;
+	int RI = 0;
+	int patternId = 0;
+	int ccId = 0;
+	int legacyLctId = 0;
+	float segmentX = 0;
+	float segmentdXdZ = 0;
+	float patX = 0;
+	float legacyLctX = 0;
+	const vector<pair<const char*, void*> > branches = {
+			{"ST", &ST}, {"RI", &RI}, {"patternId", &patternId}, {"ccId", &ccId}, {"legacyLctId", &legacyLctId},
+			{"segmentX", &segmentX}, {"segmentdXdZ", &segmentdXdZ}, {"patX", &patX}, {"legacyLctX", &legacyLctX}};
+	for(auto& b : branches){
+		if(!tree->GetBranch(b.first)){
+			cout << "Error: tree " << tree->GetName() << " has no branch " << b.first << endl;
+			return -1;
+		}
+	}
+	tree->SetBranchStatus("*", 0);
+	for(auto& b : branches){
+		tree->SetBranchStatus(b.first, 1);
+		tree->SetBranchAddress(b.first, b.second);
+	}
+
+	//the segments used, to fill the histograms once the means are known
+	const bool fillHists = cc.position.bins;
+	vector<unsigned int> keys; //cc, pattern, legacy of each
+	vector<double> values; //segment - pattern, segment - legacy pattern, slope of each
+
+	entries = tree->GetEntries();
+	for(unsigned long long i = 0; i < entries; i++){
+		tree->GetEntry(i);
+		if(matchedOnly && ccId == -1) continue;
+		if((ST != station && station) || (RI != ring && ring)) continue;
+		segments++;
+
+		unsigned int ccKey = cc.add(patternId, ccId);
+		unsigned int patternKey = patterns.add(patternId, -1);
+		unsigned int legacyKey = legacy.add(legacyLctId, -1);
+		if(!(segments % growthStep)){
+			growthSegments.push_back(segments);
+			growthCodes.push_back(cc.size());
+		}
+
+		const double position = (double)segmentX - (double)patX;
+		const double legacyPosition = (double)segmentX - (double)legacyLctX;
+		const double slope = segmentdXdZ;
+		cc.addSegment(ccKey, position, slope);
+		patterns.addSegment(patternKey, position, slope);
+		legacy.addSegment(legacyKey, legacyPosition, slope);
+		if(fillHists){
+			keys.insert(keys.end(), {ccKey, patternKey, legacyKey});
+			values.insert(values.end(), {position, legacyPosition, slope});
+		}
+	}
+	tree->ResetBranchAddresses();
+	tree->SetBranchStatus("*", 1);
+
+	cc.finish();
+	patterns.finish();
+	legacy.finish();
+	for(unsigned long i = 0; i < keys.size(); i += 3){
+		cc.fillHists(keys[i], values[i], values[i+2]);
+		patterns.fillHists(keys[i+1], values[i], values[i+2]);
+		legacy.fillHists(keys[i+2], values[i+1], values[i+2]);
+	}
+	return 0;
+}
@@ -6,11 +6,40 @@
  */
 
 #include "../include/Processor.h"
+#include "../include/StageTimers.h"
+#include "../include/Tracer.h"
+#include "../include/MemoryTracker.h"
+#include "../include/PerfCounters.h"
 
 #include <iostream>
 #include <stdio.h>
+#include <stdlib.h>
 #include <chrono>
 #include <time.h>
+#include <vector>
+#include <thread>
+#include <sstream>
+#include <algorithm>
+#include <memory>
+
+//fork
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/wait.h>
+#include <sys/resource.h>
+
+#include <TROOT.h>
+#include <TFile.h>
+#include <TTree.h>
+#include <TChain.h>
+#include <TBranch.h>
+#include <TObjArray.h>
+#include <TH1.h>
+#include <TTreeCache.h>
+#include <TEnv.h>
+#include <TDirectory.h>
+#include <TNamed.h>
+#include <TParameter.h>
 
 
 //define main function here to be used by processors that inherit from this class
@@ -19,31 +48,853 @@ int Processor::main(int argc, char* argv[])
 {
 	auto t1 = std::chrono::high_resolution_clock::now();
 
+	//pull out options, leaving the positional arguments
+	bool parallel = false;
+	bool forked = false;
+	unsigned int nThreads = 1;
+	unsigned int nProcs = 1;
+	bool saveTimers = false;
+	string statsFile;
+	string traceFile;
+	unsigned int traceSize = Tracer::DEFAULT_BUFFER_SIZE;
+	vector<string> args;
+	for(int i = 1; i < argc; i++){
+		string arg = argv[i];
+		if(arg == "-j" && i+1 < argc){
+			parallel = true;
+			nThreads = atoi(argv[++i]);
+		} else if(arg.size() > 2 && arg.compare(0,2,"-j") == 0){
+			parallel = true;
+			nThreads = atoi(arg.c_str()+2);
+		} else if(arg == "-p" && i+1 < argc){
+			forked = true;
+			nProcs = atoi(argv[++i]);
+		} else if(arg.size() > 2 && arg.compare(0,2,"-p") == 0){
+			forked = true;
+			nProcs = atoi(arg.c_str()+2);
+		} else if(arg == "--cache" && i+1 < argc){
+			_readOptions.cacheSize = atof(argv[++i])*1024*1024;
+		} else if(arg == "--cache-branches" && i+1 < argc){
+			stringstream ss(argv[++i]);
+			string branch;
+			while(getline(ss, branch, ',')) if(!branch.empty()) _readOptions.cacheBranches.push_back(branch);
+		} else if(arg == "--learn" && i+1 < argc){
+			_readOptions.learnEntries = atoi(argv[++i]);
+		} else if(arg == "--prefetch"){
+			_readOptions.prefetch = true;
+		} else if(arg == "--unzip"){
+			_readOptions.parallelUnzip = true;
+		} else if(arg == "--emulation-cache" && i+1 < argc){
+			_emulationCache = argv[++i];
+		} else if(arg == "--checkpoint" && i+1 < argc){
+			_checkpointFile = argv[++i];
+		} else if(arg == "--checkpoint-every" && i+1 < argc){
+			_checkpointEvery = atoll(argv[++i]);
+			if(_checkpointEvery <= 0) {
+				std::cout << "Error: bad option: --checkpoint-every " << argv[i] << std::endl;
+				return -1;
+			}
+		} else if(arg == "--no-timers"){
+			StageTimers::setEnabled(false);
+		} else if(arg == "--save-timers"){
+			saveTimers = true;
+		} else if(arg == "--stats" && i+1 < argc){
+			statsFile = argv[++i];
+		} else if(arg == "--mem"){
+			MemoryTracker::setEnabled(true);
+		} else if(arg == "--perf"){
+			PerfCounters::setEnabled(true);
+		} else if(arg == "--trace" && i+1 < argc){
+			traceFile = argv[++i];
+		} else if(arg == "--trace-size" && i+1 < argc){
+			traceSize = atoi(argv[++i]);
+		} else {
+			int used = option(argc, argv, i);
+			if(used < 0) {
+				std::cout << "Error: bad option: " << arg << std::endl;
+				return -1;
+			}
+			if(used) i += used-1;
+			else args.push_back(arg);
+		}
+	}
+
+	if(!_checkpointFile.empty() && !supportsCheckpoint()){
+		std::cout << "Error: processor can't write checkpoints, --checkpoint needs writeCheckpoint / readCheckpoint" << std::endl;
+		return -1;
+	}
+
+	if((parallel || forked) && !hasEventLoop()){
+		std::cout << "Warning: processor doesn't implement the event loop hooks, running single threaded" << std::endl;
+		parallel = false;
+		forked = false;
+	}
+	if(parallel && forked){
+		std::cout << "Warning: can't use both -j and -p, using " << nProcs << " processes" << std::endl;
+		parallel = false;
+	}
+
+	if(!traceFile.empty()) Tracer::start(traceFile, traceSize);
+
+	int result = 0;
 	try {
-		switch(argc){
+		switch(args.size()){
+		case 2:
+			if(forked) result = runForked(args[0], args[1], 0, -1, nProcs);
+			else if(parallel) result = runParallel(args[0], args[1], 0, -1, nThreads);
+			else result = run(args[0], args[1]);
+			break;
 		case 3:
-			return run(string(argv[1]), string(argv[2]));
+			if(forked) result = runForked(args[0], args[1], 0, atoi(args[2].c_str()), nProcs);
+			else if(parallel) result = runParallel(args[0], args[1], 0, atoi(args[2].c_str()), nThreads);
+			else result = run(args[0], args[1],0, atoi(args[2].c_str()));
 			break;
 		case 4:
-			return run(string(argv[1]), string(argv[2]),0, atoi(argv[3]));
-			break;
-		case 5:
-			return run(string(argv[1]), string(argv[2]),atoi(argv[3]), atoi(argv[4]));
+			if(forked) result = runForked(args[0], args[1], atoi(args[2].c_str()), atoi(args[3].c_str()), nProcs);
+			else if(parallel) result = runParallel(args[0], args[1], atoi(args[2].c_str()), atoi(args[3].c_str()), nThreads);
+			else result = run(args[0], args[1],atoi(args[2].c_str()), atoi(args[3].c_str()));
 			break;
 		default:
-			std::cout << "Gave "<< argc-1 << " arguments, usage is:" << std::endl;
-			std::cout << "./<Processor> inputFile outputFile (events)" << std::endl;
+			std::cout << "Gave "<< args.size() << " arguments, usage is:" << std::endl;
+			std::cout << "./<Processor> (-j nThreads | -p nProcesses) (--cache MB) (--cache-branches b1,b2) "
+					"(--learn entries) (--prefetch) (--unzip) (--no-timers | --save-timers) (--stats file.json) (--trace file.json) (--trace-size events) (--mem) (--perf) "
+					"(--emulation-cache file) (--checkpoint file) (--checkpoint-every entries) "
+					"inputFile(s) outputFile (events)" << std::endl;
 			return -1;
 		}
 	}catch( const char* msg) {
 		std::cerr << "ERROR: " << msg << std::endl;
+		result = -1;
+	}
+
+	auto t2 = std::chrono::high_resolution_clock::now();
+	printIOStats(chrono::duration<double>(t2-t1).count());
+	StageTimers::print();
+	MemoryTracker::print(_ioStats.entries);
+	PerfCounters::print();
+	if(saveTimers && !result){
+		TFile* f = TFile::Open(args[1].c_str(), "UPDATE");
+		if(f && !StageTimers::write(f)) cout << "Wrote stage timers to file: " << args[1] << endl;
+		else cout << "Error: couldn't write stage timers to file: " << args[1] << endl;
+		if(f) f->Close();
+		delete f;
+	}
+	if(Tracer::write()) result = -1;
+	if(!statsFile.empty() && writeStats(statsFile, argv[0], args.size() ? args[0] : "", result,
+			chrono::duration<double>(t2-t1).count(), forked ? nProcs : 1, parallel ? nThreads : 1)) result = -1;
+	printf("Time elapsed: %.1f s\n", chrono::duration<double>(t2-t1).count());
+
+
+	return result;
+}
+
+/* @brief Processors implementing the event loop hooks run
+ * single threaded by default, others need to override this
+ */
+int Processor::run(std::string inputfile, std::string outputfile, int start, int end){
+	if(hasEventLoop()) return runParallel(inputfile, outputfile, start, end, 1);
+	std::cout << "Defined run function in derived class" << std::endl;
+	return -1;
+}
+
+bool Processor::hasEventLoop() const {
+	Processor* worker = makeWorker();
+	if(!worker) return false;
+	delete worker;
+	return true;
+}
+
+/* @brief Chains together CSCDigiTree from a comma separated
+ * list of files, each of which can have wildcards
+ */
+TChain* Processor::openChain(const string& inputfile){
+	TChain* chain = new TChain("CSCDigiTree");
+	stringstream ss(inputfile);
+	string file;
+	while(getline(ss, file, ',')){
+		if(file.empty()) continue;
+		if(!chain->Add(file.c_str())){
+			delete chain;
+			cout << "Error: no files matching: " << file << endl;
+			throw "Can't open file";
+		}
+	}
+	if(!chain->GetNtrees()){
+		delete chain;
+		throw "Can't find tree";
+	}
+	return chain;
+}
+
+/* @brief Clamps [start, end) to the entries of the input chain
+ */
+void Processor::entryRange(const string& inputfile, int& start, int& end) const {
+	cout << "Running over file: " << inputfile << endl;
+
+	TChain* chain = openChain(inputfile);
+	long long nEntries = chain->GetEntries();
+	if(chain->GetNtrees() > 1) cout << "Chained " << chain->GetNtrees() << " files, " << nEntries << " entries" << endl;
+	delete chain;
+
+	if(end > nEntries || end < 0) end = nEntries;
+	if(start > end) start = end;
+}
+
+void Processor::printThroughput(const char* type, const vector<long long>& entries,
+		const vector<double>& seconds, double wallSeconds){
+	if(entries.size() < 2) return;
+	long long total = 0;
+	cout << "\033[94m=== Throughput ===\033[0m" << endl;
+	printf("%8s %12s %10s %12s\n", type, "entries", "time [s]", "events/s");
+	for(unsigned int i = 0; i < entries.size(); i++){
+		printf("%8u %12lli %10.1f %12.1f\n", i, entries[i], seconds[i], seconds[i] > 0 ? entries[i]/seconds[i] : 0.);
+		total += entries[i];
+	}
+	printf("%8s %12lli %10.1f %12.1f\n", "total", total, wallSeconds, wallSeconds > 0 ? total/wallSeconds : 0.);
+}
+
+int Processor::runParallel(const string& inputfile, const string& outputfile, int start, int end, unsigned int nThreads){
+	if(!nThreads) nThreads = thread::hardware_concurrency();
+	if(!nThreads) nThreads = 1;
+
+	entryRange(inputfile, start, end);
+	if((long long)nThreads > end-start) nThreads = end-start > 0 ? end-start : 1;
+
+	printf("Starting Event = %i, Ending Event = %i, Threads = %u\n", start, end, nThreads);
+
+	if(nThreads > 1) ROOT::EnableThreadSafety();
+	//histograms are owned by the workers, not whatever file is open
+	TH1::AddDirectory(false);
+
+	if(setup()) return -1;
+
+	vector<Processor*> workers;
+	for(unsigned int i = 0; i < nThreads; i++){
+		Processor* worker = makeWorker();
+		if(!worker){
+			cout << "Error: processor doesn't implement makeWorker()" << endl;
+			for(auto w : workers) delete w;
+			return -1;
+		}
+		workers.push_back(worker);
+	}
+
+	//contiguous ranges, so merging in order keeps the entry order
+	const ReadOptions& options = _readOptions;
+	applyReadOptions();
+	auto t1 = std::chrono::high_resolution_clock::now();
+	vector<int> status(nThreads, 0);
+	vector<long long> entries(nThreads, 0);
+	vector<double> seconds(nThreads, 0.);
+	vector<thread> threads;
+	for(unsigned int i = 0; i < nThreads; i++){
+		long long first = start + (long long)(end-start)*i/nThreads;
+		long long last = start + (long long)(end-start)*(i+1)/nThreads;
+		entries[i] = last-first;
+		const string checkpoint = checkpointName(i, nThreads);
+		const long long every = _checkpointEvery;
+		threads.push_back(thread([&workers, &status, &seconds, &inputfile, &options, i, first, last, checkpoint, every](){
+			if(Tracer::enabled()) Tracer::setThreadName("worker " + to_string(i));
+			status[i] = workers[i]->runWorker(inputfile, first, last, i == 0, options, checkpoint, every, seconds[i]);
+		}));
+	}
+	for(auto& th : threads) th.join();
+	auto t2 = std::chrono::high_resolution_clock::now();
+
+	int result = 0;
+	for(unsigned int i = 0; i < nThreads; i++){
+		if(status[i]){
+			cout << "Error: worker " << i << " failed" << endl;
+			result = -1;
+		}
+	}
+	if(!result) {
+		printThroughput("thread", entries, seconds, chrono::duration<double>(t2-t1).count());
+		for(unsigned int i = 0; i < nThreads; i++) addWorkerStats(workers[i]);
+		printBranchBytes();
+	}
+
+	for(unsigned int i = 1; i < nThreads && !result; i++){
+		if(workers[0]->mergeWorker(workers[i])) {
+			cout << "Error: failed merging worker " << i << endl;
+			result = -1;
+		}
+	}
+	if(!result) result = workers[0]->writeOutput(outputfile);
+	if(!result) removeCheckpoints(nThreads);
+
+	for(auto w : workers) delete w;
+	return result;
+}
+
+/* @brief Each child process runs one worker over its range and writes
+ * its results, as writeCheckpoint does, to <outputfile>.part<i>. Once they
+ * all finish, the parent reads them back into workers of its own, merges
+ * them in order and writes the output once, as runParallel does. Setup is
+ * done before forking, so the children share the LUTs, etc.
+ */
+int Processor::runForked(const string& inputfile, const string& outputfile, int start, int end, unsigned int nProcs){
+	if(!nProcs) nProcs = thread::hardware_concurrency();
+	if(!nProcs) nProcs = 1;
+
+	entryRange(inputfile, start, end);
+	if((long long)nProcs > end-start) nProcs = end-start > 0 ? end-start : 1;
+	if(nProcs == 1) return runParallel(inputfile, outputfile, start, end, 1);
+	if(!supportsCheckpoint()){
+		cout << "Error: -p needs writeCheckpoint / readCheckpoint to send back what each process did, use -j" << endl;
 		return -1;
 	}
 
+	printf("Starting Event = %i, Ending Event = %i, Processes = %u\n", start, end, nProcs);
+
+	TH1::AddDirectory(false);
+	if(setup()) return -1;
+
+	//flush before forking, otherwise the children print it again
+	cout.flush();
+	fflush(stdout);
+
+	applyReadOptions();
+	auto t1 = std::chrono::high_resolution_clock::now();
+	vector<pid_t> pids(nProcs, -1);
+	vector<int> pipes(nProcs, -1);
+	vector<long long> entries(nProcs, 0);
+	vector<string> parts;
+	int result = 0;
+	for(unsigned int i = 0; i < nProcs; i++){
+		long long first = start + (long long)(end-start)*i/nProcs;
+		long long last = start + (long long)(end-start)*(i+1)/nProcs;
+		entries[i] = last-first;
+		parts.push_back(outputfile + ".part" + to_string(i));
+
+		int fds[2];
+		if(pipe(fds)){
+			cout << "Error: can't create pipe for process " << i << endl;
+			result = -1;
+			break;
+		}
+		pid_t pid = fork();
+		if(pid < 0){
+			cout << "Error: can't fork process " << i << endl;
+			close(fds[0]);
+			close(fds[1]);
+			result = -1;
+			break;
+		}
+		if(pid == 0){
+			//child: report the time it took through the pipe, skip the parent's cleanup
+			close(fds[0]);
+			MemoryTracker::clear();
+			if(PerfCounters::enabled()) PerfCounters::clear();
+			if(Tracer::enabled()) {
+				Tracer::clear();
+				Tracer::setThreadName("worker " + to_string(i));
+			}
+			double seconds = -1;
+			int status = -1;
+			Processor* worker = makeWorker();
+			if(worker && !worker->runWorker(inputfile, first, last, i == 0, _readOptions,
+					checkpointName(i, nProcs), _checkpointEvery, seconds)){
+				status = worker->writeState(parts.back());
+			}
+			if(status) seconds = -1;
+			if(writeFully(fds[1], &seconds, sizeof(seconds))) status = -1;
+			if(!status && worker && worker->writeWorkerStats(fds[1])) status = -1;
+			close(fds[1]);
+			cout.flush();
+			fflush(stdout);
+			_exit(status ? 1 : 0);
+		}
+		close(fds[1]);
+		pids[i] = pid;
+		pipes[i] = fds[0];
+	}
+
+	vector<double> seconds(nProcs, 0.);
+	for(unsigned int i = 0; i < nProcs; i++){
+		if(pids[i] < 0) continue;
+		if(readFully(pipes[i], &seconds[i], sizeof(double))) seconds[i] = -1;
+		if(seconds[i] >= 0 && readWorkerStats(pipes[i])) seconds[i] = -1;
+		close(pipes[i]);
+		int status = 0;
+		waitpid(pids[i], &status, 0);
+		if(!WIFEXITED(status) || WEXITSTATUS(status) || seconds[i] < 0){
+			cout << "Error: process " << i << " failed" << endl;
+			result = -1;
+		}
+	}
 	auto t2 = std::chrono::high_resolution_clock::now();
-	cout << "Time elapsed: " << chrono::duration_cast<chrono::seconds>(t2-t1).count() << " s" << endl;
 
+	if(!result){
+		printThroughput("process", entries, seconds, chrono::duration<double>(t2-t1).count());
+		printBranchBytes();
+		result = mergeStates(inputfile, parts, outputfile);
+	}
+
+	//leave the parts around if the merge failed
+	if(!result) for(auto& part : parts) remove(part.c_str());
+	if(!result) removeCheckpoints(nProcs);
+
+	return result;
+}
+
+/* @brief Reads each part into a new worker, booked by beginWorker, merges
+ * them into the first one in order and writes its output
+ */
+int Processor::mergeStates(const string& inputfile, const vector<string>& parts, const string& outputfile) const {
+	TChain* t = 0;
+	try {
+		t = openChain(inputfile);
+	} catch( const char* msg) {
+		std::cerr << "ERROR: " << msg << std::endl;
+		return -1;
+	}
+
+	Processor* merged = 0;
+	int result = 0;
+	for(unsigned int i = 0; i < parts.size() && !result; i++){
+		Processor* worker = makeWorker();
+		if(!worker || worker->beginWorker(t) || worker->readState(parts[i])) {
+			cout << "Error: can't read back the results of process " << i << " from: " << parts[i] << endl;
+			result = -1;
+		} else if(merged && merged->mergeWorker(worker)) {
+			cout << "Error: failed merging process " << i << endl;
+			result = -1;
+		}
+		if(!merged && !result) merged = worker;
+		else delete worker;
+	}
+	if(!result) result = merged->writeOutput(outputfile);
+
+	delete merged;
+	delete t;
+	return result;
+}
+
+/* @brief Settings that have to be made before any file is opened
+ */
+void Processor::applyReadOptions() const {
+	if(_readOptions.prefetch) gEnv->SetValue("TFile.AsyncPrefetching", 1);
+	if(_readOptions.learnEntries > 0) TTreeCache::SetLearnEntries(_readOptions.learnEntries);
+}
+
+/* @brief Event loop of a single worker, over [first, last), from its
+ * checkpoint if it has one
+ */
+int Processor::runWorker(const string& inputfile, long long first, long long last, bool printProgress,
+		const ReadOptions& options, const string& checkpoint, long long checkpointEvery, double& seconds){
+	auto t1 = std::chrono::steady_clock::now();
+	try {
+		//freed however the loop ends, processEntry may throw
+		unique_ptr<TChain> t(openChain(inputfile));
+
+		if(beginWorker(t.get())) return -1;
 
+		long long next = first;
+		if(!checkpoint.empty() && loadCheckpoint(checkpoint, inputfile, first, last, next)) return -1;
+
+		//after beginWorker, so only the branches it enabled are cached
+		if(options.parallelUnzip) t->SetParallelUnzip(true);
+		//without --cache root makes its own, --cache 0 turns that off too
+		if(options.cacheSize >= 0) t->SetCacheSize(options.cacheSize);
+		if(options.cacheSize) {
+			t->SetCacheEntryRange(next, last);
+			if(options.cacheBranches.size()){
+				for(auto& branch : options.cacheBranches) t->AddBranchToCache(branch.c_str(), true);
+				t->StopCacheLearningPhase();
+			}
+		}
+
+		//same measurements as the I/O stats, so no extra clock reads
+		const bool timers = StageTimers::enabled();
+		const bool tracing = Tracer::enabled();
+		const bool memory = MemoryTracker::enabled();
+		const bool counters = PerfCounters::enabled();
+		PerfSample sample;
+		static const unsigned int readStage = StageTimers::stage("read");
+		static const unsigned int processStage = StageTimers::stage("process entry");
+
+		//first entry read in the current file of the chain
+		int treeNumber = -1;
+		long long treeFirst = 0;
+		for(long long i = next; i < last; i++){
+			if(!checkpoint.empty() && i > next && !((i-first)%checkpointEvery) &&
+					saveCheckpoint(checkpoint, inputfile, first, last, i)) return -1;
+			if(printProgress && !((i-first)%10000)) printf("%3.2f%% Done --- Processed %lli Events\n", 100.*(i-first)/(last-first), i-first);
+			int outerStage = memory ? MemoryTracker::enterStage(readStage) : -1;
+			auto r1 = std::chrono::steady_clock::now();
+			t->GetEntry(i);
+			auto r2 = std::chrono::steady_clock::now();
+			if(memory) MemoryTracker::leaveStage(outerStage);
+			TTree* current = t->GetTree();
+			long long local = current->GetReadEntry();
+			if(t->GetTreeNumber() != treeNumber) {
+				treeNumber = t->GetTreeNumber();
+				treeFirst = local;
+			}
+			if(memory) outerStage = MemoryTracker::enterStage(processStage);
+			if(counters) PerfCounters::begin(sample);
+			if(processEntry(i)) {
+				if(memory) MemoryTracker::leaveStage(outerStage);
+				return -1;
+			}
+			if(counters) PerfCounters::end(processStage, sample);
+			auto r3 = std::chrono::steady_clock::now();
+			if(memory) MemoryTracker::leaveStage(outerStage);
+			_ioStats.ioSeconds += chrono::duration<double>(r2-r1).count();
+			_ioStats.computeSeconds += chrono::duration<double>(r3-r2).count();
+			if(timers) {
+				StageTimers::add(readStage, chrono::duration_cast<chrono::nanoseconds>(r2-r1).count());
+				StageTimers::add(processStage, chrono::duration_cast<chrono::nanoseconds>(r3-r2).count());
+			}
+			if(tracing) {
+				Tracer::record(readStage, r1, r2, i, i+1);
+				Tracer::record(processStage, r2, r3, i, i+1);
+			}
+			_ioStats.entries++;
+			//count what was read from this file before the chain moves on to the next
+			if(i == last-1 || local == current->GetEntries()-1) addFileStats(current, treeFirst, local+1);
+		}
+	} catch( const char* msg) {
+		std::cerr << "ERROR: " << msg << std::endl;
+		return -1;
+	}
+	auto t2 = std::chrono::steady_clock::now();
+	seconds = chrono::duration<double>(t2-t1).count();
+	//the whole range of this worker, to spot imbalance between them
+	static const unsigned int workerStage = StageTimers::stage("worker");
+	if(Tracer::enabled()) Tracer::record(workerStage, t1, t2, first, last);
 	return 0;
 }
 
+/* @brief The checkpoint of worker i of nWorkers, none without --checkpoint
+ */
+string Processor::checkpointName(unsigned int worker, unsigned int nWorkers) const {
+	if(_checkpointFile.empty() || nWorkers <= 1) return _checkpointFile;
+	return _checkpointFile + "." + to_string(worker);
+}
+
+void Processor::removeCheckpoints(unsigned int nWorkers) const {
+	if(_checkpointFile.empty()) return;
+	for(unsigned int i = 0; i < nWorkers; i++) {
+		const string name = checkpointName(i, nWorkers);
+		remove(name.c_str());
+		remove((name + ".data").c_str());
+	}
+}
+
+/* @brief The checkpoint holds the input and range it was made for, the
+ * entry to go on from and a directory "state" with what writeCheckpoint wrote
+ */
+int Processor::loadCheckpoint(const string& file, const string& inputfile, long long first, long long last,
+		long long& next){
+	next = first;
+	if(access(file.c_str(), F_OK)) return 0;
+
+	TFile* f = TFile::Open(file.c_str());
+	if(!f || f->IsZombie()) {
+		cout << "Error: can't open checkpoint: " << file << endl;
+		delete f;
+		return -1;
+	}
+	TNamed* input = 0;
+	TParameter<Long64_t>* savedFirst = 0;
+	TParameter<Long64_t>* savedLast = 0;
+	TParameter<Long64_t>* savedNext = 0;
+	f->GetObject("input", input);
+	f->GetObject("first", savedFirst);
+	f->GetObject("last", savedLast);
+	f->GetObject("next", savedNext);
+	TDirectory* state = f->GetDirectory("state");
+	int result = 0;
+	if(!input || !savedFirst || !savedLast || !savedNext || !state) {
+		cout << "Error: checkpoint is incomplete: " << file << endl;
+		result = -1;
+	} else if(inputfile != input->GetTitle() || savedFirst->GetVal() != first || savedLast->GetVal() != last ||
+			savedNext->GetVal() < first || savedNext->GetVal() > last) {
+		cout << "Error: checkpoint " << file << " is of entries [" << savedFirst->GetVal() << ", " <<
+				savedLast->GetVal() << ") of " << input->GetTitle() << ", not [" << first << ", " << last <<
+				") of " << inputfile << endl;
+		result = -1;
+	} else {
+		_checkpointData = file + ".data";
+		result = readCheckpoint(state);
+		_checkpointData.clear();
+		if(result) cout << "Error: can't resume from checkpoint: " << file << endl;
+	}
+	if(!result) {
+		next = savedNext->GetVal();
+		cout << "Resuming from entry " << next << " of checkpoint: " << file << endl;
+	}
+	delete input;
+	delete savedFirst;
+	delete savedLast;
+	delete savedNext;
+	f->Close();
+	delete f;
+	return result;
+}
+
+int Processor::syncFile(const string& file){
+	int fd = open(file.c_str(), O_RDONLY);
+	int result = fd < 0 || fsync(fd) ? -1 : 0;
+	if(fd >= 0) close(fd);
+	return result;
+}
+
+/* @brief Written next to the checkpoint and renamed over it, so a job
+ * killed while writing keeps the previous one. What writeCheckpoint appended
+ * to checkpointData() is synced first, the checkpoint only counts it once renamed
+ */
+int Processor::saveCheckpoint(const string& file, const string& inputfile, long long first, long long last,
+		long long next){
+	STAGE_TIMER("checkpoint");
+	const string tmp = file + ".tmp";
+	TFile* f = TFile::Open(tmp.c_str(), "RECREATE");
+	if(!f || f->IsZombie()) {
+		cout << "Error: can't write checkpoint: " << tmp << endl;
+		delete f;
+		return -1;
+	}
+	TNamed input("input", inputfile.c_str());
+	TParameter<Long64_t> savedFirst("first", first);
+	TParameter<Long64_t> savedLast("last", last);
+	TParameter<Long64_t> savedNext("next", next);
+	f->WriteTObject(&input);
+	f->WriteTObject(&savedFirst);
+	f->WriteTObject(&savedLast);
+	f->WriteTObject(&savedNext);
+	TDirectory* state = f->mkdir("state");
+	const string data = file + ".data";
+	_checkpointData = data;
+	int result = state ? writeCheckpoint(state) : -1;
+	_checkpointData.clear();
+	if(!result && f->Write() < 0) result = -1;
+	f->Close();
+	delete f;
+	//Close doesn't sync, a node lost after the rename could otherwise leave it empty
+	if(!result && (syncFile(tmp) || (!access(data.c_str(), F_OK) && syncFile(data)))) result = -1;
+	if(!result && rename(tmp.c_str(), file.c_str())) result = -1;
+	if(result) {
+		cout << "Error: can't write checkpoint: " << file << endl;
+		remove(tmp.c_str());
+	}
+	return result;
+}
+
+/* @brief What a forked worker did, as writeCheckpoint writes it, in directory "state" of file
+ */
+int Processor::writeState(const string& file){
+	TFile* f = TFile::Open(file.c_str(), "RECREATE");
+	if(!f || f->IsZombie()) {
+		cout << "Error: can't write results to: " << file << endl;
+		delete f;
+		return -1;
+	}
+	TDirectory* state = f->mkdir("state");
+	int result = state ? writeCheckpoint(state) : -1;
+	if(!result && f->Write() < 0) result = -1;
+	f->Close();
+	delete f;
+	if(result) cout << "Error: can't write results to: " << file << endl;
+	return result;
+}
+
+int Processor::readState(const string& file){
+	TFile* f = TFile::Open(file.c_str());
+	if(!f || f->IsZombie()) {
+		delete f;
+		return -1;
+	}
+	TDirectory* state = f->GetDirectory("state");
+	int result = state ? readCheckpoint(state) : -1;
+	f->Close();
+	delete f;
+	return result;
+}
+
+/* @brief Adds the reads of the file t is in, and the baskets overlapping local
+ * entries [first, last) of each enabled branch of t. Uncompressed bytes are
+ * scaled from the compression of the whole branch
+ */
+void Processor::addFileStats(TTree* t, long long first, long long last){
+	TFile* f = t->GetCurrentFile();
+	if(f) {
+		_ioStats.readCalls += f->GetReadCalls();
+		_ioStats.bytesRead += f->GetBytesRead();
+		TTreeCache* cache = t->GetReadCache(f);
+		if(cache) _ioStats.cacheMisses += cache->GetMissCounter();
+	}
+
+	TObjArray* branches = t->GetListOfBranches();
+	if(!branches) return;
+	for(int ib = 0; ib < branches->GetEntriesFast(); ib++){
+		TBranch* b = (TBranch*)branches->At(ib);
+		if(!b || !t->GetBranchStatus(b->GetName())) continue;
+		int nBaskets = b->GetWriteBasket();
+		int* basketBytes = b->GetBasketBytes();
+		Long64_t* basketEntry = b->GetBasketEntry();
+		double zipBytes = 0;
+		for(int k = 0; k < nBaskets; k++){
+			long long basketLast = k+1 < nBaskets ? basketEntry[k+1] : b->GetEntries();
+			if(basketEntry[k] < last && basketLast > first) zipBytes += basketBytes[k];
+		}
+		double ratio = b->GetZipBytes() ? 1.*b->GetTotBytes()/b->GetZipBytes() : 1.;
+		auto& bytes = _branchBytes[b->GetName()];
+		bytes.first += zipBytes;
+		bytes.second += zipBytes*ratio;
+	}
+}
+
+void Processor::addWorkerStats(const Processor* worker){
+	_ioStats.entries += worker->_ioStats.entries;
+	_ioStats.readCalls += worker->_ioStats.readCalls;
+	_ioStats.bytesRead += worker->_ioStats.bytesRead;
+	_ioStats.ioSeconds += worker->_ioStats.ioSeconds;
+	_ioStats.computeSeconds += worker->_ioStats.computeSeconds;
+	_ioStats.cacheMisses += worker->_ioStats.cacheMisses;
+	for(auto& entry : worker->_branchBytes){
+		_branchBytes[entry.first].first += entry.second.first;
+		_branchBytes[entry.first].second += entry.second.second;
+	}
+}
+
+/* @brief Sends the stats of a forked worker through a pipe, as the IOStats,
+ * [n] then [name length, name, compressed, uncompressed] for each branch,
+ * then its stage timers, memory stats, counters and trace
+ */
+int Processor::writeWorkerStats(int fd) const {
+	if(writeFully(fd, &_ioStats, sizeof(_ioStats))) return -1;
+	unsigned int n = _branchBytes.size();
+	if(writeFully(fd, &n, sizeof(n))) return -1;
+	for(auto& entry : _branchBytes){
+		unsigned int length = entry.first.size();
+		double bytes[2] = {entry.second.first, entry.second.second};
+		if(writeFully(fd, &length, sizeof(length)) ||
+				writeFully(fd, entry.first.c_str(), length) ||
+				writeFully(fd, bytes, sizeof(bytes))) return -1;
+	}
+	if(StageTimers::send(fd) || MemoryTracker::send(fd) || PerfCounters::send(fd)) return -1;
+	return Tracer::send(fd);
+}
+
+int Processor::readWorkerStats(int fd){
+	Processor worker;
+	if(readFully(fd, &worker._ioStats, sizeof(worker._ioStats))) return -1;
+	unsigned int n = 0;
+	if(readFully(fd, &n, sizeof(n))) return -1;
+	for(unsigned int i = 0; i < n; i++){
+		unsigned int length = 0;
+		double bytes[2] = {0, 0};
+		if(readFully(fd, &length, sizeof(length))) return -1;
+		string name(length, ' ');
+		if(readFully(fd, &name[0], length) ||
+				readFully(fd, bytes, sizeof(bytes))) return -1;
+		worker._branchBytes[name] = make_pair(bytes[0], bytes[1]);
+	}
+	addWorkerStats(&worker);
+	if(StageTimers::receive(fd) || MemoryTracker::receive(fd) || PerfCounters::receive(fd)) return -1;
+	return Tracer::receive(fd);
+}
+
+void Processor::printBranchBytes() const {
+	if(_branchBytes.empty()) return;
+	vector<pair<string, pair<double,double> > > branches(_branchBytes.begin(), _branchBytes.end());
+	std::sort(branches.begin(), branches.end(),
+			[](const pair<string, pair<double,double> >& a, const pair<string, pair<double,double> >& b){
+		return a.second.first > b.second.first;
+	});
+
+	double totalZip = 0;
+	double totalBytes = 0;
+	cout << "\033[94m=== Branches Read ===\033[0m" << endl;
+	printf("%-30s %16s %18s\n", "branch", "compressed [MB]", "uncompressed [MB]");
+	for(auto& entry : branches){
+		printf("%-30s %16.2f %18.2f\n", entry.first.c_str(), entry.second.first/1e6, entry.second.second/1e6);
+		totalZip += entry.second.first;
+		totalBytes += entry.second.second;
+	}
+	printf("%-30s %16.2f %18.2f\n", ("total (" + to_string(branches.size()) + " branches)").c_str(), totalZip/1e6, totalBytes/1e6);
+}
+
+/* @brief Time in GetEntry is counted as blocked on I/O (reading and
+ * decompressing), time in processEntry as compute. Both are summed over
+ * workers, so can add up to more than the wall time. Processors overriding
+ * run() only get the totals root keeps for all files
+ */
+void Processor::printIOStats(double wallSeconds) const {
+	long long readCalls = _ioStats.entries ? _ioStats.readCalls : TFile::GetFileReadCalls();
+	long long bytesRead = _ioStats.entries ? _ioStats.bytesRead : TFile::GetFileBytesRead();
+
+	cout << "\033[94m=== I/O ===\033[0m" << endl;
+	printf("%-24s %lli\n", "read calls", readCalls);
+	printf("%-24s %.2f MB (%.2f MB/s)\n", "bytes read", bytesRead/1e6, wallSeconds > 0 ? bytesRead/1e6/wallSeconds : 0.);
+	if(!_ioStats.entries) return;
+	double total = _ioStats.ioSeconds + _ioStats.computeSeconds;
+	printf("%-24s %.3f kB\n", "bytes per entry", 1.e-3*bytesRead/_ioStats.entries);
+	printf("%-24s %lli\n", "cache misses", _ioStats.cacheMisses);
+	printf("%-24s %.1f s (%.1f%%)\n", "blocked on I/O", _ioStats.ioSeconds, total > 0 ? 100.*_ioStats.ioSeconds/total : 0.);
+	printf("%-24s %.1f s (%.1f%%)\n", "compute", _ioStats.computeSeconds, total > 0 ? 100.*_ioStats.computeSeconds/total : 0.);
+}
+
+/* @brief The totals of the job as one JSON object, for benchmark drivers.
+ * With the event loop hooks, entries and I/O come from the loop. Processors
+ * overriding run() count the calls of their "read" stage as entries and the
+ * time in it as I/O, the rest of the wall time as compute
+ */
+int Processor::writeStats(const string& file, const string& processor, const string& inputfile,
+		int result, double wallSeconds, unsigned int nProcs, unsigned int nThreads) const {
+	vector<string> names;
+	vector<StageStats> stats;
+	vector<unsigned int> stageThreads;
+	StageTimers::summary(names, stats, stageThreads);
+
+	long long entries = _ioStats.entries;
+	double ioSeconds = _ioStats.ioSeconds;
+	double computeSeconds = _ioStats.computeSeconds;
+	long long bytesRead = _ioStats.entries ? _ioStats.bytesRead : TFile::GetFileBytesRead();
+	if(!_ioStats.entries){
+		for(unsigned int i = 0; i < names.size(); i++){
+			if(names[i] != "read") continue;
+			entries = stats[i].count;
+			ioSeconds = 1e-9*stats[i].total;
+		}
+		computeSeconds = wallSeconds > ioSeconds ? wallSeconds - ioSeconds : 0;
+	}
+	const double loopSeconds = ioSeconds + computeSeconds;
+	const unsigned int cores = thread::hardware_concurrency();
+
+	//kB, the largest of this process and of any forked worker
+	struct rusage self, children;
+	getrusage(RUSAGE_SELF, &self);
+	getrusage(RUSAGE_CHILDREN, &children);
+
+	FILE* out = fopen(file.c_str(), "w");
+	if(!out){
+		cout << "Error: can't open stats file: " << file << endl;
+		return -1;
+	}
+	string name = processor.substr(processor.find_last_of('/') == string::npos ? 0 : processor.find_last_of('/')+1);
+	fprintf(out, "{\n\"processor\":\"%s\",\n\"input\":\"%s\",\n\"result\":%i,\n\"eventLoop\":%s,\n"
+			"\"threads\":%u,\n\"processes\":%u,\n\"entries\":%lli,\n\"wallSeconds\":%.6f,\n\"entriesPerSecond\":%.3f,\n"
+			"\"ioSeconds\":%.6f,\n\"computeSeconds\":%.6f,\n\"ioShare\":%.6f,\n\"bytesRead\":%lli,\n"
+			"\"peakRSSkB\":%li,\n\"peakChildRSSkB\":%li,\n\"stages\":[",
+			name.c_str(), inputfile.c_str(), result, hasEventLoop() ? "true" : "false",
+			nThreads ? nThreads : cores, nProcs ? nProcs : cores, entries, wallSeconds,
+			wallSeconds > 0 ? entries/wallSeconds : 0., ioSeconds, computeSeconds,
+			loopSeconds > 0 ? ioSeconds/loopSeconds : 0., bytesRead, self.ru_maxrss, children.ru_maxrss);
+	bool first = true;
+	for(unsigned int i = 0; i < names.size(); i++){
+		if(!stats[i].count) continue;
+		fprintf(out, "%s\n{\"name\":\"%s\",\"calls\":%llu,\"threads\":%u,\"seconds\":%.6f}", first ? "" : ",",
+				names[i].c_str(), stats[i].count, stageThreads[i], 1e-9*stats[i].total);
+		first = false;
+	}
+	fprintf(out, "\n]}\n");
+	if(fclose(out)){
+		cout << "Error: failed writing stats file: " << file << endl;
+		return -1;
+	}
+	cout << "Wrote job stats to file: " << file << endl;
+	return 0;
+}
@@ -0,0 +1,292 @@
+/*
+ * StageTimers.cpp
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: agent
+ */
+
+#include "../include/StageTimers.h"
+
+#include <iostream>
+#include <stdio.h>
+#include <string.h>
+#include <mutex>
+#include <atomic>
+#include <unistd.h>
+
+#include <TDirectory.h>
+#include <TTree.h>
+
+
+StageStats::StageStats() :
+	count(0), total(0), min(0), max(0){
+	memset(bins, 0, sizeof(bins));
+}
+
+void StageStats::add(unsigned long long ns){
+	if(!count || ns < min) min = ns;
+	if(ns > max) max = ns;
+	count++;
+	total += ns;
+	bins[getBin(ns)]++;
+}
+
+void StageStats::merge(const StageStats& s){
+	if(!s.count) return;
+	if(!count || s.min < min) min = s.min;
+	if(s.max > max) max = s.max;
+	count += s.count;
+	total += s.total;
+	for(unsigned int i = 0; i < NBINS; i++) bins[i] += s.bins[i];
+}
+
+double StageStats::percentile(double fraction) const {
+	if(!count) return 0;
+	unsigned long long target = fraction*count;
+	unsigned long long sum = 0;
+	for(unsigned int i = 0; i < NBINS; i++){
+		sum += bins[i];
+		if(sum > target) {
+			double center = binCenter(i);
+			if(center < min) return min;
+			if(center > max) return max;
+			return center;
+		}
+	}
+	return max;
+}
+
+//below 8 ns one bin per ns, then 8 per power of two
+unsigned int StageStats::getBin(unsigned long long ns){
+	if(ns < 8) return ns;
+	unsigned int e = 63 - __builtin_clzll(ns);
+	return (e-2)*8 + ((ns >> (e-3)) & 7);
+}
+
+double StageStats::binCenter(unsigned int bin){
+	if(bin < 8) return bin;
+	unsigned int e = bin/8 + 2;
+	unsigned long long width = 1ull << (e-3);
+	return (8 + bin%8)*width + 0.5*width;
+}
+
+
+/* Tables are kept for the whole job, so the stages of threads that
+ * have finished are still there for the summary
+ */
+namespace {
+
+struct ThreadTable {
+	vector<StageStats> stages;
+};
+
+mutex& registryMutex(){
+	static mutex m;
+	return m;
+}
+
+vector<string>& stageNames(){
+	static vector<string> names;
+	return names;
+}
+
+vector<ThreadTable*>& threadTables(){
+	static vector<ThreadTable*> tables;
+	return tables;
+}
+
+atomic<bool>& enabledFlag(){
+	static atomic<bool> flag(true);
+	return flag;
+}
+
+ThreadTable* newTable(){
+	lock_guard<mutex> lock(registryMutex());
+	threadTables().push_back(new ThreadTable());
+	return threadTables().back();
+}
+
+ThreadTable* threadTable(){
+	static thread_local ThreadTable* table = newTable();
+	return table;
+}
+
+}
+
+unsigned int StageTimers::stage(const string& name){
+	lock_guard<mutex> lock(registryMutex());
+	vector<string>& names = stageNames();
+	for(unsigned int i = 0; i < names.size(); i++) if(names[i] == name) return i;
+	names.push_back(name);
+	return names.size()-1;
+}
+
+string StageTimers::name(unsigned int stage){
+	lock_guard<mutex> lock(registryMutex());
+	return stage < stageNames().size() ? stageNames()[stage] : "";
+}
+
+vector<string> StageTimers::names(){
+	lock_guard<mutex> lock(registryMutex());
+	return stageNames();
+}
+
+void StageTimers::add(unsigned int stage, unsigned long long ns){
+	ThreadTable* table = threadTable();
+	if(stage >= table->stages.size()) table->stages.resize(stage+1);
+	table->stages[stage].add(ns);
+}
+
+void StageTimers::setEnabled(bool enabled){
+	enabledFlag() = enabled;
+}
+
+bool StageTimers::enabled(){
+	return enabledFlag().load(memory_order_relaxed);
+}
+
+/* @brief Only call once the timed threads are done
+ */
+void StageTimers::summary(vector<string>& names, vector<StageStats>& stats, vector<unsigned int>& nThreads){
+	lock_guard<mutex> lock(registryMutex());
+	names = stageNames();
+	stats.assign(names.size(), StageStats());
+	nThreads.assign(names.size(), 0);
+	for(auto table : threadTables()){
+		for(unsigned int i = 0; i < table->stages.size(); i++){
+			if(!table->stages[i].count) continue;
+			stats[i].merge(table->stages[i]);
+			nThreads[i]++;
+		}
+	}
+}
+
+void StageTimers::print(){
+	vector<string> names;
+	vector<StageStats> stats;
+	vector<unsigned int> nThreads;
+	summary(names, stats, nThreads);
+
+	bool any = false;
+	for(auto& s : stats) if(s.count) any = true;
+	if(!any) return;
+
+	cout << "\033[94m=== Stage Timers ===\033[0m" << endl;
+	printf("%-20s %12s %10s %10s %10s %10s %10s %10s %10s %8s\n", "stage", "calls", "total [s]",
+			"mean [us]", "min [us]", "p50 [us]", "p90 [us]", "p99 [us]", "max [us]", "threads");
+	for(unsigned int i = 0; i < names.size(); i++){
+		const StageStats& s = stats[i];
+		if(!s.count) continue;
+		printf("%-20s %12llu %10.2f %10.2f %10.2f %10.2f %10.2f %10.2f %10.2f %8u\n", names[i].c_str(), s.count,
+				1e-9*s.total, 1e-3*s.total/s.count, 1e-3*s.min, 1e-3*s.percentile(0.5),
+				1e-3*s.percentile(0.9), 1e-3*s.percentile(0.99), 1e-3*s.max, nThreads[i]);
+	}
+}
+
+/* @brief Writes the summary as a tree "stageTimers" in dir, times in us
+ */
+int StageTimers::write(TDirectory* dir){
+	if(!dir) return -1;
+	vector<string> names;
+	vector<StageStats> stats;
+	vector<unsigned int> nThreads;
+	summary(names, stats, nThreads);
+
+	string stage;
+	Long64_t calls = 0;
+	int threads = 0;
+	double total = 0, mean = 0, min = 0, p50 = 0, p90 = 0, p99 = 0, max = 0;
+
+	dir->cd();
+	TTree* t = new TTree("stageTimers", "Time spent in each stage of the job [us]");
+	t->Branch("stage", &stage);
+	t->Branch("calls", &calls, "calls/L");
+	t->Branch("threads", &threads, "threads/I");
+	t->Branch("total", &total, "total/D");
+	t->Branch("mean", &mean, "mean/D");
+	t->Branch("min", &min, "min/D");
+	t->Branch("p50", &p50, "p50/D");
+	t->Branch("p90", &p90, "p90/D");
+	t->Branch("p99", &p99, "p99/D");
+	t->Branch("max", &max, "max/D");
+	for(unsigned int i = 0; i < names.size(); i++){
+		const StageStats& s = stats[i];
+		if(!s.count) continue;
+		stage = names[i];
+		calls = s.count;
+		threads = nThreads[i];
+		total = 1e-3*s.total;
+		mean = 1e-3*s.total/s.count;
+		min = 1e-3*s.min;
+		p50 = 1e-3*s.percentile(0.5);
+		p90 = 1e-3*s.percentile(0.9);
+		p99 = 1e-3*s.percentile(0.99);
+		max = 1e-3*s.max;
+		t->Fill();
+	}
+	t->Write();
+	delete t;
+	return 0;
+}
+
+int readFully(int fd, void* buffer, unsigned long n){
+	char* p = (char*)buffer;
+	while(n){
+		ssize_t r = read(fd, p, n);
+		if(r <= 0) return -1;
+		p += r;
+		n -= r;
+	}
+	return 0;
+}
+
+int writeFully(int fd, const void* buffer, unsigned long n){
+	const char* p = (const char*)buffer;
+	while(n){
+		ssize_t w = write(fd, p, n);
+		if(w <= 0) return -1;
+		p += w;
+		n -= w;
+	}
+	return 0;
+}
+
+/* @brief Sends every stage used in this process as [n] then
+ * [name length, name, stats] for each, merged over threads
+ */
+int StageTimers::send(int fd){
+	vector<string> names;
+	vector<StageStats> stats;
+	vector<unsigned int> nThreads;
+	summary(names, stats, nThreads);
+
+	unsigned int n = names.size();
+	if(writeFully(fd, &n, sizeof(n))) return -1;
+	for(unsigned int i = 0; i < n; i++){
+		unsigned int length = names[i].size();
+		if(writeFully(fd, &length, sizeof(length)) ||
+				writeFully(fd, names[i].c_str(), length) ||
+				writeFully(fd, &stats[i], sizeof(StageStats))) return -1;
+	}
+	return 0;
+}
+
+/* @brief Adds the stages of another process, counted as one more thread
+ */
+int StageTimers::receive(int fd){
+	unsigned int n = 0;
+	if(readFully(fd, &n, sizeof(n))) return -1;
+	ThreadTable* table = newTable();
+	for(unsigned int i = 0; i < n; i++){
+		unsigned int length = 0;
+		if(readFully(fd, &length, sizeof(length))) return -1;
+		string name(length, ' ');
+		StageStats s;
+		if(readFully(fd, &name[0], length) ||
+				readFully(fd, &s, sizeof(StageStats))) return -1;
+		unsigned int id = stage(name);
+		if(id >= table->stages.size()) table->stages.resize(id+1);
+		table->stages[id].merge(s);
+	}
+	return 0;
+}
@@ -0,0 +1,202 @@
+/*
+ * SyntheticEvents.cpp
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: agent
+ */
+
+#include "../include/SyntheticEvents.h"
+#include "../include/CSCHelperFunctions.h"
+#include "../include/CSCHelper.h"
+
+
+SyntheticEvents::SyntheticEvents(const SyntheticConfig& config) :
+		_config(config),
+		_random(config.seed) {
+	_patterns = config.legacyPatterns ? createOldPatterns() : createNewPatterns();
+
+	comparators.ch_id = &_compChamber;
+	comparators.lay = &_compLayer;
+	comparators.strip = &_compStrip;
+	comparators.halfStrip = &_compHalfStrip;
+	comparators.bestTime = &_compTime;
+	comparators.nTimeOn = &_compTimeOn;
+
+	wires.ch_id = &_wireChamber;
+	wires.group = &_wireGroup;
+	wires.lay = &_wireLayer;
+	wires.timeBin = &_wireTimeBin;
+	wires.BX = &_wireBX;
+	wires.timeBinWord = &_wireTimeBinWord;
+}
+
+SyntheticEvents::~SyntheticEvents(){
+	delete _patterns;
+}
+
+void SyntheticEvents::clear(){
+	_compChamber.clear();
+	_compLayer.clear();
+	_compStrip.clear();
+	_compHalfStrip.clear();
+	_compTime.clear();
+	_compTimeOn.clear();
+
+	_wireChamber.clear();
+	_wireGroup.clear();
+	_wireLayer.clear();
+	_wireTimeBin.clear();
+	_wireBX.clear();
+	_wireTimeBinWord.clear();
+
+	muons.clear();
+}
+
+/* @brief Takes a position in ChamberHits::_hits, dropping those that
+ * fall outside of the chamber
+ */
+void SyntheticEvents::addComparator(const ChamberHits& c, int chamberId, unsigned int layer, int column, unsigned int time){
+	int hs = column - c.shift(layer);
+	if(hs < (int)c.minHs() || hs >= (int)c.maxHs()) return;
+	_compChamber.push_back(chamberId);
+	_compLayer.push_back(layer+1);
+	_compStrip.push_back(hs/2+1);
+	_compHalfStrip.push_back(hs%2);
+	_compTime.push_back(time);
+	_compTimeOn.push_back(1);
+}
+
+void SyntheticEvents::addWire(int chamberId, unsigned int layer, unsigned int group, unsigned int time){
+	_wireChamber.push_back(chamberId);
+	_wireGroup.push_back(group+1);
+	_wireLayer.push_back(layer+1);
+	_wireTimeBin.push_back(time);
+	_wireBX.push_back(time);
+	_wireTimeBinWord.push_back(1u << time);
+}
+
+namespace {
+
+/* @brief Straight line through the comparators of a muon, in the strip
+ * coordinates of the key layer, i.e. what its segment would measure
+ */
+void fitStrips(SyntheticMuon& mu){
+	double n = 0, sumx = 0, sumy = 0, sumx2 = 0, sumxy = 0;
+	for(unsigned int y = 0; y < NLAYERS; y++){
+		if(mu.strips[y] < 0) continue;
+		double x = (int)y - 2;
+		n++;
+		sumx += x;
+		sumy += mu.strips[y];
+		sumx2 += x*x;
+		sumxy += x*mu.strips[y];
+	}
+	mu.nHits = n;
+	mu.position = mu.keyHalfStrip/2. + 1;
+	mu.slope = 0;
+	if(!n) return;
+	double denominator = n*sumx2 - sumx*sumx;
+	if(denominator) mu.slope = (n*sumxy - sumx*sumy)/denominator;
+	mu.position = (sumy - mu.slope*sumx)/n;
+}
+
+}
+
+/* @brief Most of the half strips / wire groups of one to two CFEBs lit
+ * in every layer, spread over the time bins, as from an electromagnetic
+ * shower or a punch through
+ */
+void SyntheticEvents::addShower(const ChamberHits& c, int chamberId, int maxWi){
+	uniform_real_distribution<float> flat(0., 1.);
+	uniform_int_distribution<unsigned int> showerTime(5, 11);
+
+	const int width = uniform_int_distribution<int>(32, 64)(_random);
+	const int start = uniform_int_distribution<int>(c.minHs(), c.maxHs()-1)(_random) - width/2;
+	const int wireWidth = uniform_int_distribution<int>(8, 32)(_random);
+	const int wireStart = uniform_int_distribution<int>(0, maxWi-1)(_random) - wireWidth/2;
+	for(unsigned int y = 0; y < NLAYERS; y++){
+		for(int hs = start; hs < start+width; hs++){
+			if(flat(_random) < 0.5) addComparator(c, chamberId, y, hs + c.shift(y), showerTime(_random));
+		}
+		for(int group = wireStart; group < wireStart+wireWidth; group++){
+			if(group >= 0 && group < maxWi && flat(_random) < 0.5) addWire(chamberId, y, group, showerTime(_random));
+		}
+	}
+}
+
+int SyntheticEvents::addChamber(unsigned int station, unsigned int ring, unsigned int endcap, unsigned int chamber){
+	const int chamberId = CSCHelper::serialize(station, ring, chamber, endcap);
+	//only for the geometry
+	const ChamberHits c(station, ring, endcap, chamber);
+	const ALCT_ChamberHits w(station, ring, chamber, endcap);
+	const int maxWi = w.get_maxWi();
+
+	uniform_real_distribution<float> flat(0., 1.);
+	uniform_int_distribution<unsigned int> anyTime(0, 15);
+
+	poisson_distribution<int> nMuons(_config.muons);
+	int n = _config.muons > 0 ? nMuons(_random) : 0;
+	for(int i = 0; i < n; i++){
+		SyntheticMuon mu;
+		mu.station = station;
+		mu.ring = ring;
+		mu.endcap = endcap;
+		mu.chamber = chamber;
+
+		//comparators, one of the spots of the envelope in each layer,
+		// on time for the window containsPattern looks at (6-9)
+		const CSCPattern& p = _patterns->at(uniform_int_distribution<unsigned int>(0, _patterns->size()-1)(_random));
+		int x = uniform_int_distribution<int>(c.minHs(), c.maxHs()-1)(_random) - (int)MAX_PATTERN_WIDTH/2 + 1;
+		unsigned int time = uniform_int_distribution<unsigned int>(6, 8)(_random);
+		mu.patternId = p._id;
+		mu.keyHalfStrip = x + MAX_PATTERN_WIDTH/2 - 1;
+		for(unsigned int y = 0; y < NLAYERS; y++){
+			mu.strips[y] = -1;
+			mu.wireGroups[y] = -1;
+		}
+		for(unsigned int y = 0; y < NLAYERS; y++){
+			if(flat(_random) >= _config.efficiency) continue;
+			unsigned int spots = 0;
+			for(unsigned int px = 0; px < MAX_PATTERN_WIDTH; px++) spots += p._pat[px][y];
+			if(!spots) continue;
+			unsigned int column = uniform_int_distribution<unsigned int>(0, spots-1)(_random);
+			for(unsigned int px = 0; px < MAX_PATTERN_WIDTH; px++){
+				if(!p._pat[px][y]) continue;
+				if(!column--) {
+					addComparator(c, chamberId, y, x+px, time + (flat(_random) < 0.2));
+					mu.strips[y] = (x+(int)px-1)/2. + 1;
+					break;
+				}
+			}
+		}
+		fitStrips(mu);
+
+		//wires, a straight road through the key layer
+		mu.keyWireGroup = uniform_int_distribution<int>(0, maxWi-1)(_random);
+		mu.wireSlope = uniform_real_distribution<float>(-0.5, 0.5)(_random);
+		mu.bx = uniform_int_distribution<int>(6, 8)(_random);
+		for(unsigned int y = 0; y < NLAYERS; y++){
+			if(flat(_random) >= _config.efficiency) continue;
+			int group = mu.keyWireGroup + (int)round(mu.wireSlope*((int)y-2));
+			if(group < 0 || group >= maxWi) continue;
+			addWire(chamberId, y, group, mu.bx + (flat(_random) < 0.2));
+			mu.wireGroups[y] = group;
+		}
+		muons.push_back(mu);
+	}
+
+	if(_config.showers > 0 && flat(_random) < _config.showers) addShower(c, chamberId, maxWi);
+
+	//noise, flat in position and time
+	if(_config.noise > 0){
+		for(unsigned int y = 0; y < NLAYERS; y++){
+			for(unsigned int hs = c.minHs(); hs < c.maxHs(); hs++){
+				if(flat(_random) < _config.noise) addComparator(c, chamberId, y, hs + c.shift(y), anyTime(_random));
+			}
+			for(int group = 0; group < maxWi; group++){
+				if(flat(_random) < _config.noise) addWire(chamberId, y, group, anyTime(_random));
+			}
+		}
+	}
+	return n;
+}
@@ -0,0 +1,421 @@
+/*
+ * SyntheticTupleGenerator.cpp
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: agent
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <iostream>
+#include <vector>
+#include <string>
+#include <set>
+#include <chrono>
+#include <random>
+#include <functional>
+
+using namespace std;
+
+#include <TTree.h>
+#include <TFile.h>
+
+#include "../include/CSCConstants.h"
+#include "../include/CSCClasses.h"
+#include "../include/CSCHelperFunctions.h"
+#include "../include/ALCTHelperFunctions.h"
+#include "../include/CSCInfo.h"
+#include "../include/CSCHelper.h"
+#include "../include/SyntheticEvents.h"
+
+
+/* @brief Makes the branches of the CSCInfo objects, named the way
+ * they read them
+ */
+class TupleBranches {
+public:
+	TupleBranches(TTree* t) : _tree(t) {}
+	~TupleBranches(){
+		for(auto& d : _deletes) d();
+	}
+
+	//branch on a vector owned elsewhere
+	template<class T>
+	void branch(CSCInfo::Object& o, const char* varname, vector<T>* v){
+		_tree->Branch(o.branchify(varname).c_str(), v);
+	}
+
+	//new vector, cleared with clear()
+	template<class T>
+	void book(CSCInfo::Object& o, const char* varname, vector<T>*& v){
+		v = new vector<T>();
+		branch(o, varname, v);
+		vector<T>* owned = v;
+		_clears.push_back([owned](){ owned->clear(); });
+		_deletes.push_back([owned](){ delete owned; });
+	}
+
+	template<class T>
+	void book(CSCInfo::Object& o, const char* varname, T& var, const char* type){
+		_tree->Branch(o.branchify(varname).c_str(), &var, (string(varname)+"/"+type).c_str());
+	}
+
+	void clear(){
+		for(auto& c : _clears) c();
+	}
+
+private:
+	TTree* _tree;
+	vector<function<void()>> _clears;
+	vector<function<void()>> _deletes;
+};
+
+void usage(){
+	cout << "Usage: ./SyntheticTupleGenerator output.root [options]" << endl;
+	cout << "  --events N       events to write (1000)" << endl;
+	cout << "  --chambers N     chambers with hits per event (4)" << endl;
+	cout << "  --muons X        mean muons per chamber (1)" << endl;
+	cout << "  --noise X        noise occupancy, chance of a hit per half strip / wire group and layer (0.01)" << endl;
+	cout << "  --showers X      chance of a chamber having a shower (0)" << endl;
+	cout << "  --efficiency X   chance of a muon leaving a hit in a layer (0.95)" << endl;
+	cout << "  --legacy         draw the muons from the legacy pattern envelopes" << endl;
+	cout << "  --seed N         (1), the same seed and options give the same file" << endl;
+	cout << "  --run N          run number of the events (1)" << endl;
+	cout << "  --no-emulation   leave the clct, alct and lct collections empty, which is much faster" << endl;
+}
+
+/* @brief Writes a CSCDigiTree of fake events, with the branches the
+ * analyzers read: comparators and wires from SyntheticEvents, a muon,
+ * gen particle, segment and rechits for each generated muon, and as
+ * the recorded CLCTs / ALCTs / LCTs what the TMB and ALCT emulators
+ * find in each chamber
+ */
+int main(int argc, char* argv[]){
+	if(argc < 2 || argv[1][0] == '-'){
+		usage();
+		return -1;
+	}
+	const string outputfile = argv[1];
+	SyntheticConfig config;
+	unsigned int nEvents = 1000;
+	unsigned int nChambers = 4;
+	unsigned long long run = 1;
+	bool emulate = true;
+
+	for(int i = 2; i < argc; i++){
+		string arg = argv[i];
+		bool hasValue = i+1 < argc;
+		if(arg == "--events" && hasValue) nEvents = atoi(argv[++i]);
+		else if(arg == "--chambers" && hasValue) nChambers = atoi(argv[++i]);
+		else if(arg == "--muons" && hasValue) config.muons = atof(argv[++i]);
+		else if(arg == "--noise" && hasValue) config.noise = atof(argv[++i]);
+		else if(arg == "--showers" && hasValue) config.showers = atof(argv[++i]);
+		else if(arg == "--efficiency" && hasValue) config.efficiency = atof(argv[++i]);
+		else if(arg == "--seed" && hasValue) config.seed = atoi(argv[++i]);
+		else if(arg == "--run" && hasValue) run = atoll(argv[++i]);
+		else if(arg == "--legacy") config.legacyPatterns = true;
+		else if(arg == "--no-emulation") emulate = false;
+		else {
+			usage();
+			return -1;
+		}
+	}
+
+	//the chambers a muon can be found in, ME1/1a comes with ME1/1b
+	vector<unsigned int> chamberHashes;
+	for(unsigned int hash = 0; hash < CSCHelper::MAX_CHAMBER_HASH; hash++){
+		CSCHelper::ChamberId c = CSCHelper::unserialize(hash);
+		if(!CSCHelper::isValidChamber(c.station, c.ring, c.chamber, c.endcap)) continue;
+		if(c.station == 1 && c.ring == 4) continue;
+		chamberHashes.push_back(hash);
+	}
+	if(nChambers > chamberHashes.size()) nChambers = chamberHashes.size();
+
+	TFile* f = new TFile(outputfile.c_str(), "RECREATE");
+	if(!f || f->IsZombie()){
+		cout << "Error: can't open output file: " << outputfile << endl;
+		return -1;
+	}
+	TTree* t = new TTree("CSCDigiTree", "CSCDigiTree");
+
+	SyntheticEvents digis(config);
+	CSCInfo::Event evt;
+	CSCInfo::Muons muons;
+	CSCInfo::GenParticles gen;
+	CSCInfo::Segments segments;
+	CSCInfo::RecHits recHits;
+	CSCInfo::LCTs lcts;
+	CSCInfo::CLCTs clcts;
+	CSCInfo::ALCTs alcts;
+
+	TupleBranches branches(t);
+	branches.book(evt, GET_VARIABLE_NAME(EventNumber), evt.EventNumber, "l");
+	branches.book(evt, GET_VARIABLE_NAME(RunNumber), evt.RunNumber, "l");
+	branches.book(evt, GET_VARIABLE_NAME(LumiSection), evt.LumiSection, "I");
+	branches.book(evt, GET_VARIABLE_NAME(BXCrossing), evt.BXCrossing, "I");
+	branches.book(evt, GET_VARIABLE_NAME(NSegmentsInEvent), evt.NSegmentsInEvent, "I");
+
+	branches.book(muons, GET_VARIABLE_NAME(pt), muons.pt);
+	branches.book(muons, GET_VARIABLE_NAME(eta), muons.eta);
+	branches.book(muons, GET_VARIABLE_NAME(phi), muons.phi);
+	branches.book(muons, GET_VARIABLE_NAME(q), muons.q);
+	branches.book(muons, GET_VARIABLE_NAME(isGlobal), muons.isGlobal);
+	branches.book(muons, GET_VARIABLE_NAME(isTracker), muons.isTracker);
+
+	branches.book(gen, GET_VARIABLE_NAME(pdg_id), gen.pdg_id);
+	branches.book(gen, GET_VARIABLE_NAME(pt), gen.pt);
+	branches.book(gen, GET_VARIABLE_NAME(eta), gen.eta);
+	branches.book(gen, GET_VARIABLE_NAME(phi), gen.phi);
+	branches.book(gen, GET_VARIABLE_NAME(q), gen.q);
+
+	branches.book(segments, GET_VARIABLE_NAME(mu_id), segments.mu_id);
+	branches.book(segments, GET_VARIABLE_NAME(ch_id), segments.ch_id);
+	branches.book(segments, GET_VARIABLE_NAME(pos_x), segments.pos_x);
+	branches.book(segments, GET_VARIABLE_NAME(pos_y), segments.pos_y);
+	branches.book(segments, GET_VARIABLE_NAME(dxdz), segments.dxdz);
+	branches.book(segments, GET_VARIABLE_NAME(dydz), segments.dydz);
+	branches.book(segments, GET_VARIABLE_NAME(chisq), segments.chisq);
+	branches.book(segments, GET_VARIABLE_NAME(nHits), segments.nHits);
+
+	branches.book(recHits, GET_VARIABLE_NAME(mu_id), recHits.mu_id);
+	branches.book(recHits, GET_VARIABLE_NAME(ch_id), recHits.ch_id);
+	branches.book(recHits, GET_VARIABLE_NAME(lay), recHits.lay);
+	branches.book(recHits, GET_VARIABLE_NAME(pos_x), recHits.pos_x);
+	branches.book(recHits, GET_VARIABLE_NAME(pos_y), recHits.pos_y);
+	branches.book(recHits, GET_VARIABLE_NAME(e), recHits.e);
+	branches.book(recHits, GET_VARIABLE_NAME(max_adc), recHits.max_adc);
+
+	branches.book(lcts, GET_VARIABLE_NAME(ch_id), lcts.ch_id);
+	branches.book(lcts, GET_VARIABLE_NAME(quality), lcts.quality);
+	branches.book(lcts, GET_VARIABLE_NAME(pattern), lcts.pattern);
+	branches.book(lcts, GET_VARIABLE_NAME(bend), lcts.bend);
+	branches.book(lcts, GET_VARIABLE_NAME(keyWireGroup), lcts.keyWireGroup);
+	branches.book(lcts, GET_VARIABLE_NAME(keyHalfStrip), lcts.keyHalfStrip);
+	branches.book(lcts, GET_VARIABLE_NAME(bunchCross), lcts.bunchCross);
+
+	branches.book(clcts, GET_VARIABLE_NAME(ch_id), clcts.ch_id);
+	branches.book(clcts, GET_VARIABLE_NAME(isValid), clcts.isValid);
+	branches.book(clcts, GET_VARIABLE_NAME(quality), clcts.quality);
+	branches.book(clcts, GET_VARIABLE_NAME(pattern), clcts.pattern);
+	branches.book(clcts, GET_VARIABLE_NAME(stripType), clcts.stripType);
+	branches.book(clcts, GET_VARIABLE_NAME(bend), clcts.bend);
+	branches.book(clcts, GET_VARIABLE_NAME(halfStrip), clcts.halfStrip);
+	branches.book(clcts, GET_VARIABLE_NAME(CFEB), clcts.CFEB);
+	branches.book(clcts, GET_VARIABLE_NAME(BX), clcts.BX);
+	branches.book(clcts, GET_VARIABLE_NAME(trkNumber), clcts.trkNumber);
+	branches.book(clcts, GET_VARIABLE_NAME(keyStrip), clcts.keyStrip);
+
+	branches.book(alcts, GET_VARIABLE_NAME(ch_id), alcts.ch_id);
+	branches.book(alcts, GET_VARIABLE_NAME(isValid), alcts.isValid);
+	branches.book(alcts, GET_VARIABLE_NAME(quality), alcts.quality);
+	branches.book(alcts, GET_VARIABLE_NAME(accelerator), alcts.accelerator);
+	branches.book(alcts, GET_VARIABLE_NAME(collisionB), alcts.collisionB);
+	branches.book(alcts, GET_VARIABLE_NAME(keyWG), alcts.keyWG);
+	branches.book(alcts, GET_VARIABLE_NAME(BX), alcts.BX);
+	branches.book(alcts, GET_VARIABLE_NAME(trkNumber), alcts.trkNumber);
+	branches.book(alcts, GET_VARIABLE_NAME(fullBX), alcts.fullBX);
+
+	branches.branch(digis.comparators, GET_VARIABLE_NAME(ch_id), digis.comparators.ch_id);
+	branches.branch(digis.comparators, GET_VARIABLE_NAME(lay), digis.comparators.lay);
+	branches.branch(digis.comparators, GET_VARIABLE_NAME(strip), digis.comparators.strip);
+	branches.branch(digis.comparators, GET_VARIABLE_NAME(halfStrip), digis.comparators.halfStrip);
+	branches.branch(digis.comparators, GET_VARIABLE_NAME(bestTime), digis.comparators.bestTime);
+	branches.branch(digis.comparators, GET_VARIABLE_NAME(nTimeOn), digis.comparators.nTimeOn);
+
+	branches.branch(digis.wires, GET_VARIABLE_NAME(ch_id), digis.wires.ch_id);
+	branches.branch(digis.wires, GET_VARIABLE_NAME(group), digis.wires.group);
+	branches.branch(digis.wires, GET_VARIABLE_NAME(lay), digis.wires.lay);
+	branches.branch(digis.wires, GET_VARIABLE_NAME(timeBin), digis.wires.timeBin);
+	branches.branch(digis.wires, GET_VARIABLE_NAME(BX), digis.wires.BX);
+	branches.branch(digis.wires, GET_VARIABLE_NAME(timeBinWord), digis.wires.timeBinWord);
+
+	vector<CSCPattern>* oldPatterns = createOldPatterns();
+	ALCTConfig alctConfig;
+
+	//kinematics only, the digis come from their own generator
+	mt19937& random = digis.random();
+	uniform_real_distribution<float> flat(0., 1.);
+	exponential_distribution<float> ptSpectrum(1./20);
+
+	unsigned long long nMuons = 0;
+	unsigned long long nClcts = 0;
+	unsigned long long nAlcts = 0;
+	auto t1 = chrono::steady_clock::now();
+
+	for(unsigned int i = 0; i < nEvents; i++){
+		digis.clear();
+		branches.clear();
+
+		evt.EventNumber = i+1;
+		evt.RunNumber = run;
+		evt.LumiSection = i/1000 + 1;
+		evt.BXCrossing = uniform_int_distribution<int>(0, 3563)(random);
+
+		set<unsigned int> chosen;
+		while(chosen.size() < nChambers) chosen.insert(chamberHashes[uniform_int_distribution<unsigned int>(0, chamberHashes.size()-1)(random)]);
+		for(auto hash : chosen){
+			CSCHelper::ChamberId c = CSCHelper::unserialize(hash);
+			digis.addChamber(c.station, c.ring, c.endcap, c.chamber);
+		}
+
+		/***************************
+		 * MUONS AND THEIR SEGMENTS
+		 ***************************/
+
+		for(unsigned int imu = 0; imu < digis.muons.size(); imu++){
+			const SyntheticMuon& mu = digis.muons[imu];
+			const int chamberHash = CSCHelper::serialize(mu.station, mu.ring, mu.chamber, mu.endcap);
+			const int q = flat(random) < 0.5 ? -1 : 1;
+			const float pt = 3 + ptSpectrum(random);
+			//roughly where each ring sits in |eta|
+			const float etaRange[4][2] = {{1.6,2.4}, {1.2,1.7}, {0.9,1.2}, {2.0,2.4}};
+			const float* range = etaRange[(mu.ring-1)%4];
+			const float eta = (mu.endcap == 1 ? 1 : -1)*(range[0] + (range[1]-range[0])*flat(random));
+			const float phi = M_PI*(2*flat(random)-1);
+
+			muons.pt->push_back(pt);
+			muons.eta->push_back(eta);
+			muons.phi->push_back(phi);
+			muons.q->push_back(q);
+			muons.isGlobal->push_back(true);
+			muons.isTracker->push_back(true);
+
+			gen.pdg_id->push_back(-13*q);
+			gen.pt->push_back(pt);
+			gen.eta->push_back(eta);
+			gen.phi->push_back(phi);
+			gen.q->push_back(q);
+
+			double chi2 = 0;
+			for(unsigned int y = 0; y < NLAYERS; y++){
+				if(mu.strips[y] < 0) continue;
+				double residual = mu.strips[y] - (mu.position + mu.slope*((int)y-2));
+				chi2 += residual*residual*12*4; //half strip resolution
+				recHits.mu_id->push_back(imu);
+				recHits.ch_id->push_back(chamberHash);
+				recHits.lay->push_back(y+1);
+				recHits.pos_x->push_back(mu.strips[y]);
+				recHits.pos_y->push_back((mu.wireGroups[y] >= 0 ? mu.wireGroups[y] : mu.keyWireGroup) + 1);
+				recHits.e->push_back(100 + 400*flat(random));
+				recHits.max_adc->push_back(mu.bx);
+			}
+
+			//as a segment needs
+			if(mu.nHits < 3) continue;
+			segments.mu_id->push_back(imu);
+			segments.ch_id->push_back(chamberHash);
+			segments.pos_x->push_back(mu.position);
+			segments.pos_y->push_back(mu.keyWireGroup + 1);
+			segments.dxdz->push_back(mu.slope);
+			segments.dydz->push_back(mu.wireSlope);
+			segments.chisq->push_back(chi2);
+			segments.nHits->push_back(mu.nHits);
+		}
+		evt.NSegmentsInEvent = segments.mu_id->size();
+		nMuons += digis.muons.size();
+
+		/***************************
+		 * RECORDED LCTS
+		 ***************************/
+
+		for(auto hash : chosen){
+			if(!emulate) break;
+			CSCHelper::ChamberId c = CSCHelper::unserialize(hash);
+			unsigned int ST = c.station;
+			unsigned int RI = c.ring;
+			unsigned int CH = c.chamber;
+			unsigned int EC = c.endcap;
+
+			//clcts, as TMBEmulationTester emulates the TMB
+			ChamberHits compHits(ST, RI, EC, CH);
+			if(compHits.fill(digis.comparators)) return -1;
+			vector<CLCTCandidate*> emulatedCLCTs;
+			vector<CLCTCandidate*> recordedCLCTs;
+			if(!searchForMatch(compHits, oldPatterns, emulatedCLCTs, true)){
+				for(auto clct : emulatedCLCTs){
+					if(clct->layerCount() > 3 && recordedCLCTs.size() < 2) recordedCLCTs.push_back(clct);
+				}
+			}
+			for(unsigned int iclct = 0; iclct < recordedCLCTs.size(); iclct++){
+				const CLCTCandidate* clct = recordedCLCTs[iclct];
+				clcts.ch_id->push_back(hash);
+				clcts.isValid->push_back(1);
+				clcts.quality->push_back(clct->layerCount());
+				clcts.pattern->push_back(clct->patternId());
+				clcts.stripType->push_back(1);
+				clcts.bend->push_back(clct->_pattern.bendBit());
+				clcts.halfStrip->push_back(clct->keyHalfStrip() % 32);
+				clcts.CFEB->push_back(clct->keyHalfStrip() / 32);
+				clcts.BX->push_back(clct->_startTime);
+				clcts.trkNumber->push_back(iclct+1);
+				clcts.keyStrip->push_back(clct->keyHalfStrip());
+			}
+			nClcts += recordedCLCTs.size();
+
+			//alcts, as ALCTEmulationTreeCreator emulates the ALCT board
+			vector<ALCT_ChamberHits*> cvec;
+			for(int tbin = 0; tbin < 16; tbin++){
+				ALCT_ChamberHits* hits = new ALCT_ChamberHits(ST, RI, CH, EC);
+				hits->fill(digis.wires, tbin);
+				cvec.push_back(hits);
+			}
+			vector<vector<ALCTCandidate*>> end_vec;
+			vector<ALCTCandidate*> out_vec;
+			for(int tbin = 0; tbin < alctConfig.get_fifo_tbins()-alctConfig.get_drift_delay(); tbin++){
+				vector<ALCTCandidate*> row;
+				for(int j = 0; j < (int)cvec.front()->get_maxWi(); j++) row.push_back(new ALCTCandidate(j,1));
+				end_vec.push_back(row);
+			}
+			trig_and_find(cvec, alctConfig, end_vec);
+			ghostBuster(end_vec, alctConfig);
+			extract_sort_cut(end_vec, out_vec);
+			for(auto alct : out_vec){
+				alcts.ch_id->push_back(hash);
+				alcts.isValid->push_back(1);
+				alcts.quality->push_back(alct->get_quality());
+				alcts.accelerator->push_back(0);
+				alcts.collisionB->push_back(1);
+				alcts.keyWG->push_back(alct->get_kwg());
+				alcts.BX->push_back(alct->get_first_bx()-5);
+				alcts.trkNumber->push_back(alct->get_tracknumber());
+				alcts.fullBX->push_back(alct->get_first_bx()-5);
+			}
+			nAlcts += out_vec.size();
+
+			//correlated, the best clct with the best alct, and the second with the second
+			vector<ALCTCandidate*> recordedALCTs;
+			for(auto alct : out_vec){
+				if(recordedALCTs.size() < 2 && alct->get_tracknumber() == (int)recordedALCTs.size()+1) recordedALCTs.push_back(alct);
+			}
+			for(unsigned int ilct = 0; ilct < recordedCLCTs.size() && ilct < recordedALCTs.size(); ilct++){
+				lcts.ch_id->push_back(hash);
+				lcts.quality->push_back(recordedCLCTs[ilct]->layerCount());
+				lcts.pattern->push_back(recordedCLCTs[ilct]->patternId());
+				lcts.bend->push_back(recordedCLCTs[ilct]->_pattern.bendBit());
+				lcts.keyWireGroup->push_back(recordedALCTs[ilct]->get_kwg());
+				lcts.keyHalfStrip->push_back(recordedCLCTs[ilct]->keyHalfStrip());
+				lcts.bunchCross->push_back(recordedALCTs[ilct]->get_first_bx()-5);
+			}
+
+			for(auto clct : emulatedCLCTs) delete clct;
+			wipe(out_vec);
+			wipe(cvec);
+		}
+
+		t->Fill();
+		if(!((i+1)%10000)) printf("%3.2f%% Done --- Generated %u Events\n", 100.*(i+1)/nEvents, i+1);
+	}
+
+	f->cd();
+	t->Write();
+	f->Close();
+	delete f;
+	delete oldPatterns;
+
+	auto t2 = chrono::steady_clock::now();
+	printf("Wrote %u events, %u chambers each, %llu muons, %llu clcts, %llu alcts to file: %s\n",
+			nEvents, nChambers, nMuons, nClcts, nAlcts, outputfile.c_str());
+	printf("Time elapsed: %.1f s\n", chrono::duration<double>(t2-t1).count());
+	return 0;
+}
@@ -22,6 +22,8 @@
 #include <algorithm>
 #include <chrono>
 #include <time.h>
+#include <stdlib.h>
+#include <unistd.h>
 
 
 #include "../include/CSCConstants.h"
@@ -34,6 +36,10 @@
 #include "../include/LUTClasses.h"
 
 #include "../include/TMBEmulationTester.h"
+#include "../include/StageTimers.h"
+#include "../include/CandidateMatcher.h"
+#include "../include/MismatchLog.h"
+#include "../include/EmulationCache.h"
 
 using namespace std;
 
@@ -42,326 +48,456 @@ int main(int argc, char* argv[]){
 	return p.main(argc,argv);
 }
 
-int TMBEmulationTester::run(string inputfile, string outputfile, int start, int end) {
-
-	//TODO: change everythign printf -> cout
-	auto t1 = std::chrono::high_resolution_clock::now();
+namespace {
+
+enum CLCT_EMUL_MATCH {
+	real,
+	emulated,
+	noEmulated,
+	noReal,
+	match,
+	perfectMatch,
+	MATCH_SIZE
+};
+
+
+enum CLCT_OFFSET_ENUM {
+	anyOffset, //strips
+	offset2,
+	offset1,
+	noOffset,
+	OFFSET_SIZE
+};
+
+enum CLCT_PATTERN_ENUM {
+	anyPattern,
+	samePattern,
+	sameLayers,
+	PATTERN_SIZE,
+};
+
+/* @brief Appends the mismatches of a log to another, -1 if it is cut short
+ */
+int appendMismatches(const string& part, MismatchLogWriter& out){
+	MismatchLogReader in;
+	if(in.open(part)) return -1;
+	Mismatch m;
+	int status = 0;
+	while(!(status = in.next(m))){
+		if(out.write(m)) return -1;
+	}
+	if(status < 0) cout << "Error: mismatch log is cut short: " << part << endl;
+	return status < 0 ? -1 : 0;
+}
 
-	cout << "Running over file: " << inputfile << endl;
+}
 
+TMBEmulationTester::TMBEmulationTester() :
+	_ownsShared(false),
+	_oldPatterns(0),
+	_cache(0),
+	_search(0),
+	_evt(0),
+	_clcts(0),
+	_comparators(0),
+	_emulationMatching(0),
+	_emulationPattVsOffset(0),
+	_emulationStripDiff(0),
+	_emulatedLayerCount(0),
+	_realLayerCount(0),
+	_emulatedMultiplicity(0),
+	_realMultiplicity(0),
+	_clct0(0),
+	_matchClct0(0),
+	_pmatchClct0(0),
+	_matcher(CandidateMatcher::IN_ORDER)
+{
+}
 
-	TFile* f = TFile::Open(inputfile.c_str());
-	if(!f) throw "Can't open file";
+TMBEmulationTester::~TMBEmulationTester(){
+	delete _evt;
+	delete _clcts;
+	delete _comparators;
+	delete _emulationMatching;
+	delete _emulationPattVsOffset;
+	delete _emulationStripDiff;
+	delete _emulatedLayerCount;
+	delete _realLayerCount;
+	delete _emulatedMultiplicity;
+	delete _realMultiplicity;
+
+	_mismatchLog.close();
+	for(auto& part : _mismatchParts) remove(part.c_str());
+
+	if(_ownsShared){
+		delete _oldPatterns;
+		delete _cache;
+		delete _search;
+	}
+}
 
-	TTree* t =  (TTree*)f->Get("CSCDigiTree");
-	if(!t) throw "Can't find tree";
+/* @brief Makes the patterns, done once and shared by all the workers
+ */
+int TMBEmulationTester::setup() {
+	_ownsShared = true;
 
 	//
-	// SET INPUT BRANCHES
+	// MAKE ALL THE PATTERNS
 	//
 
-	CSCInfo::Event evt(t);
-	CSCInfo::Muons muons(t);
-	CSCInfo::Segments segments(t);
-	CSCInfo::RecHits recHits(t);
-	CSCInfo::LCTs lcts(t);
-	CSCInfo::CLCTs clcts(t);
-	CSCInfo::Comparators comparators(t);
+	//vector<CSCPattern>* newPatterns = createNewPatterns();
+	_oldPatterns = createOldPatterns();
+	_search = new CachedCLCTSearch(_oldPatterns, true);
 
-	//
-	// MAKE ALL THE PATTERNS
-	//
+	//clcts of a previous run over the same events, if given one
+	if(!_emulationCache.empty()){
+		_cache = new EmulationCache();
+		if(_cache->open(_emulationCache)) return -1;
+	}
+	return 0;
+}
 
+Processor* TMBEmulationTester::makeWorker() const {
+	TMBEmulationTester* worker = new TMBEmulationTester();
+	worker->_oldPatterns = _oldPatterns;
+	worker->_cache = _cache;
+	worker->_search = _search;
+	return worker;
+}
 
-	//vector<CSCPattern>* newPatterns = createNewPatterns();
-	vector<CSCPattern>* oldPatterns = createOldPatterns();
+/* @brief Sets the input branches, books the histograms and opens this worker's part of the mismatch log
+ */
+int TMBEmulationTester::beginWorker(TTree* t) {
 
 	//
-	// TREE ITERATION
+	// SET INPUT BRANCHES
 	//
 
-	enum CLCT_EMUL_MATCH {
-		real,
-		emulated,
-		noEmulated,
-		noReal,
-		match,
-		perfectMatch,
-		MATCH_SIZE
-	};
-
-
-	enum CLCT_OFFSET_ENUM {
-		anyOffset, //strips
-		offset2,
-		offset1,
-		noOffset,
-		OFFSET_SIZE
-	};
-
-	enum CLCT_PATTERN_ENUM {
-		anyPattern,
-		samePattern,
-		sameLayers,
-		PATTERN_SIZE,
-	};
-
-	TH1F* emulationMatching = new TH1F("emulationMatching", "emulationMatching; ; CLCTs",MATCH_SIZE,0,MATCH_SIZE);
-	emulationMatching->GetXaxis()->SetBinLabel(real+1, "real");
-	emulationMatching->GetXaxis()->SetBinLabel(emulated+1, "emulated");
-	emulationMatching->GetXaxis()->SetBinLabel(emulated+1, "emulated");
-	emulationMatching->GetXaxis()->SetBinLabel(noEmulated+1, "noEmulated");
-	emulationMatching->GetXaxis()->SetBinLabel(noReal+1, "noReal");
-	emulationMatching->GetXaxis()->SetBinLabel(match+1, "match");
-	emulationMatching->GetXaxis()->SetBinLabel(perfectMatch+1, "perfectMatch");
-
-	TH2F* emulationPattVsOffset = new TH2F("emulationPattVsOffset", "emulationPattVsOffset;;;", OFFSET_SIZE, 0,OFFSET_SIZE,PATTERN_SIZE,0,PATTERN_SIZE);
-	emulationPattVsOffset->GetXaxis()->SetBinLabel(anyOffset+1,"anyOffset");
-	emulationPattVsOffset->GetXaxis()->SetBinLabel(offset2+1,"Offset <= 2 HS");
-	emulationPattVsOffset->GetXaxis()->SetBinLabel(offset1+1,"Offset <= 1 HS");
-	emulationPattVsOffset->GetXaxis()->SetBinLabel(noOffset+1,"No Offset");
-
-	emulationPattVsOffset->GetYaxis()->SetBinLabel(anyPattern+1,"anyPattern");
-	emulationPattVsOffset->GetYaxis()->SetBinLabel(samePattern+1,"samePattern");
-	emulationPattVsOffset->GetYaxis()->SetBinLabel(sameLayers+1,"sameLayers");
-
-
-	TH1F* emulationStripDiff = new TH1F("emulationStripDiff", "emulationStripDiff; Real - Emulated [HS]; CLCTs", 10,-5,5);
-	TH1F* emulatedLayerCount = new TH1F("emulatedLayerCount","emulatedLayerCount; Layers; CLCTs",6,1,7);
-	TH1F* realLayerCount = new TH1F("realLayerCount","realLayerCount; Layers; CLCTs",6,1,7);
-	TH1F* emulatedMultiplicity = new TH1F("emulatedMultiplicity", "emulatedMultiplicity; CLCT Multiplicity; CLCTs", 10,0,10);
-	TH1F* realMultiplicity = new TH1F("realMultiplicity", "realMultiplicity; CLCT Multiplicity; CLCTs", 10,0,10);
-
-	//how many times we match to the first clct
-	unsigned int clct0 = 0;
-	unsigned int match_clct0 = 0;
-	unsigned int pmatch_clct0 = 0;
-
-	if(end > t->GetEntries() || end < 0) end = t->GetEntries();
-
-	printf("Starting Event = %i, Ending Event = %i\n", start, end);
-
-	for(int i = start; i < end; i++) {
-		if(!(i%10000)) printf("%3.2f%% Done --- Processed %u Events\n", 100.*(i-start)/(end-start), i-start);
-
-		t->GetEntry(i);
-		/*
-		if(evt.EventNumber != 648972225
-				&& evt.EventNumber != 640297869
-				&& evt.EventNumber != 650469080
-				) continue;
-		*/
-		//
-		//Iterate through all possible chambers
-		//
-		for(int chamberHash = 0; chamberHash < (int)CSCHelper::MAX_CHAMBER_HASH; chamberHash++){
-			CSCHelper::ChamberId c = CSCHelper::unserialize(chamberHash);
+	//only read what is used below
+	CSCInfo::disableAll(t);
+	_evt = new CSCInfo::Event(t);
+	_clcts = new CSCInfo::CLCTs(t);
+	_comparators = new CSCInfo::Comparators(t);
+
+	_evt->select({"RunNumber", "EventNumber"});
+	_clcts->select({"ch_id", "keyStrip", "pattern", "quality", "BX"});
+	_comparators->select({"ch_id", "lay", "strip", "halfStrip", "bestTime"});
+
+	_emulationMatching = new TH1F("emulationMatching", "emulationMatching; ; CLCTs",MATCH_SIZE,0,MATCH_SIZE);
+	_emulationMatching->GetXaxis()->SetBinLabel(real+1, "real");
+	_emulationMatching->GetXaxis()->SetBinLabel(emulated+1, "emulated");
+	_emulationMatching->GetXaxis()->SetBinLabel(noEmulated+1, "noEmulated");
+	_emulationMatching->GetXaxis()->SetBinLabel(noReal+1, "noReal");
+	_emulationMatching->GetXaxis()->SetBinLabel(match+1, "match");
+	_emulationMatching->GetXaxis()->SetBinLabel(perfectMatch+1, "perfectMatch");
+
+	_emulationPattVsOffset = new TH2F("emulationPattVsOffset", "emulationPattVsOffset;;;", OFFSET_SIZE, 0,OFFSET_SIZE,PATTERN_SIZE,0,PATTERN_SIZE);
+	_emulationPattVsOffset->GetXaxis()->SetBinLabel(anyOffset+1,"anyOffset");
+	_emulationPattVsOffset->GetXaxis()->SetBinLabel(offset2+1,"Offset <= 2 HS");
+	_emulationPattVsOffset->GetXaxis()->SetBinLabel(offset1+1,"Offset <= 1 HS");
+	_emulationPattVsOffset->GetXaxis()->SetBinLabel(noOffset+1,"No Offset");
+
+	_emulationPattVsOffset->GetYaxis()->SetBinLabel(anyPattern+1,"anyPattern");
+	_emulationPattVsOffset->GetYaxis()->SetBinLabel(samePattern+1,"samePattern");
+	_emulationPattVsOffset->GetYaxis()->SetBinLabel(sameLayers+1,"sameLayers");
+
+
+	_emulationStripDiff = new TH1F("emulationStripDiff", "emulationStripDiff; Real - Emulated [HS]; CLCTs", 10,-5,5);
+	_emulatedLayerCount = new TH1F("emulatedLayerCount","emulatedLayerCount; Layers; CLCTs",6,1,7);
+	_realLayerCount = new TH1F("realLayerCount","realLayerCount; Layers; CLCTs",6,1,7);
+	_emulatedMultiplicity = new TH1F("emulatedMultiplicity", "emulatedMultiplicity; CLCT Multiplicity; CLCTs", 10,0,10);
+	_realMultiplicity = new TH1F("realMultiplicity", "realMultiplicity; CLCT Multiplicity; CLCTs", 10,0,10);
+
+	//recorded clcts without a perfect match, joined next to the output in writeOutput
+	const char* tmpdir = getenv("TMPDIR");
+	string part = string(tmpdir && *tmpdir ? tmpdir : "/tmp") + "/mismatches_XXXXXX";
+	int fd = mkstemp(&part[0]);
+	if(fd < 0){
+		cout << "Error: can't make a part of the mismatch log in: " << part << endl;
+		return -1;
+	}
+	::close(fd);
+	_mismatchParts.push_back(part);
+	return _mismatchLog.open(part);
+}
 
-			unsigned int EC = c.endcap;
-			unsigned int ST = c.station;
-			unsigned int RI = c.ring;
-			unsigned int CH = c.chamber;
+int TMBEmulationTester::processEntry(long long entry) {
+	/*
+	if(_evt->EventNumber != 648972225
+			&& _evt->EventNumber != 640297869
+			&& _evt->EventNumber != 650469080
+			) continue;
+	*/
+	//
+	//Iterate through all possible chambers
+	//
+	for(int chamberHash = 0; chamberHash < (int)CSCHelper::MAX_CHAMBER_HASH; chamberHash++){
+		CSCHelper::ChamberId c = CSCHelper::unserialize(chamberHash);
 
-			if(!CSCHelper::isValidChamber(ST,RI,CH,EC)) continue;
-			bool me11a = (ST == 1 && RI == 4);
-			bool me11b = (ST == 1 && RI == 1);
+		unsigned int EC = c.endcap;
+		unsigned int ST = c.station;
+		unsigned int RI = c.ring;
+		unsigned int CH = c.chamber;
 
-			//
-			// Emulate the TMB to find all the CLCTs
-			//
+		if(!CSCHelper::isValidChamber(ST,RI,CH,EC)) continue;
+		bool me11a = (ST == 1 && RI == 4);
+		bool me11b = (ST == 1 && RI == 1);
 
-			ChamberHits compHits(ST, RI, EC, CH);
+		//
+		// Emulate the TMB to find all the CLCTs
+		//
 
-			if(compHits.fill(comparators)) return -1;
+		ChamberHits compHits(ST, RI, EC, CH);
 
-			vector<CLCTCandidate*> emulatedCLCTs;
+		{
+			STAGE_TIMER("hit filling");
+			if(compHits.fill(*_comparators)) return -1;
+		}
 
-			if(searchForMatch(compHits,oldPatterns, emulatedCLCTs,true)){
-				emulatedCLCTs.clear();
-				//cout << "Something broke" << endl;
-				//return;
+		vector<CLCTCandidate*> emulatedCLCTs;
 
-				continue;
-			}
+		bool multipleInOneLayer = false;
+		{
+			STAGE_TIMER("clct search");
+			multipleInOneLayer = _search->find(_cache, _evt->RunNumber, _evt->EventNumber, compHits, emulatedCLCTs, &_cacheLookups);
+		}
+		if(multipleInOneLayer){
+			emulatedCLCTs.clear();
+			//cout << "Something broke" << endl;
+			//return;
 
+			continue;
+		}
 
-			//remove 3 layer emulated clcts from chambers that don't
-			bool threeLayerChamber = (me11a || me11b) && CH == 11 && EC ==1;
-			if(!threeLayerChamber) {
-				for(unsigned int iemu =0; iemu < emulatedCLCTs.size(); iemu++){
-					if(emulatedCLCTs.at(iemu)->layerCount() == 3) {
-						emulatedCLCTs.erase(emulatedCLCTs.begin()+iemu);
-						iemu--;
-					}
+
+		//remove 3 layer emulated clcts from chambers that don't
+		bool threeLayerChamber = (me11a || me11b) && CH == 11 && EC ==1;
+		if(!threeLayerChamber) {
+			for(unsigned int iemu =0; iemu < emulatedCLCTs.size(); iemu++){
+				if(emulatedCLCTs.at(iemu)->layerCount() == 3) {
+					emulatedCLCTs.erase(emulatedCLCTs.begin()+iemu);
+					iemu--;
 				}
 			}
+		}
 
-			//only take two leading clcts
-			while(emulatedCLCTs.size() > 2) emulatedCLCTs.pop_back();
-
-
-			for(auto emu : emulatedCLCTs){
-				emulatedLayerCount->Fill(emu->layerCount());
-			}
+		//only take two leading clcts
+		while(emulatedCLCTs.size() > 2) emulatedCLCTs.pop_back();
 
 
-			vector<unsigned int> matchedIndices;
+		for(auto emu : emulatedCLCTs){
+			_emulatedLayerCount->Fill(emu->layerCount());
+		}
 
-			//among the matches
-			vector<unsigned int> match_offsetLE2; //less than or equal to 2 [hs]
-			vector<unsigned int> match_offsetLE1;
-			vector<unsigned int> match_noOffset;
 
-			vector<unsigned int> match_samePattern;
-			vector<unsigned int> match_sameLayers;
+		vector<unsigned int> matchedIndices;
 
-			vector<unsigned int> perfectMatches;
+		//among the matches, by emulated index
+		vector<bool> match_offsetLE2(emulatedCLCTs.size(), false); //less than or equal to 2 [hs]
+		vector<bool> match_offsetLE1(emulatedCLCTs.size(), false);
+		vector<bool> match_noOffset(emulatedCLCTs.size(), false);
 
+		vector<bool> match_samePattern(emulatedCLCTs.size(), false);
+		vector<bool> match_sameLayers(emulatedCLCTs.size(), false);
 
-			unsigned int clctsInChamber = 0;
+		vector<unsigned int> perfectMatches;
 
-			//
-			// Iterate over real clcts
-			//
-			for(unsigned int iclct=0; iclct < clcts.size(); iclct++){
-				int clctHash = clcts.ch_id->at(iclct);
-				if(clctHash != chamberHash) continue;
-				clctsInChamber++;
-				if(clctsInChamber == 1) clct0++; //hope that the first one is ordered correctly...
-				realLayerCount->Fill(clcts.quality->at(iclct));
+		//real clcts in this chamber, in the order they were recorded
+		vector<unsigned int> realCLCTs;
+		for(unsigned int iclct=0; iclct < _clcts->size(); iclct++){
+			if(_clcts->ch_id->at(iclct) == chamberHash) realCLCTs.push_back(iclct);
+		}
 
-				float clctHSPos = clcts.keyStrip->at(iclct); //key strip is in units of half strips...
+		//each real clct takes the closest emulated one not already taken
+		vector<int> closestEmus;
+		{
+			STAGE_TIMER("matching");
+			_matcher.match(realCLCTs.size(), [&](unsigned int i){
+				float clctHSPos = _clcts->keyStrip->at(realCLCTs[i]); //key strip is in units of half strips...
 				if(me11a) clctHSPos -= 32*4;
+				return MatchKey(clctHSPos);
+			}, emulatedCLCTs.size(), [&](unsigned int i){
+				return MatchKey(emulatedCLCTs[i]->keyHalfStrip());
+			}, closestEmus);
+		}
 
-				int closestEmu = -1;
-				float minDistanceToCLCT = 1e5;
-				for(unsigned int iemu=0; iemu < emulatedCLCTs.size(); iemu++){
-					if(find(matchedIndices.begin(), matchedIndices.end(), iemu) != matchedIndices.end()) continue;
-					float distance = clctHSPos - emulatedCLCTs.at(iemu)->keyHalfStrip();
-					if(abs(distance) <  abs(minDistanceToCLCT)){
-						minDistanceToCLCT = distance;
-						closestEmu = iemu;
-					}
-				}
+		unsigned int clctsInChamber = 0;
 
-				bool perfMatch = false; //if we found a perfect match
-				if(closestEmu != -1){ //found a match
-					matchedIndices.push_back(closestEmu);
-					emulationStripDiff->Fill(minDistanceToCLCT);
-					if(clctsInChamber == 1) match_clct0++;
-
-					if(abs(minDistanceToCLCT) <= 2) match_offsetLE2.push_back(closestEmu);
-					if(abs(minDistanceToCLCT) <= 1) match_offsetLE1.push_back(closestEmu);
-					if(abs(minDistanceToCLCT) == 0) match_noOffset.push_back(closestEmu);
-
-					if(clcts.pattern->at(iclct) == emulatedCLCTs.at(closestEmu)->patternId()){
-						match_samePattern.push_back(closestEmu);
-						if(clcts.quality->at(iclct) == emulatedCLCTs.at(closestEmu)->layerCount()){
-							match_sameLayers.push_back(closestEmu);
-							if(minDistanceToCLCT == 0) {
-								perfectMatches.push_back(closestEmu);
-								perfMatch = true;
-								if(clctsInChamber==1) pmatch_clct0++;
-							}
+		//
+		// Iterate over real clcts
+		//
+		for(unsigned int ireal=0; ireal < realCLCTs.size(); ireal++){
+			unsigned int iclct = realCLCTs[ireal];
+			STAGE_TIMER("matching");
+			clctsInChamber++;
+			if(clctsInChamber == 1) _clct0++; //hope that the first one is ordered correctly...
+			_realLayerCount->Fill(_clcts->quality->at(iclct));
+
+			float clctHSPos = _clcts->keyStrip->at(iclct); //key strip is in units of half strips...
+			if(me11a) clctHSPos -= 32*4;
+
+			int closestEmu = closestEmus[ireal];
+			float minDistanceToCLCT = closestEmu != -1 ? clctHSPos - emulatedCLCTs.at(closestEmu)->keyHalfStrip() : 1e5;
+
+			bool perfMatch = false; //if we found a perfect match
+			if(closestEmu != -1){ //found a match
+				matchedIndices.push_back(closestEmu);
+				_emulationStripDiff->Fill(minDistanceToCLCT);
+				if(clctsInChamber == 1) _matchClct0++;
+
+				if(abs(minDistanceToCLCT) <= 2) match_offsetLE2[closestEmu] = true;
+				if(abs(minDistanceToCLCT) <= 1) match_offsetLE1[closestEmu] = true;
+				if(abs(minDistanceToCLCT) == 0) match_noOffset[closestEmu] = true;
+
+				if(_clcts->pattern->at(iclct) == emulatedCLCTs.at(closestEmu)->patternId()){
+					match_samePattern[closestEmu] = true;
+					if(_clcts->quality->at(iclct) == emulatedCLCTs.at(closestEmu)->layerCount()){
+						match_sameLayers[closestEmu] = true;
+						if(minDistanceToCLCT == 0) {
+							perfectMatches.push_back(closestEmu);
+							perfMatch = true;
+							if(clctsInChamber==1) _pmatchClct0++;
 						}
-
 					}
-				}
-				if(!perfMatch){
-					cout << "~~~ No Perfect Match Found ~~~ " << endl;
-					compHits.print();
-					cout << "Real CLCT: pat: " << (int)clcts.pattern->at(iclct) << " layers: "<< clcts.quality->at(iclct)<< " pos: "<< clctHSPos <<" [hs]"<< endl;
-					if(closestEmu != -1) {
-						cout << "Emulated: pat: " << emulatedCLCTs.at(closestEmu)->patternId() << " layers: " <<  emulatedCLCTs.at(closestEmu)->layerCount() <<
-								" pos: " << emulatedCLCTs.at(closestEmu)->keyHalfStrip() << " [hs]" << endl;
-						printPattern(emulatedCLCTs.at(closestEmu)->_pattern);
-					}else{
-						cout << "No matching emu" << endl;
-					}
-					cout << "Using emulated CLCT: " << closestEmu+1 << " / " << emulatedCLCTs.size() << endl;
 
 				}
 			}
+			if(!perfMatch){
+				//logged, print with ./MismatchPrinter
+				STAGE_TIMER("mismatch logging");
+				Mismatch mismatch;
+				mismatch.entry = entry;
+				mismatch.run = _evt->RunNumber;
+				mismatch.event = _evt->EventNumber;
+				mismatch.chamberHash = chamberHash;
+				mismatch.recorded = EmulatedCandidate(clctHSPos, _clcts->pattern->at(iclct), -1,
+						_clcts->quality->at(iclct), _clcts->BX->at(iclct));
+				mismatch.closest = closestEmu;
+				for(auto emu : emulatedCLCTs) mismatch.emulated.push_back(Emulators::candidate(*emu));
+				mismatch.setHits(compHits);
+				if(_mismatchLog.write(mismatch)) return -1;
+			}
+		}
 
-			if(!emulatedCLCTs.size() && !clctsInChamber) continue;
+		if(!emulatedCLCTs.size() && !clctsInChamber) continue;
 
 
-			//go through all the matches and check out their characteristics
-			for(unsigned int imatch=0; imatch < matchedIndices.size(); imatch++){
-				unsigned int id = matchedIndices.at(imatch);
+		//go through all the matches and check out their characteristics
+		for(unsigned int imatch=0; imatch < matchedIndices.size(); imatch++){
+			unsigned int id = matchedIndices.at(imatch);
 
-				bool matchLE2 = find(match_offsetLE2.begin(), match_offsetLE2.end(), id) != match_offsetLE2.end();
-				bool matchLE1 = find(match_offsetLE1.begin(), match_offsetLE1.end(), id) != match_offsetLE1.end();
-				bool matchNoOffset = find(match_noOffset.begin(), match_noOffset.end(), id) != match_noOffset.end();
-				bool matchSamePattern= find(match_samePattern.begin(), match_samePattern.end(), id) != match_samePattern.end();
-				bool matchSameLayers=find(match_sameLayers.begin(), match_sameLayers.end(), id) != match_sameLayers.end();
+			bool matchLE2 = match_offsetLE2[id];
+			bool matchLE1 = match_offsetLE1[id];
+			bool matchNoOffset = match_noOffset[id];
+			bool matchSamePattern = match_samePattern[id];
+			bool matchSameLayers = match_sameLayers[id];
 
-				emulationPattVsOffset->Fill(anyOffset,anyPattern, 1);
-				emulationPattVsOffset->Fill(anyOffset,samePattern, matchSamePattern);
-				emulationPattVsOffset->Fill(anyOffset,sameLayers, matchSameLayers);
-				emulationPattVsOffset->Fill(offset2,anyPattern, matchLE2);
-				emulationPattVsOffset->Fill(offset2,samePattern, matchLE2*matchSamePattern);
-				emulationPattVsOffset->Fill(offset2,sameLayers, matchLE2*matchSameLayers);
-				emulationPattVsOffset->Fill(offset1,anyPattern, matchLE1);
-				emulationPattVsOffset->Fill(offset1,samePattern, matchLE1*matchSamePattern);
-				emulationPattVsOffset->Fill(offset1,sameLayers, matchLE1*matchSameLayers);
-				emulationPattVsOffset->Fill(noOffset,anyPattern, matchNoOffset);
-				emulationPattVsOffset->Fill(noOffset,samePattern, matchNoOffset*matchSamePattern);
-				emulationPattVsOffset->Fill(noOffset,sameLayers, matchNoOffset*matchSameLayers);
+			STAGE_TIMER("histogram filling");
 
-			}
+			_emulationPattVsOffset->Fill(anyOffset,anyPattern, 1);
+			_emulationPattVsOffset->Fill(anyOffset,samePattern, matchSamePattern);
+			_emulationPattVsOffset->Fill(anyOffset,sameLayers, matchSameLayers);
+			_emulationPattVsOffset->Fill(offset2,anyPattern, matchLE2);
+			_emulationPattVsOffset->Fill(offset2,samePattern, matchLE2*matchSamePattern);
+			_emulationPattVsOffset->Fill(offset2,sameLayers, matchLE2*matchSameLayers);
+			_emulationPattVsOffset->Fill(offset1,anyPattern, matchLE1);
+			_emulationPattVsOffset->Fill(offset1,samePattern, matchLE1*matchSamePattern);
+			_emulationPattVsOffset->Fill(offset1,sameLayers, matchLE1*matchSameLayers);
+			_emulationPattVsOffset->Fill(noOffset,anyPattern, matchNoOffset);
+			_emulationPattVsOffset->Fill(noOffset,samePattern, matchNoOffset*matchSamePattern);
+			_emulationPattVsOffset->Fill(noOffset,sameLayers, matchNoOffset*matchSameLayers);
 
-			emulationMatching->Fill(real, clctsInChamber);
-			emulationMatching->Fill(emulated, emulatedCLCTs.size());
-			emulationMatching->Fill(noEmulated, clctsInChamber - matchedIndices.size());
-			emulationMatching->Fill(noReal, emulatedCLCTs.size() - matchedIndices.size());
-			emulationMatching->Fill(match, matchedIndices.size());
-			emulationMatching->Fill(perfectMatch,perfectMatches.size());
+		}
 
-			emulatedMultiplicity->Fill(emulatedCLCTs.size());
-			realMultiplicity->Fill(clctsInChamber);
+		STAGE_TIMER("histogram filling");
+		_emulationMatching->Fill(real, clctsInChamber);
+		_emulationMatching->Fill(emulated, emulatedCLCTs.size());
+		_emulationMatching->Fill(noEmulated, clctsInChamber - matchedIndices.size());
+		_emulationMatching->Fill(noReal, emulatedCLCTs.size() - matchedIndices.size());
+		_emulationMatching->Fill(match, matchedIndices.size());
+		_emulationMatching->Fill(perfectMatch,perfectMatches.size());
+
+		_emulatedMultiplicity->Fill(emulatedCLCTs.size());
+		_realMultiplicity->Fill(clctsInChamber);
 
-		}
 	}
+	return 0;
+}
+
+/* @brief Adds the histograms and counters of another worker, which ran over
+ * the entries following this one's, and takes over its parts of the mismatch log
+ */
+int TMBEmulationTester::mergeWorker(Processor* worker) {
+	TMBEmulationTester* w = dynamic_cast<TMBEmulationTester*>(worker);
+	if(!w || w->_mismatchLog.close()) return -1;
+
+	_emulationMatching->Add(w->_emulationMatching);
+	_emulationPattVsOffset->Add(w->_emulationPattVsOffset);
+	_emulationStripDiff->Add(w->_emulationStripDiff);
+	_emulatedLayerCount->Add(w->_emulatedLayerCount);
+	_realLayerCount->Add(w->_realLayerCount);
+	_emulatedMultiplicity->Add(w->_emulatedMultiplicity);
+	_realMultiplicity->Add(w->_realMultiplicity);
+
+	_clct0 += w->_clct0;
+	_matchClct0 += w->_matchClct0;
+	_pmatchClct0 += w->_pmatchClct0;
+	_cacheLookups.hits += w->_cacheLookups.hits;
+	_cacheLookups.misses += w->_cacheLookups.misses;
+
+	_mismatchParts.insert(_mismatchParts.end(), w->_mismatchParts.begin(), w->_mismatchParts.end());
+	w->_mismatchParts.clear();
+	return 0;
+}
 
+int TMBEmulationTester::writeOutput(const string& outputfile) {
 	TFile * outF = new TFile(outputfile.c_str(),"RECREATE");
 	if(!outF){
 		printf("Failed to open output file: %s\n", outputfile.c_str());
 		return -1;
 	}
 	outF->cd();
-	emulationMatching->Write();
-	emulationPattVsOffset->Write();
-	emulationStripDiff->Write();
-	emulatedLayerCount->Write();
-	realLayerCount->Write();
-	emulatedMultiplicity->Write();
-	realMultiplicity->Write();
+	_emulationMatching->Write();
+	_emulationPattVsOffset->Write();
+	_emulationStripDiff->Write();
+	_emulatedLayerCount->Write();
+	_realLayerCount->Write();
+	_emulatedMultiplicity->Write();
+	_realMultiplicity->Write();
 	outF->Close();
 
-	unsigned int realCLCTs = emulationMatching->GetBinContent(1);
-	unsigned int matches = emulationMatching->GetBinContent(5);
-	unsigned int perfectMatches = emulationMatching->GetBinContent(6);
+	unsigned int realCLCTs = _emulationMatching->GetBinContent(1);
+	unsigned int matches = _emulationMatching->GetBinContent(5);
+	unsigned int perfectMatches = _emulationMatching->GetBinContent(6);
 
 	cout << "-- All CLCTs --" << endl;
 	cout << "        Matches: " << matches << " / " << realCLCTs << " = " << 1.*matches/realCLCTs << endl;
 	cout << "Perfect Matches: " << perfectMatches << " / " << realCLCTs << " = " << 1.*perfectMatches/realCLCTs << endl;
 
 	cout << "-- First CLCT --" << endl;
-	cout << "        Matches: " << match_clct0 << " / " << clct0 << " = " << 1.*match_clct0/clct0 << endl;
-	cout << "Perfect Matches: " << pmatch_clct0 << " / " << clct0 << " = " << 1.*pmatch_clct0/clct0 << endl;
+	cout << "        Matches: " << _matchClct0 << " / " << _clct0 << " = " << 1.*_matchClct0/_clct0 << endl;
+	cout << "Perfect Matches: " << _pmatchClct0 << " / " << _clct0 << " = " << 1.*_pmatchClct0/_clct0 << endl;
 
 
 	cout << "Wrote to file: " << outputfile << endl;
 
-	auto t2 = std::chrono::high_resolution_clock::now();
-	cout << "Time elapsed: " << chrono::duration_cast<chrono::seconds>(t2-t1).count() << " s" << endl;
+	//every worker is done with it
+	if(_cache){
+		_cache->printSummary(_cacheLookups);
+		if(_cache->close()) return -1;
+	}
+
+	//recorded clcts without a perfect match, next to the output
+	string mismatchFile = outputfile.substr(0, outputfile.rfind(".root")) + "_mismatches.bin";
+	if(_mismatchLog.close()) return -1;
+	MismatchLogWriter mismatchLog;
+	if(mismatchLog.open(mismatchFile)) return -1;
+	for(auto& part : _mismatchParts){
+		if(appendMismatches(part, mismatchLog)) return -1;
+	}
+	if(mismatchLog.close()) return -1;
+	cout << "Wrote " << mismatchLog.written() << " mismatches to file: " << mismatchFile << endl;
 
 	return 0;
 
 }
-
-
-
-
-
@@ -0,0 +1,146 @@
+/*
+ * ThresholdScan.cpp
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: agent
+ */
+
+#include "../include/ThresholdScan.h"
+
+#include <math.h>
+#include <algorithm>
+
+using namespace std;
+
+double ScanSums::rms() const {
+	if(!weight) return 0;
+	double m = mean();
+	return sqrt(max(0., value2/weight - m*m));
+}
+
+ThresholdScan::ThresholdScan(unsigned int bins, double low, double high) :
+	_bins(bins), _low(low), _high(high) {
+}
+
+unsigned int ThresholdScan::category(int chamberType, int patternSet, int ptBin){
+	auto it = _index.insert(make_pair(make_tuple(chamberType, patternSet, ptBin), (unsigned int)_categories.size()));
+	if(it.second) {
+		_categories.push_back(Category());
+		if(_bins) _categories.back().bins.resize(_bins+2);
+	}
+	return it.first->second;
+}
+
+int ThresholdScan::findCategory(int chamberType, int patternSet, int ptBin) const {
+	auto it = _index.find(make_tuple(chamberType, patternSet, ptBin));
+	return it == _index.end() ? -1 : (int)it->second;
+}
+
+/* @brief Binned as TAxis::FindBin
+ */
+void ThresholdScan::fill(unsigned int category, double score, double value, double weight){
+	if(category >= _categories.size()) return;
+	Category& c = _categories[category];
+	c.sorted = false;
+	if(!_bins) {
+		c.entries.push_back({score, value, weight});
+		return;
+	}
+	unsigned int bin = 0; //underflow
+	if(!(score < _high)) bin = _bins+1;
+	else if(score >= _low) bin = 1 + (unsigned int)(_bins*(score-_low)/(_high-_low));
+	ScanSums& s = c.bins[bin];
+	s.weight += weight;
+	s.value += weight*value;
+	s.value2 += weight*value*value;
+}
+
+/* @brief Sorts the scores and sums them up, once after each fill
+ */
+const ThresholdScan::Category& ThresholdScan::prepare(unsigned int category) const {
+	const Category& c = _categories[category];
+	if(c.sorted) return c;
+	const unsigned int n = _bins ? c.bins.size() : c.entries.size();
+	if(!_bins) stable_sort(c.entries.begin(), c.entries.end());
+	c.cumulative.assign(n+1, ScanSums());
+	for(unsigned int i = 0; i < n; i++){
+		if(_bins) c.cumulative[i+1] = c.cumulative[i] + c.bins[i];
+		else {
+			const Entry& e = c.entries[i];
+			c.cumulative[i+1] = c.cumulative[i] + ScanSums(e.weight, e.weight*e.value, e.weight*e.value*e.value);
+		}
+	}
+	c.sorted = true;
+	return c;
+}
+
+unsigned int ThresholdScan::countBelow(const Category& c, double threshold) const {
+	if(!_bins) {
+		Entry e = {threshold, 0, 0};
+		return upper_bound(c.entries.begin(), c.entries.end(), e) - c.entries.begin();
+	}
+	//the bin of the threshold counts as below it
+	if(threshold < _low) return 1;
+	if(!(threshold < _high)) return _bins+2;
+	return 2 + (unsigned int)(_bins*(threshold-_low)/(_high-_low));
+}
+
+double ThresholdScan::score(const Category& c, unsigned int i) const {
+	if(!_bins) return c.entries[i].score;
+	const double width = (_high-_low)/_bins;
+	return _low + (i-0.5)*width; //center, underflow and overflow one bin out
+}
+
+ScanSums ThresholdScan::total(unsigned int category) const {
+	if(category >= _categories.size()) return ScanSums();
+	return prepare(category).cumulative.back();
+}
+
+ScanSums ThresholdScan::below(unsigned int category, double threshold) const {
+	if(category >= _categories.size()) return ScanSums();
+	const Category& c = prepare(category);
+	return c.cumulative[countBelow(c, threshold)];
+}
+
+ScanSums ThresholdScan::above(unsigned int category, double threshold) const {
+	return total(category) - below(category, threshold);
+}
+
+vector<double> ThresholdScan::passing(unsigned int category, const vector<double>& thresholds) const {
+	vector<double> curve;
+	for(double t : thresholds) curve.push_back(above(category, t).weight);
+	return curve;
+}
+
+vector<double> ThresholdScan::efficiency(unsigned int category, const vector<double>& thresholds) const {
+	const double all = total(category).weight;
+	vector<double> curve;
+	for(double t : thresholds) curve.push_back(all ? above(category, t).weight/all : 0.);
+	return curve;
+}
+
+vector<double> ThresholdScan::switchedRMS(unsigned int pass, unsigned int fail, const vector<double>& thresholds) const {
+	vector<double> curve;
+	for(double t : thresholds) curve.push_back((above(pass, t) + below(fail, t)).rms());
+	return curve;
+}
+
+int ThresholdScan::interval(unsigned int category, double coverage, double& low, double& high) const {
+	low = 0;
+	high = 0;
+	if(category >= _categories.size()) return -1;
+	const Category& c = prepare(category);
+	const double all = c.cumulative.back().weight;
+	if(all <= 0) return -1;
+	const double outside = (1.-coverage)/2.*all;
+	const unsigned int n = c.cumulative.size()-1;
+
+	//first from each side where what was passed reaches what is left out
+	unsigned int first = 0;
+	while(first+1 < n && c.cumulative[first+1].weight < outside) first++;
+	unsigned int last = n-1;
+	while(last > 0 && all - c.cumulative[last].weight < outside) last--;
+	low = score(c, first);
+	high = score(c, last);
+	return 0;
+}
@@ -0,0 +1,257 @@
+/*
+ * Tracer.cpp
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: agent
+ */
+
+#include "../include/Tracer.h"
+#include "../include/StageTimers.h"
+
+#include <iostream>
+#include <fstream>
+#include <stdio.h>
+#include <vector>
+#include <set>
+#include <mutex>
+#include <atomic>
+#include <unistd.h>
+
+
+namespace {
+
+struct ThreadTrace {
+	ThreadTrace() : pid(0), tid(0), recorded(0), dropped(0) {}
+	int pid;
+	int tid;
+	string name;
+	vector<TraceEvent> ring;
+	unsigned long long recorded; //total, the ring keeps the last ring.size()
+	unsigned long long dropped; //before it got here, for those of forked children
+
+	unsigned long long lost() const {
+		return dropped + (recorded > ring.size() ? recorded - ring.size() : 0);
+	}
+
+	//oldest first
+	vector<TraceEvent> events() const {
+		if(recorded <= ring.size()) return vector<TraceEvent>(ring.begin(), ring.begin()+recorded);
+		vector<TraceEvent> ordered(ring.begin()+recorded%ring.size(), ring.end());
+		ordered.insert(ordered.end(), ring.begin(), ring.begin()+recorded%ring.size());
+		return ordered;
+	}
+};
+
+struct TraceState {
+	TraceState() : enabled(false), bufferSize(Tracer::DEFAULT_BUFFER_SIZE), nThreads(0) {}
+	mutex m;
+	atomic<bool> enabled;
+	string file;
+	unsigned int bufferSize;
+	chrono::steady_clock::time_point origin;
+	int nThreads;
+	vector<ThreadTrace*> threads; //kept for the whole job, like the stage timers
+};
+
+TraceState& state(){
+	static TraceState s;
+	return s;
+}
+
+ThreadTrace* newThread(int pid){
+	TraceState& s = state();
+	lock_guard<mutex> lock(s.m);
+	ThreadTrace* trace = new ThreadTrace();
+	trace->pid = pid;
+	trace->tid = s.nThreads++;
+	s.threads.push_back(trace);
+	return trace;
+}
+
+ThreadTrace* threadTrace(){
+	static thread_local ThreadTrace* trace = newThread(getpid());
+	return trace;
+}
+
+}
+
+void Tracer::start(const string& file, unsigned int bufferSize){
+	TraceState& s = state();
+	s.file = file;
+	s.bufferSize = bufferSize ? bufferSize : 1;
+	s.origin = chrono::steady_clock::now();
+	s.enabled = true;
+	setThreadName("main");
+}
+
+bool Tracer::enabled(){
+	return state().enabled.load(memory_order_relaxed);
+}
+
+void Tracer::record(unsigned int stage, chrono::steady_clock::time_point start,
+		chrono::steady_clock::time_point end, long long first, long long last){
+	ThreadTrace* trace = threadTrace();
+	if(trace->ring.empty()) trace->ring.resize(state().bufferSize);
+	const chrono::steady_clock::time_point& origin = state().origin;
+	TraceEvent& e = trace->ring[trace->recorded % trace->ring.size()];
+	e.stage = stage;
+	e.start = chrono::duration_cast<chrono::nanoseconds>(start - origin).count();
+	e.end = chrono::duration_cast<chrono::nanoseconds>(end - origin).count();
+	e.first = first;
+	e.last = last;
+	trace->recorded++;
+}
+
+void Tracer::setThreadName(const string& name){
+	threadTrace()->name = name;
+}
+
+void Tracer::clear(){
+	TraceState& s = state();
+	lock_guard<mutex> lock(s.m);
+	for(auto trace : s.threads) {
+		trace->recorded = 0;
+		trace->dropped = 0;
+	}
+}
+
+/* @brief Writes the trace events format, complete ("X") events with
+ * times in us, plus the names of the processes and threads
+ */
+int Tracer::write(){
+	TraceState& s = state();
+	if(!enabled()) return 0;
+	ofstream out(s.file.c_str());
+	if(!out){
+		cout << "Error: can't open trace file: " << s.file << endl;
+		return -1;
+	}
+
+	lock_guard<mutex> lock(s.m);
+	const int mainPid = getpid();
+	unsigned long long written = 0;
+	unsigned long long dropped = 0;
+	set<int> pids;
+	char buffer[512];
+
+	out << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[" << endl;
+	bool firstEvent = true;
+	auto line = [&](const char* text){
+		if(!firstEvent) out << "," << endl;
+		out << text;
+		firstEvent = false;
+	};
+	for(auto trace : s.threads){
+		if(!trace->recorded) continue;
+		if(pids.insert(trace->pid).second){
+			snprintf(buffer, sizeof(buffer), "{\"ph\":\"M\",\"name\":\"process_name\",\"pid\":%i,\"tid\":0,\"args\":{\"name\":\"%s\"}}",
+					trace->pid, trace->pid == mainPid ? "main" : ("process " + to_string(trace->pid)).c_str());
+			line(buffer);
+		}
+		snprintf(buffer, sizeof(buffer), "{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":%i,\"tid\":%i,\"args\":{\"name\":\"%s\"}}",
+				trace->pid, trace->tid, trace->name.empty() ? ("thread " + to_string(trace->tid)).c_str() : trace->name.c_str());
+		line(buffer);
+
+		for(auto& e : trace->events()){
+			const string name = StageTimers::name(e.stage);
+			if(e.first < 0){
+				snprintf(buffer, sizeof(buffer), "{\"ph\":\"X\",\"cat\":\"stage\",\"name\":\"%s\",\"pid\":%i,\"tid\":%i,\"ts\":%.3f,\"dur\":%.3f}",
+						name.c_str(), trace->pid, trace->tid, 1e-3*e.start, 1e-3*(e.end-e.start));
+			} else {
+				snprintf(buffer, sizeof(buffer), "{\"ph\":\"X\",\"cat\":\"stage\",\"name\":\"%s\",\"pid\":%i,\"tid\":%i,\"ts\":%.3f,\"dur\":%.3f,"
+						"\"args\":{\"first\":%lli,\"last\":%lli}}",
+						name.c_str(), trace->pid, trace->tid, 1e-3*e.start, 1e-3*(e.end-e.start), e.first, e.last);
+			}
+			line(buffer);
+			written++;
+		}
+		dropped += trace->lost();
+	}
+	out << endl << "]}" << endl;
+	out.close();
+	if(!out){
+		cout << "Error: failed writing trace file: " << s.file << endl;
+		return -1;
+	}
+
+	cout << "Wrote " << written << " trace events to file: " << s.file << endl;
+	if(dropped) cout << "Warning: dropped the " << dropped << " oldest trace events, raise --trace-size to keep them" << endl;
+	return 0;
+}
+
+/* @brief Sends [n] then [name length, name] for each stage, so the
+ * parent can map the ids, then the pid and [n] threads each as
+ * [tid, name length, name, dropped, n, events]
+ */
+int Tracer::send(int fd){
+	if(!enabled()) return 0;
+	vector<string> names = StageTimers::names();
+	unsigned int n = names.size();
+	if(writeFully(fd, &n, sizeof(n))) return -1;
+	for(auto& name : names){
+		unsigned int length = name.size();
+		if(writeFully(fd, &length, sizeof(length)) || writeFully(fd, name.c_str(), length)) return -1;
+	}
+
+	TraceState& s = state();
+	lock_guard<mutex> lock(s.m);
+	int pid = getpid();
+	n = s.threads.size();
+	if(writeFully(fd, &pid, sizeof(pid)) || writeFully(fd, &n, sizeof(n))) return -1;
+	for(auto trace : s.threads){
+		vector<TraceEvent> events = trace->events();
+		unsigned int length = trace->name.size();
+		unsigned int nEvents = events.size();
+		unsigned long long dropped = trace->lost();
+		if(writeFully(fd, &trace->tid, sizeof(trace->tid)) ||
+				writeFully(fd, &length, sizeof(length)) ||
+				writeFully(fd, trace->name.c_str(), length) ||
+				writeFully(fd, &dropped, sizeof(dropped)) ||
+				writeFully(fd, &nEvents, sizeof(nEvents)) ||
+				(nEvents && writeFully(fd, &events[0], nEvents*sizeof(TraceEvent)))) return -1;
+	}
+	return 0;
+}
+
+int Tracer::receive(int fd){
+	if(!enabled()) return 0;
+	unsigned int n = 0;
+	if(readFully(fd, &n, sizeof(n))) return -1;
+	vector<unsigned int> stageIds;
+	for(unsigned int i = 0; i < n; i++){
+		unsigned int length = 0;
+		if(readFully(fd, &length, sizeof(length))) return -1;
+		string name(length, ' ');
+		if(readFully(fd, &name[0], length)) return -1;
+		stageIds.push_back(StageTimers::stage(name));
+	}
+
+	//the child's pid, so its threads stay together on the timeline
+	int pid = -1;
+	if(readFully(fd, &pid, sizeof(pid)) || readFully(fd, &n, sizeof(n))) return -1;
+	vector<ThreadTrace> received(n);
+	for(auto& trace : received){
+		unsigned int length = 0;
+		unsigned int nEvents = 0;
+		if(readFully(fd, &trace.tid, sizeof(trace.tid)) ||
+				readFully(fd, &length, sizeof(length))) return -1;
+		trace.name.assign(length, ' ');
+		if(readFully(fd, &trace.name[0], length) ||
+				readFully(fd, &trace.dropped, sizeof(trace.dropped)) ||
+				readFully(fd, &nEvents, sizeof(nEvents))) return -1;
+		trace.pid = pid;
+		trace.ring.resize(nEvents);
+		trace.recorded = nEvents;
+		if(nEvents && readFully(fd, &trace.ring[0], nEvents*sizeof(TraceEvent))) return -1;
+		for(auto& e : trace.ring){
+			if(e.stage >= stageIds.size()) return -1;
+			e.stage = stageIds[e.stage];
+		}
+	}
+
+	//full and oldest first, so events() gives them back as they are
+	TraceState& s = state();
+	lock_guard<mutex> lock(s.m);
+	for(auto& trace : received) s.threads.push_back(new ThreadTrace(trace));
+	return 0;
+}